@@ -0,0 +1,57 @@
+/// @file bench_batch.cpp
+/// @brief End-to-end convert_tiles throughput over the whole corpus
+
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/extras/batch.hpp>
+
+#include "bench_helpers.hpp"
+
+namespace {
+
+// range(0) is the worker thread count passed through ParallelOptions.
+void BM_ConvertCorpus(benchmark::State& state)
+{
+  std::vector<art2img::extras::BatchRequest> requests;
+  std::size_t pixels_per_pass = 0;
+  for (const auto& name : bench_helpers::corpus_files()) {
+    const auto& art = bench_helpers::archive(name);
+    art2img::extras::BatchRequest request{};
+    request.archive = &art;
+    request.palette = &bench_helpers::palette();
+    for (std::size_t i = 0; i < art.layout.size(); ++i) {
+      if (art.layout[i].width != 0 && art.layout[i].height != 0) {
+        request.tiles.push_back(i);
+        pixels_per_pass +=
+            static_cast<std::size_t>(art.layout[i].width) * art.layout[i].height;
+      }
+    }
+    request.parallel.threads = static_cast<std::size_t>(state.range(0));
+    requests.push_back(std::move(request));
+  }
+
+  std::size_t tiles = 0;
+  for (auto _ : state) {
+    for (const auto& request : requests) {
+      auto result = art2img::extras::convert_tiles(request);
+      if (!result) {
+        state.SkipWithError(result.error().message.c_str());
+        return;
+      }
+      tiles += result->images.size();
+      benchmark::DoNotOptimize(result->images.data());
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(pixels_per_pass));
+  state.counters["tiles/s"] = benchmark::Counter(static_cast<double>(tiles),
+                                                 benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ConvertCorpus)->Arg(1)->Arg(2)->Arg(4)->Arg(0)->UseRealTime();
+
+}  // namespace
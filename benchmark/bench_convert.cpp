@@ -0,0 +1,304 @@
+/// @file bench_convert.cpp
+/// @brief Palette expansion and postprocessing throughput
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/palette.hpp>
+
+#include "bench_helpers.hpp"
+
+namespace {
+
+// Each bit of the benchmark argument toggles one ConversionOptions field so
+// DenseRange(0, 31) walks every combination.
+enum OptionBits : int {
+  kLookup = 1 << 0,
+  kNoTransparency = 1 << 1,
+  kPremultiply = 1 << 2,
+  kMatte = 1 << 3,
+  kShade = 1 << 4,
+};
+
+art2img::core::ConversionOptions options_from_bits(int bits)
+{
+  art2img::core::ConversionOptions options{};
+  options.apply_lookup = (bits & kLookup) != 0;
+  options.fix_transparency = (bits & kNoTransparency) == 0;
+  options.premultiply_alpha = (bits & kPremultiply) != 0;
+  options.matte_hygiene = (bits & kMatte) != 0;
+  if ((bits & kShade) != 0) {
+    options.shade_index = 8;
+  }
+  return options;
+}
+
+std::string label_from_bits(int bits)
+{
+  std::string label;
+  auto add = [&label](const char* name) {
+    if (!label.empty()) {
+      label += '+';
+    }
+    label += name;
+  };
+  if ((bits & kLookup) != 0) {
+    add("lookup");
+  }
+  if ((bits & kNoTransparency) != 0) {
+    add("no_transparency");
+  }
+  if ((bits & kPremultiply) != 0) {
+    add("premultiply");
+  }
+  if ((bits & kMatte) != 0) {
+    add("matte");
+  }
+  if ((bits & kShade) != 0) {
+    add("shade");
+  }
+  return label.empty() ? "defaults" : label;
+}
+
+// Converts every tile of TILES000.ART, which mixes tiny sprites with larger
+// wall textures.
+void BM_PaletteToRgbaArchive(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto palette = art2img::core::view_palette(bench_helpers::palette());
+  const auto options = options_from_bits(static_cast<int>(state.range(0)));
+
+  std::size_t pixels = 0;
+  std::size_t tiles = 0;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < art2img::core::tile_count(art); ++i) {
+      auto tile = art2img::core::get_tile(art, i);
+      if (!tile) {
+        continue;
+      }
+      auto image = art2img::core::palette_to_rgba(*tile, palette, options);
+      benchmark::DoNotOptimize(image);
+      pixels += static_cast<std::size_t>(tile->width) * tile->height;
+      ++tiles;
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(pixels));
+  state.counters["tiles/s"] = benchmark::Counter(static_cast<double>(tiles),
+                                                 benchmark::Counter::kIsRate);
+  state.SetLabel(label_from_bits(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_PaletteToRgbaArchive)->DenseRange(0, 31);
+
+// Converts the single largest tile of the corpus file, the case where the
+// column-major source layout matters most.
+void BM_PaletteToRgbaLargest(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto palette = art2img::core::view_palette(bench_helpers::palette());
+  const auto options = options_from_bits(static_cast<int>(state.range(0)));
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!tile) {
+    state.SkipWithError("largest tile unavailable");
+    return;
+  }
+
+  for (auto _ : state) {
+    auto image = art2img::core::palette_to_rgba(*tile, palette, options);
+    benchmark::DoNotOptimize(image);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          tile->width * tile->height);
+  state.SetLabel(label_from_bits(static_cast<int>(state.range(0))) + " " +
+                 std::to_string(tile->width) + "x" +
+                 std::to_string(tile->height));
+}
+BENCHMARK(BM_PaletteToRgbaLargest)->Arg(0)->Arg(kLookup | kShade)->Arg(kMatte);
+
+// Same as above with the palette prepared once outside the timed loop, the
+// way batch and CLI callers run.
+void BM_PaletteToRgbaPrepared(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto options = options_from_bits(static_cast<int>(state.range(0)));
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(bench_helpers::palette()), options);
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!prepared || !tile) {
+    state.SkipWithError("prepared palette or largest tile unavailable");
+    return;
+  }
+
+  for (auto _ : state) {
+    auto image = art2img::core::palette_to_rgba(*tile, *prepared);
+    benchmark::DoNotOptimize(image);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          tile->width * tile->height);
+  state.SetLabel(label_from_bits(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_PaletteToRgbaPrepared)->Arg(0)->Arg(kLookup | kShade);
+
+// Steady-state conversion into a reused workspace buffer, as batch workers run.
+void BM_PaletteToRgbaInto(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto options = options_from_bits(static_cast<int>(state.range(0)));
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(bench_helpers::palette()), options);
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!prepared || !tile) {
+    state.SkipWithError("prepared palette or largest tile unavailable");
+    return;
+  }
+
+  art2img::core::ConversionWorkspace workspace{};
+  const auto bytes = static_cast<std::size_t>(tile->width) * tile->height * 4;
+  for (auto _ : state) {
+    auto pixels = workspace.pixel_buffer(bytes);
+    auto result =
+        art2img::core::palette_to_rgba_into(*tile, *prepared, pixels, workspace);
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(pixels.data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          tile->width * tile->height);
+  state.SetLabel(label_from_bits(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_PaletteToRgbaInto)->Arg(0)->Arg(kMatte);
+
+// range(0) shades of the largest tile rendered in one fan-out pass; compare
+// with range(0) iterations of BM_PaletteToRgbaInto.
+void BM_PaletteToRgbaVariants(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!tile) {
+    state.SkipWithError("largest tile unavailable");
+    return;
+  }
+
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto bytes = static_cast<std::size_t>(tile->width) * tile->height * 4;
+  std::vector<art2img::core::PreparedPalette> prepared;
+  std::vector<std::vector<std::uint8_t>> outputs(
+      count, std::vector<std::uint8_t>(bytes));
+  for (std::size_t i = 0; i < count; ++i) {
+    auto variant = art2img::core::prepare_palette(
+        art2img::core::view_palette(bench_helpers::palette()),
+        {.shade_index = static_cast<std::uint8_t>(i)});
+    if (!variant) {
+      state.SkipWithError(variant.error().message.c_str());
+      return;
+    }
+    prepared.push_back(*variant);
+  }
+  std::vector<art2img::core::RenderVariant> variants;
+  for (std::size_t i = 0; i < count; ++i) {
+    variants.push_back({&prepared[i], outputs[i]});
+  }
+
+  art2img::core::ConversionWorkspace workspace{};
+  for (auto _ : state) {
+    auto result =
+        art2img::core::palette_to_rgba_variants(*tile, variants, workspace);
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(outputs.back().data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          tile->width * tile->height *
+                          static_cast<std::int64_t>(count));
+}
+BENCHMARK(BM_PaletteToRgbaVariants)->Arg(1)->Arg(8)->Arg(32);
+
+// Raw throughput of each expansion kernel over a dense index buffer;
+// range(0) is the ExpandKernel value.
+void BM_ExpandKernel(benchmark::State& state)
+{
+  const auto kernel = static_cast<art2img::core::ExpandKernel>(state.range(0));
+  if (!art2img::core::select_expand_kernel(kernel)) {
+    state.SkipWithError("kernel not supported on this CPU");
+    return;
+  }
+
+  constexpr std::uint32_t kSide = 512;
+  std::vector<std::byte> indices(static_cast<std::size_t>(kSide) * kSide);
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<std::byte>((i * 131) & 0xFF);
+  }
+  art2img::core::TileView tile{};
+  tile.indices = indices;
+  tile.width = kSide;
+  tile.height = kSide;
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(bench_helpers::palette()),
+      {.fix_transparency = false});
+  if (!prepared) {
+    state.SkipWithError(prepared.error().message.c_str());
+    return;
+  }
+
+  for (auto _ : state) {
+    auto image = art2img::core::palette_to_rgba(tile, *prepared);
+    benchmark::DoNotOptimize(image);
+  }
+
+  art2img::core::reset_expand_kernel();
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(indices.size() * 4));
+  state.SetLabel(std::string(art2img::core::expand_kernel_name(kernel)));
+}
+BENCHMARK(BM_ExpandKernel)->DenseRange(0, 2);
+
+// Reports the automatically selected kernel in the benchmark context header.
+const bool kKernelContext = [] {
+  benchmark::AddCustomContext(
+      "expand_kernel", std::string(art2img::core::expand_kernel_name(
+                           art2img::core::active_expand_kernel())));
+  return true;
+}();
+
+void BM_PostprocessRgba(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto palette = art2img::core::view_palette(bench_helpers::palette());
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!tile) {
+    state.SkipWithError("largest tile unavailable");
+    return;
+  }
+  auto source = art2img::core::palette_to_rgba(*tile, palette);
+  if (!source) {
+    state.SkipWithError(source.error().message.c_str());
+    return;
+  }
+
+  const auto bits = static_cast<int>(state.range(0));
+  art2img::core::PostprocessOptions options{};
+  options.apply_transparency_fix = (bits & 1) != 0;
+  options.premultiply_alpha = (bits & 2) != 0;
+  options.sanitize_matte = (bits & 4) != 0;
+
+  auto image = *source;
+  for (auto _ : state) {
+    state.PauseTiming();
+    image.pixels = source->pixels;
+    state.ResumeTiming();
+    art2img::core::postprocess_rgba(image, options);
+    benchmark::DoNotOptimize(image.pixels.data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(source->pixels.size()));
+}
+BENCHMARK(BM_PostprocessRgba)->DenseRange(0, 7);
+
+}  // namespace
@@ -0,0 +1,127 @@
+/// @file bench_encode.cpp
+/// @brief Encoder throughput for every format and compression preset
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/palette.hpp>
+
+#include "bench_helpers.hpp"
+
+namespace {
+
+const char* preset_name(art2img::core::CompressionPreset preset)
+{
+  switch (preset) {
+    case art2img::core::CompressionPreset::balanced:
+      return "balanced";
+    case art2img::core::CompressionPreset::fast:
+      return "fast";
+    case art2img::core::CompressionPreset::smallest:
+      return "smallest";
+  }
+  return "unknown";
+}
+
+// range(0) selects the ImageFormat, range(1) the CompressionPreset.
+void BM_EncodeLargestTile(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto palette = art2img::core::view_palette(bench_helpers::palette());
+  auto tile = art2img::core::get_tile(art, bench_helpers::largest_tile(art));
+  if (!tile) {
+    state.SkipWithError("largest tile unavailable");
+    return;
+  }
+  auto image = art2img::core::palette_to_rgba(*tile, palette);
+  if (!image) {
+    state.SkipWithError(image.error().message.c_str());
+    return;
+  }
+
+  const auto format = static_cast<art2img::core::ImageFormat>(state.range(0));
+  art2img::core::EncoderOptions options{};
+  options.compression =
+      static_cast<art2img::core::CompressionPreset>(state.range(1));
+  const auto view = art2img::core::make_view(*image);
+
+  std::size_t encoded_bytes = 0;
+  for (auto _ : state) {
+    auto encoded = art2img::core::encode_image(view, format, options);
+    if (!encoded) {
+      state.SkipWithError(encoded.error().message.c_str());
+      return;
+    }
+    encoded_bytes = encoded->bytes.size();
+    benchmark::DoNotOptimize(encoded->bytes.data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(image->pixels.size()));
+  state.counters["encoded_bytes"] =
+      benchmark::Counter(static_cast<double>(encoded_bytes));
+  state.counters["ratio"] = benchmark::Counter(
+      static_cast<double>(encoded_bytes) /
+      static_cast<double>(image->pixels.size()));
+  state.SetLabel(std::string(art2img::core::file_extension(format)) + "/" +
+                 preset_name(options.compression));
+}
+BENCHMARK(BM_EncodeLargestTile)->ArgsProduct({{0, 1, 2, 3, 4}, {0, 1, 2}});
+
+// Compression presets across every tile of the corpus, which is what a
+// release export pays. range(0) selects the CompressionPreset.
+void BM_EncodeArchivePreset(benchmark::State& state)
+{
+  const auto& art = bench_helpers::archive("TILES000.ART");
+  const auto palette = art2img::core::view_palette(bench_helpers::palette());
+  std::vector<art2img::core::RgbaImage> images;
+  std::size_t raw_bytes = 0;
+  for (std::size_t i = 0; i < art2img::core::tile_count(art); ++i) {
+    if (auto tile = art2img::core::get_tile(art, i)) {
+      if (auto image = art2img::core::palette_to_rgba(*tile, palette)) {
+        raw_bytes += image->pixels.size();
+        images.push_back(std::move(*image));
+      }
+    }
+  }
+
+  art2img::core::EncoderOptions options{};
+  options.compression =
+      static_cast<art2img::core::CompressionPreset>(state.range(0));
+
+  std::size_t encoded_bytes = 0;
+  for (auto _ : state) {
+    encoded_bytes = 0;
+    for (const auto& image : images) {
+      auto encoded = art2img::core::encode_image(
+          art2img::core::make_view(image), art2img::core::ImageFormat::png,
+          options);
+      if (!encoded) {
+        state.SkipWithError(encoded.error().message.c_str());
+        return;
+      }
+      encoded_bytes += encoded->bytes.size();
+      benchmark::DoNotOptimize(encoded->bytes.data());
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(raw_bytes));
+  state.counters["encoded_bytes"] =
+      benchmark::Counter(static_cast<double>(encoded_bytes));
+  state.counters["ratio"] = benchmark::Counter(
+      static_cast<double>(encoded_bytes) / static_cast<double>(raw_bytes));
+  state.SetLabel(preset_name(options.compression));
+}
+BENCHMARK(BM_EncodeArchivePreset)
+    ->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,157 @@
+/// @file bench_helpers.hpp
+/// @brief Shared corpus loading for the benchmark suite
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/palette.hpp>
+
+namespace bench_helpers {
+
+/// @brief Get the benchmark corpus directory
+/// @return Path to the bundled test assets
+inline std::filesystem::path get_assets_dir()
+{
+#ifdef BENCH_ASSETS_DIR
+  return std::filesystem::path(BENCH_ASSETS_DIR);
+#else
+  return std::filesystem::current_path() / "tests" / "assets";
+#endif
+}
+
+/// @brief Read an asset once and keep it for the rest of the run
+/// @param name File name inside the assets directory
+/// @return Raw file bytes
+inline const std::vector<std::byte>& read_asset(const std::string& name)
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::vector<std::byte>> cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = cache.find(name);
+  if (found == cache.end()) {
+    auto bytes = art2img::adapters::read_binary_file(get_assets_dir() / name);
+    if (!bytes) {
+      throw std::runtime_error(bytes.error().message);
+    }
+    found = cache.emplace(name, std::move(*bytes)).first;
+  }
+  return found->second;
+}
+
+/// @brief List the TILES*.ART corpus in tile order
+/// @return Sorted ART file names
+inline const std::vector<std::string>& corpus_files()
+{
+  static const std::vector<std::string> files = [] {
+    std::vector<std::string> names;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(get_assets_dir())) {
+      const auto name = entry.path().filename().string();
+      if (name.starts_with("TILES") && entry.path().extension() == ".ART") {
+        names.push_back(name);
+      }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+  }();
+  return files;
+}
+
+/// @brief Parsed PALETTE.DAT shared by every benchmark
+inline const art2img::core::Palette& palette()
+{
+  static const art2img::core::Palette loaded = [] {
+    auto parsed = art2img::core::load_palette(read_asset("PALETTE.DAT"));
+    if (!parsed) {
+      throw std::runtime_error(parsed.error().message);
+    }
+    return std::move(*parsed);
+  }();
+  return loaded;
+}
+
+/// @brief Parsed archive for one corpus file
+/// @param name ART file name inside the assets directory
+inline const art2img::core::ArtArchive& archive(const std::string& name)
+{
+  static std::mutex mutex;
+  static std::map<std::string, art2img::core::ArtArchive> cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = cache.find(name);
+  if (found == cache.end()) {
+    auto parsed = art2img::core::load_art(read_asset(name));
+    if (!parsed) {
+      throw std::runtime_error(parsed.error().message);
+    }
+    found = cache.emplace(name, std::move(*parsed)).first;
+  }
+  return found->second;
+}
+
+/// @brief Index of the tile with the most pixels in an archive
+inline std::size_t largest_tile(const art2img::core::ArtArchive& art)
+{
+  std::size_t best = 0;
+  std::size_t best_pixels = 0;
+  for (std::size_t i = 0; i < art.layout.size(); ++i) {
+    const auto pixels =
+        static_cast<std::size_t>(art.layout[i].width) * art.layout[i].height;
+    if (pixels > best_pixels) {
+      best = i;
+      best_pixels = pixels;
+    }
+  }
+  return best;
+}
+
+/// @brief Build an in-memory GRP holding the palette and the ART corpus
+inline const std::vector<std::byte>& corpus_grp()
+{
+  static const std::vector<std::byte> blob = [] {
+    std::vector<std::string> names = corpus_files();
+    names.insert(names.begin(), "PALETTE.DAT");
+
+    constexpr std::string_view signature = "KenSilverman";
+    std::vector<std::byte> out;
+    for (char c : signature) {
+      out.push_back(static_cast<std::byte>(c));
+    }
+    auto push_u32 = [&out](std::uint32_t value) {
+      for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<std::byte>((value >> (8 * i)) & 0xFF));
+      }
+    };
+
+    push_u32(static_cast<std::uint32_t>(names.size()));
+    for (const auto& name : names) {
+      std::string field = name;
+      field.resize(12, '\0');
+      for (char c : field) {
+        out.push_back(static_cast<std::byte>(c));
+      }
+      push_u32(static_cast<std::uint32_t>(read_asset(name).size()));
+    }
+    for (const auto& name : names) {
+      const auto& data = read_asset(name);
+      out.insert(out.end(), data.begin(), data.end());
+    }
+    return out;
+  }();
+  return blob;
+}
+
+}  // namespace bench_helpers
@@ -0,0 +1,131 @@
+/// @file bench_load.cpp
+/// @brief Parsing throughput for ART, palette, and GRP blobs
+
+#include <benchmark/benchmark.h>
+
+#include <art2img/adapters/grp.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/palette.hpp>
+
+#include "bench_helpers.hpp"
+
+namespace {
+
+void BM_LoadArt(benchmark::State& state)
+{
+  const auto& files = bench_helpers::corpus_files();
+  const auto& blob =
+      bench_helpers::read_asset(files[static_cast<std::size_t>(state.range(0))]);
+
+  for (auto _ : state) {
+    auto archive = art2img::core::load_art(blob);
+    benchmark::DoNotOptimize(archive);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(blob.size()));
+  state.SetLabel(files[static_cast<std::size_t>(state.range(0))]);
+}
+BENCHMARK(BM_LoadArt)->Arg(0)->Arg(2)->Arg(12);
+
+void BM_LoadArtBorrowed(benchmark::State& state)
+{
+  const auto& files = bench_helpers::corpus_files();
+  const auto& blob =
+      bench_helpers::read_asset(files[static_cast<std::size_t>(state.range(0))]);
+
+  for (auto _ : state) {
+    auto archive = art2img::core::load_art_borrowed(blob);
+    benchmark::DoNotOptimize(archive);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(blob.size()));
+  state.SetLabel(files[static_cast<std::size_t>(state.range(0))]);
+}
+BENCHMARK(BM_LoadArtBorrowed)->Arg(0)->Arg(2)->Arg(12);
+
+void BM_GetTileSweep(benchmark::State& state)
+{
+  const auto& blob = bench_helpers::read_asset("TILES000.ART");
+  const auto archive = art2img::core::load_art_borrowed(blob);
+  const auto count = art2img::core::tile_count(*archive);
+
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < count; ++i) {
+      auto tile = art2img::core::get_tile(*archive, i);
+      benchmark::DoNotOptimize(tile);
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(count));
+}
+BENCHMARK(BM_GetTileSweep);
+
+void BM_LoadPalette(benchmark::State& state)
+{
+  const auto& blob = bench_helpers::read_asset("PALETTE.DAT");
+
+  for (auto _ : state) {
+    auto palette = art2img::core::load_palette(blob);
+    benchmark::DoNotOptimize(palette);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(blob.size()));
+}
+BENCHMARK(BM_LoadPalette);
+
+void BM_LoadGrp(benchmark::State& state)
+{
+  const auto& blob = bench_helpers::corpus_grp();
+
+  for (auto _ : state) {
+    auto grp = art2img::adapters::load_grp(blob);
+    benchmark::DoNotOptimize(grp);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(blob.size()));
+}
+BENCHMARK(BM_LoadGrp);
+
+void BM_LoadGrpBorrowed(benchmark::State& state)
+{
+  const auto& blob = bench_helpers::corpus_grp();
+
+  for (auto _ : state) {
+    auto grp = art2img::adapters::load_grp_borrowed(blob);
+    benchmark::DoNotOptimize(grp);
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(blob.size()));
+}
+BENCHMARK(BM_LoadGrpBorrowed);
+
+void BM_GrpEntryLookup(benchmark::State& state)
+{
+  auto grp = art2img::adapters::load_grp(bench_helpers::corpus_grp());
+  if (!grp) {
+    state.SkipWithError(grp.error().message.c_str());
+    return;
+  }
+  const auto& names = bench_helpers::corpus_files();
+
+  std::size_t lookups = 0;
+  for (auto _ : state) {
+    for (const auto& name : names) {
+      auto entry = grp->entry(name);
+      benchmark::DoNotOptimize(entry);
+    }
+    lookups += names.size();
+  }
+
+  state.counters["lookups/s"] = benchmark::Counter(
+      static_cast<double>(lookups), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GrpEntryLookup);
+
+}  // namespace
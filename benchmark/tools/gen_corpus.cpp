@@ -0,0 +1,450 @@
+/// @file gen_corpus.cpp
+/// @brief Writes synthetic ART archives, a palette and optionally a GRP
+///
+/// The bundled corpus is a few megabytes, too little to show where threading,
+/// memory or I/O stop scaling. This writes corpora of any size up to the
+/// limits load_art enforces (8192 tiles a file, 4096x4096 a tile), with tile
+/// sizes drawn from a chosen distribution. Output is a function of the
+/// options and the seed alone, so runs on different machines compare.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+
+namespace {
+
+namespace core = art2img::core;
+
+constexpr std::uint32_t kMaxTilesPerFile = 8192;
+constexpr std::uint32_t kMaxDimension = 4096;
+constexpr std::byte kTransparent{255};
+
+enum class Distribution {
+  uniform,  // width and height uniform in [1, max]
+  sprites,  // log-uniform in [1, max]: mostly small, a few large
+  pow2,     // power-of-two textures from 8 to max
+  mixed,    // Build-like: textures, sprites and the odd large tile
+  max,      // every tile max x max
+};
+
+struct Options {
+  std::filesystem::path output;
+  std::uint32_t files = 4;
+  std::uint32_t tiles = 1024;  // per file
+  std::uint32_t max_size = 512;
+  Distribution distribution = Distribution::mixed;
+  std::uint32_t empty_percent = 0;  // 0x0 slots, as real archives have
+  std::uint64_t seed = 1;
+  std::string grp;  // GRP file name inside `output`; empty writes none
+};
+
+std::optional<Distribution> parse_distribution(std::string_view name)
+{
+  if (name == "uniform") {
+    return Distribution::uniform;
+  }
+  if (name == "sprites") {
+    return Distribution::sprites;
+  }
+  if (name == "pow2") {
+    return Distribution::pow2;
+  }
+  if (name == "mixed") {
+    return Distribution::mixed;
+  }
+  if (name == "max") {
+    return Distribution::max;
+  }
+  return std::nullopt;
+}
+
+void print_usage()
+{
+  std::cerr
+      << "usage: art2img_gen_corpus <output-dir> [options]\n"
+         "  --files N          ART files to write (default 4)\n"
+         "  --tiles N          tiles per file, 1-8192 (default 1024)\n"
+         "  --max-size N       largest tile side, 1-4096 (default 512)\n"
+         "  --distribution D   uniform|sprites|pow2|mixed|max (default mixed)\n"
+         "  --empty PERCENT    share of 0x0 tiles (default 0)\n"
+         "  --seed N           generator seed (default 1)\n"
+         "  --grp NAME         also pack everything into a GRP named NAME\n";
+}
+
+std::optional<Options> parse_options(int argc, char** argv)
+{
+  if (argc < 2) {
+    return std::nullopt;
+  }
+  Options options{};
+  options.output = argv[1];
+  for (int i = 2; i < argc; ++i) {
+    const std::string_view flag = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << flag << " needs a value\n";
+      return std::nullopt;
+    }
+    const std::string value = argv[++i];
+    const auto number = [&value]() -> std::optional<std::uint64_t> {
+      char* end = nullptr;
+      const auto parsed = std::strtoull(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') {
+        return std::nullopt;
+      }
+      return parsed;
+    }();
+    if (flag == "--distribution") {
+      const auto distribution = parse_distribution(value);
+      if (!distribution) {
+        std::cerr << "unknown distribution '" << value << "'\n";
+        return std::nullopt;
+      }
+      options.distribution = *distribution;
+      continue;
+    }
+    if (flag == "--grp") {
+      options.grp = value;
+      continue;
+    }
+    if (!number) {
+      std::cerr << flag << " expects a number, got '" << value << "'\n";
+      return std::nullopt;
+    }
+    if (flag == "--files") {
+      options.files = static_cast<std::uint32_t>(*number);
+    }
+    else if (flag == "--tiles") {
+      options.tiles = static_cast<std::uint32_t>(*number);
+    }
+    else if (flag == "--max-size") {
+      options.max_size = static_cast<std::uint32_t>(*number);
+    }
+    else if (flag == "--empty") {
+      options.empty_percent = static_cast<std::uint32_t>(*number);
+    }
+    else if (flag == "--seed") {
+      options.seed = *number;
+    }
+    else {
+      std::cerr << "unknown option " << flag << '\n';
+      return std::nullopt;
+    }
+  }
+
+  if (options.files == 0 || options.files > 1000) {
+    std::cerr << "--files must be 1-1000\n";
+    return std::nullopt;
+  }
+  if (options.tiles == 0 || options.tiles > kMaxTilesPerFile) {
+    std::cerr << "--tiles must be 1-" << kMaxTilesPerFile << '\n';
+    return std::nullopt;
+  }
+  if (options.max_size == 0 || options.max_size > kMaxDimension) {
+    std::cerr << "--max-size must be 1-" << kMaxDimension << '\n';
+    return std::nullopt;
+  }
+  if (options.empty_percent > 100) {
+    std::cerr << "--empty must be 0-100\n";
+    return std::nullopt;
+  }
+  return options;
+}
+
+// mt19937_64 is specified exactly but the <random> distributions are not,
+// so draws go through these to give the same corpus with every library.
+std::uint32_t below(std::mt19937_64& rng, std::uint32_t bound)
+{
+  return static_cast<std::uint32_t>(rng() % bound);
+}
+
+std::uint32_t log_uniform(std::mt19937_64& rng, std::uint32_t max)
+{
+  const auto unit = static_cast<double>(rng() >> 11) * 0x1p-53;
+  return std::clamp(
+      static_cast<std::uint32_t>(std::exp2(unit * std::log2(max + 1.0))),
+      std::uint32_t{1}, max);
+}
+
+std::uint32_t power_of_two(std::mt19937_64& rng, std::uint32_t max)
+{
+  std::uint32_t largest = 8;
+  while (largest * 2 <= max) {
+    largest *= 2;
+  }
+  if (largest > max) {
+    return max;  // max below 8
+  }
+  const auto steps = static_cast<std::uint32_t>(std::countr_zero(largest)) - 2;
+  return std::uint32_t{8} << below(rng, steps);
+}
+
+core::TileMetrics pick_size(std::mt19937_64& rng, const Options& options)
+{
+  const auto max = options.max_size;
+  std::uint32_t width = max;
+  std::uint32_t height = max;
+  switch (options.distribution) {
+    case Distribution::uniform:
+      width = below(rng, max) + 1;
+      height = below(rng, max) + 1;
+      break;
+    case Distribution::sprites:
+      width = log_uniform(rng, max);
+      height = log_uniform(rng, max);
+      break;
+    case Distribution::pow2:
+      width = power_of_two(rng, max);
+      height = power_of_two(rng, max);
+      break;
+    case Distribution::mixed: {
+      // Roughly the shape of a Build game's TILES*.ART: mostly wall and
+      // floor textures up to 256, a quarter sprites, and one in twenty
+      // tiles a large sky or screen image.
+      const auto roll = below(rng, 100);
+      if (roll < 70) {
+        width = power_of_two(rng, std::min(max, std::uint32_t{256}));
+        height = power_of_two(rng, std::min(max, std::uint32_t{256}));
+      }
+      else if (roll < 95) {
+        width = log_uniform(rng, std::min(max, std::uint32_t{192}));
+        height = log_uniform(rng, std::min(max, std::uint32_t{192}));
+      }
+      else {
+        const auto low = std::max(std::uint32_t{1}, max / 2);
+        width = low + below(rng, max - low + 1);
+        height = low + below(rng, max - low + 1);
+      }
+      break;
+    }
+    case Distribution::max:
+      break;
+  }
+  core::TileMetrics metrics{};
+  metrics.width = static_cast<std::uint16_t>(width);
+  metrics.height = static_cast<std::uint16_t>(height);
+  return metrics;
+}
+
+// Sixteen ramps of sixteen shades; index 255 is Build's transparent magenta.
+// Shade table `s` darkens each ramp by s / 2 steps.
+std::vector<std::byte> make_palette()
+{
+  constexpr std::size_t kShades = 32;
+  std::vector<std::byte> out;
+  out.reserve(768 + 2 + kShades * 256);
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    const auto ramp = i / 16;
+    const auto level = i % 16;
+    std::array<std::uint32_t, 3> rgb{(ramp & 1) != 0 ? 63u : 20u,
+                                     (ramp & 2) != 0 ? 63u : 20u,
+                                     (ramp & 4) != 0 ? 63u : 20u};
+    if ((ramp & 8) != 0) {
+      rgb[ramp % 3] /= 2;
+    }
+    if (i == 255) {
+      rgb = {63, 0, 63};
+    }
+    else {
+      for (auto& component : rgb) {
+        component = component * (level + 1) / 16;
+      }
+    }
+    for (const auto component : rgb) {
+      out.push_back(static_cast<std::byte>(component));
+    }
+  }
+  out.push_back(static_cast<std::byte>(kShades & 0xFF));
+  out.push_back(static_cast<std::byte>(kShades >> 8));
+  for (std::uint32_t shade = 0; shade < kShades; ++shade) {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      const auto level = i % 16;
+      const auto darker = level > shade / 2 ? level - shade / 2 : 0;
+      out.push_back(
+          static_cast<std::byte>(i == 255 ? 255 : (i - level) + darker));
+    }
+  }
+  return out;
+}
+
+// Column-major indices that compress and convert like real art: a ramp of
+// one palette row in diagonal bands with sparse noise, and for sprites
+// (tiles whose sides are not both powers of two) a transparent surround.
+void fill_tile(core::ArtTileData& tile, std::mt19937_64& rng)
+{
+  const std::uint32_t width = tile.metrics.width;
+  const std::uint32_t height = tile.metrics.height;
+  tile.indices.resize(static_cast<std::size_t>(width) * height);
+
+  const auto base = below(rng, 15) * 16;
+  const auto band = below(rng, 8) + 1;
+  const bool sprite =
+      !std::has_single_bit(width) || !std::has_single_bit(height);
+  auto noise = static_cast<std::uint32_t>(rng()) | 1;
+  const auto cx = static_cast<double>(width) / 2.0;
+  const auto cy = static_cast<double>(height) / 2.0;
+  for (std::uint32_t x = 0; x < width; ++x) {
+    auto* column = tile.indices.data() + static_cast<std::size_t>(x) * height;
+    const auto dx = (x + 0.5 - cx) / cx;
+    for (std::uint32_t y = 0; y < height; ++y) {
+      if (sprite) {
+        const auto dy = (y + 0.5 - cy) / cy;
+        if (dx * dx + dy * dy > 1.0) {
+          column[y] = kTransparent;
+          continue;
+        }
+      }
+      noise ^= noise << 13;
+      noise ^= noise >> 17;
+      noise ^= noise << 5;
+      auto level = ((x + y) / band) % 16;
+      if ((noise & 7) == 0) {
+        level = (level + (noise >> 8)) % 16;
+      }
+      column[y] = static_cast<std::byte>(base + level);
+    }
+  }
+}
+
+std::string art_name(std::uint32_t file)
+{
+  std::array<char, 24> name{};
+  std::snprintf(name.data(), name.size(), "TILES%03u.ART", file);
+  return name.data();
+}
+
+// Packs `names` from `directory` into a GRP, one file in memory at a time.
+bool write_grp(const std::filesystem::path& path,
+               const std::filesystem::path& directory,
+               std::span<const std::string> names)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  const auto put_u32 = [&out](std::uintmax_t value) {
+    for (int i = 0; i < 4; ++i) {
+      out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  };
+  out.write("KenSilverman", 12);
+  put_u32(names.size());
+  for (const auto& name : names) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(directory / name, error);
+    if (error || size > UINT32_MAX) {
+      std::cerr << name << " cannot go in a GRP\n";
+      return false;
+    }
+    std::array<char, 12> field{};
+    std::copy_n(name.begin(), std::min(name.size(), field.size()),
+                field.begin());
+    out.write(field.data(), field.size());
+    put_u32(size);
+  }
+  for (const auto& name : names) {
+    auto bytes = art2img::adapters::read_binary_file(directory / name);
+    if (!bytes) {
+      std::cerr << bytes.error().message << '\n';
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(bytes->data()),
+              static_cast<std::streamsize>(bytes->size()));
+  }
+  out.flush();
+  if (!out) {
+    std::cerr << "failed to write " << path.string() << '\n';
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const auto options = parse_options(argc, argv);
+  if (!options) {
+    print_usage();
+    return 1;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(options->output, error);
+  if (error) {
+    std::cerr << "cannot create " << options->output.string() << ": "
+              << error.message() << '\n';
+    return 1;
+  }
+
+  std::vector<std::string> names{"PALETTE.DAT"};
+  const auto palette = make_palette();
+  if (auto written =
+          art2img::adapters::write_file(options->output / names[0], palette);
+      !written) {
+    std::cerr << written.error().message << '\n';
+    return 1;
+  }
+
+  // Each file gets its own stream so its contents do not depend on how
+  // many files precede it.
+  std::uint64_t tiles = 0;
+  std::uint64_t empty = 0;
+  std::uint64_t pixels = 0;
+  std::uint64_t bytes = palette.size();
+  for (std::uint32_t file = 0; file < options->files; ++file) {
+    std::mt19937_64 rng(options->seed * 1000003 + file);
+    std::vector<core::ArtTileData> art(options->tiles);
+    for (auto& tile : art) {
+      if (below(rng, 100) < options->empty_percent) {
+        ++empty;
+        continue;
+      }
+      tile.metrics = pick_size(rng, *options);
+      tile.metrics.offset_x = static_cast<std::int8_t>(below(rng, 9) - 4);
+      tile.metrics.offset_y = static_cast<std::int8_t>(below(rng, 9) - 4);
+      fill_tile(tile, rng);
+      pixels += tile.indices.size();
+    }
+    tiles += art.size();
+
+    auto blob = core::write_art(art, file * options->tiles);
+    if (!blob) {
+      std::cerr << art_name(file) << ": " << blob.error().message << '\n';
+      return 1;
+    }
+    names.push_back(art_name(file));
+    const auto path = options->output / names.back();
+    if (auto written = art2img::adapters::write_file(path, *blob); !written) {
+      std::cerr << written.error().message << '\n';
+      return 1;
+    }
+    bytes += blob->size();
+  }
+
+  if (!options->grp.empty() &&
+      !write_grp(options->output / options->grp, options->output, names)) {
+    return 1;
+  }
+
+  std::cout << "Wrote " << options->files << " ART files, " << tiles
+            << " tiles (" << empty << " empty), "
+            << (pixels + 500000) / 1000000 << " Mpixels, "
+            << (bytes + (1 << 19)) / (1 << 20) << " MiB to "
+            << options->output.string() << '\n';
+  return 0;
+}
@@ -0,0 +1,544 @@
+/// @file scaling.cpp
+/// @brief Thread-scaling report for convert_tiles and the CLI over a corpus
+///
+/// Converts every tile of a corpus directory (TILES*.ART and PALETTE.DAT, as
+/// art2img_gen_corpus writes them) at 1, 2, 4, ... up to N threads, once
+/// through extras::convert_tiles and once through the art2img executable,
+/// and prints throughput, speedup over one thread, peak RSS and per-tile
+/// latency. Each run happens in a child process so its peak RSS is its own.
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/collection.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/batch.hpp>
+
+namespace {
+
+namespace core = art2img::core;
+namespace extras = art2img::extras;
+
+struct Options {
+  std::filesystem::path corpus;
+  std::size_t max_threads = 0;  // 0: hardware_concurrency
+  std::size_t repeat = 1;       // library passes per thread count
+  std::string format = "png";
+  std::filesystem::path cli;  // empty skips the CLI runs
+};
+
+struct Corpus {
+  std::vector<std::filesystem::path> files;
+  std::filesystem::path palette;
+  std::size_t tiles = 0;  // non-empty tiles
+  std::uint64_t pixels = 0;
+};
+
+/// One run at one thread count. Latencies are per tile, from its first
+/// instrumented stage starting to its last one ending.
+struct Sample {
+  double seconds = 0.0;
+  std::size_t tiles = 0;
+  double p50_ms = 0.0;
+  double p99_ms = 0.0;
+  long peak_rss_kib = 0;
+  bool ok = false;
+};
+
+std::optional<std::size_t> parse_count(std::string_view text)
+{
+  const std::string value(text);
+  char* end = nullptr;
+  const auto parsed = std::strtoull(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0') {
+    return std::nullopt;
+  }
+  return static_cast<std::size_t>(parsed);
+}
+
+std::optional<core::ImageFormat> parse_format(std::string_view name)
+{
+  constexpr std::pair<std::string_view, core::ImageFormat> formats[] = {
+      {"png", core::ImageFormat::png}, {"tga", core::ImageFormat::tga},
+      {"bmp", core::ImageFormat::bmp}, {"dds", core::ImageFormat::dds},
+      {"qoi", core::ImageFormat::qoi}};
+  for (const auto& [known, format] : formats) {
+    if (name == known) {
+      return format;
+    }
+  }
+  return std::nullopt;
+}
+
+void print_usage()
+{
+  std::cerr
+      << "usage: art2img_scaling <corpus-dir> [options]\n"
+         "  --threads N   largest thread count (default: all cores)\n"
+         "  --repeat N    library passes per thread count (default 1)\n"
+         "  --format F    png|tga|bmp|dds|qoi (default png)\n"
+         "  --cli PATH    art2img executable to time as well\n"
+         "  --no-cli      time the library only\n";
+}
+
+std::optional<Options> parse_options(int argc, char** argv)
+{
+  if (argc < 2) {
+    return std::nullopt;
+  }
+  Options options{};
+  options.corpus = argv[1];
+#ifdef ART2IMG_CLI_PATH
+  options.cli = ART2IMG_CLI_PATH;
+#endif
+  for (int i = 2; i < argc; ++i) {
+    const std::string_view flag = argv[i];
+    if (flag == "--no-cli") {
+      options.cli.clear();
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << flag << " needs a value\n";
+      return std::nullopt;
+    }
+    const std::string_view value = argv[++i];
+    if (flag == "--format") {
+      if (!parse_format(value)) {
+        std::cerr << "unknown format '" << value << "'\n";
+        return std::nullopt;
+      }
+      options.format = value;
+    }
+    else if (flag == "--cli") {
+      options.cli = value;
+    }
+    else if (flag == "--threads" || flag == "--repeat") {
+      const auto count = parse_count(value);
+      if (!count || (flag == "--repeat" && *count == 0)) {
+        std::cerr << flag << " expects a positive number\n";
+        return std::nullopt;
+      }
+      (flag == "--threads" ? options.max_threads : options.repeat) = *count;
+    }
+    else {
+      std::cerr << "unknown option " << flag << '\n';
+      return std::nullopt;
+    }
+  }
+  if (options.max_threads == 0) {
+    options.max_threads =
+        std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  }
+  return options;
+}
+
+std::optional<Corpus> find_corpus(const std::filesystem::path& directory)
+{
+  Corpus corpus{};
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(directory, error)) {
+    const auto name = entry.path().filename().string();
+    if (name.starts_with("TILES") && entry.path().extension() == ".ART") {
+      corpus.files.push_back(entry.path());
+    }
+  }
+  if (error || corpus.files.empty()) {
+    std::cerr << "no TILES*.ART files in " << directory.string() << '\n';
+    return std::nullopt;
+  }
+  std::ranges::sort(corpus.files);
+  corpus.palette = directory / "PALETTE.DAT";
+
+  // Only the tile tables are read here; the pixels are left to the runs.
+  auto collection = art2img::adapters::open_art_collection(corpus.files);
+  if (!collection) {
+    std::cerr << collection.error().message << '\n';
+    return std::nullopt;
+  }
+  for (const auto tile : collection->tile_numbers()) {
+    const auto* metrics = collection->metrics(tile);
+    if (metrics->width != 0 && metrics->height != 0) {
+      ++corpus.tiles;
+      corpus.pixels += std::uint64_t{metrics->width} * metrics->height;
+    }
+  }
+  return corpus;
+}
+
+double percentile_ms(std::vector<std::uint64_t>& nanoseconds, double rank)
+{
+  if (nanoseconds.empty()) {
+    return 0.0;
+  }
+  const auto at = static_cast<std::size_t>(
+      rank * static_cast<double>(nanoseconds.size() - 1) + 0.5);
+  std::ranges::nth_element(nanoseconds, nanoseconds.begin() + at);
+  return static_cast<double>(nanoseconds[at]) / 1e6;
+}
+
+/// Spans each tile's stages by tag. A tile is converted and encoded by one
+/// worker, so each slot has a single writer and needs no lock; the batch
+/// joins its workers before returning, which publishes the writes.
+class TileSpans final : public core::StatsSink {
+ public:
+  explicit TileSpans(std::size_t tags) : first_(tags, 0), last_(tags, 0) {}
+
+  void record(const core::StageRecord& record) noexcept override
+  {
+    if (record.tag >= first_.size()) {
+      return;  // the untagged batch span
+    }
+    const auto end = record.start_ns + record.duration_ns;
+    if (first_[record.tag] == 0 || record.start_ns < first_[record.tag]) {
+      first_[record.tag] = record.start_ns;
+    }
+    last_[record.tag] = std::max(last_[record.tag], end);
+  }
+
+  void append_latencies(std::vector<std::uint64_t>& out)
+  {
+    for (std::size_t tag = 0; tag < first_.size(); ++tag) {
+      if (last_[tag] != 0) {
+        out.push_back(last_[tag] - first_[tag]);
+      }
+    }
+    std::ranges::fill(first_, 0);
+    std::ranges::fill(last_, 0);
+  }
+
+ private:
+  std::vector<std::uint64_t> first_;
+  std::vector<std::uint64_t> last_;
+};
+
+/// Runs in the child: loads the corpus, converts it `repeat` times and
+/// writes "seconds tiles p50 p99" to `out`.
+int library_child(const Options& options,
+                  const Corpus& corpus,
+                  std::size_t threads,
+                  std::FILE* out)
+{
+  auto collection = art2img::adapters::open_art_collection(corpus.files);
+  auto palette_bytes = art2img::adapters::read_binary_file(corpus.palette);
+  if (!collection || !palette_bytes) {
+    return 1;
+  }
+  auto palette = core::load_palette(*palette_bytes);
+  const auto format = parse_format(options.format);
+  if (!palette || !format) {
+    return 1;
+  }
+
+  extras::BatchRequest request{};
+  request.collection = &*collection;
+  request.palette = &*palette;
+  request.format = *format;
+  request.parallel.threads = threads;
+  std::uint32_t last_tile = 0;
+  for (const auto tile : collection->tile_numbers()) {
+    const auto* metrics = collection->metrics(tile);
+    if (metrics->width != 0 && metrics->height != 0) {
+      request.tiles.push_back(tile);
+      last_tile = tile;
+    }
+  }
+
+  TileSpans spans(std::size_t{last_tile} + 1);
+  std::vector<std::uint64_t> latencies;
+  std::size_t converted = 0;
+  core::set_stats_sink(&spans);
+  const auto started = std::chrono::steady_clock::now();
+  for (std::size_t pass = 0; pass < options.repeat; ++pass) {
+    auto result = extras::convert_tiles(request);
+    if (!result) {
+      core::set_stats_sink(nullptr);
+      std::cerr << result.error().message << '\n';
+      return 1;
+    }
+    converted += result->images.size();
+    spans.append_latencies(latencies);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - started;
+  core::set_stats_sink(nullptr);
+
+  const auto p50 = percentile_ms(latencies, 0.50);
+  const auto p99 = percentile_ms(latencies, 0.99);
+  std::fprintf(out, "%.9f %zu %.6f %.6f\n", elapsed.count(), converted, p50,
+               p99);
+  return 0;
+}
+
+/// Forks, runs `child` there with a pipe for its report, and returns the
+/// report with the child's peak RSS.
+template <typename Child>
+std::optional<std::string> run_child(Child&& child, long& peak_rss_kib)
+{
+  int pipe_fds[2];
+  if (::pipe(pipe_fds) != 0) {
+    return std::nullopt;
+  }
+  std::cout.flush();
+  const pid_t pid = ::fork();
+  if (pid < 0) {
+    return std::nullopt;
+  }
+  if (pid == 0) {
+    ::close(pipe_fds[0]);
+    std::FILE* out = ::fdopen(pipe_fds[1], "w");
+    const int status = child(out);
+    std::fclose(out);
+    ::_exit(status);
+  }
+
+  ::close(pipe_fds[1]);
+  std::string report;
+  char buffer[256];
+  ssize_t count = 0;
+  while ((count = ::read(pipe_fds[0], buffer, sizeof buffer)) > 0) {
+    report.append(buffer, static_cast<std::size_t>(count));
+  }
+  ::close(pipe_fds[0]);
+
+  int status = 0;
+  rusage usage{};
+  if (::wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0) {
+    return std::nullopt;
+  }
+#ifdef __APPLE__
+  peak_rss_kib = usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+  peak_rss_kib = usage.ru_maxrss;
+#endif
+  return report;
+}
+
+Sample run_library(const Options& options,
+                   const Corpus& corpus,
+                   std::size_t threads)
+{
+  Sample sample{};
+  const auto report = run_child(
+      [&](std::FILE* out) {
+        return library_child(options, corpus, threads, out);
+      },
+      sample.peak_rss_kib);
+  if (report && std::sscanf(report->c_str(), "%lf %zu %lf %lf",
+                            &sample.seconds, &sample.tiles, &sample.p50_ms,
+                            &sample.p99_ms) == 4) {
+    sample.ok = true;
+  }
+  return sample;
+}
+
+std::optional<double> field(std::string_view line, std::string_view key)
+{
+  const auto at = line.find(key);
+  if (at == std::string_view::npos) {
+    return std::nullopt;
+  }
+  return std::strtod(std::string(line.substr(at + key.size(), 32)).c_str(),
+                     nullptr);
+}
+
+/// Per-tile latencies from a --trace file. Each event is on a line of its
+/// own and each thread's spans are in order, so consecutive convert,
+/// postprocess and encode spans on one thread with the same tile tag are
+/// one tile.
+std::vector<std::uint64_t> trace_latencies(const std::filesystem::path& path)
+{
+  struct Open {
+    double tile = -1.0;
+    double start = 0.0;
+    double end = 0.0;
+  };
+  std::vector<std::uint64_t> latencies;
+  std::map<double, Open> threads;
+  const auto close = [&latencies](const Open& open) {
+    if (open.tile >= 0.0) {
+      latencies.push_back(
+          static_cast<std::uint64_t>((open.end - open.start) * 1e3));
+    }
+  };
+
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find("\"ph\":\"X\"") == std::string::npos ||
+        (line.find("\"name\":\"convert\"") == std::string::npos &&
+         line.find("\"name\":\"postprocess\"") == std::string::npos &&
+         line.find("\"name\":\"encode\"") == std::string::npos)) {
+      continue;
+    }
+    const auto tile = field(line, "\"tile\":");
+    const auto ts = field(line, "\"ts\":");
+    const auto dur = field(line, "\"dur\":");
+    const auto tid = field(line, "\"tid\":");
+    if (!tile || !ts || !dur || !tid) {
+      continue;
+    }
+    auto& open = threads[*tid];
+    if (open.tile != *tile) {
+      close(open);
+      open = Open{*tile, *ts, *ts};
+    }
+    open.end = std::max(open.end, *ts + *dur);
+  }
+  for (const auto& [tid, open] : threads) {
+    close(open);
+  }
+  return latencies;
+}
+
+Sample run_cli(const Options& options,
+               const Corpus& corpus,
+               std::size_t threads,
+               const std::filesystem::path& work)
+{
+  const auto output = work / ("out-" + std::to_string(threads));
+  const auto trace = work / ("trace-" + std::to_string(threads) + ".json");
+  std::vector<std::string> args{options.cli.string()};
+  for (const auto& file : corpus.files) {
+    args.insert(args.end(), {"-i", file.string()});
+  }
+  args.insert(args.end(), {"-p", corpus.palette.string(), "-o",
+                           output.string(), "-f", options.format, "-j",
+                           std::to_string(threads), "--trace", trace.string()});
+
+  Sample sample{};
+  const auto started = std::chrono::steady_clock::now();
+  const auto report = run_child(
+      [&](std::FILE*) {
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+          argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        std::freopen("/dev/null", "w", stdout);
+        ::execv(argv[0], argv.data());
+        return 127;
+      },
+      sample.peak_rss_kib);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - started;
+  if (report) {
+    auto latencies = trace_latencies(trace);
+    sample.seconds = elapsed.count();
+    sample.tiles = corpus.tiles;
+    sample.p50_ms = percentile_ms(latencies, 0.50);
+    sample.p99_ms = percentile_ms(latencies, 0.99);
+    sample.ok = true;
+  }
+  std::error_code error;
+  std::filesystem::remove_all(output, error);
+  std::filesystem::remove(trace, error);
+  return sample;
+}
+
+void print_row(std::string_view mode,
+               std::size_t threads,
+               const Sample& sample,
+               const Sample& baseline,
+               const Corpus& corpus)
+{
+  if (!sample.ok) {
+    std::printf("%-8s %7zu  failed\n", std::string(mode).c_str(), threads);
+    return;
+  }
+  const auto per_pass =
+      static_cast<double>(std::max<std::size_t>(1, corpus.tiles));
+  const auto passes = static_cast<double>(sample.tiles) / per_pass;
+  const auto speedup =
+      baseline.ok ? baseline.seconds / static_cast<double>(baseline.tiles) /
+                        (sample.seconds / static_cast<double>(sample.tiles))
+                  : 0.0;
+  std::printf("%-8s %7zu %10.0f %9.1f %7.2fx %10.1f %8.3f %8.3f\n",
+              std::string(mode).c_str(), threads,
+              static_cast<double>(sample.tiles) / sample.seconds,
+              static_cast<double>(corpus.pixels) * passes / sample.seconds /
+                  1e6,
+              speedup, static_cast<double>(sample.peak_rss_kib) / 1024.0,
+              sample.p50_ms, sample.p99_ms);
+  std::fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const auto options = parse_options(argc, argv);
+  if (!options) {
+    print_usage();
+    return 1;
+  }
+  const auto corpus = find_corpus(options->corpus);
+  if (!corpus) {
+    return 1;
+  }
+
+  std::vector<std::size_t> counts;
+  for (std::size_t threads = 1; threads < options->max_threads; threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(options->max_threads);
+
+  std::printf("%zu files, %zu tiles, %.1f Mpixels, %s\n\n",
+              corpus->files.size(), corpus->tiles,
+              static_cast<double>(corpus->pixels) / 1e6,
+              options->format.c_str());
+  std::printf("%-8s %7s %10s %9s %8s %10s %8s %8s\n", "mode", "threads",
+              "tiles/s", "Mpix/s", "speedup", "peak MiB", "p50 ms",
+              "p99 ms");
+
+  Sample baseline{};
+  for (const auto threads : counts) {
+    const auto sample = run_library(*options, *corpus, threads);
+    if (threads == 1) {
+      baseline = sample;
+    }
+    print_row("library", threads, sample, baseline, *corpus);
+  }
+
+  if (options->cli.empty()) {
+    return 0;
+  }
+  const auto work = std::filesystem::temp_directory_path() /
+                    ("art2img-scaling-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(work);
+  for (const auto threads : counts) {
+    const auto sample = run_cli(*options, *corpus, threads, work);
+    if (threads == 1) {
+      baseline = sample;
+    }
+    print_row("cli", threads, sample, baseline, *corpus);
+  }
+  std::error_code error;
+  std::filesystem::remove_all(work, error);
+  return 0;
+}
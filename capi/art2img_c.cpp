@@ -0,0 +1,496 @@
+#include <art2img/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/error.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/extras/parallel.hpp>
+
+struct art2img_archive {
+  art2img::core::ArtArchive archive;
+};
+
+struct art2img_palette {
+  art2img::core::PaletteView view;
+};
+
+struct art2img_converter {
+  art2img::core::PreparedPalette palette;
+  art2img::core::EncoderOptions encoder{};
+  // One per thread art2img_convert_tiles has run with; the first also serves
+  // the single-tile calls. Kept between calls so their buffers are reused.
+  std::vector<art2img::core::ConversionWorkspace> workspaces;
+};
+
+namespace {
+
+thread_local std::string last_error{};
+
+art2img_status fail(art2img_status status, std::string message)
+{
+  last_error = std::move(message);
+  return status;
+}
+
+art2img_status fail(const art2img::core::Error& error)
+{
+  const auto code = error.code.value();
+  const bool ours =
+      error.code.category() == art2img::core::error_category::instance();
+  auto status = ours && code >= ART2IMG_ERROR_IO &&
+                        code <= ART2IMG_ERROR_ANIMATION_FORMAT
+                    ? static_cast<art2img_status>(code)
+                    : ART2IMG_ERROR_IO;
+  if (error.code == art2img::core::errc::buffer_too_small) {
+    status = ART2IMG_ERROR_BUFFER_TOO_SMALL;
+  }
+  return fail(status, error.message);
+}
+
+// Keeps C++ exceptions from unwinding into the caller's frames.
+template <typename Body>
+art2img_status guarded(Body&& body) noexcept
+{
+  try {
+    return body();
+  }
+  catch (const std::bad_alloc&) {
+    return fail(ART2IMG_ERROR_OUT_OF_MEMORY, "out of memory");
+  }
+  catch (...) {
+    return fail(ART2IMG_ERROR_INTERNAL, "unexpected internal error");
+  }
+}
+
+std::span<const std::byte> as_bytes(const void* data, std::size_t size)
+{
+  return {static_cast<const std::byte*>(data), size};
+}
+
+// The tile's view, or its failure; a tile with no pixels has no view.
+std::expected<std::optional<art2img::core::TileView>, art2img_status>
+resolve_tile(const art2img_archive* archive, std::size_t tile)
+{
+  if (archive == nullptr) {
+    return std::unexpected(
+        fail(ART2IMG_ERROR_INVALID_ARGUMENT, "archive is null"));
+  }
+  if (tile >= art2img::core::tile_count(archive->archive)) {
+    return std::unexpected(fail(ART2IMG_ERROR_OUT_OF_RANGE,
+                                "tile index " + std::to_string(tile) +
+                                    " is out of range"));
+  }
+  return art2img::core::get_tile(archive->archive, tile);
+}
+
+std::size_t rgba_size(const art2img::core::TileMetrics& metrics)
+{
+  return static_cast<std::size_t>(metrics.width) * metrics.height * 4;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t art2img_abi_version(void)
+{
+  return ART2IMG_C_ABI_VERSION;
+}
+
+const char* art2img_status_name(art2img_status status)
+{
+  switch (status) {
+    case ART2IMG_OK:
+      return "ok";
+    case ART2IMG_ERROR_IO:
+      return "io_failure";
+    case ART2IMG_ERROR_INVALID_ART:
+      return "invalid_art";
+    case ART2IMG_ERROR_INVALID_PALETTE:
+      return "invalid_palette";
+    case ART2IMG_ERROR_CONVERSION:
+      return "conversion_failure";
+    case ART2IMG_ERROR_ENCODING:
+      return "encoding_failure";
+    case ART2IMG_ERROR_UNSUPPORTED:
+      return "unsupported";
+    case ART2IMG_ERROR_NO_ANIMATION:
+      return "no_animation";
+    case ART2IMG_ERROR_ANIMATION_FORMAT:
+      return "animation_format";
+    case ART2IMG_ERROR_INVALID_ARGUMENT:
+      return "invalid_argument";
+    case ART2IMG_ERROR_OUT_OF_RANGE:
+      return "out_of_range";
+    case ART2IMG_ERROR_BUFFER_TOO_SMALL:
+      return "buffer_too_small";
+    case ART2IMG_ERROR_OUT_OF_MEMORY:
+      return "out_of_memory";
+    case ART2IMG_ERROR_INTERNAL:
+      return "internal";
+  }
+  return "unknown";
+}
+
+const char* art2img_last_error_message(void)
+{
+  return last_error.c_str();
+}
+
+art2img_status art2img_archive_open(const void* data,
+                                    size_t size,
+                                    art2img_archive** out)
+{
+  return guarded([&] {
+    if (out == nullptr || (data == nullptr && size > 0)) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "null archive argument");
+    }
+    auto archive = art2img::core::load_art_borrowed(as_bytes(data, size));
+    if (!archive) {
+      return fail(archive.error());
+    }
+    *out = new art2img_archive{std::move(*archive)};
+    return ART2IMG_OK;
+  });
+}
+
+void art2img_archive_close(art2img_archive* archive)
+{
+  delete archive;
+}
+
+size_t art2img_archive_tile_count(const art2img_archive* archive)
+{
+  return archive == nullptr ? 0 : art2img::core::tile_count(archive->archive);
+}
+
+art2img_status art2img_archive_tile_info(const art2img_archive* archive,
+                                         size_t tile,
+                                         art2img_tile_info* out)
+{
+  return guarded([&] {
+    if (out == nullptr) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "tile info is null");
+    }
+    const auto resolved = resolve_tile(archive, tile);
+    if (!resolved) {
+      return resolved.error();
+    }
+    const auto& metrics = archive->archive.layout[tile];
+    *out = art2img_tile_info{metrics.width, metrics.height, metrics.offset_x,
+                             metrics.offset_y};
+    return ART2IMG_OK;
+  });
+}
+
+art2img_status art2img_palette_open(const void* data,
+                                    size_t size,
+                                    art2img_palette** out)
+{
+  return guarded([&] {
+    if (out == nullptr || (data == nullptr && size > 0)) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "null palette argument");
+    }
+    auto view = art2img::core::load_palette_view(as_bytes(data, size));
+    if (!view) {
+      return fail(view.error());
+    }
+    *out = new art2img_palette{*view};
+    return ART2IMG_OK;
+  });
+}
+
+void art2img_palette_close(art2img_palette* palette)
+{
+  delete palette;
+}
+
+void art2img_default_options(art2img_options* options)
+{
+  if (options == nullptr) {
+    return;
+  }
+  *options = art2img_options{};
+  options->size = sizeof(art2img_options);
+  options->shade_index = -1;
+  options->apply_lookup = 1;
+  options->fix_transparency = 1;
+  options->compression = ART2IMG_COMPRESSION_BALANCED;
+}
+
+art2img_status art2img_converter_create(const art2img_palette* palette,
+                                        const art2img_options* options,
+                                        art2img_converter** out)
+{
+  return guarded([&] {
+    if (palette == nullptr || out == nullptr) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "null converter argument");
+    }
+    art2img_options settings{};
+    art2img_default_options(&settings);
+    if (options != nullptr) {
+      if (options->size < sizeof(art2img_options)) {
+        return fail(ART2IMG_ERROR_INVALID_ARGUMENT,
+                    "options were not filled by art2img_default_options");
+      }
+      settings = *options;
+    }
+    if (settings.shade_index > 255 ||
+        settings.compression > ART2IMG_COMPRESSION_SMALLEST ||
+        settings.texture_compression > ART2IMG_TEXTURE_AUTOMATIC) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "option out of range");
+    }
+
+    art2img::core::ConversionOptions conversion{
+        .apply_lookup = settings.apply_lookup != 0,
+        .fix_transparency = settings.fix_transparency != 0,
+        .premultiply_alpha = settings.premultiply_alpha != 0,
+        .matte_hygiene = settings.matte_hygiene != 0};
+    if (settings.shade_index >= 0) {
+      conversion.shade_index = static_cast<std::uint8_t>(settings.shade_index);
+    }
+    auto prepared = art2img::core::prepare_palette(palette->view, conversion);
+    if (!prepared) {
+      return fail(prepared.error());
+    }
+
+    auto* converter = new art2img_converter{std::move(*prepared), {}, {}};
+    converter->encoder.compression =
+        static_cast<art2img::core::CompressionPreset>(settings.compression);
+    converter->encoder.texture = static_cast<art2img::core::TextureCompression>(
+        settings.texture_compression);
+    converter->workspaces.resize(1);
+    *out = converter;
+    return ART2IMG_OK;
+  });
+}
+
+void art2img_converter_destroy(art2img_converter* converter)
+{
+  delete converter;
+}
+
+art2img_status art2img_convert_tile(art2img_converter* converter,
+                                    const art2img_archive* archive,
+                                    size_t tile,
+                                    uint8_t* out,
+                                    size_t capacity,
+                                    size_t* written)
+{
+  return guarded([&] {
+    if (converter == nullptr || written == nullptr) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "null convert argument");
+    }
+    const auto resolved = resolve_tile(archive, tile);
+    if (!resolved) {
+      return resolved.error();
+    }
+    *written = 0;
+    if (!*resolved) {
+      return ART2IMG_OK;
+    }
+    const auto needed = rgba_size(archive->archive.layout[tile]);
+    if (out == nullptr || capacity < needed) {
+      *written = needed;
+      return fail(ART2IMG_ERROR_BUFFER_TOO_SMALL, "RGBA buffer too small");
+    }
+    auto converted = art2img::core::palette_to_rgba_into(
+        **resolved, converter->palette, {out, needed},
+        converter->workspaces.front());
+    if (!converted) {
+      return fail(converted.error());
+    }
+    *written = needed;
+    return ART2IMG_OK;
+  });
+}
+
+art2img_status art2img_encoded_size(const art2img_converter* converter,
+                                    const art2img_archive* archive,
+                                    size_t tile,
+                                    art2img_format format,
+                                    size_t* size)
+{
+  return guarded([&] {
+    if (converter == nullptr || size == nullptr ||
+        format > ART2IMG_FORMAT_QOI) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "invalid size argument");
+    }
+    const auto resolved = resolve_tile(archive, tile);
+    if (!resolved) {
+      return resolved.error();
+    }
+    const auto& metrics = archive->archive.layout[tile];
+    // The estimate depends on the dimensions only, never on the pixels.
+    const art2img::core::RgbaImageView shape{
+        {}, metrics.width, metrics.height, metrics.width * 4u};
+    *size = art2img::core::estimate_encoded_size(
+        shape, static_cast<art2img::core::ImageFormat>(format),
+        converter->encoder);
+    return ART2IMG_OK;
+  });
+}
+
+art2img_status art2img_encode_tile(art2img_converter* converter,
+                                   const art2img_archive* archive,
+                                   size_t tile,
+                                   art2img_format format,
+                                   void* out,
+                                   size_t capacity,
+                                   size_t* written)
+{
+  return guarded([&] {
+    if (converter == nullptr || written == nullptr ||
+        (out == nullptr && capacity > 0) || format > ART2IMG_FORMAT_QOI) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "invalid encode argument");
+    }
+    const auto resolved = resolve_tile(archive, tile);
+    if (!resolved) {
+      return resolved.error();
+    }
+    *written = 0;
+    if (!*resolved) {
+      return fail(ART2IMG_ERROR_ENCODING,
+                  "tile " + std::to_string(tile) + " is empty");
+    }
+
+    const auto& view = **resolved;
+    auto& workspace = converter->workspaces.front();
+    const auto pixels = workspace.pixel_buffer(
+        static_cast<std::size_t>(view.width) * view.height * 4);
+    auto converted = art2img::core::palette_to_rgba_into(
+        view, converter->palette, pixels, workspace);
+    if (!converted) {
+      return fail(converted.error());
+    }
+    const art2img::core::RgbaImageView image{pixels, view.width, view.height,
+                                             view.width * 4u};
+    auto encoded = art2img::core::encode_image_into(
+        image, static_cast<art2img::core::ImageFormat>(format),
+        {static_cast<std::byte*>(out), capacity}, converter->encoder, written);
+    if (!encoded) {
+      return fail(encoded.error());
+    }
+    *written = *encoded;
+    return ART2IMG_OK;
+  });
+}
+
+art2img_status art2img_batch_size(const art2img_archive* archive,
+                                  const size_t* tiles,
+                                  size_t count,
+                                  size_t* size)
+{
+  return guarded([&] {
+    if (size == nullptr || (tiles == nullptr && count > 0)) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "invalid batch argument");
+    }
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto resolved = resolve_tile(archive, tiles[i]);
+      if (!resolved) {
+        return resolved.error();
+      }
+      total += rgba_size(archive->archive.layout[tiles[i]]);
+    }
+    *size = total;
+    return ART2IMG_OK;
+  });
+}
+
+art2img_status art2img_convert_tiles(art2img_converter* converter,
+                                     const art2img_archive* archive,
+                                     const size_t* tiles,
+                                     size_t count,
+                                     uint8_t* out,
+                                     size_t capacity,
+                                     size_t* offsets,
+                                     size_t threads)
+{
+  return guarded([&] {
+    if (converter == nullptr || offsets == nullptr) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "null batch argument");
+    }
+    std::size_t needed = 0;
+    const auto sized = art2img_batch_size(archive, tiles, count, &needed);
+    if (sized != ART2IMG_OK) {
+      return sized;
+    }
+    if (out == nullptr && needed > 0) {
+      return fail(ART2IMG_ERROR_INVALID_ARGUMENT, "RGBA buffer is null");
+    }
+    if (capacity < needed) {
+      return fail(ART2IMG_ERROR_BUFFER_TOO_SMALL, "RGBA buffer too small");
+    }
+
+    const std::span<const std::size_t> request{tiles, count};
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      offsets[i] = offset;
+      offset += rgba_size(archive->archive.layout[request[i]]);
+    }
+
+    const auto slots = art2img::extras::resolve_thread_count(threads, count);
+    if (converter->workspaces.size() < slots) {
+      converter->workspaces.resize(slots);
+    }
+    const auto order =
+        slots == 1 ? std::vector<std::size_t>{}
+                   : art2img::extras::largest_first(archive->archive, request);
+
+    // Tiles write disjoint ranges of `out`; only the first failure by
+    // request position is kept, as a one-thread run would report it.
+    std::mutex failure_mutex;
+    std::size_t failed_position = std::numeric_limits<std::size_t>::max();
+    std::optional<art2img::core::Error> failure;
+    const auto convert = [&](std::size_t position, std::size_t slot) {
+      const auto tile = art2img::core::get_tile(archive->archive,
+                                                request[position]);
+      if (!tile) {
+        return true;
+      }
+      auto converted = art2img::core::palette_to_rgba_into(
+          *tile, converter->palette,
+          {out + offsets[position],
+           rgba_size(archive->archive.layout[request[position]])},
+          converter->workspaces[slot]);
+      if (!converted) {
+        const std::lock_guard lock(failure_mutex);
+        if (position < failed_position) {
+          failed_position = position;
+          failure = std::move(converted.error());
+        }
+      }
+      return true;
+    };
+
+    if (slots == 1) {
+      for (std::size_t position = 0; position < count; ++position) {
+        convert(position, 0);
+      }
+    }
+    else {
+      art2img::extras::for_each_index(
+          order, art2img::extras::ParallelOptions{.threads = slots}, convert);
+    }
+    if (failure) {
+      return fail(*failure);
+    }
+    return ART2IMG_OK;
+  });
+}
+
+}  // extern "C"
@@ -1,9 +1,92 @@
 #include "config_parser.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <system_error>
+#include <utility>
+
 #include <art2img/core/encode.hpp>
 
 namespace art2img::cli {
 
+namespace {
+
+char fold(char c)
+{
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// Case-insensitive `*`/`?` match with backtracking to the last star.
+bool wildcard_match(std::string_view pattern, std::string_view name)
+{
+  std::size_t p = 0;
+  std::size_t n = 0;
+  std::size_t star = std::string_view::npos;
+  std::size_t resume = 0;
+  while (n < name.size()) {
+    if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      resume = n;
+    }
+    else if (p < pattern.size() &&
+             (pattern[p] == '?' || fold(pattern[p]) == fold(name[n]))) {
+      ++p;
+      ++n;
+    }
+    else if (star != std::string_view::npos) {
+      p = star + 1;
+      n = ++resume;
+    }
+    else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+std::vector<std::filesystem::path> matching_files(
+    const std::filesystem::path& directory,
+    std::string_view pattern)
+{
+  std::vector<std::filesystem::path> matches;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+    if (entry.is_regular_file(ec) &&
+        wildcard_match(pattern, entry.path().filename().string())) {
+      matches.push_back(entry.path());
+    }
+  }
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+// Output files and cache records are named after each input's stem, so two
+// inputs sharing one would overwrite each other. Stems are compared without
+// case, as the output directory may be on a case-insensitive filesystem.
+std::expected<void, std::string> check_output_stems(
+    const std::vector<std::filesystem::path>& inputs)
+{
+  std::map<std::string, const std::filesystem::path*> seen;
+  for (const auto& input : inputs) {
+    auto stem = input.stem().string();
+    std::transform(stem.begin(), stem.end(), stem.begin(), fold);
+    const auto [found, inserted] = seen.emplace(stem, &input);
+    if (!inserted) {
+      return std::unexpected("inputs " + found->second->string() + " and " +
+                             input.string() +
+                             " would write the same output files");
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
 std::expected<art2img::core::ImageFormat, std::string> parse_format(
     std::string_view text)
 {
@@ -19,7 +102,99 @@ std::expected<art2img::core::ImageFormat, std::string> parse_format(
     return art2img::core::ImageFormat::bmp;
   }
 
+  if (text == "dds") {
+    return art2img::core::ImageFormat::dds;
+  }
+
+  if (text == "qoi") {
+    return art2img::core::ImageFormat::qoi;
+  }
+
   return std::unexpected("unsupported format: " + std::string{text});
 }
 
-}  // namespace art2img::cli
\ No newline at end of file
+std::expected<std::vector<std::filesystem::path>, std::string> expand_inputs(
+    const std::vector<std::string>& arguments)
+{
+  std::vector<std::filesystem::path> inputs;
+  std::set<std::filesystem::path> canonical;  // one entry per distinct file
+  const auto add = [&](const std::filesystem::path& path) {
+    std::error_code ec;
+    auto resolved = std::filesystem::weakly_canonical(path, ec);
+    if (canonical.insert(ec ? path : std::move(resolved)).second) {
+      inputs.push_back(path);
+    }
+  };
+
+  for (const auto& argument : arguments) {
+    const std::filesystem::path path{argument};
+    const auto name = path.filename().string();
+    std::error_code ec;
+    std::vector<std::filesystem::path> matches;
+    if (std::filesystem::is_directory(path, ec)) {
+      matches = matching_files(path, "*.art");
+    }
+    else if (name.find_first_of("*?") != std::string::npos) {
+      const auto parent = path.parent_path();
+      matches = matching_files(parent.empty() ? "." : parent, name);
+    }
+    else if (std::filesystem::is_regular_file(path, ec)) {
+      matches.push_back(path);
+    }
+    else {
+      return std::unexpected("input file not found: " + argument);
+    }
+
+    if (matches.empty()) {
+      return std::unexpected("no ART files match: " + argument);
+    }
+    std::for_each(matches.begin(), matches.end(), add);
+  }
+
+  if (auto stems = check_output_stems(inputs); !stems) {
+    return std::unexpected(std::move(stems.error()));
+  }
+  return inputs;
+}
+
+std::expected<std::vector<std::filesystem::path>, std::string>
+expand_grp_inputs(const art2img::adapters::GrpFile& grp,
+                  const std::vector<std::string>& arguments)
+{
+  std::vector<std::filesystem::path> inputs;
+  const auto add = [&inputs](std::string_view name) {
+    const std::filesystem::path path{name};
+    if (std::find(inputs.begin(), inputs.end(), path) == inputs.end()) {
+      inputs.push_back(path);
+    }
+  };
+
+  for (const auto& argument : arguments) {
+    if (argument.find_first_of("*?") == std::string::npos) {
+      const auto entry = grp.entry(argument);
+      if (!entry) {
+        return std::unexpected("no GRP entry named: " + argument);
+      }
+      add(entry->name);
+      continue;
+    }
+
+    bool matched = false;
+    for (const auto& entry : grp.entries()) {
+      if (wildcard_match(argument, entry.name)) {
+        add(entry.name);
+        matched = true;
+      }
+    }
+    if (!matched) {
+      return std::unexpected("no GRP entries match: " + argument);
+    }
+  }
+
+  if (auto stems = check_output_stems(inputs); !stems) {
+    return std::unexpected(std::move(stems.error()));
+  }
+  return inputs;
+}
+
+}  // namespace art2img::cli
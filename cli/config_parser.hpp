@@ -1,30 +1,62 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <expected>
 #include <filesystem>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include <art2img/adapters/grp.hpp>
 #include <art2img/core/convert.hpp>
 #include <art2img/core/encode.hpp>
 
 namespace art2img::cli {
 
 struct CliConfig {
-  std::filesystem::path input_art;
+  std::vector<std::filesystem::path> inputs;  // expanded by expand_inputs
   std::filesystem::path palette_path;
+  std::filesystem::path grp_path{};  // when set, inputs name GRP entries
   std::filesystem::path output_dir{"."};
   std::string format{"png"};
   bool apply_lookup{true};
   bool fix_transparency{true};
   bool premultiply_alpha{false};
   bool sanitize_matte{false};
+  bool indexed{false};  // 8-bit paletted output straight from tile indices
+  bool atlas{false};    // pack every tile into shared pages plus a manifest
+  std::uint32_t atlas_size{2048};
+  bool zip{false};  // one stored ZIP per input instead of a file per tile
+  std::size_t write_behind_mb{64};  // 0 writes each tile before moving on
+  bool incremental{false};  // skip tiles whose cached fingerprint matches
+  bool dedupe{false};  // convert identical tiles once and hardlink the rest
+  bool trim{false};  // crop tiles to their opaque pixels, with a manifest
+  bool watch{false};  // keep converting as the inputs change
+  bool stats{false};    // print per-stage timings after the run
+  std::filesystem::path stats_json{};  // when set, write them here as JSON
+  std::filesystem::path trace{};  // when set, write a Chrome trace here
   std::optional<std::uint8_t> shade_index{};
+  std::size_t jobs{0};  // 0 selects std::thread::hardware_concurrency()
 };
 
 std::expected<art2img::core::ImageFormat, std::string> parse_format(
     std::string_view text);
 
+/// Resolves `--input` arguments to ART files. Each argument is a file, a
+/// directory (every *.ART inside it) or a pattern with `*`/`?` in its file
+/// name; directories and patterns match case-insensitively and expand in
+/// name order. Repeated files are kept once. Inputs whose stems match,
+/// ignoring case, are rejected since their outputs would share names.
+std::expected<std::vector<std::filesystem::path>, std::string> expand_inputs(
+    const std::vector<std::string>& arguments);
+
+/// Resolves `--input` arguments against the entries of `grp`: exact entry
+/// names or case-insensitive `*`/`?` patterns, in directory order, with the
+/// same check on stems as expand_inputs.
+std::expected<std::vector<std::filesystem::path>, std::string>
+expand_grp_inputs(const art2img::adapters::GrpFile& grp,
+                  const std::vector<std::string>& arguments);
+
 }  // namespace art2img::cli
\ No newline at end of file
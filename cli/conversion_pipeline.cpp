@@ -1,7 +1,12 @@
 #include "conversion_pipeline.hpp"
 
+#include <filesystem>
 #include <format>
-#include <span>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
 
 #include <art2img/adapters/io.hpp>
 #include <art2img/core/convert.hpp>
@@ -9,45 +14,161 @@
 
 namespace art2img::cli {
 
-std::expected<void, art2img::core::Error> convert_tile(
-    std::size_t index,
-    const art2img::core::TileView& tile,
-    const std::filesystem::path& output_dir,
-    const CliConfig& config,
-    art2img::core::PaletteView palette,
-    art2img::core::ImageFormat format)
+art2img::core::ConversionOptions conversion_options(const CliConfig& config)
 {
-  art2img::core::ConversionOptions convert_opts{
+  return art2img::core::ConversionOptions{
       .apply_lookup = config.apply_lookup,
       .shade_index = config.shade_index,
       .fix_transparency = config.fix_transparency,
       .premultiply_alpha = config.premultiply_alpha,
       .matte_hygiene = config.sanitize_matte};
-  auto image_result =
-      art2img::core::palette_to_rgba(tile, palette, convert_opts);
-  if (!image_result) {
-    return std::unexpected(image_result.error());
+}
+
+std::expected<void, art2img::core::Error> ZipOutput::add(
+    std::string_view name,
+    std::span<const std::byte> data)
+{
+  const std::lock_guard lock(mutex_);
+  return writer_.add(name, data);
+}
+
+std::expected<std::size_t, art2img::core::Error> ZipOutput::finish()
+{
+  const std::lock_guard lock(mutex_);
+  return writer_.finish();
+}
+
+namespace {
+
+std::expected<std::size_t, art2img::core::Error> encode_to_sink(
+    const art2img::core::RgbaImageView& view,
+    art2img::core::ImageFormat format,
+    const art2img::core::EncodeSink& sink)
+{
+  return art2img::core::encode_image_to(view, format, sink);
+}
+
+std::expected<std::size_t, art2img::core::Error> encode_to_sink(
+    const art2img::core::IndexedImageView& view,
+    art2img::core::ImageFormat format,
+    const art2img::core::EncodeSink& sink)
+{
+  return art2img::core::encode_indexed_image_to(view, format, sink);
+}
+
+template <typename View>
+std::expected<void, art2img::core::Error> write_tile(
+    std::size_t index,
+    const TileOutput& output,
+    const std::string& filename,
+    const View& view,
+    art2img::core::ImageFormat format)
+{
+  const bool to_directory = output.zip == nullptr && !output.deliver;
+  if (to_directory) {
+    // A --dedupe run may have left this name hardlinked to another tile;
+    // unlinking first keeps the rewrite from reaching through to it.
+    std::error_code ignored;
+    std::filesystem::remove(output.directory / filename, ignored);
+  }
+
+  if (to_directory && output.writer != nullptr) {
+    // The encoded file is handed to the write-behind queue, which reports
+    // the outcome under the tile index once it reaches the disk.
+    std::vector<std::byte> encoded;
+    encoded.reserve(art2img::core::estimate_encoded_size(view, format));
+    auto written = encode_to_sink(
+        view, format, [&encoded](std::span<const std::byte> chunk) {
+          encoded.insert(encoded.end(), chunk.begin(), chunk.end());
+          return true;
+        });
+    if (!written) {
+      return std::unexpected(written.error());
+    }
+    output.writer->submit(index, output.directory / filename,
+                          std::move(encoded));
+    return {};
+  }
+
+  if (to_directory) {
+    auto written = art2img::adapters::encode_to_file(
+        output.directory / filename, view, format);
+    if (!written) {
+      return std::unexpected(written.error());
+    }
+    return {};
   }
 
-  const auto view = art2img::core::make_view(*image_result);
-  auto encoded = art2img::core::encode_image(view, format,
-                                             art2img::core::EncoderOptions{});
-  if (!encoded) {
-    return std::unexpected(encoded.error());
+  // Each worker encodes into its own reusable buffer, so only the append
+  // itself is serialised; a delivery sees that buffer directly.
+  thread_local std::vector<std::byte> encoded;
+  encoded.clear();
+  auto written = encode_to_sink(
+      view, format, [](std::span<const std::byte> chunk) {
+        encoded.insert(encoded.end(), chunk.begin(), chunk.end());
+        return true;
+      });
+  if (!written) {
+    return std::unexpected(written.error());
+  }
+  if (output.deliver) {
+    return output.deliver(index, encoded);
+  }
+  return output.zip->add(filename, encoded);
+}
+
+}  // namespace
+
+std::string tile_filename(std::string_view stem,
+                          std::size_t index,
+                          art2img::core::ImageFormat format)
+{
+  return std::format("{}_{:04}.{}", stem, index,
+                     art2img::core::file_extension(format));
+}
+
+std::expected<void, art2img::core::Error> convert_tile(
+    std::size_t index,
+    const art2img::core::TileView& tile,
+    const TileOutput& output,
+    const CliConfig& config,
+    const art2img::core::PreparedPalette& palette,
+    art2img::core::ImageFormat format,
+    art2img::core::ConversionWorkspace& workspace,
+    std::optional<art2img::core::ImageRect> crop)
+{
+  const auto filename = tile_filename(output.stem, index, format);
+
+  if (config.indexed) {
+    const auto indices = workspace.pixel_buffer(
+        static_cast<std::size_t>(tile.width) * tile.height);
+    auto converted =
+        art2img::core::palette_to_indices_into(tile, palette, indices);
+    if (!converted) {
+      return std::unexpected(converted.error());
+    }
+
+    const art2img::core::IndexedImageView view{indices, palette.colors,
+                                               tile.width, tile.height,
+                                               tile.width};
+    return write_tile(index, output, filename,
+                      crop ? art2img::core::crop_view(view, *crop) : view,
+                      format);
   }
 
-  const auto extension = art2img::core::file_extension(format);
-  const auto filename = std::format(
-      "{}_{:04}.{}", config.input_art.stem().string(), index, extension);
-  const auto output_path = output_dir / filename;
-  auto bytes =
-      std::span<const std::byte>(encoded->bytes.data(), encoded->bytes.size());
-  auto write_result = art2img::adapters::write_file(output_path, bytes);
-  if (!write_result) {
-    return std::unexpected(write_result.error());
+  const auto pixels = workspace.pixel_buffer(
+      static_cast<std::size_t>(tile.width) * tile.height * 4);
+  auto converted =
+      art2img::core::palette_to_rgba_into(tile, palette, pixels, workspace);
+  if (!converted) {
+    return std::unexpected(converted.error());
   }
 
-  return {};
+  const art2img::core::RgbaImageView view{pixels, tile.width, tile.height,
+                                          tile.width * 4u};
+  return write_tile(index, output, filename,
+                    crop ? art2img::core::crop_view(view, *crop) : view,
+                    format);
 }
 
 }  // namespace art2img::cli
\ No newline at end of file
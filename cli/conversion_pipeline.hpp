@@ -3,8 +3,16 @@
 #include <cstddef>
 #include <expected>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <span>
+#include <string>
+#include <string_view>
+#include <utility>
 
+#include <art2img/adapters/write_queue.hpp>
+#include <art2img/adapters/zip.hpp>
 #include <art2img/core/convert.hpp>
 #include <art2img/core/encode.hpp>
 #include <art2img/core/error.hpp>
@@ -14,12 +22,61 @@
 
 namespace art2img::cli {
 
+art2img::core::ConversionOptions conversion_options(const CliConfig& config);
+
+/// Stored ZIP shared by every worker of a run; appends are serialised, so
+/// entries land in completion order.
+class ZipOutput {
+ public:
+  explicit ZipOutput(art2img::adapters::ZipWriter writer)
+      : writer_(std::move(writer))
+  {
+  }
+
+  std::expected<void, art2img::core::Error> add(
+      std::string_view name,
+      std::span<const std::byte> data);
+
+  std::expected<std::size_t, art2img::core::Error> finish();
+
+ private:
+  std::mutex mutex_{};
+  art2img::adapters::ZipWriter writer_;
+};
+
+/// Receives a tile's encoded bytes, which are only valid during the call.
+using TileDelivery = std::function<std::expected<void, art2img::core::Error>(
+    std::size_t index,
+    std::span<const std::byte> encoded)>;
+
+/// Where convert_tile puts encoded tiles: tile_filename files under
+/// `directory`, entries of `zip` when it is set, or straight to `deliver`
+/// when that is set. With a `writer` the files are written behind conversion
+/// and their errors arrive through the queue's completion, tagged with the
+/// tile index.
+struct TileOutput {
+  std::filesystem::path directory{};
+  std::string stem{};
+  ZipOutput* zip = nullptr;
+  art2img::adapters::WriteQueue* writer = nullptr;
+  TileDelivery deliver{};
+};
+
+/// `<stem>_<index>.<ext>`, the name every per-tile output is written under.
+std::string tile_filename(std::string_view stem,
+                          std::size_t index,
+                          art2img::core::ImageFormat format);
+
+/// Converts and writes one tile; with `crop` only that part of it is
+/// encoded.
 std::expected<void, art2img::core::Error> convert_tile(
     std::size_t index,
     const art2img::core::TileView& tile,
-    const std::filesystem::path& output_dir,
+    const TileOutput& output,
     const CliConfig& config,
-    art2img::core::PaletteView palette,
-    art2img::core::ImageFormat format);
+    const art2img::core::PreparedPalette& palette,
+    art2img::core::ImageFormat format,
+    art2img::core::ConversionWorkspace& workspace,
+    std::optional<art2img::core::ImageRect> crop = std::nullopt);
 
 }  // namespace art2img::cli
\ No newline at end of file
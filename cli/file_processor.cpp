@@ -1,60 +1,476 @@
 #include "file_processor.hpp"
 
+#include <cstdint>
+#include <format>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
 #include <art2img/adapters/io.hpp>
+#include <art2img/adapters/meta_serialization.hpp>
+#include <art2img/adapters/zip.hpp>
 #include <art2img/core/art.hpp>
+#include <art2img/core/hash.hpp>
 #include <art2img/core/palette.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/atlas.hpp>
+#include <art2img/extras/dedupe.hpp>
+#include <art2img/extras/parallel.hpp>
 
 #include "progress_reporter.hpp"
 
 namespace art2img::cli {
 
-std::expected<FileProcessingResult, art2img::core::Error> process_art_file(
+namespace {
+
+std::expected<FileProcessingResult, art2img::core::Error> write_atlas(
     const CliConfig& config,
+    const std::string& stem,
+    const art2img::core::ArtArchive& art,
+    const art2img::core::Palette& palette,
     art2img::core::ImageFormat format)
 {
-  auto art_bytes = art2img::adapters::read_binary_file(config.input_art);
-  if (!art_bytes) {
-    return std::unexpected(art_bytes.error());
+  art2img::extras::AtlasRequest request{};
+  request.archive = &art;
+  request.palette = &palette;
+  request.format = format;
+  request.conversion = conversion_options(config);
+  request.atlas.max_size = config.atlas_size;
+  request.parallel.threads = config.jobs;
+
+  auto atlas = art2img::extras::build_atlas(request);
+  if (!atlas) {
+    return std::unexpected(atlas.error());
+  }
+
+  const auto extension = art2img::core::file_extension(format);
+  for (std::size_t i = 0; i < atlas->pages.size(); ++i) {
+    auto& page = atlas->manifest.pages[i];
+    page.image = std::format("{}_atlas_{}.{}", stem, i, extension);
+    auto written = art2img::adapters::write_file(config.output_dir / page.image,
+                                                 atlas->pages[i].bytes);
+    if (!written) {
+      return std::unexpected(written.error());
+    }
+  }
+
+  auto manifest = art2img::adapters::format_atlas_json(atlas->manifest);
+  if (!manifest) {
+    return std::unexpected(manifest.error());
+  }
+  auto written = art2img::adapters::write_file(
+      config.output_dir / std::format("{}_atlas.json", stem),
+      std::as_bytes(std::span{*manifest}));
+  if (!written) {
+    return std::unexpected(written.error());
+  }
+
+  return FileProcessingResult{atlas->manifest.entries.size(), 0};
+}
+
+/// The part of `tile` --trim keeps. A tile with nothing visible still needs
+/// an image, so it keeps its top-left pixel.
+art2img::core::ImageRect trim_rect(const art2img::core::TileView& tile,
+                                   const art2img::core::PreparedPalette& palette)
+{
+  const auto bounds = art2img::core::opaque_bounds(tile, palette);
+  return bounds.empty() ? art2img::core::ImageRect{0, 0, 1, 1} : bounds;
+}
+
+std::expected<void, art2img::core::Error> write_trim_manifest(
+    const CliConfig& config,
+    const std::string& stem,
+    const art2img::core::ArtArchive& art,
+    art2img::core::ImageFormat format,
+    std::span<const std::optional<art2img::core::ImageRect>> crops)
+{
+  art2img::core::TrimManifest manifest{};
+  manifest.tile_start = art.tile_start;
+  for (std::size_t i = 0; i < crops.size(); ++i) {
+    if (!crops[i]) {
+      continue;
+    }
+    const auto& metrics = art.layout[i];
+    manifest.entries.push_back(art2img::core::TrimEntry{
+        .tile = i,
+        .image = tile_filename(stem, i, format),
+        .width = metrics.width,
+        .height = metrics.height,
+        .x = crops[i]->x,
+        .y = crops[i]->y,
+        .trimmed_width = crops[i]->width,
+        .trimmed_height = crops[i]->height,
+        .origin_x = metrics.offset_x,
+        .origin_y = metrics.offset_y});
   }
 
-  auto art = art2img::core::load_art(
-      std::span<const std::byte>(art_bytes->data(), art_bytes->size()));
-  if (!art) {
-    return std::unexpected(art.error());
+  auto text = art2img::adapters::format_trim_json(manifest);
+  if (!text) {
+    return std::unexpected(text.error());
   }
+  auto written = art2img::adapters::write_file(
+      config.output_dir / std::format("{}_trim.json", stem),
+      std::as_bytes(std::span{*text}));
+  if (!written) {
+    return std::unexpected(written.error());
+  }
+  return {};
+}
 
-  auto palette_bytes = art2img::adapters::read_binary_file(config.palette_path);
-  if (!palette_bytes) {
-    return std::unexpected(palette_bytes.error());
+std::expected<std::span<const std::byte>, art2img::core::Error> find_entry(
+    const art2img::adapters::GrpFile& grp,
+    const std::filesystem::path& name)
+{
+  const auto entry = grp.entry(name.string());
+  if (!entry) {
+    return std::unexpected(
+        art2img::core::make_error(art2img::core::errc::io_failure,
+                                  "no GRP entry named: " + name.string()));
   }
+  return entry->data;
+}
 
-  auto palette = art2img::core::load_palette(
-      std::span<const std::byte>(palette_bytes->data(), palette_bytes->size()));
+/// Gives `copy` the bytes of `source`: a hardlink where the filesystem
+/// allows one, a plain copy otherwise.
+std::expected<void, art2img::core::Error> link_duplicate(
+    const std::filesystem::path& source,
+    const std::filesystem::path& copy)
+{
+  std::error_code error;
+  std::filesystem::remove(copy, error);
+  std::filesystem::create_hard_link(source, copy, error);
+  if (error) {
+    error.clear();
+    std::filesystem::copy_file(
+        source, copy, std::filesystem::copy_options::overwrite_existing, error);
+  }
+  if (error) {
+    return std::unexpected(art2img::core::make_error(
+        art2img::core::errc::io_failure,
+        "failed to link file: " + copy.string() + ": " + error.message()));
+  }
+  return {};
+}
+
+}  // namespace
+
+std::expected<SharedPalette, art2img::core::Error> load_shared_palette(
+    const CliConfig& config,
+    const art2img::adapters::GrpFile* grp)
+{
+  // A palette is a few kilobytes and parsed straight into its own storage,
+  // so a plain read is as cheap as mapping and never sees the file change.
+  std::vector<std::byte> bytes;
+  std::span<const std::byte> data;
+  if (grp != nullptr) {
+    auto entry = find_entry(*grp, config.palette_path);
+    if (!entry) {
+      return std::unexpected(entry.error());
+    }
+    data = *entry;
+  }
+  else {
+    auto read = art2img::adapters::read_binary_file(config.palette_path);
+    if (!read) {
+      return std::unexpected(read.error());
+    }
+    bytes = std::move(*read);
+    data = bytes;
+  }
+
+  auto palette = art2img::core::load_palette(data);
   if (!palette) {
     return std::unexpected(palette.error());
   }
 
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(*palette), conversion_options(config));
+  if (!prepared) {
+    return std::unexpected(prepared.error());
+  }
+
+  return SharedPalette{std::move(*palette), *prepared};
+}
+
+std::expected<art2img::core::ArtArchive, art2img::core::Error> load_art_file(
+    const std::filesystem::path& path,
+    const art2img::adapters::GrpFile* grp)
+{
+  if (grp != nullptr) {
+    auto entry = find_entry(*grp, path);
+    if (!entry) {
+      return std::unexpected(entry.error());
+    }
+    return art2img::core::load_art_borrowed(*entry);
+  }
+
+  // The archive holds on to the mapping, so tiles are read straight from the
+  // page cache rather than copied into a private buffer.
+  auto art_file = art2img::adapters::map_file(path);
+  if (!art_file) {
+    return std::unexpected(art_file.error());
+  }
+
+  return art2img::core::load_art(art_file->handle, art_file->data);
+}
+
+std::expected<art2img::core::ArtArchive, art2img::core::Error> read_art_file(
+    const std::filesystem::path& path)
+{
+  auto bytes = art2img::adapters::read_binary_file(path);
+  if (!bytes) {
+    return std::unexpected(bytes.error());
+  }
+  return art2img::core::load_art(std::move(*bytes));
+}
+
+std::expected<art2img::adapters::GrpFile, art2img::core::Error> read_grp_file(
+    const std::filesystem::path& path)
+{
+  auto bytes = art2img::adapters::read_binary_file(path);
+  if (!bytes) {
+    return std::unexpected(bytes.error());
+  }
+  auto owner =
+      std::make_shared<const std::vector<std::byte>>(std::move(*bytes));
+  return art2img::adapters::load_grp(owner, *owner);
+}
+
+std::expected<FileProcessingResult, art2img::core::Error> process_art_file(
+    const CliConfig& config,
+    const std::filesystem::path& input_art,
+    const art2img::core::ArtArchive& art,
+    const SharedPalette& palette,
+    art2img::core::ImageFormat format,
+    TileCache* cache)
+{
+  const auto stem = input_art.stem().string();
   std::filesystem::create_directories(config.output_dir);
-  const auto palette_view = art2img::core::view_palette(*palette);
+  if (config.atlas) {
+    return write_atlas(config, stem, art, palette.palette, format);
+  }
+
+  TileOutput output{config.output_dir, stem};
+  std::optional<ZipOutput> zip;
+  if (config.zip) {
+    auto writer = art2img::adapters::create_zip(
+        config.output_dir / std::format("{}.zip", stem));
+    if (!writer) {
+      return std::unexpected(writer.error());
+    }
+    output.zip = &zip.emplace(std::move(*writer));
+  }
+
+  const auto total = art2img::core::tile_count(art);
+  std::vector<std::optional<art2img::core::Error>> errors(total);
+
+  // Incremental runs fingerprint each tile against everything else that
+  // shapes its output; zip archives are always rewritten whole.
+  if (zip) {
+    cache = nullptr;
+  }
+  const auto settings =
+      cache != nullptr
+          ? art2img::core::settings_fingerprint(
+                palette.prepared, format, art2img::core::EncoderOptions{},
+                (config.indexed ? 1 : 0) | (config.trim ? 2 : 0))
+          : 0;
+  enum TileState : std::uint8_t { pending, written, unchanged, duplicate };
+  std::vector<std::uint64_t> fingerprints(cache != nullptr ? total : 0);
+  std::vector<TileState> states(total, pending);
+  // With --trim every tile's crop is found, converted or not, so the
+  // manifest always covers the whole archive.
+  std::vector<std::optional<art2img::core::ImageRect>> crops(
+      config.trim ? total : 0);
+
+  std::vector<std::size_t> tiles(total);
+  std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+
+  // With --dedupe only the first of each group of identical tiles is
+  // converted; the others are linked to its file once it is on disk.
+  std::vector<std::size_t> canonical;
+  if (config.dedupe && !zip) {
+    canonical = art2img::extras::find_duplicate_tiles(art, tiles);
+  }
+
+  std::optional<art2img::adapters::WriteQueue> writer;
+  if (!zip && config.write_behind_mb > 0) {
+    art2img::adapters::WriteQueueOptions options{};
+    options.max_pending_bytes = config.write_behind_mb << 20;
+    output.writer = &writer.emplace(
+        [&errors](std::size_t index,
+                  std::expected<void, art2img::core::Error> result) {
+          if (!result) {
+            errors[index] = std::move(result.error());
+          }
+        },
+        options);
+  }
+
+  // Tiles are independent, so they are spread across a worker pool with the
+  // largest tiles scheduled first. Errors are collected per tile and reported
+  // in tile order once every worker has finished, keeping the output
+  // identical to a serial run.
+  const art2img::extras::ParallelOptions parallel{.threads = config.jobs};
+  const auto order = art2img::extras::largest_first(art, tiles);
+
+  std::vector<art2img::core::ConversionWorkspace> workspaces(
+      art2img::extras::resolve_thread_count(parallel.threads, total));
+  art2img::extras::for_each_index(
+      order, parallel, [&](std::size_t i, std::size_t slot) {
+        const art2img::core::ScopedStageTag tag(i);
+        auto tile = art2img::core::get_tile(art, i);
+        if (!tile) {
+          return true;
+        }
+        if (config.trim) {
+          crops[i] = trim_rect(*tile, palette.prepared);
+        }
+
+        if (cache != nullptr) {
+          fingerprints[i] = art2img::core::tile_fingerprint(*tile, settings);
+          if (cache->up_to_date(tile_filename(stem, i, format),
+                                fingerprints[i])) {
+            states[i] = unchanged;
+            return true;
+          }
+        }
+        if (!canonical.empty() && canonical[i] != i) {
+          states[i] = duplicate;
+          return true;
+        }
+
+        auto result =
+            convert_tile(i, *tile, output, config, palette.prepared, format,
+                         workspaces[slot],
+                         config.trim ? crops[i] : std::nullopt);
+        if (!result) {
+          errors[i] = std::move(result.error());
+        }
+        else {
+          states[i] = written;
+        }
+        return true;
+      });
+
+  if (writer) {
+    writer->drain();
+  }
+  for (std::size_t i = 0; i < total; ++i) {
+    if (states[i] != duplicate) {
+      continue;
+    }
+    const auto source = canonical[i];
+    if (errors[source]) {
+      errors[i] = errors[source];
+      continue;
+    }
+    auto linked =
+        link_duplicate(config.output_dir / tile_filename(stem, source, format),
+                       config.output_dir / tile_filename(stem, i, format));
+    if (!linked) {
+      errors[i] = std::move(linked.error());
+    }
+    else {
+      states[i] = written;
+    }
+  }
+  if (zip) {
+    auto finished = zip->finish();
+    if (!finished) {
+      return std::unexpected(finished.error());
+    }
+  }
 
-  const auto total = art2img::core::tile_count(*art);
-  std::size_t failures = 0;
+  if (config.trim) {
+    auto manifest = write_trim_manifest(config, stem, art, format, crops);
+    if (!manifest) {
+      return std::unexpected(manifest.error());
+    }
+  }
 
+  FileProcessingResult result{total, 0};
   for (std::size_t i = 0; i < total; ++i) {
-    auto tile = art2img::core::get_tile(*art, i);
-    if (!tile) {
+    if (errors[i]) {
+      ++result.failures;
+      report_conversion_error(i, *errors[i]);
+    }
+    else if (states[i] == unchanged) {
+      ++result.unchanged;
+    }
+    else if (states[i] == written && cache != nullptr) {
+      cache->record(tile_filename(stem, i, format), fingerprints[i]);
+    }
+  }
+
+  return result;
+}
+
+bool process_art_files(const CliConfig& config,
+                       const SharedPalette& palette,
+                       art2img::core::ImageFormat format,
+                       const FileReport& report,
+                       const art2img::adapters::GrpFile* grp)
+{
+  const auto load = [grp](const std::filesystem::path& path) {
+    auto art = load_art_file(path, grp);
+    if (art) {
+      // Touch every page here so the converting workers never stall on disk.
+      [[maybe_unused]] volatile std::byte sink{};
+      for (std::size_t i = 0; i < art->raw.size(); i += 4096) {
+        sink = art->raw[i];
+      }
+    }
+    return art;
+  };
+
+  std::optional<TileCache> cache;
+  if (config.incremental && !config.atlas && !config.zip) {
+    cache = TileCache::load(config.output_dir);
+  }
+
+  bool succeeded = true;
+  std::future<std::expected<art2img::core::ArtArchive, art2img::core::Error>>
+      next;
+  if (!config.inputs.empty()) {
+    next = std::async(std::launch::async, load, config.inputs.front());
+  }
+
+  for (std::size_t i = 0; i < config.inputs.size(); ++i) {
+    auto art = next.get();
+    if (i + 1 < config.inputs.size()) {
+      next = std::async(std::launch::async, load, config.inputs[i + 1]);
+    }
+
+    if (!art) {
+      succeeded = false;
+      report(config.inputs[i], std::unexpected(art.error()));
       continue;
     }
 
-    auto result =
-        convert_tile(i, *tile, config.output_dir, config, palette_view, format);
-    if (!result) {
-      ++failures;
-      report_conversion_error(i, result.error());
+    const auto result = process_art_file(config, config.inputs[i], *art,
+                                         palette, format,
+                                         cache ? &*cache : nullptr);
+    succeeded = succeeded && result && result->failures == 0;
+    report(config.inputs[i], result);
+  }
+
+  if (cache) {
+    auto saved = cache->save();
+    if (!saved) {
+      report(config.output_dir / TileCache::file_name,
+             std::unexpected(saved.error()));
+      succeeded = false;
     }
   }
 
-  return FileProcessingResult{total, failures};
+  return succeeded;
 }
 
-}  // namespace art2img::cli
\ No newline at end of file
+}  // namespace art2img::cli
@@ -3,23 +3,77 @@
 #include <cstddef>
 #include <expected>
 #include <filesystem>
+#include <functional>
 
+#include <art2img/adapters/grp.hpp>
 #include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
 #include <art2img/core/error.hpp>
 #include <art2img/core/palette.hpp>
 
 #include "config_parser.hpp"
 #include "conversion_pipeline.hpp"
+#include "tile_cache.hpp"
 
 namespace art2img::cli {
 
 struct FileProcessingResult {
   std::size_t total_tiles;
   std::size_t failures;
+  std::size_t unchanged = 0;  // skipped by an incremental run
 };
 
+/// Palette state shared by every input of a run, so it is read and prepared
+/// once rather than per ART file.
+struct SharedPalette {
+  art2img::core::Palette palette;
+  art2img::core::PreparedPalette prepared;
+};
+
+/// Paths passed with a non-null `grp` name entries of that GRP, which are
+/// viewed in place; `grp` must outlive whatever is loaded from it.
+std::expected<SharedPalette, art2img::core::Error> load_shared_palette(
+    const CliConfig& config,
+    const art2img::adapters::GrpFile* grp = nullptr);
+
+/// Maps and parses one ART file. The archive keeps the mapping alive.
+std::expected<art2img::core::ArtArchive, art2img::core::Error> load_art_file(
+    const std::filesystem::path& path,
+    const art2img::adapters::GrpFile* grp = nullptr);
+
+/// Reads one ART file into memory the archive owns. Nothing stays mapped,
+/// so the file may be rewritten or truncated on disk while the archive is in
+/// use; the long-running modes load this way.
+std::expected<art2img::core::ArtArchive, art2img::core::Error> read_art_file(
+    const std::filesystem::path& path);
+
+/// Reads a whole GRP into memory the returned file owns, for the same reason.
+std::expected<art2img::adapters::GrpFile, art2img::core::Error> read_grp_file(
+    const std::filesystem::path& path);
+
+/// With a `cache`, tiles whose fingerprint and output file are unchanged are
+/// skipped, and every tile written successfully is recorded in it.
 std::expected<FileProcessingResult, art2img::core::Error> process_art_file(
     const CliConfig& config,
-    art2img::core::ImageFormat format);
+    const std::filesystem::path& input_art,
+    const art2img::core::ArtArchive& art,
+    const SharedPalette& palette,
+    art2img::core::ImageFormat format,
+    TileCache* cache = nullptr);
+
+using FileReport = std::function<void(
+    const std::filesystem::path&,
+    const std::expected<FileProcessingResult, art2img::core::Error>&)>;
+
+/// Converts every `config.inputs` file in order, calling `report` as each one
+/// finishes. The next file is read and parsed on a background thread while
+/// the current one converts. `config.incremental` loads the output
+/// directory's TileCache up front and saves it at the end. Returns false if
+/// any file or tile failed.
+bool process_art_files(const CliConfig& config,
+                       const SharedPalette& palette,
+                       art2img::core::ImageFormat format,
+                       const FileReport& report,
+                       const art2img::adapters::GrpFile* grp = nullptr);
 
-}  // namespace art2img::cli
\ No newline at end of file
+}  // namespace art2img::cli
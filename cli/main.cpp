@@ -1,8 +1,15 @@
 #include <CLI/CLI.hpp>
+#include <art2img/adapters/grp.hpp>
 #include <art2img/adapters/io.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/trace.hpp>
+#include <chrono>
+#include <span>
 #include "config_parser.hpp"
 #include "file_processor.hpp"
 #include "progress_reporter.hpp"
+#include "serve.hpp"
+#include "watch.hpp"
 
 int main(int argc, const char** argv)
 {
@@ -10,19 +17,22 @@ int main(int argc, const char** argv)
   art2img::cli::CliConfig config{};
   int shade = -1;
   bool disable_lookup = false, disable_transparency = false;
+  std::vector<std::string> inputs;
 
-  app.add_option("-i,--input", config.input_art, "Input ART file")
-      ->required()
-      ->check(CLI::ExistingFile);
+  app.add_option("-i,--input", inputs,
+                 "Input ART files, directories or wildcard patterns");
+
+  app.add_option("-p,--palette", config.palette_path, "Palette DAT file");
 
-  app.add_option("-p,--palette", config.palette_path, "Palette DAT file")
-      ->required()
+  app.add_option("--grp", config.grp_path,
+                 "Read ART and palette entries from a GRP archive")
       ->check(CLI::ExistingFile);
 
   app.add_option("-o,--output", config.output_dir,
                  "Directory where converted images are written");
 
-  app.add_option("-f,--format", config.format, "Output format (png|tga|bmp)");
+  app.add_option("-f,--format", config.format,
+                 "Output format (png|tga|bmp|dds|qoi)");
 
   app.add_flag("--no-lookup", disable_lookup, "Disable lookup remapping");
 
@@ -35,10 +45,72 @@ int main(int argc, const char** argv)
   app.add_flag("--matte", config.sanitize_matte,
                "Apply matte hygiene to semi-transparent pixels");
 
+  app.add_flag("--indexed", config.indexed,
+               "Write 8-bit paletted images straight from tile indices");
+
+  app.add_flag("--atlas", config.atlas,
+               "Pack all tiles into atlas pages with a JSON rect manifest");
+
+  app.add_option("--atlas-size", config.atlas_size,
+                 "Maximum atlas page width and height in pixels")
+      ->check(CLI::Range(1, 16384));
+
+  app.add_flag("--zip", config.zip,
+               "Write all images into one stored <input>.zip archive");
+
+  app.add_flag("--incremental", config.incremental,
+               "Skip tiles unchanged since the last run into this output "
+               "directory");
+
+  app.add_flag("--dedupe", config.dedupe,
+               "Convert identical tiles once and hardlink the other files "
+               "to it");
+
+  app.add_flag("--trim", config.trim,
+               "Crop each tile to its visible pixels and record the offsets "
+               "in <input>_trim.json");
+
+  app.add_flag("--watch", config.watch,
+               "After converting, keep watching the inputs and palette and "
+               "reconvert changed tiles until standard input ends");
+
+  app.add_option("--write-behind", config.write_behind_mb,
+                 "Megabytes of encoded output queued for background writing "
+                 "(0 writes synchronously)")
+      ->check(CLI::NonNegativeNumber);
+
+  app.add_flag("--stats", config.stats,
+               "Print per-stage timings and counters after the run");
+
+  app.add_option("--stats-json", config.stats_json,
+                 "Write per-stage timings and counters to a JSON file");
+
+  app.add_option("--trace", config.trace,
+                 "Write per-tile stage spans as a Chrome Trace Event file");
+
   app.add_option("--shade", shade, "Shade table index to apply (0-255)")
       ->check(CLI::Range(0, 255));
 
+  app.add_option("-j,--jobs", config.jobs,
+                 "Worker threads for tile conversion (default: all cores)")
+      ->check(CLI::NonNegativeNumber);
+
+  art2img::cli::ServeOptions serve_options{};
+  auto* serve = app.add_subcommand(
+      "serve", "Answer newline-delimited JSON jobs from stdin or a socket");
+  serve->add_option("--socket", serve_options.socket,
+                    "Listen on this Unix socket path instead of stdin");
+  serve->add_option("-j,--jobs", serve_options.jobs,
+                    "Worker threads running jobs (default: all cores)")
+      ->check(CLI::NonNegativeNumber);
+  serve->add_option("--cache-size", serve_options.cache_entries,
+                    "Archives and palettes each kept parsed between jobs")
+      ->check(CLI::NonNegativeNumber);
+
   CLI11_PARSE(app, argc, argv);
+  if (*serve) {
+    return art2img::cli::run_serve(serve_options);
+  }
   config.apply_lookup = !disable_lookup;
   config.fix_transparency = !disable_transparency;
 
@@ -51,14 +123,158 @@ int main(int argc, const char** argv)
     return 1;
   }
 
-  auto result = art2img::cli::process_art_file(config, *format_result);
-  if (!result) {
-    std::cerr << result.error().message << '\n';
+  if (config.indexed && config.sanitize_matte) {
+    std::cerr << "--indexed cannot be combined with --matte\n";
+    return 1;
+  }
+  if (config.indexed && (*format_result == art2img::core::ImageFormat::dds ||
+                         *format_result == art2img::core::ImageFormat::qoi)) {
+    std::cerr << "--indexed needs png, tga or bmp output\n";
+    return 1;
+  }
+  if (config.indexed && config.atlas) {
+    std::cerr << "--indexed cannot be combined with --atlas\n";
+    return 1;
+  }
+  if (config.trim && config.atlas) {
+    std::cerr << "--trim cannot be combined with --atlas\n";
+    return 1;
+  }
+  if (config.watch && (config.zip || config.atlas)) {
+    std::cerr << "--watch cannot be combined with --zip or --atlas\n";
+    return 1;
+  }
+  if (config.watch &&
+      (config.stats || !config.stats_json.empty() || !config.trace.empty())) {
+    std::cerr << "--watch cannot be combined with --stats, --stats-json or "
+                 "--trace\n";
+    return 1;
+  }
+  if (config.zip && config.atlas) {
+    std::cerr << "--zip cannot be combined with --atlas\n";
+    return 1;
+  }
+
+  // A GRP is mapped once and every input and the palette are viewed in place;
+  // --input and --palette then name entries and default to the usual ones.
+  // --watch holds it for as long as it runs, so it reads a copy instead that
+  // the file being rewritten on disk cannot pull out from under it.
+  std::optional<art2img::adapters::GrpFile> grp;
+  if (!config.grp_path.empty()) {
+    auto loaded =
+        [&]() -> std::expected<art2img::adapters::GrpFile,
+                               art2img::core::Error> {
+      if (config.watch) {
+        return art2img::cli::read_grp_file(config.grp_path);
+      }
+      auto grp_file = art2img::adapters::map_file(config.grp_path);
+      if (!grp_file) {
+        return std::unexpected(grp_file.error());
+      }
+      return art2img::adapters::load_grp(grp_file->handle, grp_file->data);
+    }();
+    if (!loaded) {
+      std::cerr << loaded.error().message << '\n';
+      return 1;
+    }
+    grp = std::move(*loaded);
+    if (inputs.empty()) {
+      inputs.push_back("*.ART");
+    }
+    if (config.palette_path.empty()) {
+      config.palette_path = "PALETTE.DAT";
+    }
+  }
+  else if (inputs.empty() || config.palette_path.empty()) {
+    std::cerr << "--input and --palette are required unless --grp is given\n";
+    return 1;
+  }
+
+  auto expanded = grp ? art2img::cli::expand_grp_inputs(*grp, inputs)
+                      : art2img::cli::expand_inputs(inputs);
+  if (!expanded) {
+    std::cerr << expanded.error() << '\n';
     return 1;
   }
+  config.inputs = std::move(*expanded);
 
-  art2img::cli::report_completion_summary(*result, config.input_art,
-                                          config.output_dir);
+  if (config.watch) {
+    return art2img::cli::run_watch(
+        config, *format_result, std::move(grp),
+        [&config](const std::filesystem::path& input, const auto& result) {
+          if (!result) {
+            art2img::cli::report_file_error(input, result.error());
+            return;
+          }
+          art2img::cli::report_completion_summary(*result, input,
+                                                  config.output_dir);
+        });
+  }
 
-  return result->failures > 0 ? 1 : 0;
+  const auto* grp_file = grp ? &*grp : nullptr;
+  auto palette = art2img::cli::load_shared_palette(config, grp_file);
+  if (!palette) {
+    std::cerr << palette.error().message << '\n';
+    return 1;
+  }
+
+  // Instrumentation stays off, at the cost of one atomic load per call, unless
+  // a report was asked for. A trace passes records on to the collector.
+  art2img::cli::RunStats run_stats{};
+  art2img::core::StatsCollector collector;
+  const bool collect_stats = config.stats || !config.stats_json.empty();
+  std::optional<art2img::extras::TraceRecorder> trace;
+  if (!config.trace.empty()) {
+    trace.emplace(collect_stats ? &collector : nullptr);
+    art2img::core::set_stats_sink(&*trace);
+  }
+  else if (collect_stats) {
+    art2img::core::set_stats_sink(&collector);
+  }
+  const auto started = std::chrono::steady_clock::now();
+
+  const bool succeeded = art2img::cli::process_art_files(
+      config, *palette, *format_result,
+      [&config, &run_stats](const std::filesystem::path& input,
+                            const auto& result) {
+        if (!result) {
+          art2img::cli::report_file_error(input, result.error());
+          return;
+        }
+        run_stats.tiles += result->total_tiles;
+        art2img::cli::report_completion_summary(*result, input,
+                                                config.output_dir);
+      },
+      grp_file);
+
+  art2img::core::set_stats_sink(nullptr);
+  const auto write_report = [](const std::filesystem::path& path,
+                               const std::string& text) {
+    auto written = art2img::adapters::write_file(
+        path, std::as_bytes(std::span{text.data(), text.size()}));
+    if (!written) {
+      std::cerr << written.error().message << '\n';
+    }
+    return written.has_value();
+  };
+  if (trace && !write_report(config.trace, trace->chrome_trace_json())) {
+    return 1;
+  }
+  if (!collect_stats) {
+    return succeeded ? 0 : 1;
+  }
+  run_stats.wall_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - started)
+          .count());
+  run_stats.stages = collector.totals();
+  if (config.stats) {
+    art2img::cli::report_stats(run_stats);
+  }
+  if (!config.stats_json.empty() &&
+      !write_report(config.stats_json,
+                    art2img::cli::format_stats_json(run_stats))) {
+    return 1;
+  }
+  return succeeded ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <format>
 #include <iostream>
+#include <string_view>
 
 namespace art2img::cli {
 
@@ -12,12 +13,25 @@ void report_conversion_error(std::size_t tile_index,
                            error.message);
 }
 
+void report_file_error(const std::filesystem::path& input_file,
+                       const art2img::core::Error& error)
+{
+  std::cerr << std::format("{}: {}\n", input_file.filename().string(),
+                           error.message);
+}
+
 void report_completion_summary(const FileProcessingResult& result,
                                const std::filesystem::path& input_file,
                                const std::filesystem::path& output_dir)
 {
   if (result.failures > 0) {
-    std::cerr << std::format("Completed with {} failures\n", result.failures);
+    std::cerr << std::format("Completed {} with {} failures\n",
+                             input_file.filename().string(), result.failures);
+  }
+  else if (result.unchanged > 0) {
+    std::cout << std::format(
+        "Converted {} tiles from {} to {} ({} unchanged)\n", result.total_tiles,
+        input_file.filename().string(), output_dir.string(), result.unchanged);
   }
   else {
     std::cout << std::format("Converted {} tiles from {} to {}\n",
@@ -31,4 +45,72 @@ void report_format_error(const std::string& error_message)
   std::cerr << error_message << '\n';
 }
 
+namespace {
+
+double per_second(double amount, std::uint64_t nanoseconds)
+{
+  return nanoseconds == 0 ? 0.0 : amount * 1e9 / nanoseconds;
+}
+
+double tiles_per_second(const RunStats& stats)
+{
+  return per_second(static_cast<double>(stats.tiles), stats.wall_ns);
+}
+
+// Encoded output over the time spent in the encoder, summed across workers.
+double encode_mb_per_second(const RunStats& stats)
+{
+  const auto& encode =
+      stats.stages[static_cast<std::size_t>(art2img::core::Stage::encode)];
+  return per_second(static_cast<double>(encode.bytes_out) / 1e6,
+                    encode.nanoseconds);
+}
+
+}  // namespace
+
+void report_stats(const RunStats& stats)
+{
+  std::cout << std::format("{:<12}{:>8}{:>12}{:>12}{:>12}{:>12}{:>8}\n",
+                           "stage", "calls", "ms", "pixels", "bytes in",
+                           "bytes out", "allocs");
+  for (std::size_t i = 0; i < stats.stages.size(); ++i) {
+    const auto& stage = stats.stages[i];
+    if (stage.calls == 0) {
+      continue;
+    }
+    std::cout << std::format(
+        "{:<12}{:>8}{:>12.3f}{:>12}{:>12}{:>12}{:>8}\n",
+        art2img::core::stage_name(static_cast<art2img::core::Stage>(i)),
+        stage.calls, static_cast<double>(stage.nanoseconds) / 1e6,
+        stage.pixels, stage.bytes_in, stage.bytes_out, stage.allocations);
+  }
+  std::cout << std::format(
+      "{} tiles in {:.3f} ms: {:.1f} tiles/s, encode {:.2f} MB/s\n",
+      stats.tiles, static_cast<double>(stats.wall_ns) / 1e6,
+      tiles_per_second(stats), encode_mb_per_second(stats));
+}
+
+std::string format_stats_json(const RunStats& stats)
+{
+  std::string json = std::format(
+      "{{\n  \"wall_ns\": {},\n  \"tiles\": {},\n"
+      "  \"tiles_per_second\": {:.3f},\n"
+      "  \"encode_mb_per_second\": {:.3f},\n  \"stages\": {{",
+      stats.wall_ns, stats.tiles, tiles_per_second(stats),
+      encode_mb_per_second(stats));
+  for (std::size_t i = 0; i < stats.stages.size(); ++i) {
+    const auto& stage = stats.stages[i];
+    json += std::format(
+        "{}\n    \"{}\": {{\"calls\": {}, \"nanoseconds\": {}, "
+        "\"pixels\": {}, \"bytes_in\": {}, \"bytes_out\": {}, "
+        "\"allocations\": {}}}",
+        i == 0 ? "" : ",",
+        art2img::core::stage_name(static_cast<art2img::core::Stage>(i)),
+        stage.calls, stage.nanoseconds, stage.pixels, stage.bytes_in,
+        stage.bytes_out, stage.allocations);
+  }
+  json += "\n  }\n}\n";
+  return json;
+}
+
 }  // namespace art2img::cli
\ No newline at end of file
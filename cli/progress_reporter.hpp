@@ -1,10 +1,14 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <expected>
 #include <filesystem>
 #include <string>
 
 #include <art2img/core/error.hpp>
+#include <art2img/core/stats.hpp>
 
 #include "file_processor.hpp"
 
@@ -12,9 +16,23 @@ namespace art2img::cli {
 
 void report_conversion_error(std::size_t tile_index,
                              const art2img::core::Error& error);
+void report_file_error(const std::filesystem::path& input_file,
+                       const art2img::core::Error& error);
 void report_completion_summary(const FileProcessingResult& result,
                                const std::filesystem::path& input_file,
                                const std::filesystem::path& output_dir);
 void report_format_error(const std::string& error_message);
 
+/// Per-stage totals from a run, with the wall time and tiles converted.
+struct RunStats {
+  std::array<art2img::core::StageTotals, art2img::core::stage_count> stages{};
+  std::uint64_t wall_ns = 0;
+  std::size_t tiles = 0;
+};
+
+/// The `--stats` table on stdout.
+void report_stats(const RunStats& stats);
+/// The `--stats-json` document: the same figures as one JSON object.
+std::string format_stats_json(const RunStats& stats);
+
 }  // namespace art2img::cli
\ No newline at end of file
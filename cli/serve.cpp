@@ -0,0 +1,980 @@
+#include "serve.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/error.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/extras/palette_cache.hpp>
+#include <art2img/extras/parallel.hpp>
+
+#include "config_parser.hpp"
+#include "conversion_pipeline.hpp"
+#include "file_processor.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace art2img::cli {
+
+namespace {
+
+// -- Requests --------------------------------------------------------------
+
+// Jobs are flat JSON objects; arrays may only hold numbers (tile indices).
+struct JsonField {
+  enum class Kind : std::uint8_t { null, boolean, number, string, array };
+  Kind kind = Kind::null;
+  std::string raw;   // the value as written, so ids echo back unchanged
+  std::string text;  // decoded, for strings
+  double number = 0;
+  bool boolean = false;
+  std::vector<double> numbers;
+};
+using JsonObject = std::map<std::string, JsonField, std::less<>>;
+
+class JsonReader {
+ public:
+  explicit JsonReader(std::string_view text) : text_(text) {}
+
+  std::expected<JsonObject, std::string> object()
+  {
+    JsonObject fields;
+    if (!consume('{')) {
+      return std::unexpected("job must be a JSON object");
+    }
+    if (!consume('}')) {
+      do {
+        auto key = string();
+        if (!key) {
+          return std::unexpected(key.error());
+        }
+        if (!consume(':')) {
+          return std::unexpected("expected ':' after object key");
+        }
+        auto field = value();
+        if (!field) {
+          return std::unexpected(field.error());
+        }
+        fields[std::move(*key)] = std::move(*field);
+      } while (consume(','));
+      if (!consume('}')) {
+        return std::unexpected("expected ',' or '}' in object");
+      }
+    }
+    skip_space();
+    if (pos_ != text_.size()) {
+      return std::unexpected("trailing characters after job");
+    }
+    return fields;
+  }
+
+ private:
+  void skip_space()
+  {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\r' ||
+            text_[pos_] == '\n')) {
+      ++pos_;
+    }
+  }
+
+  bool consume(char expected)
+  {
+    skip_space();
+    if (pos_ < text_.size() && text_[pos_] == expected) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  static void append_utf8(std::string& out, std::uint32_t code)
+  {
+    if (code < 0x80) {
+      out += static_cast<char>(code);
+    }
+    else if (code < 0x800) {
+      out += static_cast<char>(0xC0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+      out += static_cast<char>(0xE0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else {
+      out += static_cast<char>(0xF0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+  }
+
+  std::optional<std::uint32_t> hex4()
+  {
+    if (text_.size() - pos_ < 4) {
+      return std::nullopt;
+    }
+    std::uint32_t code = 0;
+    const auto* begin = text_.data() + pos_;
+    const auto parsed = std::from_chars(begin, begin + 4, code, 16);
+    if (parsed.ec != std::errc{} || parsed.ptr != begin + 4) {
+      return std::nullopt;
+    }
+    pos_ += 4;
+    return code;
+  }
+
+  std::expected<std::string, std::string> string()
+  {
+    if (!consume('"')) {
+      return std::unexpected("expected a string");
+    }
+    std::string out;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      const char c = text_[pos_++];
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (pos_ == text_.size()) {
+        break;
+      }
+      const char escape = text_[pos_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out += escape;
+          break;
+        case 'b':
+          out += '\b';
+          break;
+        case 'f':
+          out += '\f';
+          break;
+        case 'n':
+          out += '\n';
+          break;
+        case 'r':
+          out += '\r';
+          break;
+        case 't':
+          out += '\t';
+          break;
+        case 'u': {
+          auto code = hex4();
+          if (!code) {
+            return std::unexpected("invalid \\u escape");
+          }
+          // A high surrogate combines with the low one that follows it.
+          if (*code >= 0xD800 && *code < 0xDC00 &&
+              text_.substr(pos_, 2) == "\\u") {
+            pos_ += 2;
+            const auto low = hex4();
+            if (!low || *low < 0xDC00 || *low >= 0xE000) {
+              return std::unexpected("invalid \\u escape");
+            }
+            *code = 0x10000 + ((*code - 0xD800) << 10) + (*low - 0xDC00);
+          }
+          append_utf8(out, *code);
+          break;
+        }
+        default:
+          return std::unexpected("invalid string escape");
+      }
+    }
+    if (pos_ == text_.size()) {
+      return std::unexpected("unterminated string");
+    }
+    ++pos_;
+    return out;
+  }
+
+  std::expected<double, std::string> number()
+  {
+    // from_chars also takes inf and nan, which JSON has no spelling for and
+    // which would otherwise be echoed back verbatim as an id.
+    const auto rest = text_.substr(pos_);
+    const auto digits = rest.starts_with('-') ? rest.substr(1) : rest;
+    if (digits.empty() || digits.front() < '0' || digits.front() > '9') {
+      return std::unexpected("invalid number");
+    }
+    double value = 0;
+    const auto* begin = text_.data() + pos_;
+    const auto parsed =
+        std::from_chars(begin, text_.data() + text_.size(), value);
+    if (parsed.ec != std::errc{} || !std::isfinite(value)) {
+      return std::unexpected("invalid number");
+    }
+    pos_ += static_cast<std::size_t>(parsed.ptr - begin);
+    return value;
+  }
+
+  std::expected<JsonField, std::string> value()
+  {
+    skip_space();
+    JsonField field{};
+    const auto start = pos_;
+    const auto rest = text_.substr(pos_);
+    if (rest.starts_with('"')) {
+      auto text = string();
+      if (!text) {
+        return std::unexpected(text.error());
+      }
+      field.kind = JsonField::Kind::string;
+      field.text = std::move(*text);
+    }
+    else if (rest.starts_with('[')) {
+      ++pos_;
+      field.kind = JsonField::Kind::array;
+      if (!consume(']')) {
+        do {
+          skip_space();
+          auto element = number();
+          if (!element) {
+            return std::unexpected("arrays may only hold numbers");
+          }
+          field.numbers.push_back(*element);
+        } while (consume(','));
+        if (!consume(']')) {
+          return std::unexpected("expected ',' or ']' in array");
+        }
+      }
+    }
+    else if (rest.starts_with("true") || rest.starts_with("false")) {
+      field.kind = JsonField::Kind::boolean;
+      field.boolean = rest.starts_with("true");
+      pos_ += field.boolean ? 4 : 5;
+    }
+    else if (rest.starts_with("null")) {
+      pos_ += 4;
+    }
+    else {
+      auto parsed = number();
+      if (!parsed) {
+        return std::unexpected("unsupported JSON value");
+      }
+      field.kind = JsonField::Kind::number;
+      field.number = *parsed;
+    }
+    field.raw = std::string(text_.substr(start, pos_ - start));
+    return field;
+  }
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+};
+
+// -- Responses -------------------------------------------------------------
+
+std::string json_string(std::string_view text)
+{
+  std::string out = "\"";
+  for (const char c : text) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+        }
+        else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+  return out;
+}
+
+std::string base64(std::span<const std::byte> data)
+{
+  constexpr std::string_view alphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((data.size() + 2) / 3 * 4);
+  std::size_t i = 0;
+  for (; i + 3 <= data.size(); i += 3) {
+    const auto bits = std::to_integer<std::uint32_t>(data[i]) << 16 |
+                      std::to_integer<std::uint32_t>(data[i + 1]) << 8 |
+                      std::to_integer<std::uint32_t>(data[i + 2]);
+    out += alphabet[bits >> 18];
+    out += alphabet[(bits >> 12) & 0x3F];
+    out += alphabet[(bits >> 6) & 0x3F];
+    out += alphabet[bits & 0x3F];
+  }
+  if (i < data.size()) {
+    auto bits = std::to_integer<std::uint32_t>(data[i]) << 16;
+    if (i + 1 < data.size()) {
+      bits |= std::to_integer<std::uint32_t>(data[i + 1]) << 8;
+    }
+    out += alphabet[bits >> 18];
+    out += alphabet[(bits >> 12) & 0x3F];
+    out += i + 1 < data.size() ? alphabet[(bits >> 6) & 0x3F] : '=';
+    out += '=';
+  }
+  return out;
+}
+
+std::string error_response(std::string_view id, std::string_view message)
+{
+  return std::format("{{\"id\":{},\"ok\":false,\"error\":{}}}", id,
+                     json_string(message));
+}
+
+// -- Warm resources --------------------------------------------------------
+
+/// Parsed files keyed by path, size and modification time, so a file that
+/// changes on disk is parsed again. Holds up to `capacity` values, dropping
+/// the least recently used; a dropped value lives on with its holders.
+template <typename Value>
+class WarmCache {
+ public:
+  explicit WarmCache(std::size_t capacity) : capacity_(capacity) {}
+
+  template <typename Load>
+  std::expected<std::shared_ptr<const Value>, art2img::core::Error> get(
+      const std::filesystem::path& path,
+      Load&& load)
+  {
+    std::error_code size_error;
+    std::error_code time_error;
+    const auto size = std::filesystem::file_size(path, size_error);
+    const auto modified = std::filesystem::last_write_time(path, time_error);
+    if (size_error || time_error) {
+      return std::unexpected(
+          art2img::core::make_error(art2img::core::errc::io_failure,
+                                    "failed to open file: " + path.string()));
+    }
+    auto key = std::format("{}|{}|{}", path.string(), size,
+                           modified.time_since_epoch().count());
+
+    {
+      const std::lock_guard lock(mutex_);
+      const auto hit = std::find_if(
+          entries_.begin(), entries_.end(),
+          [&key](const Entry& entry) { return entry.key == key; });
+      if (hit != entries_.end()) {
+        std::rotate(hit, hit + 1, entries_.end());
+        return entries_.back().value;
+      }
+    }
+
+    // Parsed outside the lock so one slow file does not hold up jobs that
+    // hit the cache; two jobs racing on a new file may both parse it.
+    auto loaded = load(path);
+    if (!loaded) {
+      return std::unexpected(loaded.error());
+    }
+    auto value = std::make_shared<const Value>(std::move(*loaded));
+
+    const std::lock_guard lock(mutex_);
+    // Older versions of the same path can never hit again.
+    std::erase_if(entries_, [&path](const Entry& entry) {
+      return entry.path == path;
+    });
+    if (entries_.size() >= capacity_ && !entries_.empty()) {
+      entries_.erase(entries_.begin());
+    }
+    if (capacity_ > 0) {
+      entries_.push_back(Entry{std::move(key), path, value});
+    }
+    return value;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::filesystem::path path;
+    std::shared_ptr<const Value> value;
+  };
+
+  std::mutex mutex_{};
+  std::size_t capacity_;
+  std::vector<Entry> entries_{};  // least recently used first
+};
+
+/// Archives are read into memory rather than mapped, since a client may
+/// rewrite a file while a job is reading it. Palettes are small enough to
+/// read for every job and are shared by content.
+struct WarmResources {
+  explicit WarmResources(std::size_t capacity)
+      : archives(capacity), palettes(capacity)
+  {
+  }
+
+  WarmCache<art2img::core::ArtArchive> archives;
+  art2img::extras::PaletteCache palettes;
+};
+
+// -- Jobs ------------------------------------------------------------------
+
+const JsonField* find(const JsonObject& job, std::string_view key)
+{
+  const auto it = job.find(key);
+  return it == job.end() ? nullptr : &it->second;
+}
+
+// Applies the CLI flag a boolean job field stands for, if it is present.
+std::expected<void, std::string> read_flag(const JsonObject& job,
+                                           std::string_view key,
+                                           bool& flag)
+{
+  const auto* field = find(job, key);
+  if (field == nullptr || field->kind == JsonField::Kind::null) {
+    return {};
+  }
+  if (field->kind != JsonField::Kind::boolean) {
+    return std::unexpected(std::format("\"{}\" must be a boolean", key));
+  }
+  flag = field->boolean;
+  return {};
+}
+
+// JSON numbers arrive as doubles, which may be infinite, NaN or too large
+// for size_t; casting those is undefined, so they are rejected first. Every
+// integer up to 2^53 is exact in a double.
+std::optional<std::size_t> as_index(double value)
+{
+  constexpr double kLargestExact = 9007199254740992.0;  // 2^53
+  if (!std::isfinite(value) || value < 0 || value > kLargestExact ||
+      value != std::floor(value)) {
+    return std::nullopt;
+  }
+  return static_cast<std::size_t>(value);
+}
+
+/// Runs one job and returns its response line. Tiles go to files under
+/// "output" when it is given and come back base64-encoded otherwise.
+std::string run_job(const JsonObject& job,
+                    WarmResources& resources,
+                    art2img::core::ConversionWorkspace& workspace)
+{
+  const auto started = std::chrono::steady_clock::now();
+  const auto* id_field = find(job, "id");
+  const std::string id = id_field != nullptr ? id_field->raw : "null";
+
+  const auto* art_field = find(job, "art");
+  const auto* palette_field = find(job, "palette");
+  if (art_field == nullptr || art_field->kind != JsonField::Kind::string ||
+      palette_field == nullptr ||
+      palette_field->kind != JsonField::Kind::string) {
+    return error_response(id, "\"art\" and \"palette\" paths are required");
+  }
+
+  CliConfig config{};
+  const std::filesystem::path art_path = art_field->text;
+  config.palette_path = palette_field->text;
+  const auto* output_field = find(job, "output");
+  const bool inline_output = output_field == nullptr ||
+                             output_field->kind == JsonField::Kind::null;
+  if (!inline_output) {
+    if (output_field->kind != JsonField::Kind::string) {
+      return error_response(id, "\"output\" must be a directory path");
+    }
+    config.output_dir = output_field->text;
+  }
+  if (const auto* format = find(job, "format")) {
+    if (format->kind != JsonField::Kind::string) {
+      return error_response(id, "\"format\" must be a string");
+    }
+    config.format = format->text;
+  }
+  bool lookup = true;
+  bool transparency = true;
+  for (auto [key, flag] :
+       {std::pair<std::string_view, bool*>{"lookup", &lookup},
+        {"transparency", &transparency},
+        {"premultiply", &config.premultiply_alpha},
+        {"matte", &config.sanitize_matte},
+        {"indexed", &config.indexed}}) {
+    auto read = read_flag(job, key, *flag);
+    if (!read) {
+      return error_response(id, read.error());
+    }
+  }
+  config.apply_lookup = lookup;
+  config.fix_transparency = transparency;
+  if (const auto* shade = find(job, "shade");
+      shade != nullptr && shade->kind != JsonField::Kind::null) {
+    const auto index = shade->kind == JsonField::Kind::number
+                           ? as_index(shade->number)
+                           : std::nullopt;
+    if (!index || *index > 255) {
+      return error_response(id, "\"shade\" must be an index from 0 to 255");
+    }
+    config.shade_index = static_cast<std::uint8_t>(*index);
+  }
+  if (config.indexed && config.sanitize_matte) {
+    return error_response(id, "\"indexed\" cannot be combined with \"matte\"");
+  }
+
+  const auto format = parse_format(config.format);
+  if (!format) {
+    return error_response(id, format.error());
+  }
+  auto archive = resources.archives.get(art_path, read_art_file);
+  if (!archive) {
+    return error_response(id, archive.error().message);
+  }
+  const auto palette_bytes =
+      art2img::adapters::read_binary_file(config.palette_path);
+  if (!palette_bytes) {
+    return error_response(id, palette_bytes.error().message);
+  }
+  auto palette = resources.palettes.get(*palette_bytes);
+  if (!palette) {
+    return error_response(id, palette.error().message);
+  }
+  const auto prepared = art2img::core::prepare_palette(
+      **palette, conversion_options(config));
+  if (!prepared) {
+    return error_response(id, prepared.error().message);
+  }
+
+  const auto count = art2img::core::tile_count(**archive);
+  std::vector<std::size_t> tiles;
+  if (const auto* list = find(job, "tiles")) {
+    if (list->kind != JsonField::Kind::array) {
+      return error_response(id, "\"tiles\" must be an array of indices");
+    }
+    for (const auto value : list->numbers) {
+      const auto index = as_index(value);
+      if (!index || *index >= count) {
+        return error_response(id, "tile index out of range");
+      }
+      tiles.push_back(*index);
+    }
+  }
+  else if (const auto* single = find(job, "tile")) {
+    const auto index = single->kind == JsonField::Kind::number
+                           ? as_index(single->number)
+                           : std::nullopt;
+    if (!index || *index >= count) {
+      return error_response(id, "tile index out of range");
+    }
+    tiles.push_back(*index);
+  }
+  else {
+    tiles.resize(count);
+    std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+  }
+
+  if (!inline_output) {
+    std::error_code error;
+    std::filesystem::create_directories(config.output_dir, error);
+  }
+  TileOutput output{config.output_dir, art_path.stem().string()};
+  std::string data;
+  if (inline_output) {
+    output.deliver = [&data](std::size_t,
+                             std::span<const std::byte> encoded)
+        -> std::expected<void, art2img::core::Error> {
+      data = base64(encoded);
+      return {};
+    };
+  }
+
+  std::string entries;
+  for (const auto index : tiles) {
+    const auto& metrics = (*archive)->layout[index];
+    entries += std::format("{}{{\"tile\":{},\"width\":{},\"height\":{}",
+                           entries.empty() ? "" : ",", index, metrics.width,
+                           metrics.height);
+    // Empty tiles have nothing to encode and are listed without output.
+    const auto tile = art2img::core::get_tile(**archive, index);
+    if (tile) {
+      auto converted = convert_tile(index, *tile, output, config, *prepared,
+                                    *format, workspace);
+      if (!converted) {
+        return error_response(id, converted.error().message);
+      }
+      if (inline_output) {
+        entries += ",\"data\":\"" + data + '"';
+      }
+      else {
+        entries += ",\"file\":" +
+                   json_string((config.output_dir /
+                                tile_filename(output.stem, index, *format))
+                                   .string());
+      }
+    }
+    entries += '}';
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - started);
+  return std::format(
+      "{{\"id\":{},\"ok\":true,\"microseconds\":{},\"tiles\":[{}]}}", id,
+      elapsed.count(), entries);
+}
+
+// -- Worker pool -----------------------------------------------------------
+
+using Reply = std::function<void(const std::string& line)>;
+
+/// Fixed set of worker threads, each with its own conversion workspace,
+/// started once for the life of the server. A job's tiles run on the worker
+/// that took it, so concurrent jobs never wait on one another's tiles.
+class JobPool {
+ public:
+  JobPool(std::size_t threads, WarmResources& resources)
+      : resources_(resources)
+  {
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+  JobPool(const JobPool&) = delete;
+  JobPool& operator=(const JobPool&) = delete;
+
+  /// Finishes every queued job before returning.
+  ~JobPool()
+  {
+    {
+      const std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void submit(JsonObject job, Reply reply)
+  {
+    {
+      const std::lock_guard lock(mutex_);
+      queued_.push_back(Task{std::move(job), std::move(reply)});
+    }
+    work_ready_.notify_one();
+  }
+
+ private:
+  struct Task {
+    JsonObject job;
+    Reply reply;
+  };
+
+  void run()
+  {
+    art2img::core::ConversionWorkspace workspace;
+    while (true) {
+      std::unique_lock lock(mutex_);
+      work_ready_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+      if (queued_.empty()) {
+        return;
+      }
+      auto task = std::move(queued_.front());
+      queued_.pop_front();
+      lock.unlock();
+      task.reply(run_job(task.job, resources_, workspace));
+    }
+  }
+
+  WarmResources& resources_;
+  std::mutex mutex_{};
+  std::condition_variable work_ready_{};
+  std::deque<Task> queued_{};
+  bool stopping_ = false;
+  std::vector<std::thread> workers_{};
+};
+
+/// Parses one request line and queues it. Returns false when the line asks
+/// the server to shut down.
+bool handle_line(std::string_view line, JobPool& pool, const Reply& reply)
+{
+  if (line.ends_with('\r')) {
+    line.remove_suffix(1);
+  }
+  if (line.find_first_not_of(" \t") == std::string_view::npos) {
+    return true;
+  }
+  auto job = JsonReader(line).object();
+  if (!job) {
+    reply(error_response("null", job.error()));
+    return true;
+  }
+  if (const auto* op = find(*job, "op")) {
+    const auto* id = find(*job, "id");
+    if (op->kind == JsonField::Kind::string && op->text == "shutdown") {
+      reply(std::format("{{\"id\":{},\"ok\":true}}",
+                        id != nullptr ? id->raw : "null"));
+      return false;
+    }
+    return reply(error_response(id != nullptr ? id->raw : "null",
+                                "unknown op")),
+           true;
+  }
+  pool.submit(std::move(*job), reply);
+  return true;
+}
+
+int serve_stdin(JobPool& pool)
+{
+  auto output = std::make_shared<std::mutex>();
+  const Reply reply = [output](const std::string& line) {
+    const std::lock_guard lock(*output);
+    std::cout << line << '\n' << std::flush;
+  };
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!handle_line(line, pool, reply)) {
+      break;
+    }
+  }
+  return 0;
+}
+
+#ifndef _WIN32
+
+// A job is a few hundred bytes, or tens of kilobytes with a long tile list.
+constexpr std::size_t kMaxLineBytes = std::size_t{1} << 20;
+
+/// One client connection; the descriptor closes once the reader and every
+/// reply still queued for it are done.
+class Connection {
+ public:
+  explicit Connection(int fd) : fd_(fd) {}
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+  ~Connection() { ::close(fd_); }
+
+  int fd() const noexcept { return fd_; }
+
+  void send_line(const std::string& line)
+  {
+    const std::lock_guard lock(mutex_);
+    send_all(line.data(), line.size());
+    send_all("\n", 1);
+  }
+
+ private:
+  void send_all(const char* data, std::size_t size)
+  {
+#ifdef MSG_NOSIGNAL
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+    while (size > 0) {
+      const auto sent = ::send(fd_, data, size, flags);
+      if (sent < 0 && errno == EINTR) {
+        continue;
+      }
+      if (sent <= 0) {
+        return;  // the client went away; its replies are dropped
+      }
+      data += sent;
+      size -= static_cast<std::size_t>(sent);
+    }
+  }
+
+  int fd_;
+  std::mutex mutex_{};
+};
+
+int serve_socket(const std::filesystem::path& path, JobPool& pool)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  const auto name = path.string();
+  if (name.size() >= sizeof(address.sun_path)) {
+    std::cerr << "socket path too long: " << name << '\n';
+    return 1;
+  }
+  std::copy(name.begin(), name.end(), address.sun_path);
+
+  // A socket left behind by an earlier server is replaced; anything else at
+  // the path is left alone and bind reports it.
+  struct stat existing {};
+  if (::lstat(name.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+    ::unlink(name.c_str());
+  }
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 ||
+      ::bind(listener, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener, 16) != 0) {
+    std::cerr << "failed to listen on " << name << ": "
+              << std::generic_category().message(errno) << '\n';
+    if (listener >= 0) {
+      ::close(listener);
+    }
+    return 1;
+  }
+
+  std::mutex mutex;
+  bool stopping = false;
+  std::set<int> open_fds;
+  // Wakes the accept loop and every reader so the server can exit.
+  const auto stop = [&] {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+    ::shutdown(listener, SHUT_RDWR);
+    for (const int fd : open_fds) {
+      ::shutdown(fd, SHUT_RD);
+    }
+  };
+
+  // Readers are keyed by thread id so that each one can be joined as soon
+  // as it reports itself finished, rather than all at once on exit.
+  std::map<std::thread::id, std::thread> readers;
+  std::vector<std::thread::id> finished;
+  const auto reap = [&] {
+    std::vector<std::thread::id> done;
+    {
+      const std::lock_guard lock(mutex);
+      done.swap(finished);
+    }
+    for (const auto id : done) {
+      const auto reader = readers.find(id);
+      reader->second.join();
+      readers.erase(reader);
+    }
+  };
+
+  while (true) {
+    const int client = ::accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    reap();
+    const std::lock_guard lock(mutex);
+    if (stopping) {
+      ::close(client);
+      break;
+    }
+    open_fds.insert(client);
+
+    // The lock is still held, so the reader cannot report itself finished
+    // before it is in the map.
+    auto connection = std::make_shared<Connection>(client);
+    std::thread reader([&, connection] {
+      const Reply reply = [connection](const std::string& line) {
+        connection->send_line(line);
+      };
+      std::string pending;
+      std::array<char, 4096> buffer{};
+      bool open = true;
+      while (open) {
+        const auto received =
+            ::recv(connection->fd(), buffer.data(), buffer.size(), 0);
+        if (received < 0 && errno == EINTR) {
+          continue;
+        }
+        if (received <= 0) {
+          break;
+        }
+        pending.append(buffer.data(), static_cast<std::size_t>(received));
+        std::size_t start = 0;
+        for (auto end = pending.find('\n', start);
+             open && end != std::string::npos;
+             end = pending.find('\n', start)) {
+          if (!handle_line(std::string_view{pending}.substr(start, end - start),
+                           pool, reply)) {
+            stop();
+            open = false;
+          }
+          start = end + 1;
+        }
+        pending.erase(0, start);
+        if (open && pending.size() > kMaxLineBytes) {
+          // Whatever the client meant, it is not a job; stop buffering it.
+          reply(error_response("null", "request line too long"));
+          break;
+        }
+      }
+      const std::lock_guard lock(mutex);
+      open_fds.erase(connection->fd());
+      finished.push_back(std::this_thread::get_id());
+    });
+    const auto id = reader.get_id();
+    readers.emplace(id, std::move(reader));
+  }
+
+  for (auto& [id, reader] : readers) {
+    reader.join();
+  }
+  ::close(listener);
+  ::unlink(name.c_str());
+  return 0;
+}
+
+#else
+
+int serve_socket(const std::filesystem::path&, JobPool&)
+{
+  std::cerr << "--socket is not supported on this platform\n";
+  return 1;
+}
+
+#endif
+
+}  // namespace
+
+int run_serve(const ServeOptions& options)
+{
+  WarmResources resources(options.cache_entries);
+  // Jobs arrive one at a time, so the pool is sized by --jobs alone.
+  JobPool pool(art2img::extras::resolve_thread_count(
+                   options.jobs, std::numeric_limits<std::size_t>::max()),
+               resources);
+  return options.socket.empty() ? serve_stdin(pool)
+                                : serve_socket(options.socket, pool);
+}
+
+}  // namespace art2img::cli
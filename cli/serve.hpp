@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace art2img::cli {
+
+struct ServeOptions {
+  std::filesystem::path socket{};  // empty reads jobs from stdin
+  std::size_t jobs{0};  // worker threads; 0 selects hardware_concurrency()
+  std::size_t cache_entries{16};  // archives and palettes kept warm, each
+};
+
+/// `art2img serve`: reads newline-delimited JSON jobs from stdin, or from
+/// every connection to a Unix socket at `options.socket`, and answers each
+/// with one JSON line on the same stream. Jobs run on a fixed pool of worker
+/// threads. Parsed archives stay cached between jobs by path, size and
+/// modification time, and palettes by content. Returns the process exit code once stdin
+/// ends or a `{"op":"shutdown"}` job arrives.
+int run_serve(const ServeOptions& options);
+
+}  // namespace art2img::cli
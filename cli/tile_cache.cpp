@@ -0,0 +1,93 @@
+#include "tile_cache.hpp"
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <art2img/adapters/io.hpp>
+
+namespace art2img::cli {
+
+namespace {
+
+// One "<16 hex digits> <file name>" line per output after the header.
+constexpr std::string_view kHeader = "art2img-cache 1";
+
+}  // namespace
+
+TileCache TileCache::load(const std::filesystem::path& output_dir)
+{
+  TileCache cache{};
+  cache.output_dir_ = output_dir;
+
+  std::ifstream file(output_dir / file_name);
+  std::string line;
+  if (!std::getline(file, line) || line != kHeader) {
+    return cache;
+  }
+
+  while (std::getline(file, line)) {
+    if (line.size() < 18 || line[16] != ' ') {
+      continue;
+    }
+    std::uint64_t fingerprint = 0;
+    const auto parsed =
+        std::from_chars(line.data(), line.data() + 16, fingerprint, 16);
+    if (parsed.ec != std::errc{} || parsed.ptr != line.data() + 16) {
+      continue;
+    }
+    cache.entries_[line.substr(17)] = fingerprint;
+  }
+  return cache;
+}
+
+bool TileCache::up_to_date(const std::string& name,
+                           std::uint64_t fingerprint) const
+{
+  const auto found = entries_.find(name);
+  if (found == entries_.end() || found->second != fingerprint) {
+    return false;
+  }
+  std::error_code ec;
+  return std::filesystem::is_regular_file(output_dir_ / name, ec);
+}
+
+void TileCache::record(std::string name, std::uint64_t fingerprint)
+{
+  entries_[std::move(name)] = fingerprint;
+}
+
+std::expected<void, art2img::core::Error> TileCache::save() const
+{
+  std::string text{kHeader};
+  text += '\n';
+  for (const auto& [name, fingerprint] : entries_) {
+    text += std::format("{:016x} {}\n", fingerprint, name);
+  }
+  // Written aside and renamed over the old cache, so an interrupted save
+  // never leaves a truncated cache behind.
+  const auto path = output_dir_ / file_name;
+  auto temporary = path;
+  temporary += ".tmp";
+  auto written =
+      art2img::adapters::write_file(temporary, std::as_bytes(std::span{text}));
+  if (!written) {
+    return written;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    return std::unexpected(
+        art2img::core::make_error(art2img::core::errc::io_failure,
+                                  "failed to write file: " + path.string()));
+  }
+  return {};
+}
+
+}  // namespace art2img::cli
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <art2img/core/error.hpp>
+
+namespace art2img::cli {
+
+/// Sidecar record of the fingerprint each output file was written from, kept
+/// as `.art2img-cache` in the output directory. Lookups are read-only and
+/// safe from several workers; record() and save() are not.
+class TileCache {
+ public:
+  static constexpr std::string_view file_name = ".art2img-cache";
+
+  /// Reads the cache in `output_dir`. A missing or unreadable cache starts
+  /// empty, so the next run simply converts everything.
+  static TileCache load(const std::filesystem::path& output_dir);
+
+  /// True when `name` was last written from `fingerprint` and still exists.
+  bool up_to_date(const std::string& name, std::uint64_t fingerprint) const;
+
+  void record(std::string name, std::uint64_t fingerprint);
+
+  std::expected<void, art2img::core::Error> save() const;
+
+ private:
+  std::filesystem::path output_dir_{};
+  std::unordered_map<std::string, std::uint64_t> entries_{};
+};
+
+}  // namespace art2img::cli
@@ -0,0 +1,299 @@
+#include "watch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+
+#include "tile_cache.hpp"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace art2img::cli {
+
+namespace {
+
+// Editors and build tools often save in several writes, or write a temporary
+// file and rename it over the original; events closer together than this
+// are treated as one save.
+constexpr std::chrono::milliseconds kDebounce{50};
+constexpr std::chrono::milliseconds kIdleWait{1000};
+
+/// Reports changes to a fixed set of files. On Linux their directories are
+/// watched with inotify, so a file replaced by rename-on-save is still seen.
+/// Elsewhere, or if inotify is unavailable, each file's size and write time
+/// are compared on every call.
+class FileWatcher {
+ public:
+  explicit FileWatcher(std::vector<std::filesystem::path> files)
+      : files_(std::move(files))
+  {
+    for (const auto& file : files_) {
+      absolute_.push_back(std::filesystem::absolute(file).lexically_normal());
+      stamps_.push_back(stamp(file));
+    }
+#ifdef __linux__
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    for (const auto& file : absolute_) {
+      const auto directory = file.parent_path();
+      if (fd_ < 0 || std::ranges::find_if(directories_, [&](const auto& entry) {
+                       return entry.second == directory;
+                     }) != directories_.end()) {
+        continue;
+      }
+      const int wd = ::inotify_add_watch(
+          fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO);
+      if (wd < 0) {
+        ::close(fd_);
+        fd_ = -1;
+        directories_.clear();
+        break;
+      }
+      directories_.emplace(wd, directory);
+    }
+#endif
+  }
+
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+
+  ~FileWatcher()
+  {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+#endif
+  }
+
+  /// Waits up to `timeout` and returns the indices of the files that changed
+  /// meanwhile, possibly none. `input_closed` is set once standard input has
+  /// reached its end.
+  std::set<std::size_t> poll(std::chrono::milliseconds timeout,
+                             bool& input_closed)
+  {
+    std::set<std::size_t> changed;
+#ifndef _WIN32
+    std::array<pollfd, 2> fds{{{STDIN_FILENO, POLLIN, 0}, {fd_, POLLIN, 0}}};
+    const auto count = fd_ >= 0 ? 2 : 1;
+    if (::poll(fds.data(), count, static_cast<int>(timeout.count())) > 0) {
+      if (fds[0].revents != 0) {
+        std::array<char, 256> discard{};
+        if (::read(STDIN_FILENO, discard.data(), discard.size()) <= 0) {
+          input_closed = true;
+        }
+      }
+      if (count == 2 && (fds[1].revents & POLLIN) != 0) {
+        read_events(changed);
+      }
+    }
+#else
+    std::this_thread::sleep_for(timeout);
+#endif
+    if (fd_ < 0) {
+      compare_stamps(changed);
+    }
+    return changed;
+  }
+
+  const std::filesystem::path& file(std::size_t index) const
+  {
+    return files_[index];
+  }
+
+ private:
+  struct Stamp {
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type written{};
+
+    bool operator==(const Stamp&) const = default;
+  };
+
+  static Stamp stamp(const std::filesystem::path& file)
+  {
+    std::error_code error;
+    Stamp result{};
+    result.size = std::filesystem::file_size(file, error);
+    result.written = std::filesystem::last_write_time(file, error);
+    return result;
+  }
+
+  void compare_stamps(std::set<std::size_t>& changed)
+  {
+    for (std::size_t i = 0; i < files_.size(); ++i) {
+      auto now = stamp(files_[i]);
+      if (now != stamps_[i]) {
+        stamps_[i] = now;
+        changed.insert(i);
+      }
+    }
+  }
+
+  void read_events(std::set<std::size_t>& changed)
+  {
+#ifdef __linux__
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    for (;;) {
+      const auto bytes = ::read(fd_, buffer.data(), buffer.size());
+      if (bytes <= 0) {
+        return;
+      }
+      for (auto offset = std::size_t{0};
+           offset < static_cast<std::size_t>(bytes);) {
+        const auto* event =
+            reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+        offset += sizeof(inotify_event) + event->len;
+        const auto directory = directories_.find(event->wd);
+        if (event->len == 0 || directory == directories_.end()) {
+          continue;
+        }
+        const auto path = directory->second / event->name;
+        for (std::size_t i = 0; i < absolute_.size(); ++i) {
+          if (absolute_[i] == path) {
+            changed.insert(i);
+          }
+        }
+      }
+    }
+#else
+    (void)changed;
+#endif
+  }
+
+  std::vector<std::filesystem::path> files_;
+  std::vector<std::filesystem::path> absolute_{};
+  std::vector<Stamp> stamps_{};
+  int fd_ = -1;  // inotify descriptor; -1 compares stamps instead
+  std::map<int, std::filesystem::path> directories_{};  // watch -> directory
+};
+
+}  // namespace
+
+int run_watch(const CliConfig& config,
+              art2img::core::ImageFormat format,
+              std::optional<art2img::adapters::GrpFile> grp,
+              const FileReport& report)
+{
+  const bool from_grp = !config.grp_path.empty();
+  std::optional<SharedPalette> palette;
+  const auto reload_palette = [&] {
+    auto loaded = load_shared_palette(config, grp ? &*grp : nullptr);
+    if (!loaded) {
+      palette.reset();
+      report(config.palette_path, std::unexpected(loaded.error()));
+      return;
+    }
+    palette = std::move(*loaded);
+  };
+
+  // The cache stays in memory between updates and is saved after each, so
+  // unchanged tiles are skipped without touching their files.
+  auto cache = TileCache::load(config.output_dir);
+  const auto convert = [&](const std::vector<std::filesystem::path>& inputs) {
+    if (!palette || (from_grp && !grp)) {
+      return;
+    }
+    for (const auto& input : inputs) {
+      auto art = grp ? load_art_file(input, &*grp) : read_art_file(input);
+      if (!art) {
+        report(input, std::unexpected(art.error()));
+        continue;
+      }
+      report(input, process_art_file(config, input, *art, *palette, format,
+                                     &cache));
+    }
+    auto saved = cache.save();
+    if (!saved) {
+      report(config.output_dir / TileCache::file_name,
+             std::unexpected(saved.error()));
+    }
+  };
+
+  // Inside a GRP everything lives in the one file; otherwise each input and
+  // the palette are watched by name. Watching starts before the first pass
+  // so saves made during it are not missed.
+  std::vector<std::filesystem::path> watched;
+  if (from_grp) {
+    watched.push_back(config.grp_path);
+  }
+  else {
+    watched = config.inputs;
+    watched.push_back(config.palette_path);
+  }
+  FileWatcher watcher(watched);
+
+  reload_palette();
+  convert(config.inputs);
+  std::cout << std::format("Watching {} files for changes\n", watched.size())
+            << std::flush;
+
+  bool input_closed = false;
+  while (!input_closed) {
+    auto changed = watcher.poll(kIdleWait, input_closed);
+    if (changed.empty()) {
+      continue;
+    }
+    for (;;) {
+      auto more = watcher.poll(kDebounce, input_closed);
+      if (more.empty() || input_closed) {
+        break;
+      }
+      changed.insert(more.begin(), more.end());
+    }
+    const auto started = std::chrono::steady_clock::now();
+
+    const auto palette_index = watched.size() - 1;
+    if (from_grp) {
+      // Views into the old copy must go before it is replaced.
+      palette.reset();
+      grp.reset();
+      auto reopened = read_grp_file(config.grp_path);
+      if (!reopened) {
+        report(config.grp_path, std::unexpected(reopened.error()));
+        continue;
+      }
+      grp = std::move(*reopened);
+      reload_palette();
+      convert(config.inputs);
+    }
+    else if (changed.contains(palette_index)) {
+      reload_palette();
+      convert(config.inputs);
+    }
+    else {
+      std::vector<std::filesystem::path> inputs;
+      for (const auto index : changed) {
+        inputs.push_back(watcher.file(index));
+      }
+      convert(inputs);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+    std::cout << std::format("Updated in {} ms\n", elapsed.count())
+              << std::flush;
+  }
+  return 0;
+}
+
+}  // namespace art2img::cli
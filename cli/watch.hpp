@@ -0,0 +1,26 @@
+#pragma once
+
+#include <optional>
+
+#include <art2img/adapters/grp.hpp>
+#include <art2img/core/encode.hpp>
+
+#include "config_parser.hpp"
+#include "file_processor.hpp"
+
+namespace art2img::cli {
+
+/// `--watch`: converts every input once, then waits for the ART files, the
+/// palette or the GRP holding them to change and brings the output directory
+/// up to date. Bursts of events are debounced into one update. A changed ART
+/// file is parsed again on its own; a changed palette or GRP reloads it and
+/// revisits every input. Either way only tiles whose fingerprint differs
+/// from the `.art2img-cache` record are converted, as with --incremental.
+/// `grp` is the archive `config.inputs` name entries of, if any. Returns the
+/// process exit code once standard input ends.
+int run_watch(const CliConfig& config,
+              art2img::core::ImageFormat format,
+              std::optional<art2img::adapters::GrpFile> grp,
+              const FileReport& report);
+
+}  // namespace art2img::cli
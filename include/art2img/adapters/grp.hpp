@@ -7,6 +7,7 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "../core/error.hpp"
@@ -18,23 +19,50 @@ struct GrpEntry {
   std::span<const std::byte> data;
 };
 
+/// Case-insensitive, allocation-free hashing for GRP entry names.
+struct GrpNameHash {
+  std::size_t operator()(std::string_view name) const noexcept;
+};
+
+struct GrpNameEqual {
+  bool operator()(std::string_view lhs, std::string_view rhs) const noexcept;
+};
+
 class GrpFile {
  public:
   GrpFile() = default;
 
   const std::vector<GrpEntry>& entries() const noexcept { return entries_; }
 
+  /// O(1) case-insensitive lookup; trailing NULs and spaces are ignored.
   std::optional<GrpEntry> entry(std::string_view name) const noexcept;
 
  private:
   std::vector<GrpEntry> entries_;
-  std::shared_ptr<std::vector<std::byte>> storage_{};
+  // Keys view the raw name fields in the directory, so they stay valid for as
+  // long as storage_ (or the borrowed blob) does.
+  std::unordered_map<std::string_view, std::size_t, GrpNameHash, GrpNameEqual>
+      index_;
+  std::shared_ptr<const void> storage_{};
 
   friend std::expected<GrpFile, core::Error> load_grp(
+      std::shared_ptr<const void>,
       std::span<const std::byte>) noexcept;
 };
 
+/// Copies `blob` into storage owned by the returned file.
+std::expected<GrpFile, core::Error> load_grp(
+    std::span<const std::byte> blob) noexcept;
+
+/// Views caller-owned memory without copying. `blob` must outlive the file
+/// and every GrpEntry obtained from it.
+std::expected<GrpFile, core::Error> load_grp_borrowed(
+    std::span<const std::byte> blob) noexcept;
+
+/// Views `blob` in place and keeps `owner` (for example a MappedFile handle)
+/// alive while the file or any copy of it exists.
 std::expected<GrpFile, core::Error> load_grp(
+    std::shared_ptr<const void> owner,
     std::span<const std::byte> blob) noexcept;
 
 }  // namespace art2img::adapters
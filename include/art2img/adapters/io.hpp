@@ -4,9 +4,12 @@
 #include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <memory>
 #include <span>
 #include <vector>
 
+#include "../core/collection.hpp"
+#include "../core/encode.hpp"
 #include "../core/error.hpp"
 
 namespace art2img::adapters {
@@ -14,7 +17,43 @@ namespace art2img::adapters {
 std::expected<std::vector<std::byte>, core::Error> read_binary_file(
     const std::filesystem::path& path);
 
+/// Read-only view of a whole file. `handle` owns the mapping and unmaps it
+/// when the last copy is released; pass it as the owner to load_art or
+/// load_grp so archives keep the pages alive without copying them.
+struct MappedFile {
+  std::span<const std::byte> data{};
+  std::shared_ptr<const void> handle{};
+};
+
+/// Maps `path` read-only (mmap on POSIX, MapViewOfFile on Windows). Pages are
+/// faulted in on first access, so nothing is read up front. Empty files map
+/// to an empty span with a null handle.
+std::expected<MappedFile, core::Error> map_file(
+    const std::filesystem::path& path);
+
+/// Maps every ART file in `paths` (see map_file) and indexes them by tile
+/// number, so a whole game's tiles are one collection without reading any
+/// pixels up front. Errors name the file they came from.
+std::expected<core::ArtCollection, core::Error> open_art_collection(
+    std::span<const std::filesystem::path> paths);
+
 std::expected<void, core::Error> write_file(const std::filesystem::path& path,
                                             std::span<const std::byte> data);
 
+/// Encodes `image` straight into `path` through a buffered file sink, so the
+/// encoded bytes never sit in an intermediate vector. A partially written
+/// file is removed on failure. Returns the number of bytes written.
+std::expected<std::size_t, core::Error> encode_to_file(
+    const std::filesystem::path& path,
+    const core::RgbaImageView& image,
+    core::ImageFormat format,
+    core::EncoderOptions options = {});
+
+/// Streams an indexed image into `path`; see core::encode_indexed_image.
+std::expected<std::size_t, core::Error> encode_to_file(
+    const std::filesystem::path& path,
+    const core::IndexedImageView& image,
+    core::ImageFormat format,
+    core::EncoderOptions options = {});
+
 }  // namespace art2img::adapters
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "../core/art.hpp"
+#include "../core/error.hpp"
+
+namespace art2img::adapters {
+
+/// ART file opened for random tile access. Opening reads only the header and
+/// the width/height/picanm arrays; each tile's pixels and lookup bytes are
+/// fetched when asked for, with positional reads (pread on POSIX, ReadFile
+/// at an offset on Windows), so time to first tile does not grow with the
+/// archive. Reads share no state: one archive (or copies of it) can serve
+/// several threads at once.
+class LazyArtArchive {
+ public:
+  LazyArtArchive() = default;
+
+  std::size_t tile_count() const noexcept { return layout_.tiles.size(); }
+  std::uint32_t tile_start() const noexcept { return layout_.tile_start; }
+  std::span<const core::TileMetrics> layout() const noexcept
+  {
+    return layout_.tiles;
+  }
+
+  /// Reads tile `index` into `storage`, replacing its contents, and returns
+  /// a view of it that stays valid until `storage` is next modified. Empty and
+  /// out-of-range tiles give nullopt, as core::get_tile does; failed reads
+  /// give an error.
+  std::expected<std::optional<core::TileView>, core::Error> read_tile(
+      std::size_t index,
+      std::vector<std::byte>& storage) const;
+
+ private:
+  struct File;
+
+  std::shared_ptr<const File> file_{};
+  core::ArtLayout layout_{};
+  std::size_t file_size_ = 0;
+
+  friend std::expected<LazyArtArchive, core::Error> open_art_lazy(
+      const std::filesystem::path& path);
+};
+
+std::expected<LazyArtArchive, core::Error> open_art_lazy(
+    const std::filesystem::path& path);
+
+}  // namespace art2img::adapters
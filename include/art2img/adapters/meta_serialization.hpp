@@ -16,7 +16,17 @@ std::expected<std::string, core::Error> format_animation_ini(
 std::expected<std::string, core::Error> format_animation_json(
     const core::ExportManifest& manifest);
 
-std::expected<std::string, core::Error> format_animation(
+/// Rect manifest for an atlas: one object per page and one per tile with its
+/// page, rectangle, picnum and origin.
+std::expected<std::string, core::Error> format_atlas_json(
+    const core::AtlasManifest& manifest);
+
+/// Crop manifest for trimmed tiles: one object per tile with its image, the
+/// full tile size, where the trimmed rectangle sits in it, picnum and origin.
+std::expected<std::string, core::Error> format_trim_json(
+    const core::TrimManifest& manifest);
+
+inline std::expected<std::string, core::Error> format_animation(
     const core::ExportManifest& manifest,
     animation_format format)
 {
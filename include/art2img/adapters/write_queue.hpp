@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../core/error.hpp"
+
+namespace art2img::adapters {
+
+enum class WriteBackend : std::uint8_t { io_uring, threads };
+
+struct WriteQueueOptions {
+  /// submit() blocks while this many bytes are queued or in flight. A single
+  /// larger file is still accepted once the queue is empty.
+  std::size_t max_pending_bytes = std::size_t{64} << 20;
+  /// Writes handed to io_uring per submission.
+  std::size_t batch = 32;
+  /// Writer threads for the portable backend.
+  std::size_t threads = 2;
+  /// Try io_uring first on Linux; falls back to threads when the kernel (or
+  /// a sandbox) refuses it.
+  bool use_io_uring = true;
+};
+
+/// Write-behind stage for encoded files. Producers hand over whole files and
+/// carry on converting while a writer drains the queue: through batched
+/// io_uring submissions on Linux, or a small thread pool elsewhere. Should
+/// the ring fail mid-run, its writer carries on without it. Each write
+/// reports to `on_complete` with the tag it was submitted under, on a writer
+/// thread. Partially written files are removed.
+class WriteQueue {
+ public:
+  using Completion =
+      std::function<void(std::size_t tag, std::expected<void, core::Error>)>;
+
+  explicit WriteQueue(Completion on_complete, WriteQueueOptions options = {});
+  WriteQueue(const WriteQueue&) = delete;
+  WriteQueue& operator=(const WriteQueue&) = delete;
+  /// Drains outstanding writes before returning.
+  ~WriteQueue();
+
+  /// Queues `bytes` for `path`, blocking while the queue is full.
+  void submit(std::size_t tag,
+              std::filesystem::path path,
+              std::vector<std::byte> bytes);
+
+  /// Blocks until every write submitted so far has completed.
+  void drain();
+
+  WriteBackend backend() const noexcept { return backend_.load(); }
+
+ private:
+  struct Job {
+    std::size_t tag;
+    std::filesystem::path path;
+    std::vector<std::byte> bytes;
+  };
+  struct Ring;
+
+  bool take(std::vector<Job>& jobs, std::size_t limit);
+  void finish(const Job& job, std::expected<void, core::Error> result);
+  void run_threads();
+  void run_ring();
+
+  Completion on_complete_;
+  WriteQueueOptions options_;
+  std::atomic<WriteBackend> backend_{WriteBackend::threads};
+  std::unique_ptr<Ring> ring_;
+
+  std::mutex mutex_{};
+  std::condition_variable work_ready_{};
+  std::condition_variable space_ready_{};
+  std::deque<Job> queued_{};
+  std::size_t pending_bytes_ = 0;
+  std::size_t unfinished_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> writers_{};
+};
+
+}  // namespace art2img::adapters
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../core/error.hpp"
+
+namespace art2img::adapters {
+
+/// Sequential writer for a stored (uncompressed) ZIP archive. Entries are
+/// appended to one buffered file as they arrive and the central directory is
+/// written by finish(), so a whole run costs a single file creation. Entries
+/// carry a fixed 1980-01-01 timestamp, keeping archives reproducible.
+///
+/// Plain ZIP limits apply: at most 65535 entries and 4 GiB of output. Calls
+/// are not synchronised; share a writer between threads behind a lock.
+class ZipWriter {
+ public:
+  ZipWriter(ZipWriter&&) noexcept = default;
+  ZipWriter& operator=(ZipWriter&&) noexcept = default;
+
+  /// Appends `data` as `name`. Names use '/' separators and must be unique.
+  std::expected<void, core::Error> add(std::string_view name,
+                                       std::span<const std::byte> data);
+
+  /// Writes the central directory and closes the file. Returns the archive
+  /// size in bytes. The writer accepts no entries afterwards.
+  std::expected<std::size_t, core::Error> finish();
+
+  std::size_t entry_count() const noexcept { return entries_.size(); }
+
+ private:
+  struct Entry {
+    std::string name;
+    std::uint32_t crc = 0;
+    std::uint32_t size = 0;
+    std::uint32_t offset = 0;
+  };
+
+  ZipWriter() = default;
+
+  std::filesystem::path path_{};
+  std::unique_ptr<std::ofstream> file_{};
+  std::vector<Entry> entries_{};
+  std::uint64_t offset_ = 0;
+
+  friend std::expected<ZipWriter, core::Error> create_zip(
+      const std::filesystem::path& path);
+};
+
+/// Creates (or truncates) `path` for writing a stored ZIP archive.
+std::expected<ZipWriter, core::Error> create_zip(
+    const std::filesystem::path& path);
+
+}  // namespace art2img::adapters
@@ -13,15 +13,26 @@
 #include <format>
 #include "adapters/grp.hpp"
 #include "adapters/io.hpp"
+#include "adapters/lazy_art.hpp"
 #include "adapters/meta_serialization.hpp"
+#include "adapters/zip.hpp"
 #include "core/art.hpp"
+#include "core/collection.hpp"
 #include "core/convert.hpp"
 #include "core/encode.hpp"
 #include "core/error.hpp"
+#include "core/hash.hpp"
 #include "core/image.hpp"
 #include "core/meta.hpp"
+#include "core/mipmap.hpp"
 #include "core/palette.hpp"
+#include "core/quantize.hpp"
+#include "core/stats.hpp"
+#include "extras/atlas.hpp"
 #include "extras/batch.hpp"
+#include "extras/dedupe.hpp"
+#include "extras/palette_cache.hpp"
+#include "extras/trace.hpp"
 /**
  * @namespace art2img
  * @brief Main namespace for the art2img library
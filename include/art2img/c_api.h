@@ -0,0 +1,209 @@
+#pragma once
+
+/**
+ * @file c_api.h
+ * @brief C ABI over the memory-first API, for FFI callers
+ *
+ * Built as the `art2img_c` shared library. Archives and palettes are opened
+ * from caller memory without copying it, and pixels are written into buffers
+ * the caller owns; the library keeps only reusable scratch space inside a
+ * converter. Every function reports through an art2img_status, never through
+ * exceptions, and only plain C types cross the boundary.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(ART2IMG_C_BUILD)
+#define ART2IMG_C_EXPORT __declspec(dllexport)
+#else
+#define ART2IMG_C_EXPORT __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define ART2IMG_C_EXPORT __attribute__((visibility("default")))
+#else
+#define ART2IMG_C_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a signature or struct layout changes incompatibly. */
+#define ART2IMG_C_ABI_VERSION 1
+
+/* Codes 1-8 match art2img::core::errc; its buffer_too_small is reported as
+ * ART2IMG_ERROR_BUFFER_TOO_SMALL. */
+typedef enum art2img_status {
+  ART2IMG_OK = 0,
+  ART2IMG_ERROR_IO = 1,
+  ART2IMG_ERROR_INVALID_ART = 2,
+  ART2IMG_ERROR_INVALID_PALETTE = 3,
+  ART2IMG_ERROR_CONVERSION = 4,
+  ART2IMG_ERROR_ENCODING = 5,
+  ART2IMG_ERROR_UNSUPPORTED = 6,
+  ART2IMG_ERROR_NO_ANIMATION = 7,
+  ART2IMG_ERROR_ANIMATION_FORMAT = 8,
+  ART2IMG_ERROR_INVALID_ARGUMENT = 100,
+  ART2IMG_ERROR_OUT_OF_RANGE = 101,    /* tile index past the archive */
+  ART2IMG_ERROR_BUFFER_TOO_SMALL = 102, /* required size is reported */
+  ART2IMG_ERROR_OUT_OF_MEMORY = 103,
+  ART2IMG_ERROR_INTERNAL = 104
+} art2img_status;
+
+typedef enum art2img_format {
+  ART2IMG_FORMAT_PNG = 0,
+  ART2IMG_FORMAT_TGA = 1,
+  ART2IMG_FORMAT_BMP = 2,
+  ART2IMG_FORMAT_DDS = 3,
+  ART2IMG_FORMAT_QOI = 4
+} art2img_format;
+
+typedef enum art2img_compression {
+  ART2IMG_COMPRESSION_BALANCED = 0,
+  ART2IMG_COMPRESSION_FAST = 1,
+  ART2IMG_COMPRESSION_SMALLEST = 2
+} art2img_compression;
+
+/* DDS payload; AUTOMATIC picks BC1 for tiles whose alpha is only 0 or 255
+ * and BC3 otherwise. */
+typedef enum art2img_texture_compression {
+  ART2IMG_TEXTURE_RGBA8 = 0,
+  ART2IMG_TEXTURE_BC1 = 1,
+  ART2IMG_TEXTURE_BC3 = 2,
+  ART2IMG_TEXTURE_AUTOMATIC = 3
+} art2img_texture_compression;
+
+typedef struct art2img_archive art2img_archive;
+typedef struct art2img_palette art2img_palette;
+typedef struct art2img_converter art2img_converter;
+
+/* Conversion settings. Fill with art2img_default_options and leave `size`
+ * as set, so later versions can append fields and still read old callers. */
+typedef struct art2img_options {
+  uint32_t size;           /* sizeof(art2img_options) */
+  int32_t shade_index;     /* 0-255, or -1 for none */
+  uint8_t apply_lookup;    /* remap through the tile lookup first */
+  uint8_t fix_transparency;
+  uint8_t premultiply_alpha;
+  uint8_t matte_hygiene;
+  uint8_t compression;     /* an art2img_compression, for encoding */
+  uint8_t texture_compression; /* an art2img_texture_compression, for DDS */
+  uint8_t reserved[2];
+} art2img_options;
+
+typedef struct art2img_tile_info {
+  uint32_t width;
+  uint32_t height;
+  int32_t offset_x;  /* picanm centre offsets */
+  int32_t offset_y;
+} art2img_tile_info;
+
+ART2IMG_C_EXPORT uint32_t art2img_abi_version(void);
+
+ART2IMG_C_EXPORT const char* art2img_status_name(art2img_status status);
+
+/* Message for the last failing call on this thread; valid until the next one
+ * fails. Empty when nothing has failed. */
+ART2IMG_C_EXPORT const char* art2img_last_error_message(void);
+
+/* Views `size` bytes of ART data without copying; `data` must stay valid and
+ * unchanged until the archive is closed. */
+ART2IMG_C_EXPORT art2img_status art2img_archive_open(const void* data,
+                                                     size_t size,
+                                                     art2img_archive** out);
+
+ART2IMG_C_EXPORT void art2img_archive_close(art2img_archive* archive);
+
+ART2IMG_C_EXPORT size_t art2img_archive_tile_count(
+    const art2img_archive* archive);
+
+ART2IMG_C_EXPORT art2img_status art2img_archive_tile_info(
+    const art2img_archive* archive,
+    size_t tile,
+    art2img_tile_info* out);
+
+/* Views PALETTE.DAT bytes without copying; `data` must outlive the palette.
+ * Converters copy what they need, so the palette may be closed after
+ * creating them. */
+ART2IMG_C_EXPORT art2img_status art2img_palette_open(const void* data,
+                                                     size_t size,
+                                                     art2img_palette** out);
+
+ART2IMG_C_EXPORT void art2img_palette_close(art2img_palette* palette);
+
+/* Lookup and transparency cleanup on, everything else off. */
+ART2IMG_C_EXPORT void art2img_default_options(art2img_options* options);
+
+/* Resolves `palette` for `options` once. A converter reuses its scratch
+ * buffers across calls, so steady-state conversion does not allocate; it is
+ * not thread-safe, so use one per thread (art2img_convert_tiles runs its own
+ * threads safely). `options` may be NULL for the defaults. */
+ART2IMG_C_EXPORT art2img_status art2img_converter_create(
+    const art2img_palette* palette,
+    const art2img_options* options,
+    art2img_converter** out);
+
+ART2IMG_C_EXPORT void art2img_converter_destroy(art2img_converter* converter);
+
+/* Writes the tile as tightly packed RGBA rows, width * height * 4 bytes, to
+ * `out`. `*written` receives the bytes used, or the bytes needed when the
+ * call fails with ART2IMG_ERROR_BUFFER_TOO_SMALL. Empty tiles write
+ * nothing. */
+ART2IMG_C_EXPORT art2img_status art2img_convert_tile(
+    art2img_converter* converter,
+    const art2img_archive* archive,
+    size_t tile,
+    uint8_t* out,
+    size_t capacity,
+    size_t* written);
+
+/* Buffer size for art2img_encode_tile. It is an upper bound in every format,
+ * not the exact size: TGA's allows for run-length packets that do not pay
+ * off, and PNG's for pixels deflate cannot shrink. A buffer of this size
+ * always fits. */
+ART2IMG_C_EXPORT art2img_status art2img_encoded_size(
+    const art2img_converter* converter,
+    const art2img_archive* archive,
+    size_t tile,
+    art2img_format format,
+    size_t* size);
+
+/* Converts and encodes the tile into `out`; `*written` receives the file
+ * size in bytes, or the bytes needed when the call fails with
+ * ART2IMG_ERROR_BUFFER_TOO_SMALL. Empty tiles cannot be encoded. */
+ART2IMG_C_EXPORT art2img_status art2img_encode_tile(
+    art2img_converter* converter,
+    const art2img_archive* archive,
+    size_t tile,
+    art2img_format format,
+    void* out,
+    size_t capacity,
+    size_t* written);
+
+/* Total RGBA bytes for converting `count` tiles with art2img_convert_tiles. */
+ART2IMG_C_EXPORT art2img_status art2img_batch_size(
+    const art2img_archive* archive,
+    const size_t* tiles,
+    size_t count,
+    size_t* size);
+
+/* Converts `count` tiles into one caller buffer, packed back to back in
+ * request order; `offsets[i]` receives where tile `tiles[i]` starts. Runs on
+ * `threads` threads (0 for one per hardware thread), largest tiles first.
+ * On failure the error is that of the earliest failing tile; other tiles
+ * may already have been written. */
+ART2IMG_C_EXPORT art2img_status art2img_convert_tiles(
+    art2img_converter* converter,
+    const art2img_archive* archive,
+    const size_t* tiles,
+    size_t count,
+    uint8_t* out,
+    size_t capacity,
+    size_t* offsets,
+    size_t threads);
+
+#ifdef __cplusplus
+}
+#endif
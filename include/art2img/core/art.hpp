@@ -12,9 +12,12 @@
 
 namespace art2img::core {
 
+/// Six bytes per tile: ART stores dimensions as 16-bit values.
 struct TileMetrics {
-  std::uint32_t width = 0;
-  std::uint32_t height = 0;
+  std::uint16_t width = 0;
+  std::uint16_t height = 0;
+  std::int8_t offset_x = 0;  // picanm centre offsets
+  std::int8_t offset_y = 0;
 };
 
 struct TileView {
@@ -31,28 +34,82 @@ struct TileView {
   }
 };
 
+/// Where an ART file keeps its tiles, worked out from the 16-byte header and
+/// the tile arrays alone; nothing past them is read.
+struct ArtLayout {
+  std::uint32_t tile_start = 0;
+  std::vector<TileMetrics> tiles{};
+  std::vector<std::uint32_t> pixel_offsets{};  // from pixel_data_offset
+  std::size_t pixel_data_offset = 0;
+  std::size_t lookup_data_offset = 0;  // first byte after every pixel
+};
+
+/// Per-tile metadata is two parallel arrays, `layout` and the pixel offsets:
+/// ten bytes a tile. Lookup ranges follow from the tile index and are not
+/// stored.
 struct ArtArchive {
   std::span<const std::byte> raw{};
   std::vector<TileMetrics> layout{};
   std::uint32_t tile_start = 0;
 
  private:
-  std::shared_ptr<const std::vector<std::byte>> storage_{};
-  std::vector<std::size_t> pixel_offsets_{};
-  std::vector<std::size_t> lookup_offsets_{};
-  std::vector<std::size_t> lookup_sizes_{};
+  std::shared_ptr<const void> storage_{};  // null when borrowing
+  std::vector<std::uint32_t> pixel_offsets_{};
   std::size_t pixel_data_offset_ = 0;
   std::size_t lookup_data_offset_ = 0;
 
   friend std::expected<ArtArchive, Error> load_art(
+      std::shared_ptr<const void>,
       std::span<const std::byte>) noexcept;
   friend std::optional<TileView> get_tile(const ArtArchive&,
                                           std::size_t) noexcept;
 };
 
+/// A tile for write_art: its metrics and `width * height` palette indices,
+/// column-major as TileView::indices holds them. A 0x0 tile has no indices.
+struct ArtTileData {
+  TileMetrics metrics{};
+  std::vector<std::byte> indices{};
+};
+
+/// Copies `blob` into storage owned by the returned archive.
 std::expected<ArtArchive, Error> load_art(
     std::span<const std::byte> blob) noexcept;
 
+/// Takes ownership of `blob`; tile views point straight into it.
+std::expected<ArtArchive, Error> load_art(
+    std::vector<std::byte>&& blob) noexcept;
+
+/// Views `blob` and keeps `owner` alive for as long as the archive (or a copy
+/// of it) exists. `owner` may be null, in which case this borrows.
+std::expected<ArtArchive, Error> load_art(
+    std::shared_ptr<const void> owner,
+    std::span<const std::byte> blob) noexcept;
+
+/// Views caller-owned memory without copying. `blob` must outlive the archive
+/// and every TileView obtained from it.
+std::expected<ArtArchive, Error> load_art_borrowed(
+    std::span<const std::byte> blob) noexcept;
+
+/// Bytes of header plus tile arrays at the front of an ART file, as declared
+/// by its first 16 bytes.
+std::expected<std::size_t, Error> art_tables_size(
+    std::span<const std::byte> header) noexcept;
+
+/// Parses the header and tile arrays at the front of an ART file that is
+/// `file_size` bytes long, with the same checks as load_art; `tables` needs
+/// at least art_tables_size bytes.
+std::expected<ArtLayout, Error> parse_art_layout(
+    std::span<const std::byte> tables,
+    std::size_t file_size) noexcept;
+
+/// Serialises `tiles` as a version 1 ART file numbered from `tile_start`.
+/// picanm keeps only the centre offsets, and no lookup data is written; the
+/// result loads back with load_art.
+std::expected<std::vector<std::byte>, Error> write_art(
+    std::span<const ArtTileData> tiles,
+    std::uint32_t tile_start = 0);
+
 std::size_t tile_count(const ArtArchive&) noexcept;
 
 std::optional<TileView> get_tile(const ArtArchive&,
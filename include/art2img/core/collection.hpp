@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "art.hpp"
+#include "error.hpp"
+
+namespace art2img::core {
+
+/// Where a global tile number lives in an ArtCollection.
+struct TileLocation {
+  std::size_t archive = 0;  // index into ArtCollection::archives()
+  std::size_t tile = 0;     // local index for get_tile(archive, tile)
+};
+
+/// A game's ART files addressed by global tile number (picnum), the way
+/// Build splits them across TILES000.ART to TILES019.ART. Archive `i` covers
+/// the numbers [tile_start, tile_start + tile_count); the ranges are indexed
+/// in order, so finding a tile is a binary search over the archives rather
+/// than over their tiles. Read-only once built and safe to share between
+/// threads.
+class ArtCollection {
+ public:
+  ArtCollection() = default;
+
+  /// In the order they were given to make_art_collection.
+  std::span<const ArtArchive> archives() const noexcept { return archives_; }
+
+  /// Tiles across every archive.
+  std::size_t tile_count() const noexcept { return tile_count_; }
+
+  /// Every tile number the collection covers, ascending.
+  std::vector<std::uint32_t> tile_numbers() const;
+
+  std::optional<TileLocation> locate(std::uint32_t tile) const noexcept;
+
+  /// Metrics of tile `tile`, or null when no archive covers it.
+  const TileMetrics* metrics(std::uint32_t tile) const noexcept;
+
+ private:
+  struct Range {
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+    std::size_t archive = 0;
+  };
+
+  std::vector<ArtArchive> archives_{};
+  std::vector<Range> ranges_{};  // non-empty archives, by first tile
+  std::size_t tile_count_ = 0;
+
+  friend std::expected<ArtCollection, Error> make_art_collection(
+      std::vector<ArtArchive> archives);
+};
+
+/// Indexes `archives` by tile number. Archives whose tile ranges overlap are
+/// rejected, since a tile number must name one tile.
+std::expected<ArtCollection, Error> make_art_collection(
+    std::vector<ArtArchive> archives);
+
+std::size_t tile_count(const ArtCollection&) noexcept;
+
+/// Tile number `tile` from whichever archive covers it. Empty and missing
+/// tiles give nullopt, as get_tile on an archive does.
+std::optional<TileView> get_tile(const ArtCollection&,
+                                 std::uint32_t tile) noexcept;
+
+}  // namespace art2img::core
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include "art.hpp"
 #include "color_helpers.hpp"
@@ -25,10 +31,143 @@ struct PostprocessOptions {
   bool sanitize_matte = false;
 };
 
+/// Palette colours resolved for one set of conversion options: shade table,
+/// 6-to-8 bit expansion and transparency are folded into 256 RGBA entries
+/// (bytes in R, G, B, A memory order), so converting a pixel is one load.
+/// Tile lookups are still applied per tile when `options.apply_lookup` is set.
+struct PreparedPalette {
+  std::array<std::uint32_t, palette_color_count> colors{};
+  ConversionOptions options{};
+};
+
+/// Scratch memory reused across conversions. Buffers grow to the largest
+/// tile seen and are never shrunk, so converting at steady state does not
+/// touch the heap. Not thread-safe; keep one per worker.
+struct ConversionWorkspace {
+  std::vector<std::uint8_t> index_strip{};  // transposed rows of indices
+  std::vector<std::uint8_t> matte_rows{};   // eroded alpha line buffers
+  std::vector<std::uint32_t> variant_colors{};  // per-variant lookup tables
+
+  /// Uninitialised output space for `bytes` bytes, valid until the next call.
+  std::span<std::uint8_t> pixel_buffer(std::size_t bytes);
+
+ private:
+  std::unique_ptr<std::uint8_t[]> pixels_{};
+  std::size_t pixel_capacity_ = 0;
+};
+
+std::expected<PreparedPalette, Error> prepare_palette(
+    PaletteView palette,
+    ConversionOptions options = {});
+
 std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
                                                 PaletteView palette,
                                                 ConversionOptions options = {});
 
+/// Converts with a palette prepared once up front; equivalent to the
+/// PaletteView overload called with `palette.options`.
+std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
+                                                const PreparedPalette& palette);
+
+std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
+                                                const PreparedPalette& palette,
+                                                ConversionWorkspace& workspace);
+
+/// Writes the tile as tightly packed RGBA rows into the first
+/// `width * height * 4` bytes of `out`, which must be at least that large.
+std::expected<void, Error> palette_to_rgba_into(const TileView& tile,
+                                                PaletteView palette,
+                                                ConversionOptions options,
+                                                std::span<std::uint8_t> out);
+
+std::expected<void, Error> palette_to_rgba_into(const TileView& tile,
+                                                const PreparedPalette& palette,
+                                                std::span<std::uint8_t> out,
+                                                ConversionWorkspace& workspace);
+
+/// One output of palette_to_rgba_variants: the prepared palette to render
+/// with (a shade or palette swap is one prepare_palette call each) and the
+/// `width * height * 4` bytes to write.
+struct RenderVariant {
+  const PreparedPalette* palette = nullptr;
+  std::span<std::uint8_t> out{};
+};
+
+/// Renders `tile` once per variant with a single pass over its indices:
+/// each strip of rows is transposed once and expanded through every
+/// variant's colour table while it is still in cache. Each output matches
+/// palette_to_rgba_into with that palette. Indexed output needs no fan-out:
+/// palette_to_indices_into gives one plane that pairs with every variant's
+/// `colors`, as long as they agree on `apply_lookup`.
+std::expected<void, Error> palette_to_rgba_variants(
+    const TileView& tile,
+    std::span<const RenderVariant> variants,
+    ConversionWorkspace& workspace);
+
+/// Writes the tile's palette indices as tightly packed rows into the first
+/// `width * height` bytes of `out`, with the tile lookup applied when
+/// `palette.options.apply_lookup` is set. Shade and transparency live in
+/// `palette.colors`, so the result pairs with that table to give the same
+/// pixels palette_to_rgba would. Matte hygiene cannot be expressed per index
+/// and is rejected as unsupported.
+std::expected<void, Error> palette_to_indices_into(
+    const TileView& tile,
+    const PreparedPalette& palette,
+    std::span<std::uint8_t> out);
+
+/// Smallest rectangle holding every pixel of `tile` that converts to a
+/// non-zero alpha with `palette`, found from the column-major indices
+/// without converting. Encoding only that part of the image (crop_view)
+/// drops the transparent border most sprites carry. Empty when nothing is
+/// visible.
+ImageRect opaque_bounds(const TileView& tile,
+                        const PreparedPalette& palette) noexcept;
+
+/// Runs the requested passes fused into at most one sweep over the pixels
+/// (two with matte hygiene, which needs the neighbourhood first).
 void postprocess_rgba(RgbaImage& image, PostprocessOptions options = {});
 
+void postprocess_rgba(RgbaImage& image,
+                      PostprocessOptions options,
+                      ConversionWorkspace& workspace);
+
+/// Postprocesses tightly packed RGBA pixels in place.
+void postprocess_rgba(std::span<std::uint8_t> pixels,
+                      std::uint32_t width,
+                      std::uint32_t height,
+                      PostprocessOptions options,
+                      ConversionWorkspace& workspace);
+
+/// Drops the postprocess passes that cannot change an image that
+/// palette_to_rgba produced with `conversion`, so callers chaining the two
+/// only pay for passes that add work. Output is identical either way.
+PostprocessOptions residual_postprocess(ConversionOptions conversion,
+                                        PostprocessOptions postprocess) noexcept;
+
+/// Implementations of the index-to-RGBA expansion loop. The best kernel the
+/// CPU supports is picked on first use.
+enum class ExpandKernel : std::uint8_t { scalar, avx2, neon };
+
+ExpandKernel active_expand_kernel() noexcept;
+
+/// Forces `kernel` for all later conversions. Returns false, leaving the
+/// selection unchanged, when the CPU or build does not support it.
+bool select_expand_kernel(ExpandKernel kernel) noexcept;
+
+/// Restores the automatically detected kernel.
+void reset_expand_kernel() noexcept;
+
+constexpr std::string_view expand_kernel_name(ExpandKernel kernel) noexcept
+{
+  switch (kernel) {
+    case ExpandKernel::scalar:
+      return "scalar";
+    case ExpandKernel::avx2:
+      return "avx2";
+    case ExpandKernel::neon:
+      return "neon";
+  }
+  return "unknown";
+}
+
 }  // namespace art2img::core
@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <functional>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -12,15 +14,31 @@
 
 namespace art2img::core {
 
-enum class ImageFormat : std::uint8_t { png, tga, bmp };
+/// `dds` is a GPU texture container: RGBA8 rows that upload as they are, or
+/// BC1/BC3 blocks (see TextureCompression), optionally with a mip chain.
+/// `qoi` is lossless and encodes far faster than PNG's deflate, for quick
+/// iteration where file size matters less.
+enum class ImageFormat : std::uint8_t { png, tga, bmp, dds, qoi };
 
+/// PNG deflate effort. `fast` uses a single cheap row filter and the lowest
+/// level for previews, `smallest` searches hardest for release packaging.
+/// Builds with ART2IMG_WITH_LIBDEFLATE compress through libdeflate; TGA and
+/// BMP output does not depend on the preset.
 enum class CompressionPreset : std::uint8_t { balanced, fast, smallest };
 
+/// `auto_detect` writes 24-bit output when every alpha is 255 and 32-bit
+/// otherwise.
 enum class BitDepth : std::uint8_t { auto_detect, bpp24, bpp32 };
 
+/// DDS payload. `bc1` keeps one bit of alpha (under 128 is transparent),
+/// `bc3` keeps eight; `automatic` picks bc1 when every alpha is 0 or 255.
+enum class TextureCompression : std::uint8_t { none, bc1, bc3, automatic };
+
 struct EncoderOptions {
   CompressionPreset compression = CompressionPreset::balanced;
-  BitDepth bit_depth = BitDepth::auto_detect;
+  BitDepth bit_depth = BitDepth::auto_detect;  // DDS is always 32-bit
+  bool tga_rle = true;  // run-length encode TGA output
+  TextureCompression texture = TextureCompression::none;
 };
 
 struct EncodedImage {
@@ -30,10 +48,69 @@ struct EncodedImage {
   std::vector<std::byte> bytes;
 };
 
+/// Receives encoded bytes in file order. Returning false aborts the encode;
+/// the remaining output is discarded and the encode reports an error.
+using EncodeSink = std::function<bool(std::span<const std::byte> chunk)>;
+
+/// Upper bound on the encoded size of a single-level image in any format;
+/// used to reserve output storage up front. PNG data that deflate would
+/// expand is stored uncompressed instead, which keeps its bound close.
+std::size_t estimate_encoded_size(const RgbaImageView& image,
+                                  ImageFormat format,
+                                  EncoderOptions options = {}) noexcept;
+
 std::expected<EncodedImage, Error> encode_image(const RgbaImageView& image,
                                                 ImageFormat format,
                                                 EncoderOptions options = {});
 
+/// Streams the encoded image into `sink` as the encoder produces it and
+/// returns the number of bytes delivered.
+std::expected<std::size_t, Error> encode_image_to(const RgbaImageView& image,
+                                                  ImageFormat format,
+                                                  const EncodeSink& sink,
+                                                  EncoderOptions options = {});
+
+/// Encodes into a caller-owned buffer and returns the number of bytes used.
+/// Size it with estimate_encoded_size. A shorter `out` fails with
+/// errc::buffer_too_small and holds no usable output; the encode still runs
+/// to the end so that `required`, if given, receives the size it needed.
+std::expected<std::size_t, Error> encode_image_into(
+    const RgbaImageView& image,
+    ImageFormat format,
+    std::span<std::byte> out,
+    EncoderOptions options = {},
+    std::size_t* required = nullptr);
+
+/// Encodes `image` with the successively smaller `levels` under it in one
+/// file, as a texture's mip chain (see build_mip_chain): each level must
+/// halve the one before it, rounding down to no less than 1. Only DDS holds
+/// levels; other formats accept an empty `levels` only.
+std::expected<EncodedImage, Error> encode_image_levels(
+    const RgbaImageView& image,
+    std::span<const RgbaImageView> levels,
+    ImageFormat format,
+    EncoderOptions options = {});
+
+std::size_t estimate_encoded_size(const IndexedImageView& image,
+                                  ImageFormat format,
+                                  EncoderOptions options = {}) noexcept;
+
+/// Encodes 8-bit indices with their colour table, with no RGBA intermediate:
+/// PNG colour type 3 with PLTE and a trimmed tRNS, TGA image type 1 (or 9
+/// with `tga_rle`) with a 24- or 32-bit colour map, or an 8bpp BI_RGB BMP,
+/// which cannot carry palette alpha. `bit_depth` does not apply, and DDS and
+/// QOI are rejected as unsupported.
+std::expected<EncodedImage, Error> encode_indexed_image(
+    const IndexedImageView& image,
+    ImageFormat format,
+    EncoderOptions options = {});
+
+std::expected<std::size_t, Error> encode_indexed_image_to(
+    const IndexedImageView& image,
+    ImageFormat format,
+    const EncodeSink& sink,
+    EncoderOptions options = {});
+
 constexpr std::string_view file_extension(ImageFormat format) noexcept
 {
   switch (format) {
@@ -43,6 +120,10 @@ constexpr std::string_view file_extension(ImageFormat format) noexcept
       return "tga";
     case ImageFormat::bmp:
       return "bmp";
+    case ImageFormat::dds:
+      return "dds";
+    case ImageFormat::qoi:
+      return "qoi";
   }
   return "bin";
 }
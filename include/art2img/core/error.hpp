@@ -20,6 +20,7 @@ enum class errc : std::uint8_t {
   unsupported = 6,
   no_animation = 7,
   animation_format = 8,
+  buffer_too_small = 9,
 };
 
 }  // namespace art2img::core
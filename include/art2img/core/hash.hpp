@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "art.hpp"
+#include "convert.hpp"
+#include "encode.hpp"
+
+namespace art2img::core {
+
+/// Streaming XXH64. Fast and non-cryptographic: meant for change detection,
+/// not for anything an adversary controls.
+class Xxh64 {
+ public:
+  explicit Xxh64(std::uint64_t seed = 0) noexcept;
+
+  void update(std::span<const std::byte> data) noexcept;
+  void update(std::uint64_t value) noexcept;  // as 8 little-endian bytes
+
+  std::uint64_t digest() const noexcept;
+
+ private:
+  std::array<std::uint64_t, 4> lanes_{};
+  std::array<std::byte, 32> buffer_{};
+  std::size_t buffered_ = 0;
+  std::uint64_t length_ = 0;
+  std::uint64_t seed_ = 0;
+};
+
+std::uint64_t xxh64(std::span<const std::byte> data,
+                    std::uint64_t seed = 0) noexcept;
+
+/// Hash of everything besides the tile that decides the encoded bytes: the
+/// prepared colours, their ConversionOptions, the format and EncoderOptions.
+/// Callers fold in settings of their own through `seed`.
+std::uint64_t settings_fingerprint(const PreparedPalette& palette,
+                                   ImageFormat format,
+                                   EncoderOptions encoder,
+                                   std::uint64_t seed = 0) noexcept;
+
+/// Hash of a tile's dimensions, indices and lookup bytes, seeded with a
+/// settings_fingerprint. Equal fingerprints mean equal encoded output.
+std::uint64_t tile_fingerprint(const TileView& tile,
+                               std::uint64_t settings) noexcept;
+
+}  // namespace art2img::core
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <span>
 #include <vector>
@@ -14,6 +15,8 @@ struct RgbaImage {
   constexpr bool empty() const noexcept { return pixels.empty(); }
 };
 
+/// Rows start `stride` bytes apart, so a view can cover a sub-rectangle of
+/// a larger image; the last row only needs its own `width * 4` bytes.
 struct RgbaImageView {
   std::span<const std::uint8_t> pixels;
   std::uint32_t width = 0;
@@ -23,14 +26,65 @@ struct RgbaImageView {
   constexpr bool valid() const noexcept
   {
     return width > 0 && height > 0 && stride >= width * 4 &&
-           pixels.size() >= static_cast<std::size_t>(stride) * height;
+           pixels.size() >= static_cast<std::size_t>(stride) * (height - 1) +
+                                static_cast<std::size_t>(width) * 4;
   }
 };
 
+/// 8-bit palettised pixels. `palette` holds up to 256 colours packed as R, G,
+/// B, A in memory order (the layout of PreparedPalette::colors); every index
+/// must be below `palette.size()`. Rows are `stride` bytes apart as in
+/// RgbaImageView.
+struct IndexedImageView {
+  std::span<const std::uint8_t> indices;
+  std::span<const std::uint32_t> palette;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::uint32_t stride = 0;
+
+  constexpr bool valid() const noexcept
+  {
+    return width > 0 && height > 0 && stride >= width && !palette.empty() &&
+           palette.size() <= 256 &&
+           indices.size() >= static_cast<std::size_t>(stride) * (height - 1) +
+                                 width;
+  }
+};
+
+/// A sub-rectangle of an image, in pixels from its top-left corner.
+struct ImageRect {
+  std::uint32_t x = 0;
+  std::uint32_t y = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+
+  constexpr bool empty() const noexcept { return width == 0 || height == 0; }
+};
+
 inline RgbaImageView make_view(const RgbaImage& image) noexcept
 {
   return RgbaImageView{image.pixels, image.width, image.height,
                        image.width * 4u};
 }
 
+/// The part of `view` inside `rect`, sharing its pixels and stride. `rect`
+/// must lie within the view.
+inline RgbaImageView crop_view(const RgbaImageView& view,
+                               ImageRect rect) noexcept
+{
+  const auto offset = static_cast<std::size_t>(rect.y) * view.stride +
+                      static_cast<std::size_t>(rect.x) * 4;
+  return RgbaImageView{view.pixels.subspan(offset), rect.width, rect.height,
+                       view.stride};
+}
+
+inline IndexedImageView crop_view(const IndexedImageView& view,
+                                  ImageRect rect) noexcept
+{
+  const auto offset =
+      static_cast<std::size_t>(rect.y) * view.stride + rect.x;
+  return IndexedImageView{view.indices.subspan(offset), view.palette,
+                          rect.width, rect.height, view.stride};
+}
+
 }  // namespace art2img::core
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -24,4 +25,51 @@ struct ExportManifest {
   std::vector<AnimationData> animations;
 };
 
+struct AtlasPage {
+  std::string image;  // file the page was written to, if any
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+};
+
+/// Where one tile landed in an atlas. The origin is the tile's picanm centre
+/// offset, so consumers can anchor the sprite the way the engine does.
+struct AtlasEntry {
+  std::size_t tile = 0;
+  std::uint32_t page = 0;
+  std::uint32_t x = 0;
+  std::uint32_t y = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::int32_t origin_x = 0;
+  std::int32_t origin_y = 0;
+};
+
+struct AtlasManifest {
+  std::uint32_t tile_start = 0;  // picnum of archive tile 0
+  std::vector<AtlasPage> pages;
+  std::vector<AtlasEntry> entries;
+};
+
+/// One tile written trimmed to its opaque pixels. The image is the
+/// `trimmed_width` x `trimmed_height` part of the full `width` x `height`
+/// tile starting at (`x`, `y`); the origin is the full tile's picanm centre
+/// offset, as in AtlasEntry.
+struct TrimEntry {
+  std::size_t tile = 0;
+  std::string image;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::uint32_t x = 0;
+  std::uint32_t y = 0;
+  std::uint32_t trimmed_width = 0;
+  std::uint32_t trimmed_height = 0;
+  std::int32_t origin_x = 0;
+  std::int32_t origin_y = 0;
+};
+
+struct TrimManifest {
+  std::uint32_t tile_start = 0;  // picnum of archive tile 0
+  std::vector<TrimEntry> entries;
+};
+
 }  // namespace art2img::core
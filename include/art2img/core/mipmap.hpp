@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <vector>
+
+#include "error.hpp"
+#include "image.hpp"
+
+namespace art2img::core {
+
+/// MipmapOptions::levels value that keeps halving down to 1x1.
+inline constexpr std::uint32_t full_mip_chain =
+    std::numeric_limits<std::uint32_t>::max();
+
+struct MipmapOptions {
+  std::uint32_t levels = 0;  // downscaled levels below the full-size image
+  std::uint32_t thumbnail_size = 0;  // when set, also fit one in this square
+};
+
+/// Scales `image` to `width` by `height` with an area-weighted box filter.
+/// Straight alpha is weighted by coverage, so fully transparent pixels
+/// (palette index 255) add no colour to their neighbours and a pixel whose
+/// whole footprint is transparent comes out as transparent black, as
+/// palette_to_rgba writes them. Pass `premultiplied` for pixels that already
+/// carry premultiplied alpha; those are averaged channel by channel.
+std::expected<RgbaImage, Error> resize_rgba(const RgbaImageView& image,
+                                            std::uint32_t width,
+                                            std::uint32_t height,
+                                            bool premultiplied = false);
+
+/// Up to `levels` successive halvings of `base`, largest first: each level
+/// halves both dimensions, rounding down and stopping at 1, and is filtered
+/// from the previous one. The chain ends once a 1x1 level is produced.
+std::expected<std::vector<RgbaImage>, Error> build_mip_chain(
+    const RgbaImageView& base,
+    std::uint32_t levels = full_mip_chain,
+    bool premultiplied = false);
+
+/// `image` scaled to fit within `max_size` square with its aspect ratio kept;
+/// images that already fit are copied unscaled.
+std::expected<RgbaImage, Error> make_thumbnail(const RgbaImageView& image,
+                                               std::uint32_t max_size,
+                                               bool premultiplied = false);
+
+}  // namespace art2img::core
@@ -45,6 +45,12 @@ struct Palette {
 std::expected<Palette, Error> load_palette(
     std::span<const std::byte> blob) noexcept;
 
+/// Validates `blob` as load_palette does and returns a view straight into it,
+/// copying nothing. `blob` must outlive the view. `translucent` is empty when
+/// the blob has no translucency table, where load_palette would zero-fill it.
+std::expected<PaletteView, Error> load_palette_view(
+    std::span<const std::byte> blob) noexcept;
+
 PaletteView view_palette(const Palette&) noexcept;
 
 }  // namespace art2img::core
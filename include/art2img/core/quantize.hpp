@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <vector>
+
+#include "art.hpp"
+#include "error.hpp"
+#include "image.hpp"
+#include "palette.hpp"
+
+namespace art2img::core {
+
+/// Edge length of the RGB lookup grid; each cell spans 8 levels a channel.
+inline constexpr std::size_t quantize_grid_size = 32;
+
+/// Nearest-colour search over a palette's first 255 entries, built once per
+/// palette and shared read-only between threads. The RGB cube is cut into
+/// 32x32x32 cells and each cell keeps only the entries that can be nearest
+/// to some colour inside it, so a lookup checks a handful of candidates and
+/// still returns the exact nearest (lowest index on ties). Index 255 is
+/// reserved for transparency and is never a candidate.
+struct QuantizeTable {
+  std::array<std::uint8_t, palette_component_count> rgb{};  // 8-bit colours
+  std::vector<std::uint32_t> cell_offsets{};  // grid^3 + 1 into candidates
+  std::vector<std::uint8_t> candidates{};
+};
+
+struct QuantizeOptions {
+  /// Pixels with alpha below this become index 255, the transparent index.
+  std::uint8_t alpha_threshold = 1;
+};
+
+std::expected<QuantizeTable, Error> prepare_quantize_table(
+    PaletteView palette);
+
+/// Index of the palette colour nearest to (r, g, b) in squared RGB distance.
+std::uint8_t nearest_index(const QuantizeTable& table,
+                           std::uint8_t r,
+                           std::uint8_t g,
+                           std::uint8_t b) noexcept;
+
+/// Writes one index per pixel into the first `width * height` bytes of
+/// `out`, column-major as ART stores tiles (TileView::indices), so the tile
+/// converts back to the same colours for every pixel that had an exact
+/// palette match.
+std::expected<void, Error> rgba_to_indices_into(const RgbaImageView& image,
+                                                const QuantizeTable& table,
+                                                std::span<std::byte> out,
+                                                QuantizeOptions options = {});
+
+/// Quantises `image` into a tile ready for write_art. ART dimensions are
+/// 16-bit and load_art accepts at most 4096 a side.
+std::expected<ArtTileData, Error> rgba_to_tile(const RgbaImageView& image,
+                                               const QuantizeTable& table,
+                                               QuantizeOptions options = {});
+
+}  // namespace art2img::core
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace art2img::core {
+
+/// Instrumented entry points. `batch` spans a whole extras::convert_tiles
+/// call and so overlaps the per-tile stages it runs.
+enum class Stage : std::uint8_t {
+  load_art,
+  convert,
+  postprocess,
+  encode,
+  write,
+  batch,
+};
+
+inline constexpr std::size_t stage_count = 6;
+
+/// StageRecord::tag of a call made outside any ScopedStageTag.
+inline constexpr std::uint64_t no_stage_tag = ~std::uint64_t{0};
+
+constexpr std::string_view stage_name(Stage stage) noexcept
+{
+  switch (stage) {
+    case Stage::load_art:
+      return "load_art";
+    case Stage::convert:
+      return "convert";
+    case Stage::postprocess:
+      return "postprocess";
+    case Stage::encode:
+      return "encode";
+    case Stage::write:
+      return "write";
+    case Stage::batch:
+      return "batch";
+  }
+  return "unknown";
+}
+
+/// One instrumented call. `allocations` counts the heap buffers the library
+/// itself allocated or grew during the call (outputs and workspace growth).
+struct StageRecord {
+  Stage stage = Stage::convert;
+  std::uint64_t start_ns = 0;  // steady_clock time since its epoch
+  std::uint64_t duration_ns = 0;
+  std::uint64_t pixels = 0;
+  std::uint64_t bytes_in = 0;
+  std::uint64_t bytes_out = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t tag = no_stage_tag;  // innermost ScopedStageTag, e.g. a tile
+};
+
+/// Receives a record as each instrumented call returns, on the thread that
+/// made the call, so implementations must be thread-safe.
+class StatsSink {
+ public:
+  virtual ~StatsSink() = default;
+  virtual void record(const StageRecord& record) noexcept = 0;
+};
+
+namespace detail {
+inline std::atomic<StatsSink*> active_stats_sink{nullptr};
+}  // namespace detail
+
+/// Installs the process-wide sink; null, the default, turns instrumentation
+/// off. The sink must outlive every call that may report into it.
+inline void set_stats_sink(StatsSink* sink) noexcept
+{
+  detail::active_stats_sink.store(sink, std::memory_order_release);
+}
+
+inline StatsSink* stats_sink() noexcept
+{
+  return detail::active_stats_sink.load(std::memory_order_acquire);
+}
+
+struct StageTotals {
+  std::uint64_t calls = 0;
+  std::uint64_t nanoseconds = 0;
+  std::uint64_t pixels = 0;
+  std::uint64_t bytes_in = 0;
+  std::uint64_t bytes_out = 0;
+  std::uint64_t allocations = 0;
+};
+
+/// Sums records per stage with relaxed atomics.
+class StatsCollector final : public StatsSink {
+ public:
+  void record(const StageRecord& record) noexcept override;
+
+  std::array<StageTotals, stage_count> totals() const noexcept;
+  void reset() noexcept;
+
+ private:
+  struct Counters {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> pixels{0};
+    std::atomic<std::uint64_t> bytes_in{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+    std::atomic<std::uint64_t> allocations{0};
+  };
+  std::array<Counters, stage_count> counters_{};
+};
+
+/// Times the enclosing scope as one `stage` call when a sink is installed;
+/// otherwise it does nothing beyond one atomic load. A timer nested inside
+/// one for the same stage on the same thread adds its counts to the outer
+/// record instead of reporting, so public overloads that call one another
+/// report once.
+class StageTimer {
+ public:
+  explicit StageTimer(Stage stage) noexcept;
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+  ~StageTimer();
+
+  void add_pixels(std::uint64_t count) noexcept
+  {
+    if (target_ != nullptr) {
+      target_->pixels += count;
+    }
+  }
+  void add_bytes_in(std::uint64_t count) noexcept
+  {
+    if (target_ != nullptr) {
+      target_->bytes_in += count;
+    }
+  }
+  void add_bytes_out(std::uint64_t count) noexcept
+  {
+    if (target_ != nullptr) {
+      target_->bytes_out += count;
+    }
+  }
+
+ private:
+  StatsSink* sink_ = nullptr;      // set only on the outermost timer
+  StageRecord* target_ = nullptr;  // the record counts go to, if any
+  StageRecord record_{};
+  std::uint64_t allocations_before_ = 0;
+};
+
+/// Labels the stages timed on this thread within the scope with `tag`, so a
+/// sink can attribute them to one item of work (the CLI uses tile indices).
+class ScopedStageTag {
+ public:
+  explicit ScopedStageTag(std::uint64_t tag) noexcept;
+  ScopedStageTag(const ScopedStageTag&) = delete;
+  ScopedStageTag& operator=(const ScopedStageTag&) = delete;
+  ~ScopedStageTag();
+
+ private:
+  std::uint64_t previous_;
+};
+
+/// Counts heap allocations towards the stages timed on this thread.
+void note_allocation(std::uint64_t count = 1) noexcept;
+
+}  // namespace art2img::core
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <vector>
+
+#include "../core/art.hpp"
+#include "../core/convert.hpp"
+#include "../core/encode.hpp"
+#include "../core/meta.hpp"
+#include "parallel.hpp"
+
+namespace art2img::extras {
+
+struct AtlasOptions {
+  std::uint32_t max_size = 2048;  // page width and height limit in pixels
+  std::uint32_t padding = 1;      // transparent gap kept around every tile
+};
+
+/// Packs the non-empty tiles of `tiles` onto as few pages as `max_size`
+/// allows with a first-fit shelf packer over tiles sorted by height. A tile
+/// too large for a page gets a page of its own. Entries follow request order;
+/// page images are left unnamed.
+std::expected<core::AtlasManifest, core::Error> pack_atlas(
+    const core::ArtArchive& archive,
+    std::span<const std::size_t> tiles,
+    AtlasOptions options = {});
+
+struct AtlasRequest {
+  const core::ArtArchive* archive = nullptr;
+  const core::Palette* palette = nullptr;
+  std::vector<std::size_t> tiles;  // empty selects every tile
+  core::ImageFormat format = core::ImageFormat::png;
+  core::ConversionOptions conversion{};
+  core::EncoderOptions encoder{};
+  AtlasOptions atlas{};
+  ParallelOptions parallel{};
+};
+
+struct AtlasResult {
+  core::AtlasManifest manifest;
+  std::vector<core::EncodedImage> pages;  // indexed like manifest.pages
+};
+
+/// Packs, converts and encodes the requested tiles into atlas pages. Each
+/// tile is converted on its own, so matte hygiene never bleeds across rects.
+std::expected<AtlasResult, core::Error> build_atlas(
+    const AtlasRequest& request);
+
+}  // namespace art2img::extras
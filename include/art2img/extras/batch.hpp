@@ -2,28 +2,85 @@
 
 #include <cstddef>
 #include <expected>
+#include <functional>
+#include <span>
 #include <vector>
 
+#include "../core/collection.hpp"
 #include "../core/convert.hpp"
 #include "../core/encode.hpp"
+#include "../core/mipmap.hpp"
+#include "parallel.hpp"
 
 namespace art2img::extras {
 
 struct BatchRequest {
   const core::ArtArchive* archive = nullptr;
+  /// When set instead of `archive`, `tiles` holds global tile numbers and
+  /// the batch runs across every archive of the collection as one work list.
+  const core::ArtCollection* collection = nullptr;
   const core::Palette* palette = nullptr;
   std::vector<std::size_t> tiles;
   core::ImageFormat format = core::ImageFormat::png;
   core::ConversionOptions conversion{};
   core::PostprocessOptions postprocess{};
   core::EncoderOptions encoder{};
+  ParallelOptions parallel{};  // tiles run largest-first when threads != 1
+  /// Convert byte-identical tiles once (see find_duplicate_tiles); their
+  /// entries then share one encoded image.
+  bool deduplicate = false;
+  /// Downscaled levels and a thumbnail, filtered from each tile's pixels
+  /// right after conversion and encoded like the full-size image. Alpha is
+  /// treated as premultiplied when either premultiply option is set.
+  core::MipmapOptions mipmaps{};
 };
 
 struct BatchResult {
+  /// One per request tile, in BatchRequest::tiles order, unless the request
+  /// deduplicated; then one per distinct tile, in first-seen order.
   std::vector<core::EncodedImage> images;
+  std::vector<std::size_t> sources;  // per request tile: index into images
+  /// Per entry of images, filled when the request asked for them: the
+  /// encoded mip levels, largest first, and the thumbnail. DDS images hold
+  /// their mip chain themselves, so their `levels` entries stay empty.
+  std::vector<std::vector<core::EncodedImage>> levels;
+  std::vector<core::EncodedImage> thumbnails;
 };
 
+/// The stages run for each tile are tagged (core::ScopedStageTag) with its
+/// BatchRequest::tiles entry, so a stats sink can time tiles one by one.
 std::expected<BatchResult, core::Error> convert_tiles(
     const BatchRequest& request);
 
+/// Receives each distinct encoded image with the request positions it serves
+/// (several when the request deduplicated). Returning false stops the batch.
+using TileSink = std::function<bool(std::span<const std::size_t> positions,
+                                    const core::EncodedImage& image)>;
+
+struct StreamOptions {
+  /// Encoded images alive at once, from the start of their conversion until
+  /// the sink returns; workers wait for room before starting a tile. 0 allows
+  /// two per worker thread. Peak memory is about this many largest tiles.
+  std::size_t max_in_flight = 0;
+};
+
+/// Converts like convert_tiles but hands each image to `sink` as soon as it
+/// is encoded, in completion order, and keeps none of them. The sink runs on
+/// the calling thread, one image at a time, while workers carry on. Images
+/// already delivered stay delivered if a later tile fails; the error is that
+/// of the earliest failing position, as in convert_tiles, and stages are
+/// tagged the same way. Requests with `mipmaps` are rejected as unsupported;
+/// use convert_tiles for those.
+std::expected<void, core::Error> convert_tiles_streaming(
+    const BatchRequest& request,
+    const TileSink& sink,
+    StreamOptions options = {});
+
+/// The encoded image for request tile `position`, shared or not.
+inline const core::EncodedImage& image_for(const BatchResult& result,
+                                           std::size_t position)
+{
+  return result.images[result.sources[position]];
+}
+
 }  // namespace art2img::extras
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "../core/art.hpp"
+
+namespace art2img::extras {
+
+/// Groups byte-identical tiles: same dimensions, indices and lookup bytes.
+/// Returns, for every position in `tiles`, the position of the first tile
+/// identical to it (itself when it is unique), so each group can be
+/// converted once and the result reused. Fingerprint collisions are settled
+/// by comparing the payloads. Out-of-range indices map to themselves.
+std::vector<std::size_t> find_duplicate_tiles(
+    const core::ArtArchive& archive,
+    std::span<const std::size_t> tiles);
+
+/// The same grouping over tiles already resolved, one view per position,
+/// from any number of archives. Empty views map to themselves.
+std::vector<std::size_t> find_duplicate_tiles(
+    std::span<const core::TileView> views);
+
+}  // namespace art2img::extras
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "../core/error.hpp"
+#include "../core/palette.hpp"
+
+namespace art2img::extras {
+
+/// Parsed palettes keyed by the content of their source bytes, so requests
+/// that load the same PALETTE.DAT share one validated copy instead of parsing
+/// their own. Holds up to `capacity` palettes, dropping the least recently
+/// used; a dropped palette stays valid for whoever still holds it. Safe to
+/// use from several threads.
+class PaletteCache {
+ public:
+  explicit PaletteCache(std::size_t capacity = 16) : capacity_(capacity) {}
+
+  /// The palette whose source bytes equal `blob`, parsed on first sight with
+  /// core::load_palette_view over a private copy of them. The view stays
+  /// valid for as long as the returned pointer lives.
+  std::expected<std::shared_ptr<const core::PaletteView>, core::Error> get(
+      std::span<const std::byte> blob);
+
+  std::size_t size() const;
+  void clear();
+
+ private:
+  struct Stored {
+    std::vector<std::byte> bytes;
+    core::PaletteView view;
+  };
+  struct Entry {
+    std::uint64_t key;
+    std::shared_ptr<const Stored> palette;
+  };
+
+  mutable std::mutex mutex_{};
+  std::size_t capacity_;
+  std::vector<Entry> entries_{};  // least recently used first
+};
+
+/// The process-wide cache, created on first use.
+PaletteCache& palette_cache();
+
+}  // namespace art2img::extras
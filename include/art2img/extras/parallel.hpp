@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "../core/art.hpp"
+
+namespace art2img::extras {
+
+/// Runs `worker(slot)` once for every slot in [0, slots) and returns after all
+/// of them have finished. Implementations may run slots concurrently; the
+/// default spawns one std::jthread per slot beyond the first.
+using Executor =
+    std::function<void(std::size_t slots,
+                       const std::function<void(std::size_t slot)>& worker)>;
+
+struct ParallelOptions {
+  std::size_t threads = 1;  // 0 selects std::thread::hardware_concurrency()
+  Executor executor{};      // empty uses run_on_threads
+};
+
+void run_on_threads(std::size_t slots,
+                    const std::function<void(std::size_t slot)>& worker);
+
+std::size_t resolve_thread_count(std::size_t requested,
+                                 std::size_t items) noexcept;
+
+/// Orders positions into `tiles` by descending pixel count so the largest
+/// tiles start first and small ones fill the gaps at the end of a run.
+/// Positions whose tile index is out of range sort last.
+std::vector<std::size_t> largest_first(const core::ArtArchive& archive,
+                                       std::span<const std::size_t> tiles);
+
+/// The same order for tiles already resolved, one view per position.
+std::vector<std::size_t> largest_first(std::span<const core::TileView> views);
+
+/// Hands the items of `order` to worker slots one at a time, in order, until
+/// the list is exhausted or `body` returns false. `body` receives the item
+/// and the slot running it so callers can keep per-worker state.
+void for_each_index(
+    std::span<const std::size_t> order,
+    const ParallelOptions& options,
+    const std::function<bool(std::size_t item, std::size_t slot)>& body);
+
+}  // namespace art2img::extras
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../core/stats.hpp"
+
+namespace art2img::extras {
+
+/// StatsSink that keeps every record as a span for a Chrome Trace Event
+/// (chrome://tracing, Perfetto) timeline. Each thread appends to a buffer of
+/// its own, so recording takes no lock after a thread's first record.
+/// Records are also passed on to `forward` when one is given, so a trace and
+/// aggregate counters can be collected in the same run.
+class TraceRecorder final : public core::StatsSink {
+ public:
+  explicit TraceRecorder(core::StatsSink* forward = nullptr);
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+  ~TraceRecorder() override;
+
+  void record(const core::StageRecord& record) noexcept override;
+
+  /// Spans recorded so far across every thread.
+  std::size_t span_count() const;
+
+  /// The trace as a JSON object with one complete ("X") event per span and
+  /// a thread name per recording thread; timestamps start at the earliest
+  /// span. Call once no instrumented call is still running.
+  std::string chrome_trace_json() const;
+
+ private:
+  struct Buffer {
+    std::size_t thread = 0;  // trace tid, in order of first record
+    std::vector<core::StageRecord> spans;
+  };
+
+  Buffer* buffer_for_this_thread();
+
+  core::StatsSink* forward_;
+  std::uint64_t id_;  // tells recorders apart in the thread-local cache
+  mutable std::mutex mutex_{};
+  std::vector<std::unique_ptr<Buffer>> buffers_{};
+};
+
+}  // namespace art2img::extras
@@ -1,13 +1,14 @@
 #include <art2img/adapters/grp.hpp>
 
 #include <algorithm>
-#include <cctype>
+#include <cstdint>
 #include <cstddef>
 #include <expected>
 #include <memory>
 #include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -29,23 +30,66 @@ std::uint32_t read_u32(std::span<const std::byte> data, std::size_t offset)
   return value;
 }
 
-std::string normalise_name(std::string_view name)
+constexpr char fold_ascii(char c) noexcept
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string_view trim_name(std::string_view name) noexcept
 {
-  std::string lowered(name);
-  while (!lowered.empty() &&
-         (lowered.back() == '\0' || lowered.back() == ' ')) {
-    lowered.pop_back();
+  while (!name.empty() && (name.back() == '\0' || name.back() == ' ')) {
+    name.remove_suffix(1);
   }
-  std::transform(
-      lowered.begin(), lowered.end(), lowered.begin(),
-      [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return name;
+}
+
+std::string normalise_name(std::string_view name)
+{
+  std::string lowered(trim_name(name));
+  std::transform(lowered.begin(), lowered.end(), lowered.begin(), fold_ascii);
   return lowered;
 }
 
 }  // namespace
 
+std::size_t GrpNameHash::operator()(std::string_view name) const noexcept
+{
+  // FNV-1a over the case-folded bytes.
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(fold_ascii(c));
+    hash *= 1099511628211ull;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+bool GrpNameEqual::operator()(std::string_view lhs,
+                              std::string_view rhs) const noexcept
+{
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+           return fold_ascii(a) == fold_ascii(b);
+         });
+}
+
 std::expected<GrpFile, core::Error> load_grp(
     std::span<const std::byte> blob) noexcept
+{
+  auto storage =
+      std::make_shared<const std::vector<std::byte>>(blob.begin(), blob.end());
+  const std::span<const std::byte> data(*storage);
+  return load_grp(std::move(storage), data);
+}
+
+std::expected<GrpFile, core::Error> load_grp_borrowed(
+    std::span<const std::byte> blob) noexcept
+{
+  return load_grp(nullptr, blob);
+}
+
+std::expected<GrpFile, core::Error> load_grp(
+    std::shared_ptr<const void> owner,
+    std::span<const std::byte> blob) noexcept
 {
   if (blob.size() < kSignature.size() + 4) {
     return std::unexpected(core::make_error(core::errc::invalid_art,
@@ -68,44 +112,46 @@ std::expected<GrpFile, core::Error> load_grp(
         core::make_error(core::errc::invalid_art, "GRP directory truncated"));
   }
 
-  auto storage =
-      std::make_shared<std::vector<std::byte>>(blob.begin(), blob.end());
-  std::span<const std::byte> data(*storage);
+  const std::span<const std::byte> data = blob;
 
   std::vector<GrpEntry> entries;
   entries.reserve(entry_count);
+  std::unordered_map<std::string_view, std::size_t, GrpNameHash, GrpNameEqual>
+      index;
+  index.reserve(entry_count);
   std::size_t data_offset = directory_offset + directory_bytes;
   std::size_t directory_cursor = directory_offset;
   for (std::uint32_t i = 0; i < entry_count; ++i) {
-    std::string name(
+    const auto name = trim_name(std::string_view(
         reinterpret_cast<const char*>(data.data() + directory_cursor),
-        kNameSize);
-    const auto normalised = normalise_name(name);
+        kNameSize));
     const std::uint32_t size = read_u32(data, directory_cursor + kNameSize);
     if (data_offset + size > data.size()) {
       return std::unexpected(core::make_error(core::errc::invalid_art,
                                               "GRP entry exceeds file size"));
     }
-    entries.push_back(GrpEntry{normalised, data.subspan(data_offset, size)});
+    // Later duplicates never shadow the first entry with the same name.
+    index.emplace(name, entries.size());
+    entries.push_back(
+        GrpEntry{normalise_name(name), data.subspan(data_offset, size)});
     data_offset += size;
     directory_cursor += kDirectoryEntrySize;
   }
 
   GrpFile file;
   file.entries_ = std::move(entries);
-  file.storage_ = std::move(storage);
+  file.index_ = std::move(index);
+  file.storage_ = std::move(owner);
   return file;
 }
 
 std::optional<GrpEntry> GrpFile::entry(std::string_view name) const noexcept
 {
-  std::string key = normalise_name(name);
-  for (const auto& entry : entries_) {
-    if (entry.name == key) {
-      return entry;
-    }
+  const auto found = index_.find(trim_name(name));
+  if (found == index_.end()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return entries_[found->second];
 }
 
 }  // namespace art2img::adapters
@@ -1,15 +1,210 @@
 #include <art2img/adapters/io.hpp>
 
 #include <climits>
+#include <cstdint>
 #include <expected>
 #include <filesystem>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <span>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <art2img/core/stats.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace art2img::adapters {
 
+namespace {
+
+#ifdef _WIN32
+
+struct Mapping {
+  const void* view = nullptr;
+
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+  ~Mapping()
+  {
+    if (view != nullptr) {
+      UnmapViewOfFile(view);
+    }
+  }
+};
+
+std::expected<MappedFile, core::Error> map_whole_file(
+    const std::filesystem::path& path)
+{
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to open file: " + path.string()));
+  }
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "failed to determine file size: " + path.string()));
+  }
+  if (static_cast<unsigned long long>(size.QuadPart) >
+      std::numeric_limits<std::size_t>::max()) {
+    CloseHandle(file);
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "file too large to map: " + path.string()));
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return MappedFile{};
+  }
+
+  HANDLE section =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (section == nullptr) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to map file: " + path.string()));
+  }
+
+  auto mapping = std::make_shared<Mapping>();
+  mapping->view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(section);
+  if (mapping->view == nullptr) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to map file: " + path.string()));
+  }
+
+  MappedFile mapped{};
+  mapped.data = std::span<const std::byte>(
+      static_cast<const std::byte*>(mapping->view),
+      static_cast<std::size_t>(size.QuadPart));
+  mapped.handle = std::move(mapping);
+  return mapped;
+}
+
+#else
+
+struct Mapping {
+  void* address = MAP_FAILED;
+  std::size_t length = 0;
+
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+  ~Mapping()
+  {
+    if (address != MAP_FAILED) {
+      munmap(address, length);
+    }
+  }
+};
+
+std::expected<MappedFile, core::Error> map_whole_file(
+    const std::filesystem::path& path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to open file: " + path.string()));
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "failed to determine file size: " + path.string()));
+  }
+  if (!S_ISREG(info.st_mode)) {
+    ::close(fd);
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "not a regular file: " + path.string()));
+  }
+  if (static_cast<std::uintmax_t>(info.st_size) >
+      std::numeric_limits<std::size_t>::max()) {
+    ::close(fd);
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "file too large to map: " + path.string()));
+  }
+  if (info.st_size == 0) {
+    ::close(fd);
+    return MappedFile{};
+  }
+
+  auto mapping = std::make_shared<Mapping>();
+  mapping->length = static_cast<std::size_t>(info.st_size);
+  mapping->address =
+      ::mmap(nullptr, mapping->length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (mapping->address == MAP_FAILED) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to map file: " + path.string()));
+  }
+
+  MappedFile mapped{};
+  mapped.data = std::span<const std::byte>(
+      static_cast<const std::byte*>(mapping->address), mapping->length);
+  mapped.handle = std::move(mapping);
+  return mapped;
+}
+
+#endif
+
+template <typename Encode>
+std::expected<std::size_t, core::Error> stream_to_file(
+    const std::filesystem::path& path,
+    Encode&& encode)
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "failed to open file for writing: " + path.string()));
+  }
+
+  const core::EncodeSink sink = [&file](std::span<const std::byte> chunk) {
+    return static_cast<bool>(
+        file.write(reinterpret_cast<const char*>(chunk.data()),
+                   static_cast<std::streamsize>(chunk.size())));
+  };
+  auto written = encode(sink);
+  file.close();
+  if (written && !file.fail()) {
+    return written;
+  }
+
+  std::error_code ignored;
+  std::filesystem::remove(path, ignored);
+  if (file.fail()) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to write file: " + path.string()));
+  }
+  return std::unexpected(written.error());
+}
+
+}  // namespace
+
 std::expected<std::vector<std::byte>, core::Error> read_binary_file(
     const std::filesystem::path& path)
 {
@@ -44,9 +239,37 @@ std::expected<std::vector<std::byte>, core::Error> read_binary_file(
   return buffer;
 }
 
+std::expected<MappedFile, core::Error> map_file(
+    const std::filesystem::path& path)
+{
+  return map_whole_file(path);
+}
+
+std::expected<core::ArtCollection, core::Error> open_art_collection(
+    std::span<const std::filesystem::path> paths)
+{
+  std::vector<core::ArtArchive> archives;
+  archives.reserve(paths.size());
+  for (const auto& path : paths) {
+    auto mapped = map_whole_file(path);
+    if (!mapped) {
+      return std::unexpected(mapped.error());
+    }
+    auto archive = core::load_art(mapped->handle, mapped->data);
+    if (!archive) {
+      return std::unexpected(
+          core::Error{archive.error().code,
+                      path.string() + ": " + archive.error().message});
+    }
+    archives.push_back(std::move(*archive));
+  }
+  return core::make_art_collection(std::move(archives));
+}
+
 std::expected<void, core::Error> write_file(const std::filesystem::path& path,
                                             std::span<const std::byte> data)
 {
+  core::StageTimer timer(core::Stage::write);
   std::ofstream file(path, std::ios::binary | std::ios::trunc);
   if (!file) {
     return std::unexpected(
@@ -60,7 +283,31 @@ std::expected<void, core::Error> write_file(const std::filesystem::path& path,
         core::errc::io_failure, "failed to write file: " + path.string()));
   }
 
+  timer.add_bytes_in(data.size());
+  timer.add_bytes_out(data.size());
   return {};
 }
 
+std::expected<std::size_t, core::Error> encode_to_file(
+    const std::filesystem::path& path,
+    const core::RgbaImageView& image,
+    core::ImageFormat format,
+    core::EncoderOptions options)
+{
+  return stream_to_file(path, [&](const core::EncodeSink& sink) {
+    return core::encode_image_to(image, format, sink, options);
+  });
+}
+
+std::expected<std::size_t, core::Error> encode_to_file(
+    const std::filesystem::path& path,
+    const core::IndexedImageView& image,
+    core::ImageFormat format,
+    core::EncoderOptions options)
+{
+  return stream_to_file(path, [&](const core::EncodeSink& sink) {
+    return core::encode_indexed_image_to(image, format, sink, options);
+  });
+}
+
 }  // namespace art2img::adapters
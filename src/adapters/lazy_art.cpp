@@ -0,0 +1,266 @@
+#include <art2img/adapters/lazy_art.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace art2img::adapters {
+
+namespace {
+
+constexpr std::size_t kHeaderSize = 16;
+constexpr std::size_t kLookupStride = 256;
+
+core::Error read_error(const std::filesystem::path& path)
+{
+  return core::make_error(core::errc::io_failure,
+                          "failed to read file: " + path.string());
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+struct LazyArtArchive::File {
+  HANDLE handle = INVALID_HANDLE_VALUE;
+  std::filesystem::path path;
+
+  File() = default;
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+  ~File()
+  {
+    if (handle != INVALID_HANDLE_VALUE) {
+      CloseHandle(handle);
+    }
+  }
+
+  static std::expected<std::shared_ptr<File>, core::Error> open(
+      const std::filesystem::path& path)
+  {
+    auto file = std::make_shared<File>();
+    file->path = path;
+    file->handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+    if (file->handle == INVALID_HANDLE_VALUE) {
+      return std::unexpected(core::make_error(
+          core::errc::io_failure, "failed to open file: " + path.string()));
+    }
+    return file;
+  }
+
+  std::expected<std::size_t, core::Error> size() const
+  {
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(handle, &size) ||
+        static_cast<unsigned long long>(size.QuadPart) >
+            std::numeric_limits<std::size_t>::max()) {
+      return std::unexpected(
+          core::make_error(core::errc::io_failure,
+                           "failed to determine file size: " + path.string()));
+    }
+    return static_cast<std::size_t>(size.QuadPart);
+  }
+
+  /// Fills `out` from `offset` without touching any shared file position.
+  std::expected<void, core::Error> read_at(std::uint64_t offset,
+                                           std::span<std::byte> out) const
+  {
+    while (!out.empty()) {
+      OVERLAPPED at{};
+      at.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+      at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+      const auto chunk = static_cast<DWORD>(
+          std::min<std::size_t>(out.size(), std::size_t{1} << 30));
+      DWORD read = 0;
+      if (!ReadFile(handle, out.data(), chunk, &read, &at) || read == 0) {
+        return std::unexpected(read_error(path));
+      }
+      offset += read;
+      out = out.subspan(read);
+    }
+    return {};
+  }
+};
+
+#else
+
+struct LazyArtArchive::File {
+  int fd = -1;
+  std::filesystem::path path;
+
+  File() = default;
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+  ~File()
+  {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  static std::expected<std::shared_ptr<File>, core::Error> open(
+      const std::filesystem::path& path)
+  {
+    auto file = std::make_shared<File>();
+    file->path = path;
+    file->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+      return std::unexpected(core::make_error(
+          core::errc::io_failure, "failed to open file: " + path.string()));
+    }
+    return file;
+  }
+
+  std::expected<std::size_t, core::Error> size() const
+  {
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      return std::unexpected(
+          core::make_error(core::errc::io_failure,
+                           "failed to determine file size: " + path.string()));
+    }
+    if (!S_ISREG(info.st_mode)) {
+      return std::unexpected(core::make_error(
+          core::errc::io_failure, "not a regular file: " + path.string()));
+    }
+    return static_cast<std::size_t>(info.st_size);
+  }
+
+  /// Fills `out` from `offset` without touching any shared file position.
+  std::expected<void, core::Error> read_at(std::uint64_t offset,
+                                           std::span<std::byte> out) const
+  {
+    while (!out.empty()) {
+      const auto read = ::pread(fd, out.data(), out.size(),
+                                static_cast<off_t>(offset));
+      if (read < 0 && errno == EINTR) {
+        continue;
+      }
+      if (read <= 0) {
+        return std::unexpected(read_error(path));
+      }
+      offset += static_cast<std::uint64_t>(read);
+      out = out.subspan(static_cast<std::size_t>(read));
+    }
+    return {};
+  }
+};
+
+#endif
+
+std::expected<LazyArtArchive, core::Error> open_art_lazy(
+    const std::filesystem::path& path)
+{
+  auto file = LazyArtArchive::File::open(path);
+  if (!file) {
+    return std::unexpected(file.error());
+  }
+  const auto size = (*file)->size();
+  if (!size) {
+    return std::unexpected(size.error());
+  }
+  if (*size < kHeaderSize) {
+    return std::unexpected(core::make_error(core::errc::invalid_art,
+                                            "ART data too small for header"));
+  }
+
+  // Header first, to learn how long the tile arrays are, then the arrays.
+  std::vector<std::byte> tables(kHeaderSize);
+  auto read = (*file)->read_at(0, tables);
+  if (!read) {
+    return std::unexpected(read.error());
+  }
+  const auto tables_size = core::art_tables_size(tables);
+  if (!tables_size) {
+    return std::unexpected(tables_size.error());
+  }
+  if (*tables_size > *size) {
+    return std::unexpected(core::make_error(core::errc::invalid_art,
+                                            "ART data missing tile arrays"));
+  }
+  tables.resize(*tables_size);
+  read = (*file)->read_at(
+      kHeaderSize, std::span{tables}.subspan(kHeaderSize));
+  if (!read) {
+    return std::unexpected(read.error());
+  }
+
+  auto layout = core::parse_art_layout(tables, *size);
+  if (!layout) {
+    return std::unexpected(layout.error());
+  }
+
+  LazyArtArchive archive{};
+  archive.file_ = std::move(*file);
+  archive.layout_ = std::move(*layout);
+  archive.file_size_ = *size;
+  return archive;
+}
+
+std::expected<std::optional<core::TileView>, core::Error>
+LazyArtArchive::read_tile(std::size_t index,
+                          std::vector<std::byte>& storage) const
+{
+  if (index >= layout_.tiles.size() || !file_) {
+    return std::nullopt;
+  }
+
+  const auto& metrics = layout_.tiles[index];
+  const auto pixels = static_cast<std::size_t>(metrics.width) * metrics.height;
+  if (pixels == 0) {
+    return std::nullopt;
+  }
+  const auto pixel_start =
+      layout_.pixel_data_offset + layout_.pixel_offsets[index];
+
+  // Lookup bytes follow the pixel payload in 256-byte strides, the last one
+  // possibly cut short by the end of the file, as load_art reads them.
+  const auto lookup_start = layout_.lookup_data_offset + index * kLookupStride;
+  const auto lookup_size =
+      lookup_start < file_size_
+          ? std::min(kLookupStride, file_size_ - lookup_start)
+          : std::size_t{0};
+
+  storage.resize(pixels + lookup_size);
+  const std::span<std::byte> bytes{storage};
+  auto read = file_->read_at(pixel_start, bytes.first(pixels));
+  if (read && lookup_size > 0) {
+    read = file_->read_at(lookup_start, bytes.subspan(pixels));
+  }
+  if (!read) {
+    return std::unexpected(read.error());
+  }
+
+  core::TileView view{};
+  view.width = metrics.width;
+  view.height = metrics.height;
+  view.indices = bytes.first(pixels);
+  view.lookup = bytes.subspan(pixels);
+  return view;
+}
+
+}  // namespace art2img::adapters
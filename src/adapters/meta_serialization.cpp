@@ -83,4 +83,67 @@ std::expected<std::string, core::Error> format_animation_json(
   return out.str();
 }
 
+std::expected<std::string, core::Error> format_atlas_json(
+    const core::AtlasManifest& manifest)
+{
+  std::ostringstream out;
+  out << "{\n";
+  out << "  \"pages\": [\n";
+  for (std::size_t i = 0; i < manifest.pages.size(); ++i) {
+    const auto& page = manifest.pages[i];
+    out << "    {\"image\": \"" << page.image << "\", \"width\": "
+        << page.width << ", \"height\": " << page.height << "}"
+        << (i + 1 == manifest.pages.size() ? "\n" : ",\n");
+  }
+  out << "  ],\n";
+  out << "  \"tiles\": [\n";
+  for (std::size_t i = 0; i < manifest.entries.size(); ++i) {
+    const auto& entry = manifest.entries[i];
+    if (entry.page >= manifest.pages.size()) {
+      return std::unexpected(
+          manifest_error("atlas entry refers to a missing page"));
+    }
+    out << "    {\"tile\": " << entry.tile
+        << ", \"picnum\": " << manifest.tile_start + entry.tile
+        << ", \"page\": " << entry.page << ", \"x\": " << entry.x
+        << ", \"y\": " << entry.y << ", \"width\": " << entry.width
+        << ", \"height\": " << entry.height
+        << ", \"origin_x\": " << entry.origin_x
+        << ", \"origin_y\": " << entry.origin_y << "}"
+        << (i + 1 == manifest.entries.size() ? "\n" : ",\n");
+  }
+  out << "  ]\n";
+  out << "}\n";
+  return out.str();
+}
+
+std::expected<std::string, core::Error> format_trim_json(
+    const core::TrimManifest& manifest)
+{
+  std::ostringstream out;
+  out << "{\n";
+  out << "  \"tiles\": [\n";
+  for (std::size_t i = 0; i < manifest.entries.size(); ++i) {
+    const auto& entry = manifest.entries[i];
+    if (std::uint64_t{entry.x} + entry.trimmed_width > entry.width ||
+        std::uint64_t{entry.y} + entry.trimmed_height > entry.height) {
+      return std::unexpected(
+          manifest_error("trimmed rectangle lies outside its tile"));
+    }
+    out << "    {\"tile\": " << entry.tile
+        << ", \"picnum\": " << manifest.tile_start + entry.tile
+        << ", \"image\": \"" << entry.image << "\", \"width\": "
+        << entry.width << ", \"height\": " << entry.height
+        << ", \"x\": " << entry.x << ", \"y\": " << entry.y
+        << ", \"trimmed_width\": " << entry.trimmed_width
+        << ", \"trimmed_height\": " << entry.trimmed_height
+        << ", \"origin_x\": " << entry.origin_x
+        << ", \"origin_y\": " << entry.origin_y << "}"
+        << (i + 1 == manifest.entries.size() ? "\n" : ",\n");
+  }
+  out << "  ]\n";
+  out << "}\n";
+  return out.str();
+}
+
 }  // namespace art2img::adapters
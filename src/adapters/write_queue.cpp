@@ -0,0 +1,406 @@
+#include <art2img/adapters/write_queue.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/stats.hpp>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ART2IMG_HAVE_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace art2img::adapters {
+
+#ifdef ART2IMG_HAVE_IO_URING
+
+// Minimal io_uring over the raw syscalls, enough for batches of writev. Only
+// the writer thread touches it, so the sole synchronisation is with the
+// kernel through the ring head and tail indices.
+struct WriteQueue::Ring {
+  int fd = -1;
+  void* sq_map = MAP_FAILED;
+  std::size_t sq_map_size = 0;
+  void* cq_map = MAP_FAILED;
+  std::size_t cq_map_size = 0;
+  void* sqe_map = MAP_FAILED;
+  std::size_t sqe_map_size = 0;
+
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned sq_mask = 0;
+  unsigned sq_entries = 0;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_sqe* sqes = nullptr;
+  io_uring_cqe* cqes = nullptr;
+
+  Ring() = default;
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+  ~Ring()
+  {
+    if (sqe_map != MAP_FAILED) {
+      ::munmap(sqe_map, sqe_map_size);
+    }
+    if (cq_map != MAP_FAILED) {
+      ::munmap(cq_map, cq_map_size);
+    }
+    if (sq_map != MAP_FAILED) {
+      ::munmap(sq_map, sq_map_size);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  static std::unique_ptr<Ring> create(unsigned entries)
+  {
+    io_uring_params params{};
+    auto ring = std::make_unique<Ring>();
+    ring->fd =
+        static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (ring->fd < 0) {
+      return nullptr;
+    }
+
+    const auto map = [&](std::size_t size, off_t offset) {
+      return ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, offset);
+    };
+    ring->sq_map_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring->sqe_map_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sq_map = map(ring->sq_map_size, IORING_OFF_SQ_RING);
+    ring->cq_map = map(ring->cq_map_size, IORING_OFF_CQ_RING);
+    ring->sqe_map = map(ring->sqe_map_size, IORING_OFF_SQES);
+    if (ring->sq_map == MAP_FAILED || ring->cq_map == MAP_FAILED ||
+        ring->sqe_map == MAP_FAILED) {
+      return nullptr;
+    }
+
+    auto* sq = static_cast<std::byte*>(ring->sq_map);
+    auto* cq = static_cast<std::byte*>(ring->cq_map);
+    ring->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->sqes = static_cast<io_uring_sqe*>(ring->sqe_map);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return ring;
+  }
+
+  /// Queues a writev of `iov` at `offset`; the caller keeps at most
+  /// `sq_entries` operations outstanding.
+  void push(int file, const iovec* iov, std::uint64_t offset, std::uint64_t id)
+  {
+    const unsigned tail = *sq_tail;
+    const unsigned index = tail & sq_mask;
+    io_uring_sqe& sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_WRITEV;
+    sqe.fd = file;
+    sqe.addr = reinterpret_cast<std::uint64_t>(iov);
+    sqe.len = 1;
+    sqe.off = offset;
+    sqe.user_data = id;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  /// Submits `count` queued entries and waits for at least `wait`
+  /// completions. Returns the number submitted, or -errno.
+  int enter(unsigned count, unsigned wait)
+  {
+    const auto result =
+        ::syscall(__NR_io_uring_enter, fd, count, wait,
+                  wait > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+    return result < 0 ? -errno : static_cast<int>(result);
+  }
+
+  /// Takes back the last `count` queued entries before they are submitted.
+  void withdraw(unsigned count)
+  {
+    __atomic_store_n(sq_tail, *sq_tail - count, __ATOMIC_RELEASE);
+  }
+
+  bool pop(io_uring_cqe& out)
+  {
+    const unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    out = cqes[head & cq_mask];
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+};
+
+#else
+
+struct WriteQueue::Ring {};
+
+#endif
+
+namespace {
+
+core::Error write_error(const std::filesystem::path& path, int error)
+{
+  return core::make_error(core::errc::io_failure,
+                          "failed to write file: " + path.string() + ": " +
+                              std::generic_category().message(error));
+}
+
+}  // namespace
+
+WriteQueue::WriteQueue(Completion on_complete, WriteQueueOptions options)
+    : on_complete_(std::move(on_complete)), options_(options)
+{
+  options_.batch = std::max<std::size_t>(options_.batch, 1);
+#ifdef ART2IMG_HAVE_IO_URING
+  if (options_.use_io_uring) {
+    ring_ = Ring::create(static_cast<unsigned>(options_.batch));
+  }
+  if (ring_) {
+    options_.batch = std::min<std::size_t>(options_.batch, ring_->sq_entries);
+    backend_.store(WriteBackend::io_uring);
+    writers_.emplace_back([this] { run_ring(); });
+    return;
+  }
+#endif
+  const auto threads = std::max<std::size_t>(options_.threads, 1);
+  for (std::size_t i = 0; i < threads; ++i) {
+    writers_.emplace_back([this] { run_threads(); });
+  }
+}
+
+WriteQueue::~WriteQueue()
+{
+  {
+    const std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (auto& writer : writers_) {
+    writer.join();
+  }
+}
+
+void WriteQueue::submit(std::size_t tag,
+                        std::filesystem::path path,
+                        std::vector<std::byte> bytes)
+{
+  std::unique_lock lock(mutex_);
+  space_ready_.wait(lock, [&] {
+    return pending_bytes_ == 0 ||
+           pending_bytes_ + bytes.size() <= options_.max_pending_bytes;
+  });
+  pending_bytes_ += bytes.size();
+  ++unfinished_;
+  queued_.push_back(Job{tag, std::move(path), std::move(bytes)});
+  lock.unlock();
+  work_ready_.notify_one();
+}
+
+void WriteQueue::drain()
+{
+  std::unique_lock lock(mutex_);
+  space_ready_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool WriteQueue::take(std::vector<Job>& jobs, std::size_t limit)
+{
+  jobs.clear();
+  std::unique_lock lock(mutex_);
+  work_ready_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+  while (!queued_.empty() && jobs.size() < limit) {
+    jobs.push_back(std::move(queued_.front()));
+    queued_.pop_front();
+  }
+  return !jobs.empty();
+}
+
+void WriteQueue::finish(const Job& job, std::expected<void, core::Error> result)
+{
+  if (!result) {
+    std::error_code ignored;
+    std::filesystem::remove(job.path, ignored);
+  }
+  on_complete_(job.tag, std::move(result));
+
+  {
+    const std::lock_guard lock(mutex_);
+    pending_bytes_ -= job.bytes.size();
+    --unfinished_;
+  }
+  space_ready_.notify_all();
+}
+
+void WriteQueue::run_threads()
+{
+  std::vector<Job> jobs;
+  while (take(jobs, 1)) {
+    for (const auto& job : jobs) {
+      const core::ScopedStageTag tag(job.tag);
+      finish(job, write_file(job.path, job.bytes));
+    }
+  }
+}
+
+#ifdef ART2IMG_HAVE_IO_URING
+
+void WriteQueue::run_ring()
+{
+  struct Write {
+    int fd = -1;
+    std::size_t written = 0;
+    iovec iov{};
+    int error = 0;
+  };
+
+  std::vector<Job> jobs;
+  std::vector<Write> writes;
+  bool ring_failed = false;
+  while (!ring_failed && take(jobs, options_.batch)) {
+    // Opening stays synchronous; the data itself goes out as one batch,
+    // which reports as a single write stage call.
+    core::StageTimer timer(core::Stage::write);
+    writes.assign(jobs.size(), Write{});
+    unsigned queued = 0;
+    unsigned in_flight = 0;
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+      auto& write = writes[i];
+      write.fd = ::open(jobs[i].path.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+      if (write.fd < 0) {
+        write.error = errno;
+        continue;
+      }
+      if (jobs[i].bytes.empty()) {
+        continue;
+      }
+      write.iov.iov_base = jobs[i].bytes.data();
+      write.iov.iov_len = jobs[i].bytes.size();
+      ring_->push(write.fd, &write.iov, 0, i);
+      ++queued;
+      ++in_flight;
+    }
+
+    while (in_flight > 0) {
+      const int submitted = ring_->enter(queued, 1);
+      if (submitted == -EINTR) {
+        continue;
+      }
+      if (submitted < 0) {
+        // The ring is unusable. Entries it has not taken are withdrawn, and
+        // those it has may still be reading the buffers, so their
+        // completions are awaited before anything is freed. Whatever is
+        // still outstanding fails.
+        ring_->withdraw(queued);
+        in_flight -= queued;
+        queued = 0;
+        while (in_flight > 0) {
+          const int waited = ring_->enter(0, 1);
+          if (waited < 0 && waited != -EINTR) {
+            break;
+          }
+          io_uring_cqe cqe{};
+          while (ring_->pop(cqe)) {
+            --in_flight;
+          }
+        }
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+          if (writes[i].error == 0 && writes[i].fd >= 0 &&
+              writes[i].written < jobs[i].bytes.size()) {
+            writes[i].error = -submitted;
+          }
+        }
+        ring_failed = true;
+        break;
+      }
+      queued -= static_cast<unsigned>(submitted);
+
+      io_uring_cqe cqe{};
+      while (ring_->pop(cqe)) {
+        --in_flight;
+        auto& write = writes[cqe.user_data];
+        auto& bytes = jobs[cqe.user_data].bytes;
+        if (cqe.res <= 0) {
+          write.error = cqe.res < 0 ? -cqe.res : EIO;
+          continue;
+        }
+
+        write.written += static_cast<std::size_t>(cqe.res);
+        if (write.written < bytes.size()) {
+          write.iov.iov_base = bytes.data() + write.written;
+          write.iov.iov_len = bytes.size() - write.written;
+          ring_->push(write.fd, &write.iov, write.written, cqe.user_data);
+          ++queued;
+          ++in_flight;
+        }
+      }
+    }
+
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+      auto& write = writes[i];
+      if (write.fd >= 0 && ::close(write.fd) != 0 && write.error == 0) {
+        write.error = errno;
+      }
+      if (write.error != 0) {
+        finish(jobs[i],
+               std::unexpected(write_error(jobs[i].path, write.error)));
+      }
+      else {
+        timer.add_bytes_in(jobs[i].bytes.size());
+        timer.add_bytes_out(jobs[i].bytes.size());
+        finish(jobs[i], {});
+      }
+    }
+    if (ring_failed && in_flight > 0) {
+      // Not even waiting works, so the kernel may write from these at any
+      // time: the buffers, their iovecs and the ring are kept for good.
+      auto* kept = new std::vector<std::vector<std::byte>>();
+      for (auto& job : jobs) {
+        kept->push_back(std::move(job.bytes));
+      }
+      static_cast<void>(new std::vector<Write>(std::move(writes)));
+      static_cast<void>(ring_.release());
+    }
+  }
+  if (ring_failed) {
+    backend_.store(WriteBackend::threads);
+    run_threads();
+  }
+}
+
+#else
+
+void WriteQueue::run_ring() {}
+
+#endif
+
+}  // namespace art2img::adapters
@@ -0,0 +1,203 @@
+#include <art2img/adapters/zip.hpp>
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace art2img::adapters {
+
+namespace {
+
+constexpr std::uint32_t kLocalHeaderSignature = 0x04034B50u;
+constexpr std::uint32_t kCentralHeaderSignature = 0x02014B50u;
+constexpr std::uint32_t kEndOfDirectorySignature = 0x06054B50u;
+constexpr std::size_t kLocalHeaderSize = 30;
+constexpr std::size_t kCentralHeaderSize = 46;
+constexpr std::size_t kEndOfDirectorySize = 22;
+constexpr std::uint16_t kVersionStored = 10;  // 1.0: stored entries only
+constexpr std::uint16_t kDosDate = (0 << 9) | (1 << 5) | 1;  // 1980-01-01
+constexpr std::uint64_t kMaxOffset = std::numeric_limits<std::uint32_t>::max();
+constexpr std::size_t kMaxEntries = std::numeric_limits<std::uint16_t>::max();
+constexpr std::size_t kMaxNameLength = kMaxEntries;  // both 16-bit fields
+
+constexpr std::array<std::uint32_t, 256> kCrcTable = [] {
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t n = 0; n < table.size(); ++n) {
+    std::uint32_t c = n;
+    for (int k = 0; k < 8; ++k) {
+      c = (c & 1) != 0 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    table[n] = c;
+  }
+  return table;
+}();
+
+std::uint32_t crc32(std::span<const std::byte> data) noexcept
+{
+  std::uint32_t crc = 0xFFFFFFFFu;
+  for (const auto byte : data) {
+    crc = kCrcTable[(crc ^ static_cast<std::uint8_t>(byte)) & 0xFF] ^
+          (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+void put_le16(std::uint8_t* out, std::uint16_t value) noexcept
+{
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void put_le32(std::uint8_t* out, std::uint32_t value) noexcept
+{
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+  out[2] = static_cast<std::uint8_t>(value >> 16);
+  out[3] = static_cast<std::uint8_t>(value >> 24);
+}
+
+// Fields shared by the local and central headers, starting at "version
+// needed to extract": version, flags, method, time, date, crc, sizes, name
+// length.
+void put_entry_fields(std::uint8_t* out,
+                      std::uint32_t crc,
+                      std::uint32_t size,
+                      std::uint16_t name_length) noexcept
+{
+  put_le16(out, kVersionStored);
+  put_le16(out + 2, 0);  // flags
+  put_le16(out + 4, 0);  // method: stored
+  put_le16(out + 6, 0);  // time
+  put_le16(out + 8, kDosDate);
+  put_le32(out + 10, crc);
+  put_le32(out + 14, size);  // compressed size
+  put_le32(out + 18, size);  // uncompressed size
+  put_le16(out + 22, name_length);
+}
+
+}  // namespace
+
+std::expected<ZipWriter, core::Error> create_zip(
+    const std::filesystem::path& path)
+{
+  auto file = std::make_unique<std::ofstream>(
+      path, std::ios::binary | std::ios::trunc);
+  if (!*file) {
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "failed to open file for writing: " + path.string()));
+  }
+
+  ZipWriter writer{};
+  writer.path_ = path;
+  writer.file_ = std::move(file);
+  return writer;
+}
+
+std::expected<void, core::Error> ZipWriter::add(
+    std::string_view name,
+    std::span<const std::byte> data)
+{
+  if (!file_) {
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "zip archive already finished: " + path_.string()));
+  }
+  if (name.empty() || name.size() > kMaxNameLength) {
+    return std::unexpected(core::make_error(
+        core::errc::unsupported, "invalid zip entry name length"));
+  }
+  if (entries_.size() == kMaxEntries ||
+      offset_ + kLocalHeaderSize + name.size() + data.size() > kMaxOffset) {
+    return std::unexpected(core::make_error(
+        core::errc::unsupported,
+        "zip archive exceeds 65535 entries or 4 GiB: " + path_.string()));
+  }
+
+  Entry entry{};
+  entry.name = std::string{name};
+  entry.crc = crc32(data);
+  entry.size = static_cast<std::uint32_t>(data.size());
+  entry.offset = static_cast<std::uint32_t>(offset_);
+
+  std::array<std::uint8_t, kLocalHeaderSize> header{};
+  put_le32(header.data(), kLocalHeaderSignature);
+  put_entry_fields(header.data() + 4, entry.crc, entry.size,
+                   static_cast<std::uint16_t>(name.size()));
+  put_le16(header.data() + 28, 0);  // extra field length
+
+  file_->write(reinterpret_cast<const char*>(header.data()), header.size());
+  file_->write(name.data(), static_cast<std::streamsize>(name.size()));
+  file_->write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+  if (!*file_) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to write file: " + path_.string()));
+  }
+
+  offset_ += kLocalHeaderSize + name.size() + data.size();
+  entries_.push_back(std::move(entry));
+  return {};
+}
+
+std::expected<std::size_t, core::Error> ZipWriter::finish()
+{
+  if (!file_) {
+    return std::unexpected(
+        core::make_error(core::errc::io_failure,
+                         "zip archive already finished: " + path_.string()));
+  }
+
+  const auto directory_offset = offset_;
+  std::uint64_t directory_size = 0;
+  for (const auto& entry : entries_) {
+    std::array<std::uint8_t, kCentralHeaderSize> header{};
+    put_le32(header.data(), kCentralHeaderSignature);
+    put_le16(header.data() + 4, kVersionStored);  // version made by: MS-DOS
+    put_entry_fields(header.data() + 6, entry.crc, entry.size,
+                     static_cast<std::uint16_t>(entry.name.size()));
+    // Extra, comment, disk number and attributes stay zero.
+    put_le32(header.data() + 42, entry.offset);
+
+    file_->write(reinterpret_cast<const char*>(header.data()), header.size());
+    file_->write(entry.name.data(),
+                 static_cast<std::streamsize>(entry.name.size()));
+    directory_size += kCentralHeaderSize + entry.name.size();
+  }
+  if (directory_offset + directory_size > kMaxOffset) {
+    file_.reset();
+    return std::unexpected(
+        core::make_error(core::errc::unsupported,
+                         "zip archive exceeds 4 GiB: " + path_.string()));
+  }
+
+  std::array<std::uint8_t, kEndOfDirectorySize> end{};
+  const auto count = static_cast<std::uint16_t>(entries_.size());
+  put_le32(end.data(), kEndOfDirectorySignature);
+  put_le16(end.data() + 8, count);   // entries on this disk
+  put_le16(end.data() + 10, count);  // entries in total
+  put_le32(end.data() + 12, static_cast<std::uint32_t>(directory_size));
+  put_le32(end.data() + 16, static_cast<std::uint32_t>(directory_offset));
+  file_->write(reinterpret_cast<const char*>(end.data()), end.size());
+
+  file_->close();
+  const bool failed = file_->fail();
+  file_.reset();
+  if (failed) {
+    return std::unexpected(core::make_error(
+        core::errc::io_failure, "failed to write file: " + path_.string()));
+  }
+
+  offset_ = directory_offset + directory_size + kEndOfDirectorySize;
+  return static_cast<std::size_t>(offset_);
+}
+
+}  // namespace art2img::adapters
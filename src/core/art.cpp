@@ -10,6 +10,8 @@
 #include <span>
 #include <vector>
 
+#include <art2img/core/stats.hpp>
+
 namespace art2img::core {
 namespace {
 
@@ -20,17 +22,7 @@ constexpr std::size_t kTileAnimBytes = 4;
 constexpr std::size_t kMaxTileCount = 8192;
 constexpr std::size_t kLookupStride = 256;
 
-// Safe arithmetic functions to prevent integer overflow
-template <typename T>
-constexpr bool safe_add(T a, T b, T& result)
-{
-  if (b > std::numeric_limits<T>::max() - a) {
-    return false;
-  }
-  result = a + b;
-  return true;
-}
-
+// Overflow-checked multiplication
 template <typename T>
 constexpr bool safe_multiply(T a, T b, T& result)
 {
@@ -103,24 +95,47 @@ std::size_t safe_pixel_count(std::uint16_t width, std::uint16_t height)
 std::expected<ArtArchive, Error> load_art(
     std::span<const std::byte> blob) noexcept
 {
+  const StageTimer timer(Stage::load_art);
   if (blob.size() < kHeaderSize) {
     return std::unexpected(
         make_error(errc::invalid_art, "ART data too small for header"));
   }
 
   auto storage =
-      std::make_shared<std::vector<std::byte>>(blob.begin(), blob.end());
-  std::span<const std::byte> data{storage->data(), storage->size()};
-
-  std::size_t offset = 0;
-  const auto version = read_u32(data, offset);
-  offset += 4;
-  (void)read_u32(data, offset);
-  offset += 4;
-  const auto tile_start = read_u32(data, offset);
-  offset += 4;
-  const auto tile_end = read_u32(data, offset);
-  offset += 4;
+      std::make_shared<const std::vector<std::byte>>(blob.begin(), blob.end());
+  note_allocation();
+  const std::span<const std::byte> data{storage->data(), storage->size()};
+  return load_art(std::move(storage), data);
+}
+
+std::expected<ArtArchive, Error> load_art(
+    std::vector<std::byte>&& blob) noexcept
+{
+  const StageTimer timer(Stage::load_art);
+  auto storage =
+      std::make_shared<const std::vector<std::byte>>(std::move(blob));
+  note_allocation();
+  const std::span<const std::byte> data{storage->data(), storage->size()};
+  return load_art(std::move(storage), data);
+}
+
+std::expected<ArtArchive, Error> load_art_borrowed(
+    std::span<const std::byte> blob) noexcept
+{
+  return load_art(nullptr, blob);
+}
+
+std::expected<std::size_t, Error> art_tables_size(
+    std::span<const std::byte> header) noexcept
+{
+  if (header.size() < kHeaderSize) {
+    return std::unexpected(
+        make_error(errc::invalid_art, "ART data too small for header"));
+  }
+
+  const auto version = read_u32(header, 0);
+  const auto tile_start = read_u32(header, 8);
+  const auto tile_end = read_u32(header, 12);
 
   // Safe calculation of tile count with overflow protection
   // tile_count = tile_end - tile_start + 1
@@ -142,90 +157,153 @@ std::expected<ArtArchive, Error> load_art(
     return std::unexpected(
         make_error(errc::invalid_art, "array size calculation overflow"));
   }
-  if (!checked_advance(offset, arrays_bytes, data.size())) {
-    return std::unexpected(
-        make_error(errc::invalid_art, "ART data missing tile arrays"));
-  }
-
-  // Rewind to parse arrays.
-  offset = kHeaderSize;
-  std::vector<std::uint16_t> widths(tile_count);
-  std::vector<std::uint16_t> heights(tile_count);
+  return kHeaderSize + arrays_bytes;
+}
 
-  for (std::size_t i = 0; i < tile_count; ++i) {
-    widths[i] = read_u16(data, offset);
-    offset += kTileWidthBytes;
+std::expected<ArtLayout, Error> parse_art_layout(
+    std::span<const std::byte> data,
+    std::size_t file_size) noexcept
+{
+  const auto tables_size = art_tables_size(data);
+  if (!tables_size) {
+    return std::unexpected(tables_size.error());
   }
-  for (std::size_t i = 0; i < tile_count; ++i) {
-    heights[i] = read_u16(data, offset);
-    offset += kTileHeightBytes;
+  if (*tables_size > data.size() || *tables_size > file_size) {
+    return std::unexpected(
+        make_error(errc::invalid_art, "ART data missing tile arrays"));
   }
-  offset += tile_count * kTileAnimBytes;
 
+  const auto tile_start = read_u32(data, 8);
+  const std::size_t tile_count =
+      static_cast<std::size_t>(read_u32(data, 12) - tile_start) + 1;
+
+  ArtLayout layout{};
+  layout.tile_start = tile_start;
+  layout.tiles.resize(tile_count);
+  layout.pixel_offsets.resize(tile_count);
+  note_allocation(2);
+
+  // One pass over the three arrays: widths, then heights, then picanm, each
+  // tile_count entries long. picanm packs animation data with the signed
+  // centre offsets in bits 8-15 (x) and 16-23 (y); only the offsets are kept.
+  const std::size_t heights = kHeaderSize + tile_count * kTileWidthBytes;
+  const std::size_t animations = heights + tile_count * kTileHeightBytes;
   std::size_t total_pixels = 0;
   for (std::size_t i = 0; i < tile_count; ++i) {
-    if (!validate_tile_dimensions(widths[i], heights[i])) {
+    const auto width = read_u16(data, kHeaderSize + i * kTileWidthBytes);
+    const auto height = read_u16(data, heights + i * kTileHeightBytes);
+    const auto animation = read_u32(data, animations + i * kTileAnimBytes);
+    if (!validate_tile_dimensions(width, height)) {
       return std::unexpected(
           make_error(errc::invalid_art, "tile dimensions exceed limits"));
     }
-    std::size_t tile_pixels = safe_pixel_count(widths[i], heights[i]);
-    if (!safe_add(total_pixels, tile_pixels, total_pixels)) {
+
+    // Offsets are stored in 32 bits, which caps the payload at 4 GiB; no
+    // real archive comes close.
+    layout.pixel_offsets[i] = static_cast<std::uint32_t>(total_pixels);
+    total_pixels += safe_pixel_count(width, height);
+    if (total_pixels > std::numeric_limits<std::uint32_t>::max()) {
       return std::unexpected(
           make_error(errc::invalid_art, "total pixel count overflow"));
     }
+    layout.tiles[i] =
+        TileMetrics{width, height,
+                    static_cast<std::int8_t>((animation >> 8) & 0xFF),
+                    static_cast<std::int8_t>((animation >> 16) & 0xFF)};
   }
 
-  const std::size_t pixel_data_offset = offset;
-  if (!checked_advance(offset, total_pixels, data.size())) {
+  std::size_t offset = *tables_size;
+  layout.pixel_data_offset = offset;
+  if (!checked_advance(offset, total_pixels, file_size)) {
     return std::unexpected(
         make_error(errc::invalid_art, "ART data missing pixel payload"));
   }
+  layout.lookup_data_offset = offset;
+  return layout;
+}
+
+std::expected<ArtArchive, Error> load_art(
+    std::shared_ptr<const void> owner,
+    std::span<const std::byte> data) noexcept
+{
+  StageTimer timer(Stage::load_art);
+  timer.add_bytes_in(data.size());
+  auto layout = parse_art_layout(data, data.size());
+  if (!layout) {
+    return std::unexpected(layout.error());
+  }
+  timer.add_pixels(layout->lookup_data_offset - layout->pixel_data_offset);
 
   ArtArchive archive{};
-  archive.storage_ = std::move(storage);
+  archive.storage_ = std::move(owner);
   archive.raw = data;
-  archive.tile_start = tile_start;
-  archive.pixel_data_offset_ = pixel_data_offset;
-  archive.lookup_data_offset_ = offset;
-  archive.layout.reserve(tile_count);
-  archive.pixel_offsets_.resize(tile_count);
-  archive.lookup_offsets_.resize(tile_count);
-  archive.lookup_sizes_.resize(tile_count);
-
-  std::size_t pixel_offset = 0;
-  for (std::size_t i = 0; i < tile_count; ++i) {
-    archive.layout.push_back(TileMetrics{widths[i], heights[i]});
-    archive.pixel_offsets_[i] = pixel_offset;
-    std::size_t tile_pixels = safe_pixel_count(widths[i], heights[i]);
-    if (!safe_add(pixel_offset, tile_pixels, pixel_offset)) {
-      return std::unexpected(
-          make_error(errc::invalid_art, "pixel offset overflow"));
-    }
-  }
+  archive.tile_start = layout->tile_start;
+  archive.pixel_data_offset_ = layout->pixel_data_offset;
+  archive.lookup_data_offset_ = layout->lookup_data_offset;
+  archive.layout = std::move(layout->tiles);
+  archive.pixel_offsets_ = std::move(layout->pixel_offsets);
+  return archive;
+}
 
-  const std::size_t remaining_lookup =
-      data.size() > offset ? data.size() - offset : 0;
-  if (remaining_lookup == 0) {
-    archive.lookup_offsets_.assign(tile_count, 0);
-    archive.lookup_sizes_.assign(tile_count, 0);
+std::expected<std::vector<std::byte>, Error> write_art(
+    std::span<const ArtTileData> tiles,
+    std::uint32_t tile_start)
+{
+  if (tiles.empty() || tiles.size() > kMaxTileCount ||
+      tile_start > std::numeric_limits<std::uint32_t>::max() - tiles.size()) {
+    return std::unexpected(
+        make_error(errc::invalid_art, "invalid tile count for ART output"));
   }
-  else {
-    std::size_t lookup_offset = 0;
-    for (std::size_t i = 0; i < tile_count; ++i) {
-      archive.lookup_offsets_[i] = lookup_offset;
-      if (lookup_offset < remaining_lookup) {
-        const auto available = remaining_lookup - lookup_offset;
-        const auto use = std::min<std::size_t>(kLookupStride, available);
-        archive.lookup_sizes_[i] = use;
-        lookup_offset += use;
-      }
-      else {
-        archive.lookup_sizes_[i] = 0;
-      }
+
+  std::size_t total_pixels = 0;
+  for (const auto& tile : tiles) {
+    const auto& metrics = tile.metrics;
+    const auto pixels = safe_pixel_count(metrics.width, metrics.height);
+    if (!validate_tile_dimensions(metrics.width, metrics.height) ||
+        tile.indices.size() != pixels) {
+      return std::unexpected(make_error(
+          errc::invalid_art, "tile indices do not match its dimensions"));
     }
+    total_pixels += pixels;
+  }
+  if (total_pixels > std::numeric_limits<std::uint32_t>::max()) {
+    return std::unexpected(
+        make_error(errc::invalid_art, "total pixel count overflow"));
   }
 
-  return archive;
+  const std::size_t count = tiles.size();
+  const std::size_t heights = kHeaderSize + count * kTileWidthBytes;
+  const std::size_t animations = heights + count * kTileHeightBytes;
+  const std::size_t pixel_data = animations + count * kTileAnimBytes;
+  std::vector<std::byte> out(pixel_data + total_pixels);
+  note_allocation();
+
+  auto put = [&out](std::size_t offset, auto value) {
+    std::memcpy(out.data() + offset, &value, sizeof(value));
+  };
+  put(0, std::uint32_t{1});  // version
+  put(4, static_cast<std::uint32_t>(count));
+  put(8, tile_start);
+  put(12, static_cast<std::uint32_t>(tile_start + count - 1));
+
+  std::size_t offset = pixel_data;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& tile = tiles[i];
+    put(kHeaderSize + i * kTileWidthBytes, tile.metrics.width);
+    put(heights + i * kTileHeightBytes, tile.metrics.height);
+    const auto animation =
+        static_cast<std::uint32_t>(
+            static_cast<std::uint8_t>(tile.metrics.offset_x))
+            << 8 |
+        static_cast<std::uint32_t>(
+            static_cast<std::uint8_t>(tile.metrics.offset_y))
+            << 16;
+    put(animations + i * kTileAnimBytes, animation);
+    std::ranges::copy(tile.indices, out.begin() + offset);
+    offset += tile.indices.size();
+  }
+
+  return out;
 }
 
 std::size_t tile_count(const ArtArchive& archive) noexcept
@@ -236,7 +314,7 @@ std::size_t tile_count(const ArtArchive& archive) noexcept
 std::optional<TileView> get_tile(const ArtArchive& archive,
                                  std::size_t tile_index) noexcept
 {
-  if (tile_index >= archive.layout.size() || !archive.storage_) {
+  if (tile_index >= archive.layout.size() || archive.raw.empty()) {
     return std::nullopt;
   }
 
@@ -253,15 +331,14 @@ std::optional<TileView> get_tile(const ArtArchive& archive,
   view.height = metrics.height;
   view.indices = archive.raw.subspan(start, required);
 
-  if (tile_index < archive.lookup_sizes_.size()) {
-    const auto lookup_size = archive.lookup_sizes_[tile_index];
-    if (lookup_size > 0) {
-      const auto lookup_start =
-          archive.lookup_data_offset_ + archive.lookup_offsets_[tile_index];
-      if (lookup_start + lookup_size <= archive.raw.size()) {
-        view.lookup = archive.raw.subspan(lookup_start, lookup_size);
-      }
-    }
+  // Lookup bytes follow the pixels in 256-byte strides, the last possibly
+  // cut short by the end of the data.
+  const auto lookup_start =
+      archive.lookup_data_offset_ + tile_index * kLookupStride;
+  if (lookup_start < archive.raw.size()) {
+    view.lookup = archive.raw.subspan(
+        lookup_start,
+        std::min(kLookupStride, archive.raw.size() - lookup_start));
   }
 
   if (!view.valid()) {
@@ -0,0 +1,100 @@
+#include <art2img/core/collection.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <vector>
+
+namespace art2img::core {
+
+std::expected<ArtCollection, Error> make_art_collection(
+    std::vector<ArtArchive> archives)
+{
+  ArtCollection collection{};
+  for (std::size_t i = 0; i < archives.size(); ++i) {
+    const auto count = tile_count(archives[i]);
+    if (count == 0) {
+      continue;
+    }
+    if (std::uint64_t{archives[i].tile_start} + count >
+        std::uint64_t{UINT32_MAX} + 1) {
+      return std::unexpected(make_error(
+          errc::invalid_art, "ART tile numbers run past 2^32"));
+    }
+    collection.ranges_.push_back(ArtCollection::Range{
+        .first = archives[i].tile_start,
+        .count = static_cast<std::uint32_t>(count),
+        .archive = i});
+    collection.tile_count_ += count;
+  }
+
+  std::ranges::sort(collection.ranges_, {}, &ArtCollection::Range::first);
+  for (std::size_t i = 1; i < collection.ranges_.size(); ++i) {
+    const auto& previous = collection.ranges_[i - 1];
+    if (std::uint64_t{previous.first} + previous.count >
+        collection.ranges_[i].first) {
+      return std::unexpected(make_error(
+          errc::invalid_art, "ART files overlap in tile numbers"));
+    }
+  }
+
+  collection.archives_ = std::move(archives);
+  return collection;
+}
+
+std::vector<std::uint32_t> ArtCollection::tile_numbers() const
+{
+  std::vector<std::uint32_t> numbers;
+  numbers.reserve(tile_count_);
+  for (const auto& range : ranges_) {
+    for (std::uint32_t i = 0; i < range.count; ++i) {
+      numbers.push_back(range.first + i);
+    }
+  }
+  return numbers;
+}
+
+std::optional<TileLocation> ArtCollection::locate(
+    std::uint32_t tile) const noexcept
+{
+  // The last range starting at or before `tile` is the only one that can
+  // hold it.
+  const auto after = std::ranges::upper_bound(ranges_, tile, {},
+                                              &ArtCollection::Range::first);
+  if (after == ranges_.begin()) {
+    return std::nullopt;
+  }
+  const auto& range = *(after - 1);
+  if (tile - range.first >= range.count) {
+    return std::nullopt;
+  }
+  return TileLocation{range.archive, tile - range.first};
+}
+
+const TileMetrics* ArtCollection::metrics(std::uint32_t tile) const noexcept
+{
+  const auto location = locate(tile);
+  if (!location) {
+    return nullptr;
+  }
+  return &archives_[location->archive].layout[location->tile];
+}
+
+std::size_t tile_count(const ArtCollection& collection) noexcept
+{
+  return collection.tile_count();
+}
+
+std::optional<TileView> get_tile(const ArtCollection& collection,
+                                 std::uint32_t tile) noexcept
+{
+  const auto location = collection.locate(tile);
+  if (!location) {
+    return std::nullopt;
+  }
+  return get_tile(collection.archives()[location->archive], location->tile);
+}
+
+}  // namespace art2img::core
@@ -1,15 +1,21 @@
 #include <art2img/core/convert.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <expected>
+#include <memory>
 #include <optional>
 #include <span>
 #include <vector>
 
 #include <art2img/core/art.hpp>
 #include <art2img/core/palette.hpp>
+#include <art2img/core/stats.hpp>
+
+#include "expand_kernels.hpp"
 
 namespace art2img::core {
 namespace {
@@ -52,165 +58,375 @@ std::uint8_t apply_shade(std::uint8_t index,
   return palette.shade_tables[offset];
 }
 
-struct RgbaPixel {
-  std::uint8_t r = 0;
-  std::uint8_t g = 0;
-  std::uint8_t b = 0;
-  std::uint8_t a = 255;
-};
-
-RgbaPixel sample_color(std::uint8_t index,
-                       PaletteView palette,
-                       const ConversionOptions& options,
-                       const TileView& tile) noexcept
+std::uint32_t pack_rgba(std::uint8_t r,
+                        std::uint8_t g,
+                        std::uint8_t b,
+                        std::uint8_t a) noexcept
+{
+  const std::array<std::uint8_t, kChannels> bytes{r, g, b, a};
+  std::uint32_t packed = 0;
+  std::memcpy(&packed, bytes.data(), sizeof(packed));
+  return packed;
+}
+
+std::uint32_t resolve_color(std::uint8_t index,
+                            PaletteView palette,
+                            const ConversionOptions& options) noexcept
 {
-  auto mapped = apply_lookup(index, tile, options);
-  auto shaded = apply_shade(mapped, palette, options);
+  const auto shaded = apply_shade(index, palette, options);
 
   const std::size_t base = static_cast<std::size_t>(shaded) * 3;
-  RgbaPixel pixel{};
-  if (base + 2 < palette.rgb.size()) {
-    pixel.r = expand_component(palette.rgb[base + 0]);
-    pixel.g = expand_component(palette.rgb[base + 1]);
-    pixel.b = expand_component(palette.rgb[base + 2]);
-  }
+  const auto r = expand_component(palette.rgb[base + 0]);
+  const auto g = expand_component(palette.rgb[base + 1]);
+  const auto b = expand_component(palette.rgb[base + 2]);
 
   // ART format uses palette index 255 for transparency, not index 0
   // Only apply transparency detection if fix_transparency is enabled
   if (options.fix_transparency &&
-      (shaded == 255 || is_build_engine_magenta(pixel.r, pixel.g, pixel.b))) {
-    pixel.a = 0;
-    pixel.r = 0;
-    pixel.g = 0;
-    pixel.b = 0;
+      (shaded == 255 || is_build_engine_magenta(r, g, b))) {
+    return pack_rgba(0, 0, 0, 0);
   }
+  return pack_rgba(r, g, b, 255);
+}
 
-  return pixel;
+// Rows are converted in strips of this many rows, and each strip is
+// transposed in square blocks of the same size. 16 rows x 16 columns keeps
+// both the column-major source and the row-major strip within L1.
+constexpr std::uint32_t kTransposeBlock = 16;
+
+// Copies rows [y0, y0 + rows) of a column-major index plane into `strip`,
+// row-major with a stride of `width`.
+void transpose_strip(std::span<const std::byte> indices,
+                     std::uint32_t width,
+                     std::uint32_t height,
+                     std::uint32_t y0,
+                     std::uint32_t rows,
+                     std::uint8_t* strip) noexcept
+{
+  for (std::uint32_t x0 = 0; x0 < width; x0 += kTransposeBlock) {
+    const auto x_end = std::min(width, x0 + kTransposeBlock);
+    for (std::uint32_t x = x0; x < x_end; ++x) {
+      const std::byte* column =
+          indices.data() + static_cast<std::size_t>(x) * height + y0;
+      for (std::uint32_t r = 0; r < rows; ++r) {
+        strip[static_cast<std::size_t>(r) * width + x] =
+            std::to_integer<std::uint8_t>(column[r]);
+      }
+    }
+  }
 }
 
-void clean_transparent_pixels(std::vector<std::uint8_t>& pixels,
-                              std::uint32_t width,
-                              std::uint32_t height)
+void premultiply_pixel(std::uint8_t* pixel) noexcept
 {
-  if (width == 0 || height == 0) {
+  const auto alpha = pixel[3];
+  if (alpha == 0) {
+    pixel[0] = 0;
+    pixel[1] = 0;
+    pixel[2] = 0;
+  }
+  else if (alpha < 255) {
+    pixel[0] = static_cast<std::uint8_t>((pixel[0] * alpha + 127) / 255);
+    pixel[1] = static_cast<std::uint8_t>((pixel[1] * alpha + 127) / 255);
+    pixel[2] = static_cast<std::uint8_t>((pixel[2] * alpha + 127) / 255);
+  }
+}
+
+// Single sweep that zeroes the colour of fully transparent pixels among the
+// first `clean_count` pixels and/or premultiplies every pixel. Premultiplying
+// already blacks out alpha-0 pixels, so it subsumes the cleanup.
+void finish_pixels(std::span<std::uint8_t> pixels,
+                   std::size_t clean_count,
+                   bool premultiply) noexcept
+{
+  if (premultiply) {
+    for (std::size_t i = 0; i + 3 < pixels.size(); i += kChannels) {
+      premultiply_pixel(pixels.data() + i);
+    }
     return;
   }
 
+  const auto limit = std::min(clean_count, pixels.size() / kChannels);
+  for (std::size_t i = 0; i < limit; ++i) {
+    auto* px = pixels.data() + i * kChannels;
+    if (px[3] == 0) {
+      px[0] = 0;
+      px[1] = 0;
+      px[2] = 0;
+    }
+  }
+}
+
+// Alpha of row `y` after the 4-neighbour erosion: border pixels and fully
+// transparent pixels keep their value, interior pixels take the minimum of
+// their up/down/left/right neighbours.
+void erode_row(const std::uint8_t* pixels,
+               std::uint32_t width,
+               std::uint32_t height,
+               std::uint32_t y,
+               std::uint8_t* out) noexcept
+{
   const std::size_t row_stride = static_cast<std::size_t>(width) * kChannels;
-  for (std::uint32_t y = 0; y < height; ++y) {
+  const std::uint8_t* row = pixels + static_cast<std::size_t>(y) * row_stride;
+  if (y == 0 || y + 1 == height) {
     for (std::uint32_t x = 0; x < width; ++x) {
-      const std::size_t idx = static_cast<std::size_t>(y) * row_stride +
-                              static_cast<std::size_t>(x) * kChannels;
-      if (idx + 3 >= pixels.size()) {
-        continue;
-      }
-      if (pixels[idx + 3] == 0) {
-        pixels[idx + 0] = 0;
-        pixels[idx + 1] = 0;
-        pixels[idx + 2] = 0;
-      }
+      out[x] = row[static_cast<std::size_t>(x) * kChannels + 3];
     }
+    return;
+  }
+
+  const std::uint8_t* above = row - row_stride;
+  const std::uint8_t* below = row + row_stride;
+  out[0] = row[3];
+  for (std::uint32_t x = 1; x + 1 < width; ++x) {
+    const std::size_t a = static_cast<std::size_t>(x) * kChannels + 3;
+    const auto center = row[a];
+    out[x] = center == 0
+                 ? center
+                 : std::min({above[a], below[a], row[a - kChannels],
+                             row[a + kChannels]});
   }
+  out[width - 1] = row[row_stride - 1];
 }
 
-void premultiply_alpha(std::vector<std::uint8_t>& pixels)
+// Write-back of one matte pixel. Clean and Premultiply are template
+// parameters so each combination compiles to its own branch-free loop.
+template <bool Clean, bool Premultiply>
+void store_matte_pixel(std::uint8_t* px, std::uint8_t alpha) noexcept
 {
-  for (std::size_t i = 0; i + 3 < pixels.size(); i += kChannels) {
-    const auto alpha = pixels[i + 3];
-    if (alpha == 0) {
-      pixels[i + 0] = 0;
-      pixels[i + 1] = 0;
-      pixels[i + 2] = 0;
-    }
-    else if (alpha < 255) {
-      pixels[i + 0] =
-          static_cast<std::uint8_t>((pixels[i + 0] * alpha + 127) / 255);
-      pixels[i + 1] =
-          static_cast<std::uint8_t>((pixels[i + 1] * alpha + 127) / 255);
-      pixels[i + 2] =
-          static_cast<std::uint8_t>((pixels[i + 2] * alpha + 127) / 255);
+  if constexpr (Clean) {
+    if (px[3] == 0) {
+      px[0] = 0;
+      px[1] = 0;
+      px[2] = 0;
     }
   }
+  px[3] = alpha;
+  if constexpr (Premultiply) {
+    premultiply_pixel(px);
+  }
 }
 
-void apply_matte(std::vector<std::uint8_t>& pixels,
-                 std::uint32_t width,
-                 std::uint32_t height)
+// Matte hygiene: erode alpha with a 4-neighbour minimum, then soften it with
+// a 3x3 box blur (interior only). The blur is separable, so each output row
+// sums three eroded rows column-wise and slides a 3-wide window along x.
+// Eroded rows are produced one row ahead of the write-back, which is the last
+// point the original alpha of the rows below is still needed, so three line
+// buffers from `workspace` are the only scratch memory.
+//
+// Transparency cleanup (against the pre-matte alpha) and premultiply
+// (against the new alpha) are folded into the write-back, giving the same
+// result as running cleanup, matte and premultiply as separate passes.
+template <bool Clean, bool Premultiply>
+void apply_matte_full(std::uint8_t* pixels,
+                      std::uint32_t width,
+                      std::uint32_t height,
+                      std::vector<std::uint8_t>& workspace)
 {
-  if (width < 3 || height < 3) {
-    return;
+  const std::size_t row_stride = static_cast<std::size_t>(width) * kChannels;
+  if (workspace.size() < static_cast<std::size_t>(width) * 3) {
+    note_allocation();
+    workspace.resize(static_cast<std::size_t>(width) * 3);
   }
+  std::uint8_t* rows[3] = {workspace.data(), workspace.data() + width,
+                           workspace.data() + 2 * static_cast<std::size_t>(width)};
 
-  const std::size_t count = static_cast<std::size_t>(width) * height;
-  std::vector<std::uint8_t> alpha(count, 0);
-  const std::size_t row_stride = static_cast<std::size_t>(width) * kChannels;
+  // After the rotation at the top of each iteration rows[0..2] hold the
+  // eroded rows y - 1, y and y + 1 (rows[0] is unused on the first row).
+  erode_row(pixels, width, height, 0, rows[2]);
 
   for (std::uint32_t y = 0; y < height; ++y) {
-    for (std::uint32_t x = 0; x < width; ++x) {
-      const std::size_t dst = static_cast<std::size_t>(y) * width + x;
-      const std::size_t src = static_cast<std::size_t>(y) * row_stride +
-                              static_cast<std::size_t>(x) * kChannels + 3;
-      if (src < pixels.size()) {
-        alpha[dst] = pixels[src];
-      }
+    std::rotate(rows, rows + 1, rows + 3);
+    if (y + 1 < height) {
+      // Must happen before row y is written: it reads row y's alpha.
+      erode_row(pixels, width, height, y + 1, rows[2]);
     }
-  }
 
-  std::vector<std::uint8_t> eroded = alpha;
-  for (std::uint32_t y = 1; y + 1 < height; ++y) {
-    for (std::uint32_t x = 1; x + 1 < width; ++x) {
-      const std::size_t idx = static_cast<std::size_t>(y) * width + x;
-      if (alpha[idx] == 0) {
-        continue;
+    std::uint8_t* out = pixels + static_cast<std::size_t>(y) * row_stride;
+    const auto store = [out](std::uint32_t x, std::uint8_t alpha) {
+      store_matte_pixel<Clean, Premultiply>(
+          out + static_cast<std::size_t>(x) * kChannels, alpha);
+    };
+
+    // Border rows keep their eroded alpha; interior rows blur every pixel
+    // but the first and last, so the middle loop carries no edge checks.
+    if (y == 0 || y + 1 == height) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        store(x, rows[1][x]);
       }
-      std::uint8_t min_value = 255;
-      min_value = std::min(min_value, alpha[idx - width]);
-      min_value = std::min(min_value, alpha[idx + width]);
-      min_value = std::min(min_value, alpha[idx - 1]);
-      min_value = std::min(min_value, alpha[idx + 1]);
-      eroded[idx] = min_value;
+      continue;
     }
-  }
 
-  std::vector<std::uint8_t> blurred = eroded;
-  for (std::uint32_t y = 1; y + 1 < height; ++y) {
+    std::uint32_t left =
+        static_cast<std::uint32_t>(rows[0][0]) + rows[1][0] + rows[2][0];
+    std::uint32_t middle =
+        static_cast<std::uint32_t>(rows[0][1]) + rows[1][1] + rows[2][1];
+    std::uint32_t window = left + middle;
+    store(0, rows[1][0]);
     for (std::uint32_t x = 1; x + 1 < width; ++x) {
-      std::uint32_t sum = 0;
-      for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-          sum += eroded[static_cast<std::size_t>(y + dy) * width + (x + dx)];
-        }
-      }
-      blurred[static_cast<std::size_t>(y) * width + x] =
-          static_cast<std::uint8_t>(sum / 9);
+      const std::uint32_t right = static_cast<std::uint32_t>(rows[0][x + 1]) +
+                                  rows[1][x + 1] + rows[2][x + 1];
+      window += right;
+      store(x, static_cast<std::uint8_t>(window / 9));
+      window -= left;
+      left = middle;
+      middle = right;
     }
+    store(width - 1, rows[1][width - 1]);
   }
+}
 
-  for (std::uint32_t y = 0; y < height; ++y) {
-    for (std::uint32_t x = 0; x < width; ++x) {
-      const std::size_t dst = static_cast<std::size_t>(y) * row_stride +
-                              static_cast<std::size_t>(x) * kChannels + 3;
-      if (dst < pixels.size()) {
-        pixels[dst] = blurred[static_cast<std::size_t>(y) * width +
-                              static_cast<std::size_t>(x)];
-      }
+using MatteFn = void (*)(std::uint8_t*,
+                         std::uint32_t,
+                         std::uint32_t,
+                         std::vector<std::uint8_t>&);
+
+// Indexed by clean * 2 + premultiply; chosen once per image.
+constexpr std::array<MatteFn, 4> kMatteKernels{
+    &apply_matte_full<false, false>, &apply_matte_full<false, true>,
+    &apply_matte_full<true, false>, &apply_matte_full<true, true>};
+
+void apply_matte_full(std::uint8_t* pixels,
+                      std::uint32_t width,
+                      std::uint32_t height,
+                      bool clean,
+                      bool premultiply,
+                      std::vector<std::uint8_t>& workspace)
+{
+  kMatteKernels[(clean ? 2 : 0) + (premultiply ? 1 : 0)](pixels, width, height,
+                                                          workspace);
+}
+
+void apply_matte(std::span<std::uint8_t> pixels,
+                 std::uint32_t width,
+                 std::uint32_t height,
+                 bool clean,
+                 bool premultiply,
+                 ConversionWorkspace& workspace)
+{
+  const std::size_t count = static_cast<std::size_t>(width) * height;
+  if (width < 3 || height < 3) {
+    finish_pixels(pixels, clean ? count : 0, premultiply);
+    return;
+  }
+
+  const std::size_t bytes = count * kChannels;
+  if (pixels.size() >= bytes) {
+    apply_matte_full(pixels.data(), width, height, clean, premultiply,
+                     workspace.matte_rows);
+    // Premultiply also covers any bytes past the width * height pixels.
+    if (premultiply && pixels.size() > bytes) {
+      finish_pixels(pixels.subspan(bytes), 0, true);
     }
+    return;
   }
+
+  // Short buffers treat the missing alpha as 0 and leave incomplete pixels
+  // untouched; run on a zero-padded copy to keep the main loop unchecked.
+  std::vector<std::uint8_t> padded(bytes, 0);
+  note_allocation();
+  std::copy(pixels.begin(), pixels.end(), padded.begin());
+  apply_matte_full(padded.data(), width, height, clean, premultiply,
+                   workspace.matte_rows);
+  const std::size_t whole = pixels.size() / kChannels * kChannels;
+  std::copy_n(padded.begin(), whole, pixels.begin());
 }
 
 }  // namespace
 
+std::expected<PreparedPalette, Error> prepare_palette(
+    PaletteView palette,
+    ConversionOptions options)
+{
+  if (palette.rgb.size() < palette_component_count) {
+    return std::unexpected(
+        make_error(errc::invalid_palette, "palette view missing color data"));
+  }
+
+  PreparedPalette prepared{};
+  prepared.options = options;
+  for (std::size_t i = 0; i < palette_color_count; ++i) {
+    prepared.colors[i] =
+        resolve_color(static_cast<std::uint8_t>(i), palette, options);
+  }
+  return prepared;
+}
+
 std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
                                                 PaletteView palette_view,
                                                 ConversionOptions options)
 {
+  const StageTimer timer(Stage::convert);
   if (!tile.valid()) {
     return std::unexpected(
         make_error(errc::conversion_failure, "invalid tile view"));
   }
-  if (palette_view.rgb.size() < palette_component_count) {
+
+  auto prepared = prepare_palette(palette_view, options);
+  if (!prepared) {
+    return std::unexpected(prepared.error());
+  }
+  return palette_to_rgba(tile, *prepared);
+}
+
+std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
+                                                const PreparedPalette& palette)
+{
+  ConversionWorkspace workspace{};
+  return palette_to_rgba(tile, palette, workspace);
+}
+
+std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
+                                                const PreparedPalette& palette,
+                                                ConversionWorkspace& workspace)
+{
+  const StageTimer timer(Stage::convert);
+  if (!tile.valid()) {
     return std::unexpected(
-        make_error(errc::invalid_palette, "palette view missing color data"));
+        make_error(errc::conversion_failure, "invalid tile view"));
+  }
+
+  RgbaImage image{};
+  image.width = tile.width;
+  image.height = tile.height;
+  image.pixels.resize(static_cast<std::size_t>(tile.width) * tile.height *
+                      kChannels);
+  note_allocation();
+
+  auto converted = palette_to_rgba_into(tile, palette, image.pixels, workspace);
+  if (!converted) {
+    return std::unexpected(converted.error());
+  }
+  return image;
+}
+
+std::expected<void, Error> palette_to_rgba_into(const TileView& tile,
+                                                PaletteView palette_view,
+                                                ConversionOptions options,
+                                                std::span<std::uint8_t> out)
+{
+  const StageTimer timer(Stage::convert);
+  if (!tile.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid tile view"));
+  }
+
+  auto prepared = prepare_palette(palette_view, options);
+  if (!prepared) {
+    return std::unexpected(prepared.error());
+  }
+  ConversionWorkspace workspace{};
+  return palette_to_rgba_into(tile, *prepared, out, workspace);
+}
+
+std::expected<void, Error> palette_to_rgba_into(const TileView& tile,
+                                                const PreparedPalette& palette,
+                                                std::span<std::uint8_t> out,
+                                                ConversionWorkspace& workspace)
+{
+  StageTimer timer(Stage::convert);
+  if (!tile.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid tile view"));
   }
 
   const auto required = static_cast<std::size_t>(tile.width) * tile.height;
@@ -218,65 +434,305 @@ std::expected<RgbaImage, Error> palette_to_rgba(const TileView& tile,
     return std::unexpected(make_error(errc::conversion_failure,
                                       "tile does not contain enough indices"));
   }
+  if (out.size() < required * kChannels) {
+    return std::unexpected(make_error(errc::conversion_failure,
+                                      "output buffer too small for tile"));
+  }
+  out = out.first(required * kChannels);
+  timer.add_pixels(required);
+  timer.add_bytes_in(required);
+  timer.add_bytes_out(out.size());
+
+  const auto& options = palette.options;
+
+  // Fold the tile's lookup into the colour table so the pixel loop below is
+  // a single table load per pixel.
+  const std::uint32_t* colors = palette.colors.data();
+  std::array<std::uint32_t, palette_color_count> remapped{};
+  if (options.apply_lookup && !tile.lookup.empty()) {
+    for (std::size_t i = 0; i < palette_color_count; ++i) {
+      remapped[i] =
+          palette.colors[apply_lookup(static_cast<std::uint8_t>(i), tile,
+                                      options)];
+    }
+    colors = remapped.data();
+  }
 
-  RgbaImage image{};
-  image.width = tile.width;
-  image.height = tile.height;
-  image.pixels.resize(required * kChannels);
+  // ART stores pixels column-major. Walking output rows directly would read
+  // the source with a stride of `height`, so each strip of rows is first
+  // transposed block by block into row-major indices. The strip is then
+  // contiguous in the output and expands with one kernel call.
+  const std::size_t row_stride =
+      static_cast<std::size_t>(tile.width) * kChannels;
+  const auto expand = detail::expand_kernel();
+  auto& strip = workspace.index_strip;
+  const auto strip_size = static_cast<std::size_t>(kTransposeBlock) * tile.width;
+  if (strip.size() < strip_size) {
+    note_allocation();
+    strip.resize(strip_size);
+  }
+  for (std::uint32_t y0 = 0; y0 < tile.height; y0 += kTransposeBlock) {
+    const auto rows = std::min(kTransposeBlock, tile.height - y0);
+    transpose_strip(tile.indices, tile.width, tile.height, y0, rows,
+                    strip.data());
+    expand(strip.data(), static_cast<std::size_t>(rows) * tile.width, colors,
+           out.data() + static_cast<std::size_t>(y0) * row_stride);
+  }
+
+  // The colour table already blacks out transparent pixels and alpha is
+  // either 0 or 255, so transparency cleanup and premultiply are no-ops
+  // unless matte hygiene produces partial alpha; in that case premultiply is
+  // applied during the matte write-back.
+  if (options.matte_hygiene) {
+    apply_matte(out, tile.width, tile.height, false, options.premultiply_alpha,
+                workspace);
+  }
+
+  return {};
+}
+
+std::expected<void, Error> palette_to_rgba_variants(
+    const TileView& tile,
+    std::span<const RenderVariant> variants,
+    ConversionWorkspace& workspace)
+{
+  StageTimer timer(Stage::convert);
+  if (!tile.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid tile view"));
+  }
+
+  const auto required = static_cast<std::size_t>(tile.width) * tile.height;
+  for (const auto& variant : variants) {
+    if (variant.palette == nullptr) {
+      return std::unexpected(
+          make_error(errc::conversion_failure, "variant has no palette"));
+    }
+    if (variant.out.size() < required * kChannels) {
+      return std::unexpected(make_error(errc::conversion_failure,
+                                        "output buffer too small for tile"));
+    }
+  }
+
+  // Every variant gets its colour table copied into the workspace, with the
+  // tile lookup folded in where its options ask for it, as
+  // palette_to_rgba_into does.
+  timer.add_pixels(required * variants.size());
+  timer.add_bytes_in(required);
+  timer.add_bytes_out(required * kChannels * variants.size());
+
+  auto& tables = workspace.variant_colors;
+  if (tables.capacity() < variants.size() * palette_color_count) {
+    note_allocation();
+  }
+  tables.resize(variants.size() * palette_color_count);
+  for (std::size_t v = 0; v < variants.size(); ++v) {
+    const auto& palette = *variants[v].palette;
+    auto* table = tables.data() + v * palette_color_count;
+    const bool remap = palette.options.apply_lookup && !tile.lookup.empty();
+    for (std::size_t i = 0; i < palette_color_count; ++i) {
+      const auto index = static_cast<std::uint8_t>(i);
+      table[i] = palette.colors[remap ? apply_lookup(index, tile,
+                                                     palette.options)
+                                      : index];
+    }
+  }
 
   const std::size_t row_stride =
-      static_cast<std::size_t>(image.width) * kChannels;
-  for (std::uint32_t y = 0; y < tile.height; ++y) {
-    for (std::uint32_t x = 0; x < tile.width; ++x) {
-      const std::size_t src_index =
-          static_cast<std::size_t>(x) * tile.height + y;
-      const auto palette_index =
-          std::to_integer<std::uint8_t>(tile.indices[src_index]);
-      const auto color =
-          sample_color(palette_index, palette_view, options, tile);
-
-      const std::size_t dst = static_cast<std::size_t>(y) * row_stride +
-                              static_cast<std::size_t>(x) * kChannels;
-      image.pixels[dst + 0] = color.r;
-      image.pixels[dst + 1] = color.g;
-      image.pixels[dst + 2] = color.b;
-      image.pixels[dst + 3] = color.a;
+      static_cast<std::size_t>(tile.width) * kChannels;
+  const auto expand = detail::expand_kernel();
+  auto& strip = workspace.index_strip;
+  const auto strip_size = static_cast<std::size_t>(kTransposeBlock) * tile.width;
+  if (strip.size() < strip_size) {
+    note_allocation();
+    strip.resize(strip_size);
+  }
+  for (std::uint32_t y0 = 0; y0 < tile.height; y0 += kTransposeBlock) {
+    const auto rows = std::min(kTransposeBlock, tile.height - y0);
+    transpose_strip(tile.indices, tile.width, tile.height, y0, rows,
+                    strip.data());
+    const auto offset = static_cast<std::size_t>(y0) * row_stride;
+    for (std::size_t v = 0; v < variants.size(); ++v) {
+      expand(strip.data(), static_cast<std::size_t>(rows) * tile.width,
+             tables.data() + v * palette_color_count,
+             variants[v].out.data() + offset);
     }
   }
 
-  // Apply transparency processing pipeline
-  if (options.fix_transparency) {
-    clean_transparent_pixels(image.pixels, image.width, image.height);
+  for (const auto& variant : variants) {
+    const auto& options = variant.palette->options;
+    if (options.matte_hygiene) {
+      apply_matte(variant.out.first(required * kChannels), tile.width,
+                  tile.height, false, options.premultiply_alpha, workspace);
+    }
   }
+  return {};
+}
 
-  if (options.matte_hygiene) {
-    apply_matte(image.pixels, image.width, image.height);
+std::expected<void, Error> palette_to_indices_into(
+    const TileView& tile,
+    const PreparedPalette& palette,
+    std::span<std::uint8_t> out)
+{
+  StageTimer timer(Stage::convert);
+  if (!tile.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid tile view"));
+  }
+  if (palette.options.matte_hygiene) {
+    return std::unexpected(make_error(
+        errc::unsupported, "matte hygiene requires RGBA output"));
+  }
+
+  const auto required = static_cast<std::size_t>(tile.width) * tile.height;
+  if (out.size() < required) {
+    return std::unexpected(make_error(errc::conversion_failure,
+                                      "output buffer too small for tile"));
+  }
+  timer.add_pixels(required);
+  timer.add_bytes_in(required);
+  timer.add_bytes_out(required);
+
+  const auto& options = palette.options;
+  const bool remap = options.apply_lookup && !tile.lookup.empty();
+  std::array<std::uint8_t, palette_color_count> lookup{};
+  if (remap) {
+    for (std::size_t i = 0; i < palette_color_count; ++i) {
+      lookup[i] = apply_lookup(static_cast<std::uint8_t>(i), tile, options);
+    }
   }
 
-  if (options.premultiply_alpha) {
-    premultiply_alpha(image.pixels);
+  // Same strip walk as the RGBA path, but the transposed rows land directly
+  // in the output.
+  for (std::uint32_t y0 = 0; y0 < tile.height; y0 += kTransposeBlock) {
+    const auto rows = std::min(kTransposeBlock, tile.height - y0);
+    auto* strip = out.data() + static_cast<std::size_t>(y0) * tile.width;
+    transpose_strip(tile.indices, tile.width, tile.height, y0, rows, strip);
+    if (remap) {
+      const auto count = static_cast<std::size_t>(rows) * tile.width;
+      for (std::size_t i = 0; i < count; ++i) {
+        strip[i] = lookup[strip[i]];
+      }
+    }
   }
+  return {};
+}
 
-  return image;
+ImageRect opaque_bounds(const TileView& tile,
+                        const PreparedPalette& palette) noexcept
+{
+  if (!tile.valid() || tile.width == 0 || tile.height == 0) {
+    return {};
+  }
+
+  std::array<bool, palette_color_count> visible{};
+  for (std::size_t i = 0; i < palette_color_count; ++i) {
+    const auto index = apply_lookup(static_cast<std::uint8_t>(i), tile,
+                                    palette.options);
+    std::array<std::uint8_t, kChannels> rgba{};
+    std::memcpy(rgba.data(), &palette.colors[index], rgba.size());
+    visible[i] = rgba[3] != 0;
+  }
+
+  // Columns are contiguous, so each is scanned down to its first visible
+  // pixel and then up from the bottom, stopping at the lowest row already
+  // known to be visible.
+  auto left = tile.width;
+  std::uint32_t right = 0;
+  auto top = tile.height;
+  std::uint32_t bottom = 0;
+  for (std::uint32_t x = 0; x < tile.width; ++x) {
+    const auto* column = reinterpret_cast<const std::uint8_t*>(
+        tile.indices.data() + static_cast<std::size_t>(x) * tile.height);
+    std::uint32_t first = 0;
+    while (first < tile.height && !visible[column[first]]) {
+      ++first;
+    }
+    if (first == tile.height) {
+      continue;
+    }
+    auto last = tile.height - 1;
+    while (last > bottom && !visible[column[last]]) {
+      --last;
+    }
+    left = std::min(left, x);
+    right = x;
+    top = std::min(top, first);
+    bottom = std::max(bottom, last);
+  }
+
+  if (left == tile.width) {
+    return {};
+  }
+  return ImageRect{left, top, right - left + 1, bottom - top + 1};
 }
 
 void postprocess_rgba(RgbaImage& image, PostprocessOptions options)
 {
-  if (image.width == 0 || image.height == 0 || image.pixels.empty()) {
+  const StageTimer timer(Stage::postprocess);
+  ConversionWorkspace workspace{};
+  postprocess_rgba(image, options, workspace);
+}
+
+void postprocess_rgba(RgbaImage& image,
+                      PostprocessOptions options,
+                      ConversionWorkspace& workspace)
+{
+  postprocess_rgba(image.pixels, image.width, image.height, options,
+                   workspace);
+}
+
+void postprocess_rgba(std::span<std::uint8_t> pixels,
+                      std::uint32_t width,
+                      std::uint32_t height,
+                      PostprocessOptions options,
+                      ConversionWorkspace& workspace)
+{
+  StageTimer timer(Stage::postprocess);
+  if (width == 0 || height == 0 || pixels.empty()) {
     return;
   }
+  timer.add_pixels(static_cast<std::uint64_t>(width) * height);
+  timer.add_bytes_in(pixels.size());
+  timer.add_bytes_out(pixels.size());
 
-  if (options.apply_transparency_fix) {
-    clean_transparent_pixels(image.pixels, image.width, image.height);
+  if (options.sanitize_matte) {
+    apply_matte(pixels, width, height, options.apply_transparency_fix,
+                options.premultiply_alpha, workspace);
+    return;
   }
 
-  if (options.sanitize_matte) {
-    apply_matte(image.pixels, image.width, image.height);
+  const auto count = static_cast<std::size_t>(width) * height;
+  finish_pixels(pixels, options.apply_transparency_fix ? count : 0,
+                options.premultiply_alpha);
+}
+
+std::span<std::uint8_t> ConversionWorkspace::pixel_buffer(std::size_t bytes)
+{
+  if (bytes > pixel_capacity_) {
+    // Grow geometrically so a run of slightly larger tiles does not
+    // reallocate every time; the contents are left uninitialised.
+    const auto capacity = std::max(bytes, pixel_capacity_ * 2);
+    note_allocation();
+    pixels_ = std::make_unique_for_overwrite<std::uint8_t[]>(capacity);
+    pixel_capacity_ = capacity;
   }
+  return {pixels_.get(), bytes};
+}
 
-  if (options.premultiply_alpha) {
-    premultiply_alpha(image.pixels);
+PostprocessOptions residual_postprocess(ConversionOptions conversion,
+                                        PostprocessOptions postprocess) noexcept
+{
+  // Without matte hygiene, palette_to_rgba leaves alpha at 0 or 255 with
+  // every alpha-0 pixel black. Premultiplying after matte blacks them out too.
+  const bool binary_alpha = !conversion.matte_hygiene;
+  if (binary_alpha || conversion.premultiply_alpha) {
+    postprocess.apply_transparency_fix = false;
+  }
+  if (binary_alpha && !postprocess.sanitize_matte) {
+    postprocess.premultiply_alpha = false;
   }
+  return postprocess;
 }
 
 }  // namespace art2img::core
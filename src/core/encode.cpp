@@ -1,15 +1,36 @@
 #include <art2img/core/encode.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <expected>
+#include <limits>
+#include <memory>
 #include <span>
 #include <vector>
 
 #include <stb_image_write.h>
 
+#include <art2img/core/stats.hpp>
+
+#include "texture_blocks.hpp"
+
+#ifdef ART2IMG_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ART2IMG_ALPHA_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define ART2IMG_ALPHA_NEON 1
+#include <arm_neon.h>
+#endif
+
 namespace art2img::core {
 namespace {
 
@@ -25,191 +46,1379 @@ std::size_t row_bytes(const RgbaImageView& view) noexcept
   return static_cast<std::size_t>(view.width) * kChannels;
 }
 
-std::vector<std::uint8_t> make_contiguous_rgba(const RgbaImageView& view)
+// Packs one row of RGBA pixels into RGB, for 24-bit output.
+void pack_rgb_row(const std::uint8_t* src,
+                  std::uint32_t width,
+                  std::uint8_t* dst) noexcept
+{
+  for (std::uint32_t x = 0; x < width; ++x) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    src += kChannels;
+    dst += 3;
+  }
+}
+
+bool opaque_scalar(const std::uint8_t* row, std::uint32_t count) noexcept
+{
+  std::uint8_t all = 0xFF;
+  for (std::uint32_t x = 0; x < count; ++x) {
+    all &= row[x * kChannels + 3];
+  }
+  return all == 0xFF;
+}
+
+// True when every alpha is 255. Each row is ANDed 16 bytes at a time with
+// the colour bytes masked on, and the scan stops at the first row with a
+// translucent pixel. SSE2 and NEON are baseline on their targets, so there
+// is no runtime dispatch.
+bool opaque_alpha(const RgbaImageView& view) noexcept
 {
-  const auto bytes_per_row = row_bytes(view);
-  std::vector<std::uint8_t> buffer(static_cast<std::size_t>(view.height) *
-                                   bytes_per_row);
-  const auto* src = view.pixels.data();
-  auto* dst = buffer.data();
   for (std::uint32_t y = 0; y < view.height; ++y) {
-    std::memcpy(dst, src, bytes_per_row);
-    src += view.stride;
-    dst += bytes_per_row;
+    const auto* row =
+        view.pixels.data() + static_cast<std::size_t>(y) * view.stride;
+    std::uint32_t x = 0;
+#if defined(ART2IMG_ALPHA_SSE2)
+    const __m128i colour = _mm_set1_epi32(0x00FFFFFF);
+    __m128i all = _mm_set1_epi32(-1);
+    for (; x + 4 <= view.width; x += 4) {
+      all = _mm_and_si128(
+          all, _mm_loadu_si128(
+                   reinterpret_cast<const __m128i*>(row + x * kChannels)));
+    }
+    all = _mm_or_si128(all, colour);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(all, _mm_set1_epi32(-1))) !=
+        0xFFFF) {
+      return false;
+    }
+#elif defined(ART2IMG_ALPHA_NEON)
+    const uint8x16_t colour = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFF));
+    uint8x16_t all = vdupq_n_u8(0xFF);
+    for (; x + 4 <= view.width; x += 4) {
+      all = vandq_u8(all, vld1q_u8(row + x * kChannels));
+    }
+    if (vminvq_u8(vorrq_u8(all, colour)) != 0xFF) {
+      return false;
+    }
+#endif
+    if (!opaque_scalar(row + x * kChannels, view.width - x)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// stb cannot abort mid-image, so once the sink rejects a chunk the rest of
+// the output is dropped and the failure is reported afterwards.
+struct SinkContext {
+  const EncodeSink* sink = nullptr;
+  std::size_t written = 0;
+  bool failed = false;
+};
+
+void emit(SinkContext& output, const void* data, std::size_t size)
+{
+  if (output.failed || size == 0) {
+    return;
+  }
+  const std::span<const std::byte> chunk(static_cast<const std::byte*>(data),
+                                         size);
+  if (!(*output.sink)(chunk)) {
+    output.failed = true;
+    return;
   }
-  return buffer;
+  output.written += size;
+}
+
+// The most channels an encode can write; estimates size for this.
+std::size_t output_channels(EncoderOptions options) noexcept
+{
+  return options.bit_depth == BitDepth::bpp24 ? 3 : kChannels;
 }
 
-std::vector<std::uint8_t> drop_alpha(const std::uint8_t* data,
-                                     std::uint32_t width,
-                                     std::uint32_t height,
-                                     std::size_t stride)
+// The channels an encode of `view` writes: `auto_detect` drops alpha when
+// every pixel is opaque.
+std::size_t output_channels(const RgbaImageView& view,
+                            EncoderOptions options) noexcept
 {
-  std::vector<std::uint8_t> buffer(static_cast<std::size_t>(width) * height *
-                                   3);
+  switch (options.bit_depth) {
+    case BitDepth::bpp24:
+      return 3;
+    case BitDepth::bpp32:
+      return kChannels;
+    case BitDepth::auto_detect:
+      break;
+  }
+  return opaque_alpha(view) ? 3 : kChannels;
+}
+
+enum class RowFilter : std::uint8_t { none, up, adaptive };
+
+struct DeflatePreset {
+  int level = 0;
+  RowFilter filter = RowFilter::adaptive;
+};
+
+// Levels are on the backend's own scale: libdeflate runs 1-12, while stb's
+// quality bounds its hash chains, with anything below 5 acting as 5.
+constexpr DeflatePreset deflate_preset(CompressionPreset preset) noexcept
+{
+  switch (preset) {
+#ifdef ART2IMG_HAVE_LIBDEFLATE
+    case CompressionPreset::fast:
+      return {1, RowFilter::up};
+    case CompressionPreset::balanced:
+      return {6, RowFilter::adaptive};
+    case CompressionPreset::smallest:
+      return {12, RowFilter::adaptive};
+#else
+    case CompressionPreset::fast:
+      return {5, RowFilter::up};
+    case CompressionPreset::balanced:
+      return {8, RowFilter::adaptive};
+    case CompressionPreset::smallest:
+      return {32, RowFilter::adaptive};
+#endif
+  }
+  return {};
+}
+
+#ifdef ART2IMG_HAVE_LIBDEFLATE
+
+struct CompressorDeleter {
+  void operator()(libdeflate_compressor* compressor) const noexcept
+  {
+    libdeflate_free_compressor(compressor);
+  }
+};
+
+// Compressors carry sizeable match-finder state, so each thread keeps one
+// per level instead of allocating it for every image.
+libdeflate_compressor* compressor_for(int level)
+{
+  thread_local std::array<
+      std::unique_ptr<libdeflate_compressor, CompressorDeleter>, 13>
+      cache;
+  auto& slot = cache[static_cast<std::size_t>(level)];
+  if (!slot) {
+    slot.reset(libdeflate_alloc_compressor(level));
+  }
+  return slot.get();
+}
+
+std::expected<std::vector<std::uint8_t>, Error> zlib_compress(
+    std::span<const std::uint8_t> data,
+    int level)
+{
+  auto* compressor = compressor_for(level);
+  if (compressor == nullptr) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "failed to compress PNG data"));
+  }
+  std::vector<std::uint8_t> compressed(
+      libdeflate_zlib_compress_bound(compressor, data.size()));
+  note_allocation();
+  const auto size =
+      libdeflate_zlib_compress(compressor, data.data(), data.size(),
+                               compressed.data(), compressed.size());
+  if (size == 0) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "failed to compress PNG data"));
+  }
+  compressed.resize(size);
+  return compressed;
+}
+
+#else
+
+std::expected<std::vector<std::uint8_t>, Error> zlib_compress(
+    std::span<const std::uint8_t> data,
+    int level)
+{
+  int size = 0;
+  std::unique_ptr<unsigned char, decltype(&std::free)> compressed(
+      stbi_zlib_compress(const_cast<unsigned char*>(data.data()),
+                         static_cast<int>(data.size()), &size, level),
+      &std::free);
+  if (!compressed) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "failed to compress PNG data"));
+  }
+  note_allocation(2);
+  return std::vector<std::uint8_t>(compressed.get(), compressed.get() + size);
+}
+
+#endif
+
+constexpr std::size_t kStoredBlockBytes = 65535;
+
+// Size of `size` bytes as a zlib stream of stored deflate blocks: the two
+// byte header, five bytes framing each block and the Adler-32 trailer.
+constexpr std::size_t stored_zlib_size(std::size_t size) noexcept
+{
+  const auto blocks = std::max<std::size_t>(
+      1, (size + kStoredBlockBytes - 1) / kStoredBlockBytes);
+  return 2 + blocks * 5 + size + 4;
+}
+
+// Wraps `data` in stored blocks uncompressed. Used when deflate would expand
+// it, which stb does for incompressible input since it never falls back to
+// stored blocks itself.
+std::vector<std::uint8_t> zlib_store(std::span<const std::uint8_t> data)
+{
+  std::vector<std::uint8_t> stored;
+  stored.reserve(stored_zlib_size(data.size()));
+  note_allocation();
+  stored.push_back(0x78);
+  stored.push_back(0x01);
+  std::size_t offset = 0;
+  do {
+    const auto length = std::min(kStoredBlockBytes, data.size() - offset);
+    const bool last = offset + length == data.size();
+    stored.push_back(last ? 1 : 0);  // BFINAL, BTYPE 00
+    stored.push_back(static_cast<std::uint8_t>(length));
+    stored.push_back(static_cast<std::uint8_t>(length >> 8));
+    stored.push_back(static_cast<std::uint8_t>(~length));
+    stored.push_back(static_cast<std::uint8_t>(~length >> 8));
+    stored.insert(stored.end(), data.begin() + offset,
+                  data.begin() + offset + length);
+    offset += length;
+  } while (offset < data.size());
+
+  // Adler-32, reduced often enough that the sums cannot overflow.
+  std::uint32_t a = 1;
+  std::uint32_t b = 0;
+  for (std::size_t i = 0; i < data.size();) {
+    const auto end = std::min(data.size(), i + 5552);
+    for (; i < end; ++i) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  const auto adler = (b << 16) | a;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    stored.push_back(static_cast<std::uint8_t>(adler >> shift));
+  }
+  return stored;
+}
+
+std::uint8_t paeth(std::uint8_t a, std::uint8_t b, std::uint8_t c) noexcept
+{
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+// Applies PNG filter `type` to one row; `prior` is the unfiltered previous
+// row, or zeros for the first.
+void filter_row(std::uint8_t type,
+                const std::uint8_t* row,
+                const std::uint8_t* prior,
+                std::size_t size,
+                std::size_t bpp,
+                std::uint8_t* out) noexcept
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    const std::uint8_t left = i >= bpp ? row[i - bpp] : 0;
+    const std::uint8_t up = prior[i];
+    const std::uint8_t up_left = i >= bpp ? prior[i - bpp] : 0;
+    std::uint8_t predicted = 0;
+    switch (type) {
+      case 1:
+        predicted = left;
+        break;
+      case 2:
+        predicted = up;
+        break;
+      case 3:
+        predicted = static_cast<std::uint8_t>((left + up) / 2);
+        break;
+      case 4:
+        predicted = paeth(left, up, up_left);
+        break;
+      default:
+        break;
+    }
+    out[i] = static_cast<std::uint8_t>(row[i] - predicted);
+  }
+}
+
+// Lays out tightly packed rows with a leading filter byte each. The adaptive
+// mode keeps, per row, the filter with the smallest sum of signed residuals,
+// the heuristic libpng and stb use. `data` rows are read at `stride`; with
+// `bpp` 3 they are RGBA and packed to RGB one row at a time into two
+// scanlines, the current row and its prior.
+std::vector<std::uint8_t> filter_rows(const std::uint8_t* data,
+                                      std::uint32_t width,
+                                      std::uint32_t height,
+                                      std::size_t stride,
+                                      std::size_t bpp,
+                                      RowFilter mode)
+{
+  const std::size_t size = static_cast<std::size_t>(width) * bpp;
+  const bool pack = bpp == 3;
+  std::vector<std::uint8_t> filtered((size + 1) * height);
+  std::vector<std::uint8_t> zeros(size, 0);
+  std::vector<std::uint8_t> trial(mode == RowFilter::adaptive ? size : 0);
+  std::vector<std::uint8_t> scanlines(pack ? size * 2 : 0);
+  note_allocation(2 + (mode == RowFilter::adaptive ? 1 : 0) + (pack ? 1 : 0));
+
+  const std::uint8_t* prior = zeros.data();
   for (std::uint32_t y = 0; y < height; ++y) {
-    const auto* src_row = data + static_cast<std::size_t>(y) * stride;
-    auto* dst_row = buffer.data() + static_cast<std::size_t>(y) * width * 3;
-    for (std::uint32_t x = 0; x < width; ++x) {
-      const auto* src_px = src_row + static_cast<std::size_t>(x) * kChannels;
-      auto* dst_px = dst_row + static_cast<std::size_t>(x) * 3;
-      dst_px[0] = src_px[0];
-      dst_px[1] = src_px[1];
-      dst_px[2] = src_px[2];
+    const std::uint8_t* row = data + static_cast<std::size_t>(y) * stride;
+    if (pack) {
+      auto* scanline = scanlines.data() + (y % 2) * size;
+      pack_rgb_row(row, width, scanline);
+      row = scanline;
+    }
+    auto* dst = filtered.data() + static_cast<std::size_t>(y) * (size + 1);
+
+    std::uint8_t best = 0;
+    if (mode == RowFilter::up) {
+      best = 2;
+    }
+    else if (mode == RowFilter::adaptive) {
+      auto best_cost = std::numeric_limits<std::size_t>::max();
+      for (std::uint8_t type = 0; type < 5; ++type) {
+        filter_row(type, row, prior, size, bpp, trial.data());
+        std::size_t cost = 0;
+        for (const auto value : trial) {
+          cost += static_cast<std::size_t>(
+              std::abs(static_cast<int>(static_cast<std::int8_t>(value))));
+        }
+        if (cost < best_cost) {
+          best_cost = cost;
+          best = type;
+        }
+      }
+    }
+    dst[0] = best;
+    filter_row(best, row, prior, size, bpp, dst + 1);
+    prior = row;
+  }
+  return filtered;
+}
+
+constexpr std::array<std::uint32_t, 256> kCrcTable = [] {
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t n = 0; n < table.size(); ++n) {
+    std::uint32_t c = n;
+    for (int k = 0; k < 8; ++k) {
+      c = (c & 1) != 0 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
     }
+    table[n] = c;
+  }
+  return table;
+}();
+
+std::uint32_t update_crc(std::uint32_t crc,
+                         const std::uint8_t* data,
+                         std::size_t size) noexcept
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = kCrcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
   }
-  return buffer;
+  return crc;
 }
 
-void write_bytes(void* context, void* data, int size)
+void put_be32(std::uint8_t* out, std::uint32_t value) noexcept
 {
-  auto* output = static_cast<std::vector<std::byte>*>(context);
-  const auto* begin = static_cast<const std::uint8_t*>(data);
-  const auto* end = begin + size;
-  output->insert(output->end(), reinterpret_cast<const std::byte*>(begin),
-                 reinterpret_cast<const std::byte*>(end));
+  out[0] = static_cast<std::uint8_t>(value >> 24);
+  out[1] = static_cast<std::uint8_t>(value >> 16);
+  out[2] = static_cast<std::uint8_t>(value >> 8);
+  out[3] = static_cast<std::uint8_t>(value);
 }
 
-std::expected<std::vector<std::byte>, Error> encode_png(
-    const RgbaImageView& view,
-    EncoderOptions options)
+void emit_chunk(SinkContext& output,
+                const char (&type)[5],
+                const std::uint8_t* data,
+                std::size_t size)
 {
-  if (!validate_view(view)) {
+  std::array<std::uint8_t, 8> head{};
+  put_be32(head.data(), static_cast<std::uint32_t>(size));
+  std::memcpy(head.data() + 4, type, 4);
+  auto crc = update_crc(0xFFFFFFFFu, head.data() + 4, 4);
+  crc = update_crc(crc, data, size) ^ 0xFFFFFFFFu;
+  std::array<std::uint8_t, 4> tail{};
+  put_be32(tail.data(), crc);
+
+  // Emitted piecewise so large IDAT payloads reach the sink without being
+  // copied next to their length and CRC.
+  emit(output, head.data(), head.size());
+  emit(output, data, size);
+  emit(output, tail.data(), tail.size());
+}
+
+void emit_png_header(SinkContext& output,
+                     std::uint32_t width,
+                     std::uint32_t height,
+                     std::uint8_t color_type)
+{
+  static constexpr std::array<std::uint8_t, 8> kSignature{
+      0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  emit(output, kSignature.data(), kSignature.size());
+
+  std::array<std::uint8_t, 13> header{};
+  put_be32(header.data(), width);
+  put_be32(header.data() + 4, height);
+  header[8] = 8;  // bit depth
+  header[9] = color_type;
+  emit_chunk(output, "IHDR", header.data(), header.size());
+}
+
+std::expected<void, Error> emit_png_image(SinkContext& output,
+                                          std::span<const std::uint8_t> rows,
+                                          int level)
+{
+  auto compressed = zlib_compress(rows, level);
+  if (!compressed) {
+    return std::unexpected(compressed.error());
+  }
+  // Storing caps the stream at a known size, which is what lets
+  // estimate_encoded_size bound PNG output.
+  if (compressed->size() > stored_zlib_size(rows.size())) {
+    *compressed = zlib_store(rows);
+  }
+  emit_chunk(output, "IDAT", compressed->data(), compressed->size());
+  emit_chunk(output, "IEND", nullptr, 0);
+  return {};
+}
+
+std::expected<void, Error> encode_indexed_png(const IndexedImageView& view,
+                                              EncoderOptions options,
+                                              SinkContext& output)
+{
+  // Palettised rows are never filtered: neighbouring index deltas carry no
+  // meaning, so prediction only adds noise for deflate.
+  const auto filtered = filter_rows(view.indices.data(), view.width,
+                                    view.height, view.stride, 1,
+                                    RowFilter::none);
+
+  emit_png_header(output, view.width, view.height, 3);
+
+  std::array<std::uint8_t, 256 * 3> colors{};
+  std::array<std::uint8_t, 256> alpha{};
+  std::size_t alpha_count = 0;
+  for (std::size_t i = 0; i < view.palette.size(); ++i) {
+    std::array<std::uint8_t, kChannels> rgba{};
+    std::memcpy(rgba.data(), &view.palette[i], rgba.size());
+    std::memcpy(colors.data() + i * 3, rgba.data(), 3);
+    alpha[i] = rgba[3];
+    if (rgba[3] != 255) {
+      alpha_count = i + 1;  // trailing opaque entries may be omitted
+    }
+  }
+  emit_chunk(output, "PLTE", colors.data(), view.palette.size() * 3);
+  if (alpha_count > 0) {
+    emit_chunk(output, "tRNS", alpha.data(), alpha_count);
+  }
+
+  return emit_png_image(output, filtered,
+                        deflate_preset(options.compression).level);
+}
+
+void put_le16(std::uint8_t* out, std::uint32_t value) noexcept
+{
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void put_le32(std::uint8_t* out, std::uint32_t value) noexcept
+{
+  put_le16(out, value);
+  put_le16(out + 2, value >> 16);
+}
+
+// Appends one scanline of `bpp`-byte pixels as TGA packets. Packets never
+// span scanlines, as the TGA 2.0 specification recommends. A run of two
+// pays for its header only when pixels are wider than a byte; two 8-bit
+// indices cost as much either way, and the run would split the literal
+// packet around it, so index runs start at three.
+void append_rle_row(const std::uint8_t* row,
+                    std::uint32_t width,
+                    std::size_t bpp,
+                    std::vector<std::uint8_t>& out)
+{
+  const std::uint32_t min_run = bpp == 1 ? 3 : 2;
+  auto same = [row, bpp](std::uint32_t a, std::uint32_t b) {
+    return std::memcmp(row + a * bpp, row + b * bpp, bpp) == 0;
+  };
+  auto run_starts = [&](std::uint32_t at) {
+    if (width - at < min_run) {
+      return false;
+    }
+    for (std::uint32_t i = 1; i < min_run; ++i) {
+      if (!same(at + i, at)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::uint32_t x = 0;
+  while (x < width) {
+    std::uint32_t run = 1;
+    while (x + run < width && run < 128 && same(x + run, x)) {
+      ++run;
+    }
+    if (run >= min_run) {
+      out.push_back(static_cast<std::uint8_t>(0x80 | (run - 1)));
+      out.insert(out.end(), row + x * bpp, row + (x + 1) * bpp);
+      x += run;
+      continue;
+    }
+
+    // Collect literals up to the next run worth a packet.
+    std::uint32_t literal = 1;
+    while (x + literal < width && literal < 128 && !run_starts(x + literal)) {
+      ++literal;
+    }
+    out.push_back(static_cast<std::uint8_t>(literal - 1));
+    out.insert(out.end(), row + x * bpp, row + (x + literal) * bpp);
+    x += literal;
+  }
+}
+
+bool has_alpha(std::span<const std::uint32_t> palette) noexcept
+{
+  return std::any_of(palette.begin(), palette.end(), [](std::uint32_t color) {
+    std::array<std::uint8_t, kChannels> rgba{};
+    std::memcpy(rgba.data(), &color, rgba.size());
+    return rgba[3] != 255;
+  });
+}
+
+// Colour-mapped TGA (type 1, or 9 with RLE) with a BGR(A) map. Rows are
+// written bottom-up with the default lower-left origin, which every legacy
+// reader understands.
+std::expected<void, Error> encode_indexed_tga(const IndexedImageView& view,
+                                              EncoderOptions options,
+                                              SinkContext& output)
+{
+  const bool alpha = has_alpha(view.palette);
+  const std::size_t entry = alpha ? 4 : 3;
+
+  std::array<std::uint8_t, 18> header{};
+  header[1] = 1;  // colour map present
+  header[2] = options.tga_rle ? 9 : 1;
+  put_le16(header.data() + 5, static_cast<std::uint32_t>(view.palette.size()));
+  header[7] = static_cast<std::uint8_t>(entry * 8);
+  put_le16(header.data() + 12, view.width);
+  put_le16(header.data() + 14, view.height);
+  header[16] = 8;              // bits per index
+  header[17] = alpha ? 8 : 0;  // attribute bits, lower-left origin
+  emit(output, header.data(), header.size());
+
+  std::array<std::uint8_t, 256 * 4> map{};
+  for (std::size_t i = 0; i < view.palette.size(); ++i) {
+    std::array<std::uint8_t, kChannels> rgba{};
+    std::memcpy(rgba.data(), &view.palette[i], rgba.size());
+    auto* dst = map.data() + i * entry;
+    dst[0] = rgba[2];
+    dst[1] = rgba[1];
+    dst[2] = rgba[0];
+    if (alpha) {
+      dst[3] = rgba[3];
+    }
+  }
+  emit(output, map.data(), view.palette.size() * entry);
+
+  std::vector<std::uint8_t> packed;
+  if (options.tga_rle) {
+    packed.reserve(static_cast<std::size_t>(view.width) + view.width / 128 + 1);
+    note_allocation();
+  }
+  for (std::uint32_t y = view.height; y-- > 0;) {
+    const auto* row =
+        view.indices.data() + static_cast<std::size_t>(y) * view.stride;
+    if (!options.tga_rle) {
+      emit(output, row, view.width);
+      continue;
+    }
+    packed.clear();
+    append_rle_row(row, view.width, 1, packed);
+    emit(output, packed.data(), packed.size());
+  }
+  return {};
+}
+
+// 8bpp BI_RGB bitmap: BITMAPINFOHEADER, a BGRX colour table, then bottom-up
+// rows padded to four bytes. BMP has no palette alpha, so transparency is
+// carried only by the colour the prepared palette gives index 255.
+std::expected<void, Error> encode_indexed_bmp(const IndexedImageView& view,
+                                              SinkContext& output)
+{
+  const std::size_t row_size = (static_cast<std::size_t>(view.width) + 3) & ~3u;
+  const std::size_t table_size = view.palette.size() * 4;
+  const std::size_t pixel_offset = 14 + 40 + table_size;
+  const std::size_t file_size = pixel_offset + row_size * view.height;
+  if (file_size > 0xFFFFFFFFu) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "invalid image view for PNG"));
+        make_error(errc::encoding_failure, "image too large for BMP"));
   }
 
-  const auto expected_stride = row_bytes(view);
-  const std::uint8_t* data_ptr = view.pixels.data();
-  std::vector<std::uint8_t> owned;
-  if (view.stride != expected_stride) {
-    owned = make_contiguous_rgba(view);
-    data_ptr = owned.data();
+  std::array<std::uint8_t, 54> header{};
+  header[0] = 'B';
+  header[1] = 'M';
+  put_le32(header.data() + 2, static_cast<std::uint32_t>(file_size));
+  put_le32(header.data() + 10, static_cast<std::uint32_t>(pixel_offset));
+  put_le32(header.data() + 14, 40);  // BITMAPINFOHEADER
+  put_le32(header.data() + 18, view.width);
+  put_le32(header.data() + 22, view.height);  // positive: bottom-up
+  put_le16(header.data() + 26, 1);            // planes
+  put_le16(header.data() + 28, 8);            // bits per pixel
+  put_le32(header.data() + 34,
+           static_cast<std::uint32_t>(row_size * view.height));
+  put_le32(header.data() + 38, 2835);  // 72 DPI
+  put_le32(header.data() + 42, 2835);
+  put_le32(header.data() + 46, static_cast<std::uint32_t>(view.palette.size()));
+  emit(output, header.data(), header.size());
+
+  std::array<std::uint8_t, 256 * 4> table{};
+  for (std::size_t i = 0; i < view.palette.size(); ++i) {
+    std::array<std::uint8_t, kChannels> rgba{};
+    std::memcpy(rgba.data(), &view.palette[i], rgba.size());
+    table[i * 4 + 0] = rgba[2];
+    table[i * 4 + 1] = rgba[1];
+    table[i * 4 + 2] = rgba[0];
   }
+  emit(output, table.data(), table_size);
 
-  int channels = 4;
-  std::vector<std::uint8_t> converted;
-  if (options.bit_depth == BitDepth::bpp24) {
-    converted = drop_alpha(data_ptr, view.width, view.height, expected_stride);
-    data_ptr = converted.data();
-    channels = 3;
+  static constexpr std::array<std::uint8_t, 3> kPadding{};
+  for (std::uint32_t y = view.height; y-- > 0;) {
+    emit(output,
+         view.indices.data() + static_cast<std::size_t>(y) * view.stride,
+         view.width);
+    emit(output, kPadding.data(), row_size - view.width);
   }
+  return {};
+}
 
-  std::vector<std::byte> output;
-  const int result = stbi_write_png_to_func(
-      write_bytes, &output, static_cast<int>(view.width),
-      static_cast<int>(view.height), channels, data_ptr, channels * view.width);
-  if (result == 0) {
+std::expected<void, Error> encode_png(const RgbaImageView& view,
+                                     EncoderOptions options,
+                                     SinkContext& output)
+{
+  if (!validate_view(view)) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "failed to encode PNG"));
+        make_error(errc::encoding_failure, "invalid image view for PNG"));
   }
-  return output;
+
+  const auto channels = output_channels(view, options);
+
+  // Compression is configured per call rather than through
+  // stbi_write_png_compression_level, which is global and shared by every
+  // encoding thread. stb's own writer is not used even for its defaults, as
+  // it would expand incompressible rows past estimate_encoded_size.
+  const auto preset = deflate_preset(options.compression);
+  const auto filtered = filter_rows(view.pixels.data(), view.width,
+                                    view.height, view.stride, channels,
+                                    preset.filter);
+  emit_png_header(output, view.width, view.height, channels == 4 ? 6 : 2);
+  return emit_png_image(output, filtered, preset.level);
 }
 
-std::expected<std::vector<std::byte>, Error> encode_tga(
-    const RgbaImageView& view,
-    EncoderOptions options)
+// Swizzles one row of RGBA pixels to BGR(A), the byte order TGA and BMP
+// store.
+void pack_bgr_row(const std::uint8_t* src,
+                  std::uint32_t width,
+                  std::size_t channels,
+                  std::uint8_t* dst) noexcept
+{
+  for (std::uint32_t x = 0; x < width; ++x) {
+    dst[0] = src[2];
+    dst[1] = src[1];
+    dst[2] = src[0];
+    if (channels == kChannels) {
+      dst[3] = src[3];
+    }
+    src += kChannels;
+    dst += channels;
+  }
+}
+
+// Truecolour TGA (type 2, or 10 with `tga_rle`), BGR or BGRA, bottom-up with
+// the lower-left origin like the indexed writer. Each row is swizzled into
+// one reused scanline straight from the view's stride.
+std::expected<void, Error> encode_tga(const RgbaImageView& view,
+                                     EncoderOptions options,
+                                     SinkContext& output)
 {
   if (!validate_view(view)) {
     return std::unexpected(
         make_error(errc::encoding_failure, "invalid image view for TGA"));
   }
 
-  const auto expected_stride = row_bytes(view);
-  const std::uint8_t* data_ptr = view.pixels.data();
-  std::vector<std::uint8_t> owned;
-  if (view.stride != expected_stride) {
-    owned = make_contiguous_rgba(view);
-    data_ptr = owned.data();
+  const auto channels = output_channels(view, options);
+  std::array<std::uint8_t, 18> header{};
+  header[2] = options.tga_rle ? 10 : 2;
+  put_le16(header.data() + 12, view.width);
+  put_le16(header.data() + 14, view.height);
+  header[16] = static_cast<std::uint8_t>(channels * 8);
+  header[17] = channels == kChannels ? 8 : 0;  // attribute bits
+  emit(output, header.data(), header.size());
+
+  const std::size_t size = static_cast<std::size_t>(view.width) * channels;
+  std::vector<std::uint8_t> scanline(size);
+  std::vector<std::uint8_t> packed;
+  if (options.tga_rle) {
+    packed.reserve(size + view.width / 128 + 1);
   }
+  note_allocation(options.tga_rle ? 2 : 1);
+  for (std::uint32_t y = view.height; y-- > 0;) {
+    pack_bgr_row(
+        view.pixels.data() + static_cast<std::size_t>(y) * view.stride,
+        view.width, channels, scanline.data());
+    if (!options.tga_rle) {
+      emit(output, scanline.data(), size);
+      continue;
+    }
+    packed.clear();
+    append_rle_row(scanline.data(), view.width, channels, packed);
+    emit(output, packed.data(), packed.size());
+  }
+  return {};
+}
 
-  int channels = 4;
-  std::vector<std::uint8_t> converted;
-  if (options.bit_depth == BitDepth::bpp24) {
-    converted = drop_alpha(data_ptr, view.width, view.height, expected_stride);
-    data_ptr = converted.data();
-    channels = 3;
+// 24-bit BI_RGB bitmap with rows padded to four bytes, or 32-bit
+// BI_BITFIELDS with a BITMAPV4HEADER carrying the alpha mask, which is what
+// most readers need to honour alpha. Rows are bottom-up.
+std::expected<void, Error> encode_bmp(const RgbaImageView& view,
+                                     EncoderOptions options,
+                                     SinkContext& output)
+{
+  if (!validate_view(view)) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "invalid image view for BMP"));
   }
 
-  std::vector<std::byte> output;
-  const int result =
-      stbi_write_tga_to_func(write_bytes, &output, static_cast<int>(view.width),
-                             static_cast<int>(view.height), channels, data_ptr);
-  if (result == 0) {
+  const auto channels = output_channels(view, options);
+  const bool alpha = channels == kChannels;
+  const std::size_t info_size = alpha ? 108 : 40;
+  const std::size_t size = static_cast<std::size_t>(view.width) * channels;
+  const std::size_t row_size = (size + 3) & ~std::size_t{3};
+  const std::size_t pixel_offset = 14 + info_size;
+
+  std::array<std::uint8_t, 14 + 108> header{};
+  header[0] = 'B';
+  header[1] = 'M';
+  put_le32(header.data() + 2, static_cast<std::uint32_t>(
+                                  pixel_offset + row_size * view.height));
+  put_le32(header.data() + 10, static_cast<std::uint32_t>(pixel_offset));
+  put_le32(header.data() + 14, static_cast<std::uint32_t>(info_size));
+  put_le32(header.data() + 18, view.width);
+  put_le32(header.data() + 22, view.height);  // positive: bottom-up
+  put_le16(header.data() + 26, 1);            // planes
+  put_le16(header.data() + 28, static_cast<std::uint32_t>(channels * 8));
+  if (alpha) {
+    put_le32(header.data() + 30, 3);  // BI_BITFIELDS
+    put_le32(header.data() + 54, 0x00FF0000u);
+    put_le32(header.data() + 58, 0x0000FF00u);
+    put_le32(header.data() + 62, 0x000000FFu);
+    put_le32(header.data() + 66, 0xFF000000u);
+  }
+  emit(output, header.data(), pixel_offset);
+
+  std::vector<std::uint8_t> scanline(row_size, 0);
+  note_allocation();
+  for (std::uint32_t y = view.height; y-- > 0;) {
+    pack_bgr_row(
+        view.pixels.data() + static_cast<std::size_t>(y) * view.stride,
+        view.width, channels, scanline.data());
+    emit(output, scanline.data(), row_size);
+  }
+  return {};
+}
+
+constexpr std::size_t kDdsHeaderBytes = 128;  // magic plus DDS_HEADER
+
+bool binary_alpha(const RgbaImageView& view) noexcept
+{
+  for (std::uint32_t y = 0; y < view.height; ++y) {
+    const auto* row =
+        view.pixels.data() + static_cast<std::size_t>(y) * view.stride;
+    for (std::uint32_t x = 0; x < view.width; ++x) {
+      const auto alpha = row[x * kChannels + 3];
+      if (alpha != 0 && alpha != 255) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::size_t texture_block_bytes(TextureCompression texture) noexcept
+{
+  switch (texture) {
+    case TextureCompression::bc1:
+      return 8;
+    case TextureCompression::bc3:
+    case TextureCompression::automatic:
+      return 16;
+    case TextureCompression::none:
+      break;
+  }
+  return 0;
+}
+
+std::size_t dds_level_bytes(std::uint32_t width,
+                            std::uint32_t height,
+                            TextureCompression texture) noexcept
+{
+  const auto block_bytes = texture_block_bytes(texture);
+  if (block_bytes == 0) {
+    return static_cast<std::size_t>(width) * height * kChannels;
+  }
+  return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) *
+         block_bytes;
+}
+
+void emit_dds_header(SinkContext& output,
+                     const RgbaImageView& view,
+                     std::size_t level_count,
+                     TextureCompression texture)
+{
+  constexpr std::uint32_t caps = 0x1, height = 0x2, width = 0x4, pitch = 0x8,
+                          pixel_format = 0x1000, mipmap_count = 0x20000,
+                          linear_size = 0x80000;
+  constexpr std::uint32_t alpha_pixels = 0x1, fourcc = 0x4, rgb = 0x40;
+  constexpr std::uint32_t complex = 0x8, texture_caps = 0x1000,
+                          mipmap = 0x400000;
+
+  std::array<std::uint8_t, kDdsHeaderBytes> header{};
+  std::memcpy(header.data(), "DDS ", 4);
+  auto* dds = header.data() + 4;
+  const bool compressed = texture != TextureCompression::none;
+  std::uint32_t flags = caps | height | width | pixel_format;
+  flags |= compressed ? linear_size : pitch;
+  if (level_count > 1) {
+    flags |= mipmap_count;
+  }
+  put_le32(dds, 124);
+  put_le32(dds + 4, flags);
+  put_le32(dds + 8, view.height);
+  put_le32(dds + 12, view.width);
+  put_le32(dds + 16,
+           static_cast<std::uint32_t>(
+               compressed ? dds_level_bytes(view.width, view.height, texture)
+                          : static_cast<std::size_t>(view.width) * kChannels));
+  put_le32(dds + 24, static_cast<std::uint32_t>(level_count));
+
+  // DDS_PIXELFORMAT
+  auto* format = dds + 72;
+  put_le32(format, 32);
+  if (compressed) {
+    put_le32(format + 4, fourcc);
+    const auto* code = texture == TextureCompression::bc1 ? "DXT1" : "DXT5";
+    std::memcpy(format + 8, code, 4);
+  }
+  else {
+    // Masks for R, G, B, A bytes in memory order (DXGI R8G8B8A8_UNORM).
+    put_le32(format + 4, rgb | alpha_pixels);
+    put_le32(format + 12, 32);
+    put_le32(format + 16, 0x000000FFu);
+    put_le32(format + 20, 0x0000FF00u);
+    put_le32(format + 24, 0x00FF0000u);
+    put_le32(format + 28, 0xFF000000u);
+  }
+
+  put_le32(dds + 104,
+           texture_caps | (level_count > 1 ? complex | mipmap : 0u));
+  emit(output, header.data(), header.size());
+}
+
+// One mip level's payload: rows as they are, or a row of 4x4 blocks at a
+// time with edge pixels repeated to fill partial blocks.
+void emit_dds_level(SinkContext& output,
+                    const RgbaImageView& view,
+                    TextureCompression texture,
+                    std::vector<std::uint8_t>& scratch)
+{
+  const auto block_bytes = texture_block_bytes(texture);
+  if (block_bytes == 0) {
+    for (std::uint32_t y = 0; y < view.height; ++y) {
+      const auto* row =
+          view.pixels.data() + static_cast<std::size_t>(y) * view.stride;
+      emit(output, row, row_bytes(view));
+    }
+    return;
+  }
+
+  const std::uint32_t blocks_wide = (view.width + 3) / 4;
+  scratch.resize(static_cast<std::size_t>(blocks_wide) * block_bytes);
+  std::array<std::uint8_t, 16 * kChannels> block{};
+  for (std::uint32_t by = 0; by < view.height; by += 4) {
+    for (std::uint32_t bx = 0; bx < view.width; bx += 4) {
+      for (std::uint32_t i = 0; i < 16; ++i) {
+        const auto x = std::min(bx + i % 4, view.width - 1);
+        const auto y = std::min(by + i / 4, view.height - 1);
+        std::memcpy(block.data() + i * kChannels,
+                    view.pixels.data() +
+                        static_cast<std::size_t>(y) * view.stride +
+                        static_cast<std::size_t>(x) * kChannels,
+                    kChannels);
+      }
+      auto* out = scratch.data() + (bx / 4) * block_bytes;
+      if (texture == TextureCompression::bc1) {
+        detail::compress_bc1_block(block.data(), out);
+      }
+      else {
+        detail::compress_bc3_block(block.data(), out);
+      }
+    }
+    emit(output, scratch.data(), scratch.size());
+  }
+}
+
+std::expected<void, Error> encode_dds(const RgbaImageView& view,
+                                      std::span<const RgbaImageView> levels,
+                                      EncoderOptions options,
+                                      SinkContext& output)
+{
+  if (!validate_view(view)) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "failed to encode TGA"));
+        make_error(errc::encoding_failure, "invalid image view for DDS"));
+  }
+  auto previous = view;
+  for (const auto& level : levels) {
+    if (!level.valid() || level.width != std::max(1u, previous.width / 2) ||
+        level.height != std::max(1u, previous.height / 2)) {
+      return std::unexpected(make_error(
+          errc::encoding_failure, "mip levels must halve the level above"));
+    }
+    previous = level;
   }
-  return output;
+
+  // Chosen once from the full-size image so every level shares one format.
+  auto texture = options.texture;
+  if (texture == TextureCompression::automatic) {
+    texture = binary_alpha(view) ? TextureCompression::bc1
+                                 : TextureCompression::bc3;
+  }
+
+  emit_dds_header(output, view, levels.size() + 1, texture);
+  std::vector<std::uint8_t> scratch;
+  if (texture != TextureCompression::none) {
+    note_allocation();
+  }
+  emit_dds_level(output, view, texture, scratch);
+  for (const auto& level : levels) {
+    emit_dds_level(output, level, texture, scratch);
+  }
+  return {};
 }
 
-std::expected<std::vector<std::byte>, Error> encode_bmp(
-    const RgbaImageView& view,
-    EncoderOptions options)
+constexpr std::size_t kQoiHeaderBytes = 14;
+constexpr std::array<std::uint8_t, 8> kQoiEnd{0, 0, 0, 0, 0, 0, 0, 1};
+
+// Worst case is a full QOI_OP_RGBA (or QOI_OP_RGB) for every pixel.
+std::size_t qoi_row_bound(std::uint32_t width, std::size_t channels) noexcept
+{
+  return static_cast<std::size_t>(width) * (channels + 1);
+}
+
+// QOI (qoiformat.org): running-hash index, small deltas and runs over the
+// previous pixel. Rows are encoded straight from the view's stride into a
+// one-row buffer, so output streams to the sink with no full-image copy.
+// 24-bit output encodes every alpha as 255, as the format requires.
+std::expected<void, Error> encode_qoi(const RgbaImageView& view,
+                                     EncoderOptions options,
+                                     SinkContext& output)
 {
   if (!validate_view(view)) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "invalid image view for BMP"));
+        make_error(errc::encoding_failure, "invalid image view for QOI"));
   }
 
-  const auto expected_stride = row_bytes(view);
-  const std::uint8_t* data_ptr = view.pixels.data();
-  std::vector<std::uint8_t> owned;
-  if (view.stride != expected_stride) {
-    owned = make_contiguous_rgba(view);
-    data_ptr = owned.data();
+  const auto channels = output_channels(view, options);
+  std::array<std::uint8_t, kQoiHeaderBytes> header{'q', 'o', 'i', 'f'};
+  put_be32(header.data() + 4, view.width);
+  put_be32(header.data() + 8, view.height);
+  header[12] = static_cast<std::uint8_t>(channels);
+  header[13] = 0;  // sRGB with linear alpha
+  emit(output, header.data(), header.size());
+
+  constexpr std::uint8_t op_index = 0x00, op_diff = 0x40, op_luma = 0x80,
+                         op_run = 0xC0, op_rgb = 0xFE, op_rgba = 0xFF;
+  const bool keep_alpha = channels == kChannels;
+  std::array<std::array<std::uint8_t, 4>, 64> seen{};
+  std::array<std::uint8_t, 4> previous{0, 0, 0, 255};
+  std::vector<std::uint8_t> buffer(qoi_row_bound(view.width, channels));
+  note_allocation();
+  int run = 0;
+
+  for (std::uint32_t y = 0; y < view.height; ++y) {
+    const auto* row =
+        view.pixels.data() + static_cast<std::size_t>(y) * view.stride;
+    auto* out = buffer.data();
+    for (std::uint32_t x = 0; x < view.width; ++x) {
+      const auto* src = row + static_cast<std::size_t>(x) * kChannels;
+      const std::array<std::uint8_t, 4> pixel{
+          src[0], src[1], src[2], keep_alpha ? src[3] : std::uint8_t{255}};
+      if (pixel == previous) {
+        // Runs carry across rows; flush before they overflow 62.
+        if (++run == 62) {
+          *out++ = static_cast<std::uint8_t>(op_run | (run - 1));
+          run = 0;
+        }
+        continue;
+      }
+      if (run > 0) {
+        *out++ = static_cast<std::uint8_t>(op_run | (run - 1));
+        run = 0;
+      }
+
+      const auto hash =
+          (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+      if (seen[hash] == pixel) {
+        *out++ = static_cast<std::uint8_t>(op_index | hash);
+      }
+      else {
+        seen[hash] = pixel;
+        if (pixel[3] != previous[3]) {
+          *out++ = op_rgba;
+          std::memcpy(out, pixel.data(), 4);
+          out += 4;
+        }
+        else {
+          const auto dr = static_cast<std::int8_t>(pixel[0] - previous[0]);
+          const auto dg = static_cast<std::int8_t>(pixel[1] - previous[1]);
+          const auto db = static_cast<std::int8_t>(pixel[2] - previous[2]);
+          const auto dr_dg = static_cast<std::int8_t>(dr - dg);
+          const auto db_dg = static_cast<std::int8_t>(db - dg);
+          if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+            *out++ = static_cast<std::uint8_t>(op_diff | (dr + 2) << 4 |
+                                               (dg + 2) << 2 | (db + 2));
+          }
+          else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 &&
+                   db_dg > -9 && db_dg < 8) {
+            *out++ = static_cast<std::uint8_t>(op_luma | (dg + 32));
+            *out++ = static_cast<std::uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+          }
+          else {
+            *out++ = op_rgb;
+            std::memcpy(out, pixel.data(), 3);
+            out += 3;
+          }
+        }
+      }
+      previous = pixel;
+    }
+    emit(output, buffer.data(), static_cast<std::size_t>(out - buffer.data()));
   }
 
-  int channels = options.bit_depth == BitDepth::bpp24 ? 3 : 4;
-  std::vector<std::uint8_t> converted;
-  if (channels == 3) {
-    converted = drop_alpha(data_ptr, view.width, view.height, expected_stride);
-    data_ptr = converted.data();
+  if (run > 0) {
+    const auto last = static_cast<std::uint8_t>(op_run | (run - 1));
+    emit(output, &last, 1);
   }
+  emit(output, kQoiEnd.data(), kQoiEnd.size());
+  return {};
+}
 
-  std::vector<std::byte> output;
-  const int result =
-      stbi_write_bmp_to_func(write_bytes, &output, static_cast<int>(view.width),
-                             static_cast<int>(view.height), channels, data_ptr);
-  if (result == 0) {
+// Every RGBA encode lands here; only DDS can hold `levels`.
+std::expected<std::size_t, Error> encode_rgba_to(
+    const RgbaImageView& image,
+    std::span<const RgbaImageView> levels,
+    ImageFormat format,
+    const EncodeSink& sink,
+    EncoderOptions options)
+{
+  StageTimer timer(Stage::encode);
+  if (!image.valid()) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "invalid image view"));
+  }
+  if (!sink) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "encoder sink is empty"));
+  }
+  if (!levels.empty() && format != ImageFormat::dds) {
+    return std::unexpected(make_error(
+        errc::unsupported, "only DDS output can hold mip levels"));
+  }
+
+  SinkContext output{};
+  output.sink = &sink;
+  std::expected<void, Error> encoded;
+  switch (format) {
+    case ImageFormat::png:
+      encoded = encode_png(image, options, output);
+      break;
+    case ImageFormat::tga:
+      encoded = encode_tga(image, options, output);
+      break;
+    case ImageFormat::bmp:
+      encoded = encode_bmp(image, options, output);
+      break;
+    case ImageFormat::dds:
+      encoded = encode_dds(image, levels, options, output);
+      break;
+    case ImageFormat::qoi:
+      encoded = encode_qoi(image, options, output);
+      break;
+  }
+
+  if (!encoded) {
+    return std::unexpected(encoded.error());
+  }
+  if (output.failed) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "failed to encode BMP"));
+        make_error(errc::encoding_failure, "encoder sink rejected output"));
   }
-  return output;
+  auto pixels = static_cast<std::uint64_t>(image.width) * image.height;
+  for (const auto& level : levels) {
+    pixels += static_cast<std::uint64_t>(level.width) * level.height;
+  }
+  timer.add_pixels(pixels);
+  timer.add_bytes_in(pixels * kChannels);
+  timer.add_bytes_out(output.written);
+  return output.written;
 }
 
 }  // namespace
 
-std::expected<EncodedImage, Error> encode_image(const RgbaImageView& image,
-                                                ImageFormat format,
-                                                EncoderOptions options)
+std::size_t estimate_encoded_size(const RgbaImageView& image,
+                                  ImageFormat format,
+                                  EncoderOptions options) noexcept
 {
+  const auto raw = static_cast<std::size_t>(image.width) * image.height *
+                   output_channels(options);
+  switch (format) {
+    case ImageFormat::png:
+      // Filtered rows stored verbatim, as emit_png_image falls back to,
+      // plus the chunks around them.
+      return stored_zlib_size(raw + image.height) + 128;
+    case ImageFormat::tga:
+      // Each run packet saves at least the header of the literal packet it
+      // ends, so a row costs at most one header per 128 pixels over raw.
+      return 18 + raw +
+             static_cast<std::size_t>(image.height) * (image.width / 128 + 1);
+    case ImageFormat::bmp:
+      return 138 + raw + static_cast<std::size_t>(image.height) * 3;
+    case ImageFormat::dds:
+      return kDdsHeaderBytes +
+             dds_level_bytes(image.width, image.height, options.texture);
+    case ImageFormat::qoi:
+      return kQoiHeaderBytes +
+             qoi_row_bound(image.width, output_channels(options)) *
+                 image.height +
+             kQoiEnd.size();
+  }
+  return raw;
+}
+
+std::expected<std::size_t, Error> encode_image_to(const RgbaImageView& image,
+                                                  ImageFormat format,
+                                                  const EncodeSink& sink,
+                                                  EncoderOptions options)
+{
+  return encode_rgba_to(image, {}, format, sink, options);
+}
+
+std::expected<std::size_t, Error> encode_image_into(const RgbaImageView& image,
+                                                    ImageFormat format,
+                                                    std::span<std::byte> out,
+                                                    EncoderOptions options,
+                                                    std::size_t* required)
+{
+  const StageTimer timer(Stage::encode);
+  std::size_t used = 0;
+  bool overflow = false;
+  // Once a chunk does not fit, the rest is only counted, so the caller
+  // learns the size to retry with from this one pass.
+  const EncodeSink sink = [&](std::span<const std::byte> chunk) {
+    if (!overflow && chunk.size() <= out.size() - used) {
+      std::memcpy(out.data() + used, chunk.data(), chunk.size());
+    }
+    else {
+      overflow = true;
+    }
+    used += chunk.size();
+    return true;
+  };
+
+  auto written = encode_image_to(image, format, sink, options);
+  if (written && overflow) {
+    if (required != nullptr) {
+      *required = *written;
+    }
+    return std::unexpected(make_error(errc::buffer_too_small,
+                                      "output buffer too small for image"));
+  }
+  return written;
+}
+
+std::size_t estimate_encoded_size(const IndexedImageView& image,
+                                  ImageFormat format,
+                                  EncoderOptions options) noexcept
+{
+  const auto pixels = static_cast<std::size_t>(image.width) * image.height;
+  const auto colors = image.palette.size();
+  switch (format) {
+    case ImageFormat::png:
+      return stored_zlib_size(pixels + image.height) + colors * 4 + 128;
+    case ImageFormat::tga:
+      // As for RGBA: at worst one literal header per 128 indices of a row.
+      return 18 + colors * 4 + pixels +
+             (options.tga_rle ? static_cast<std::size_t>(image.height) *
+                                    (image.width / 128 + 1)
+                              : 0);
+    case ImageFormat::bmp:
+      return 54 + colors * 4 +
+             ((static_cast<std::size_t>(image.width) + 3) & ~std::size_t{3}) *
+                 image.height;
+    case ImageFormat::dds:
+    case ImageFormat::qoi:
+      break;
+  }
+  return pixels;
+}
+
+std::expected<std::size_t, Error> encode_indexed_image_to(
+    const IndexedImageView& image,
+    ImageFormat format,
+    const EncodeSink& sink,
+    EncoderOptions options)
+{
+  StageTimer timer(Stage::encode);
   if (!image.valid()) {
     return std::unexpected(
-        make_error(errc::encoding_failure, "invalid image view"));
+        make_error(errc::encoding_failure, "invalid indexed image view"));
+  }
+  if (!sink) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "encoder sink is empty"));
   }
 
-  std::expected<std::vector<std::byte>, Error> encoded;
+  SinkContext output{};
+  output.sink = &sink;
+  std::expected<void, Error> encoded;
   switch (format) {
     case ImageFormat::png:
-      encoded = encode_png(image, options);
+      encoded = encode_indexed_png(image, options, output);
       break;
     case ImageFormat::tga:
-      encoded = encode_tga(image, options);
+      encoded = encode_indexed_tga(image, options, output);
       break;
     case ImageFormat::bmp:
-      encoded = encode_bmp(image, options);
+      encoded = encode_indexed_bmp(image, output);
       break;
+    case ImageFormat::dds:
+      return std::unexpected(make_error(
+          errc::unsupported, "DDS output needs RGBA pixels, not indices"));
+    case ImageFormat::qoi:
+      return std::unexpected(make_error(
+          errc::unsupported, "QOI has no palette; encode RGBA pixels"));
   }
 
   if (!encoded) {
     return std::unexpected(encoded.error());
   }
+  if (output.failed) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "encoder sink rejected output"));
+  }
+  const auto pixels = static_cast<std::uint64_t>(image.width) * image.height;
+  timer.add_pixels(pixels);
+  timer.add_bytes_in(pixels);
+  timer.add_bytes_out(output.written);
+  return output.written;
+}
+
+std::expected<EncodedImage, Error> encode_indexed_image(
+    const IndexedImageView& image,
+    ImageFormat format,
+    EncoderOptions options)
+{
+  const StageTimer timer(Stage::encode);
+  if (!image.valid()) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "invalid indexed image view"));
+  }
 
   EncodedImage result{};
   result.format = format;
   result.width = image.width;
   result.height = image.height;
-  result.bytes = std::move(encoded.value());
+  result.bytes.reserve(estimate_encoded_size(image, format, options));
+  note_allocation();
+
+  const EncodeSink sink = [&result](std::span<const std::byte> chunk) {
+    result.bytes.insert(result.bytes.end(), chunk.begin(), chunk.end());
+    return true;
+  };
+  auto written = encode_indexed_image_to(image, format, sink, options);
+  if (!written) {
+    return std::unexpected(written.error());
+  }
+  return result;
+}
+
+std::expected<EncodedImage, Error> encode_image(const RgbaImageView& image,
+                                                ImageFormat format,
+                                                EncoderOptions options)
+{
+  const StageTimer timer(Stage::encode);
+  if (!image.valid()) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "invalid image view"));
+  }
+
+  EncodedImage result{};
+  result.format = format;
+  result.width = image.width;
+  result.height = image.height;
+  result.bytes.reserve(estimate_encoded_size(image, format, options));
+  note_allocation();
+
+  const EncodeSink sink = [&result](std::span<const std::byte> chunk) {
+    result.bytes.insert(result.bytes.end(), chunk.begin(), chunk.end());
+    return true;
+  };
+  auto written = encode_image_to(image, format, sink, options);
+  if (!written) {
+    return std::unexpected(written.error());
+  }
+  return result;
+}
+
+std::expected<EncodedImage, Error> encode_image_levels(
+    const RgbaImageView& image,
+    std::span<const RgbaImageView> levels,
+    ImageFormat format,
+    EncoderOptions options)
+{
+  const StageTimer timer(Stage::encode);
+  if (!image.valid()) {
+    return std::unexpected(
+        make_error(errc::encoding_failure, "invalid image view"));
+  }
+
+  EncodedImage result{};
+  result.format = format;
+  result.width = image.width;
+  result.height = image.height;
+  auto reserve = estimate_encoded_size(image, format, options);
+  for (const auto& level : levels) {
+    reserve += estimate_encoded_size(level, format, options);
+  }
+  result.bytes.reserve(reserve);
+  note_allocation();
+
+  const EncodeSink sink = [&result](std::span<const std::byte> chunk) {
+    result.bytes.insert(result.bytes.end(), chunk.begin(), chunk.end());
+    return true;
+  };
+  auto written = encode_rgba_to(image, levels, format, sink, options);
+  if (!written) {
+    return std::unexpected(written.error());
+  }
   return result;
 }
 
@@ -30,6 +30,8 @@ std::string error_category::message(int ev) const
       return "No animation data found in ART file";
     case errc::animation_format:
       return "Invalid animation format";
+    case errc::buffer_too_small:
+      return "Output buffer is too small";
     default:
       return "Unknown error";
   }
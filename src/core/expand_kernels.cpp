@@ -0,0 +1,225 @@
+#include "expand_kernels.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include <art2img/core/convert.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define ART2IMG_EXPAND_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ART2IMG_TARGET_AVX2
+#else
+#define ART2IMG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define ART2IMG_EXPAND_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace art2img::core {
+namespace {
+
+constexpr std::size_t kChannels = 4;
+
+void expand_scalar(const std::uint8_t* indices,
+                   std::size_t count,
+                   const std::uint32_t* colors,
+                   std::uint8_t* out) noexcept
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    std::memcpy(out + i * kChannels, &colors[indices[i]], kChannels);
+  }
+}
+
+#if defined(ART2IMG_EXPAND_X86)
+
+// Widens 16 indices at a time to 32-bit lanes and gathers their colours.
+ART2IMG_TARGET_AVX2 void expand_avx2(const std::uint8_t* indices,
+                                     std::size_t count,
+                                     const std::uint32_t* colors,
+                                     std::uint8_t* out) noexcept
+{
+  const auto* table = reinterpret_cast<const int*>(colors);
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+    const __m256i lo = _mm256_cvtepu8_epi32(bytes);
+    const __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * kChannels),
+                        _mm256_i32gather_epi32(table, lo, 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (i + 8) * kChannels),
+                        _mm256_i32gather_epi32(table, hi, 4));
+  }
+  expand_scalar(indices + i, count - i, colors, out + i * kChannels);
+}
+
+bool cpu_has_avx2() noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4] = {};
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+#if defined(ART2IMG_EXPAND_NEON)
+
+uint8x16x4_t load_quarter(const std::uint8_t* plane) noexcept
+{
+  return uint8x16x4_t{{vld1q_u8(plane), vld1q_u8(plane + 16),
+                       vld1q_u8(plane + 32), vld1q_u8(plane + 48)}};
+}
+
+// Splits the table into one 256-byte plane per channel, then resolves 16
+// indices per channel with four 64-byte table lookups and interleaves the
+// channels back on store.
+void expand_neon(const std::uint8_t* indices,
+                 std::size_t count,
+                 const std::uint32_t* colors,
+                 std::uint8_t* out) noexcept
+{
+  const auto* packed = reinterpret_cast<const std::uint8_t*>(colors);
+  alignas(16) std::uint8_t planes[kChannels][256];
+  for (std::size_t i = 0; i < 256; i += 16) {
+    const uint8x16x4_t split = vld4q_u8(packed + i * kChannels);
+    vst1q_u8(planes[0] + i, split.val[0]);
+    vst1q_u8(planes[1] + i, split.val[1]);
+    vst1q_u8(planes[2] + i, split.val[2]);
+    vst1q_u8(planes[3] + i, split.val[3]);
+  }
+
+  const uint8x16_t step = vdupq_n_u8(64);
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const uint8x16_t idx0 = vld1q_u8(indices + i);
+    const uint8x16_t idx1 = vsubq_u8(idx0, step);
+    const uint8x16_t idx2 = vsubq_u8(idx1, step);
+    const uint8x16_t idx3 = vsubq_u8(idx2, step);
+
+    uint8x16x4_t result;
+    for (std::size_t c = 0; c < kChannels; ++c) {
+      uint8x16_t value = vqtbl4q_u8(load_quarter(planes[c]), idx0);
+      value = vqtbx4q_u8(value, load_quarter(planes[c] + 64), idx1);
+      value = vqtbx4q_u8(value, load_quarter(planes[c] + 128), idx2);
+      value = vqtbx4q_u8(value, load_quarter(planes[c] + 192), idx3);
+      result.val[c] = value;
+    }
+    vst4q_u8(out + i * kChannels, result);
+  }
+  expand_scalar(indices + i, count - i, colors, out + i * kChannels);
+}
+
+#endif
+
+ExpandKernel best_supported_kernel() noexcept
+{
+#if defined(ART2IMG_EXPAND_X86)
+  if (cpu_has_avx2()) {
+    return ExpandKernel::avx2;
+  }
+#endif
+#if defined(ART2IMG_EXPAND_NEON)
+  return ExpandKernel::neon;
+#else
+  return ExpandKernel::scalar;
+#endif
+}
+
+bool kernel_supported(ExpandKernel kernel) noexcept
+{
+  switch (kernel) {
+    case ExpandKernel::scalar:
+      return true;
+    case ExpandKernel::avx2:
+#if defined(ART2IMG_EXPAND_X86)
+      return cpu_has_avx2();
+#else
+      return false;
+#endif
+    case ExpandKernel::neon:
+#if defined(ART2IMG_EXPAND_NEON)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+std::atomic<ExpandKernel>& selected_kernel() noexcept
+{
+  static std::atomic<ExpandKernel> kernel{best_supported_kernel()};
+  return kernel;
+}
+
+}  // namespace
+
+ExpandKernel active_expand_kernel() noexcept
+{
+  return selected_kernel().load(std::memory_order_relaxed);
+}
+
+bool select_expand_kernel(ExpandKernel kernel) noexcept
+{
+  if (!kernel_supported(kernel)) {
+    return false;
+  }
+  selected_kernel().store(kernel, std::memory_order_relaxed);
+  return true;
+}
+
+void reset_expand_kernel() noexcept
+{
+  selected_kernel().store(best_supported_kernel(), std::memory_order_relaxed);
+}
+
+namespace detail {
+
+ExpandFn expand_kernel() noexcept
+{
+  switch (active_expand_kernel()) {
+    case ExpandKernel::avx2:
+#if defined(ART2IMG_EXPAND_X86)
+      return expand_avx2;
+#else
+      break;
+#endif
+    case ExpandKernel::neon:
+#if defined(ART2IMG_EXPAND_NEON)
+      return expand_neon;
+#else
+      break;
+#endif
+    case ExpandKernel::scalar:
+      break;
+  }
+  return expand_scalar;
+}
+
+}  // namespace detail
+
+}  // namespace art2img::core
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace art2img::core::detail {
+
+/// Writes `count` packed RGBA pixels to `out`, one per index in `indices`,
+/// by looking each index up in the 256-entry `colors` table.
+using ExpandFn = void (*)(const std::uint8_t* indices,
+                          std::size_t count,
+                          const std::uint32_t* colors,
+                          std::uint8_t* out) noexcept;
+
+/// Kernel for the currently selected ExpandKernel.
+ExpandFn expand_kernel() noexcept;
+
+}  // namespace art2img::core::detail
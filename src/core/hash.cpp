@@ -0,0 +1,187 @@
+#include <art2img/core/hash.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace art2img::core {
+
+namespace {
+
+constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+// Bumped whenever the encoders change their output for the same input, so
+// cached fingerprints from older builds stop matching.
+constexpr std::uint64_t kEncoderRevision = 3;
+
+std::uint64_t read64(const std::byte* data) noexcept
+{
+  std::uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | static_cast<std::uint8_t>(data[i]);
+  }
+  return value;
+}
+
+std::uint32_t read32(const std::byte* data) noexcept
+{
+  std::uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = (value << 8) | static_cast<std::uint8_t>(data[i]);
+  }
+  return value;
+}
+
+std::uint64_t mix_lane(std::uint64_t lane, std::uint64_t input) noexcept
+{
+  lane += input * kPrime2;
+  return std::rotl(lane, 31) * kPrime1;
+}
+
+std::uint64_t merge(std::uint64_t hash, std::uint64_t lane) noexcept
+{
+  hash ^= mix_lane(0, lane);
+  return hash * kPrime1 + kPrime4;
+}
+
+}  // namespace
+
+Xxh64::Xxh64(std::uint64_t seed) noexcept
+    : lanes_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1},
+      seed_(seed)
+{
+}
+
+void Xxh64::update(std::span<const std::byte> data) noexcept
+{
+  length_ += data.size();
+  if (buffered_ + data.size() < buffer_.size()) {
+    std::copy(data.begin(), data.end(), buffer_.begin() + buffered_);
+    buffered_ += data.size();
+    return;
+  }
+
+  const auto stripe = [this](const std::byte* p) {
+    for (std::size_t lane = 0; lane < 4; ++lane) {
+      lanes_[lane] = mix_lane(lanes_[lane], read64(p + lane * 8));
+    }
+  };
+
+  if (buffered_ > 0) {
+    const auto fill = buffer_.size() - buffered_;
+    std::copy_n(data.begin(), fill, buffer_.begin() + buffered_);
+    stripe(buffer_.data());
+    data = data.subspan(fill);
+    buffered_ = 0;
+  }
+  while (data.size() >= buffer_.size()) {
+    stripe(data.data());
+    data = data.subspan(buffer_.size());
+  }
+  std::copy(data.begin(), data.end(), buffer_.begin());
+  buffered_ = data.size();
+}
+
+void Xxh64::update(std::uint64_t value) noexcept
+{
+  std::array<std::byte, 8> bytes{};
+  for (auto& byte : bytes) {
+    byte = static_cast<std::byte>(value & 0xFF);
+    value >>= 8;
+  }
+  update(bytes);
+}
+
+std::uint64_t Xxh64::digest() const noexcept
+{
+  std::uint64_t hash = 0;
+  if (length_ >= buffer_.size()) {
+    hash = std::rotl(lanes_[0], 1) + std::rotl(lanes_[1], 7) +
+           std::rotl(lanes_[2], 12) + std::rotl(lanes_[3], 18);
+    for (const auto lane : lanes_) {
+      hash = merge(hash, lane);
+    }
+  }
+  else {
+    hash = seed_ + kPrime5;
+  }
+  hash += length_;
+
+  const std::byte* p = buffer_.data();
+  const std::byte* end = p + buffered_;
+  for (; p + 8 <= end; p += 8) {
+    hash ^= mix_lane(0, read64(p));
+    hash = std::rotl(hash, 27) * kPrime1 + kPrime4;
+  }
+  if (p + 4 <= end) {
+    hash ^= static_cast<std::uint64_t>(read32(p)) * kPrime1;
+    hash = std::rotl(hash, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= static_cast<std::uint8_t>(*p) * kPrime5;
+    hash = std::rotl(hash, 11) * kPrime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+std::uint64_t xxh64(std::span<const std::byte> data,
+                    std::uint64_t seed) noexcept
+{
+  Xxh64 hasher(seed);
+  hasher.update(data);
+  return hasher.digest();
+}
+
+std::uint64_t settings_fingerprint(const PreparedPalette& palette,
+                                   ImageFormat format,
+                                   EncoderOptions encoder,
+                                   std::uint64_t seed) noexcept
+{
+  Xxh64 hasher(seed);
+  hasher.update(kEncoderRevision);
+  hasher.update(std::as_bytes(std::span{palette.colors}));
+
+  // Field by field, so padding never leaks into the hash.
+  const auto& options = palette.options;
+  hasher.update(static_cast<std::uint64_t>(options.apply_lookup) |
+                static_cast<std::uint64_t>(options.fix_transparency) << 1 |
+                static_cast<std::uint64_t>(options.premultiply_alpha) << 2 |
+                static_cast<std::uint64_t>(options.matte_hygiene) << 3 |
+                static_cast<std::uint64_t>(options.shade_index.has_value())
+                    << 4 |
+                static_cast<std::uint64_t>(options.shade_index.value_or(0))
+                    << 8);
+  hasher.update(static_cast<std::uint64_t>(format) |
+                static_cast<std::uint64_t>(encoder.compression) << 8 |
+                static_cast<std::uint64_t>(encoder.bit_depth) << 16 |
+                static_cast<std::uint64_t>(encoder.tga_rle) << 24 |
+                static_cast<std::uint64_t>(encoder.texture) << 32);
+  return hasher.digest();
+}
+
+std::uint64_t tile_fingerprint(const TileView& tile,
+                               std::uint64_t settings) noexcept
+{
+  const auto count = static_cast<std::size_t>(tile.width) * tile.height;
+  Xxh64 hasher(settings);
+  hasher.update(static_cast<std::uint64_t>(tile.width) << 32 | tile.height);
+  hasher.update(tile.indices.first(std::min(count, tile.indices.size())));
+  hasher.update(static_cast<std::uint64_t>(tile.lookup.size()));
+  hasher.update(tile.lookup);
+  return hasher.digest();
+}
+
+}  // namespace art2img::core
@@ -0,0 +1,207 @@
+#include <art2img/core/mipmap.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <utility>
+#include <vector>
+
+#include <art2img/core/stats.hpp>
+
+namespace art2img::core {
+
+namespace {
+
+// The source samples behind each output sample along one axis, weighted by
+// how much of the output footprint they cover. Output `i` reads sources
+// first[i], first[i] + 1, ... with weights[offset[i]] to weights[offset[i+1]],
+// which sum to 1.
+struct AxisTaps {
+  std::vector<std::uint32_t> first;
+  std::vector<std::size_t> offset;
+  std::vector<float> weights;
+};
+
+AxisTaps axis_taps(std::uint32_t source, std::uint32_t target)
+{
+  AxisTaps taps;
+  taps.first.resize(target);
+  taps.offset.resize(target + 1);
+  const double scale = static_cast<double>(source) / target;
+  for (std::uint32_t i = 0; i < target; ++i) {
+    const double begin = i * scale;
+    const double end = (i + 1) * scale;
+    auto j = static_cast<std::uint32_t>(begin);
+    taps.first[i] = j;
+    taps.offset[i] = taps.weights.size();
+    for (; j < source && j < end; ++j) {
+      const double covered =
+          std::min(end, j + 1.0) - std::max(begin, static_cast<double>(j));
+      taps.weights.push_back(static_cast<float>(covered / scale));
+    }
+  }
+  taps.offset[target] = taps.weights.size();
+  return taps;
+}
+
+std::uint8_t to_channel(float value)
+{
+  return static_cast<std::uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+}
+
+RgbaImage copy_image(const RgbaImageView& image)
+{
+  RgbaImage copy{image.width, image.height, {}};
+  const std::size_t row_bytes = static_cast<std::size_t>(image.width) * 4;
+  copy.pixels.resize(row_bytes * image.height);
+  note_allocation();
+  for (std::uint32_t y = 0; y < image.height; ++y) {
+    const auto* row =
+        image.pixels.data() + static_cast<std::size_t>(y) * image.stride;
+    std::memcpy(copy.pixels.data() + y * row_bytes, row, row_bytes);
+  }
+  return copy;
+}
+
+}  // namespace
+
+std::expected<RgbaImage, Error> resize_rgba(const RgbaImageView& image,
+                                            std::uint32_t width,
+                                            std::uint32_t height,
+                                            bool premultiplied)
+{
+  if (!image.valid() || width == 0 || height == 0) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid image for resizing"));
+  }
+
+  const auto columns = axis_taps(image.width, width);
+  const auto rows = axis_taps(image.height, height);
+  const std::size_t out_row = static_cast<std::size_t>(width) * 4;
+
+  // Horizontal pass over every source row into floats. Straight colour is
+  // weighted by alpha here, so transparent pixels drop out of the average.
+  std::vector<float> wide(out_row * image.height);
+  note_allocation();
+  for (std::uint32_t y = 0; y < image.height; ++y) {
+    const auto* source =
+        image.pixels.data() + static_cast<std::size_t>(y) * image.stride;
+    float* out = wide.data() + y * out_row;
+    for (std::uint32_t x = 0; x < width; ++x) {
+      float r = 0, g = 0, b = 0, a = 0;
+      const auto* pixel =
+          source + static_cast<std::size_t>(columns.first[x]) * 4;
+      for (auto k = columns.offset[x]; k < columns.offset[x + 1];
+           ++k, pixel += 4) {
+        const float weight = columns.weights[k];
+        const float colour_weight =
+            premultiplied ? weight : weight * pixel[3] / 255.0f;
+        r += pixel[0] * colour_weight;
+        g += pixel[1] * colour_weight;
+        b += pixel[2] * colour_weight;
+        a += pixel[3] * weight;
+      }
+      out[x * 4 + 0] = r;
+      out[x * 4 + 1] = g;
+      out[x * 4 + 2] = b;
+      out[x * 4 + 3] = a;
+    }
+  }
+
+  // Vertical pass, one output row at a time: whole rows are accumulated so
+  // the inner loop runs along contiguous memory.
+  RgbaImage result{width, height, {}};
+  result.pixels.resize(out_row * height);
+  note_allocation();
+  std::vector<float> line(out_row);
+  for (std::uint32_t y = 0; y < height; ++y) {
+    std::fill(line.begin(), line.end(), 0.0f);
+    for (auto k = rows.offset[y]; k < rows.offset[y + 1]; ++k) {
+      const float weight = rows.weights[k];
+      const auto source_row = rows.first[y] + (k - rows.offset[y]);
+      const float* in = wide.data() + source_row * out_row;
+      for (std::size_t i = 0; i < out_row; ++i) {
+        line[i] += in[i] * weight;
+      }
+    }
+
+    auto* out = result.pixels.data() + y * out_row;
+    for (std::size_t i = 0; i < out_row; i += 4) {
+      const auto alpha = to_channel(line[i + 3]);
+      out[i + 3] = alpha;
+      if (premultiplied) {
+        out[i + 0] = to_channel(line[i + 0]);
+        out[i + 1] = to_channel(line[i + 1]);
+        out[i + 2] = to_channel(line[i + 2]);
+      }
+      else if (alpha == 0) {
+        out[i + 0] = out[i + 1] = out[i + 2] = 0;
+      }
+      else {
+        // The colour sums are premultiplied; divide the coverage back out.
+        const float unpremultiply = 255.0f / line[i + 3];
+        out[i + 0] = to_channel(line[i + 0] * unpremultiply);
+        out[i + 1] = to_channel(line[i + 1] * unpremultiply);
+        out[i + 2] = to_channel(line[i + 2] * unpremultiply);
+      }
+    }
+  }
+  return result;
+}
+
+std::expected<std::vector<RgbaImage>, Error> build_mip_chain(
+    const RgbaImageView& base,
+    std::uint32_t levels,
+    bool premultiplied)
+{
+  if (!base.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid image for mipmaps"));
+  }
+
+  std::vector<RgbaImage> chain;
+  const auto possible = static_cast<std::uint32_t>(
+      std::bit_width(std::max(base.width, base.height)) - 1);
+  chain.reserve(std::min(levels, possible));
+  RgbaImageView previous = base;
+  while (chain.size() < levels &&
+         (previous.width > 1 || previous.height > 1)) {
+    auto level = resize_rgba(previous, std::max(1u, previous.width / 2),
+                             std::max(1u, previous.height / 2), premultiplied);
+    if (!level) {
+      return std::unexpected(level.error());
+    }
+    chain.push_back(std::move(*level));
+    previous = make_view(chain.back());
+  }
+  return chain;
+}
+
+std::expected<RgbaImage, Error> make_thumbnail(const RgbaImageView& image,
+                                               std::uint32_t max_size,
+                                               bool premultiplied)
+{
+  if (!image.valid() || max_size == 0) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid image for thumbnail"));
+  }
+  if (image.width <= max_size && image.height <= max_size) {
+    return copy_image(image);
+  }
+
+  const double scale = std::min(static_cast<double>(max_size) / image.width,
+                                static_cast<double>(max_size) / image.height);
+  const auto fit = [&](std::uint32_t extent) {
+    const auto scaled =
+        static_cast<std::uint32_t>(std::lround(extent * scale));
+    return std::clamp(scaled, 1u, max_size);
+  };
+  return resize_rgba(image, fit(image.width), fit(image.height),
+                     premultiplied);
+}
+
+}  // namespace art2img::core
@@ -57,6 +57,45 @@ std::expected<Palette, Error> load_palette(
   return palette;
 }
 
+std::expected<PaletteView, Error> load_palette_view(
+    std::span<const std::byte> blob) noexcept
+{
+  if (blob.size() < kPaletteBytes + kShadeCountBytes) {
+    return std::unexpected(
+        make_error(errc::invalid_palette, "palette data too small"));
+  }
+
+  const auto bytes = std::span{
+      reinterpret_cast<const std::uint8_t*>(blob.data()), blob.size()};
+  PaletteView view{};
+  view.rgb = bytes.first(kPaletteBytes);
+
+  std::size_t offset = kPaletteBytes;
+  std::memcpy(&view.shade_table_count, blob.data() + offset,
+              sizeof(view.shade_table_count));
+  offset += kShadeCountBytes;
+
+  if (view.shade_table_count > palette_color_count) {
+    return std::unexpected(
+        make_error(errc::invalid_palette, "invalid shade table count"));
+  }
+
+  const std::size_t shade_bytes =
+      static_cast<std::size_t>(view.shade_table_count) * shade_table_size;
+  if (blob.size() < offset + shade_bytes) {
+    return std::unexpected(
+        make_error(errc::invalid_palette, "palette missing shade data"));
+  }
+  view.shade_tables = bytes.subspan(offset, shade_bytes);
+  offset += shade_bytes;
+
+  if (blob.size() >= offset + translucent_table_size) {
+    view.translucent = bytes.subspan(offset, translucent_table_size);
+  }
+
+  return view;
+}
+
 PaletteView view_palette(const Palette& palette) noexcept
 {
   PaletteView view{};
@@ -0,0 +1,232 @@
+#include <art2img/core/quantize.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <art2img/core/stats.hpp>
+
+namespace art2img::core {
+namespace {
+
+constexpr std::size_t kChannels = 4;
+constexpr std::size_t kCellLevels = 256 / quantize_grid_size;
+constexpr std::size_t kCellCount =
+    quantize_grid_size * quantize_grid_size * quantize_grid_size;
+constexpr std::size_t kOpaqueColors = palette_color_count - 1;
+constexpr std::uint8_t kTransparentIndex = 255;
+constexpr std::uint32_t kMaxTileDimension = 4096;
+
+std::uint8_t expand_component(std::uint8_t value) noexcept
+{
+  return static_cast<std::uint8_t>((value << 2) | (value >> 4));
+}
+
+std::uint32_t cell_of(std::uint8_t r, std::uint8_t g, std::uint8_t b) noexcept
+{
+  constexpr unsigned shift = 3;  // log2(kCellLevels)
+  return static_cast<std::uint32_t>(r >> shift) * quantize_grid_size *
+             quantize_grid_size +
+         static_cast<std::uint32_t>(g >> shift) * quantize_grid_size +
+         static_cast<std::uint32_t>(b >> shift);
+}
+
+int squared_distance(const std::uint8_t* color,
+                     std::uint8_t r,
+                     std::uint8_t g,
+                     std::uint8_t b) noexcept
+{
+  const int dr = color[0] - r;
+  const int dg = color[1] - g;
+  const int db = color[2] - b;
+  return dr * dr + dg * dg + db * db;
+}
+
+// Per channel, the nearest and farthest squared distance from each palette
+// component to each span of kCellLevels values, so a cell's bounds are
+// three table reads per colour instead of a corner search.
+struct AxisBounds {
+  std::array<std::array<std::uint32_t, kOpaqueColors>, quantize_grid_size>
+      near{};
+  std::array<std::array<std::uint32_t, kOpaqueColors>, quantize_grid_size>
+      far{};
+};
+
+void axis_bounds(const std::uint8_t* rgb,
+                 std::size_t channel,
+                 AxisBounds& bounds) noexcept
+{
+  for (std::size_t cell = 0; cell < quantize_grid_size; ++cell) {
+    const auto low = static_cast<int>(cell * kCellLevels);
+    const auto high = low + static_cast<int>(kCellLevels) - 1;
+    for (std::size_t c = 0; c < kOpaqueColors; ++c) {
+      const int value = rgb[c * 3 + channel];
+      const int inside = std::clamp(value, low, high);
+      const int outside = value - low > high - value ? low : high;
+      bounds.near[cell][c] =
+          static_cast<std::uint32_t>((value - inside) * (value - inside));
+      bounds.far[cell][c] =
+          static_cast<std::uint32_t>((value - outside) * (value - outside));
+    }
+  }
+}
+
+}  // namespace
+
+std::expected<QuantizeTable, Error> prepare_quantize_table(PaletteView palette)
+{
+  if (palette.rgb.size() < palette_component_count) {
+    return std::unexpected(
+        make_error(errc::invalid_palette, "palette has fewer than 256 colours"));
+  }
+
+  QuantizeTable table{};
+  for (std::size_t i = 0; i < palette_component_count; ++i) {
+    table.rgb[i] = expand_component(palette.rgb[i]);
+  }
+
+  // About 200 KiB, too much for a worker thread's stack.
+  std::vector<AxisBounds> axes(3);
+  for (std::size_t channel = 0; channel < 3; ++channel) {
+    axis_bounds(table.rgb.data(), channel, axes[channel]);
+  }
+
+  // A colour can only be nearest to some point of the cell if its nearest
+  // distance to the cell is within the smallest farthest distance of any
+  // colour; everything else is pruned.
+  table.cell_offsets.resize(kCellCount + 1);
+  table.candidates.reserve(kCellCount * 4);
+  note_allocation(3);
+  std::array<std::uint32_t, kOpaqueColors> near{};
+  for (std::size_t r = 0; r < quantize_grid_size; ++r) {
+    for (std::size_t g = 0; g < quantize_grid_size; ++g) {
+      for (std::size_t b = 0; b < quantize_grid_size; ++b) {
+        auto bound = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t c = 0; c < kOpaqueColors; ++c) {
+          near[c] = axes[0].near[r][c] + axes[1].near[g][c] +
+                    axes[2].near[b][c];
+          bound = std::min(bound, axes[0].far[r][c] + axes[1].far[g][c] +
+                                      axes[2].far[b][c]);
+        }
+        const auto cell =
+            (r * quantize_grid_size + g) * quantize_grid_size + b;
+        table.cell_offsets[cell] =
+            static_cast<std::uint32_t>(table.candidates.size());
+        for (std::size_t c = 0; c < kOpaqueColors; ++c) {
+          if (near[c] <= bound) {
+            table.candidates.push_back(static_cast<std::uint8_t>(c));
+          }
+        }
+      }
+    }
+  }
+  table.cell_offsets[kCellCount] =
+      static_cast<std::uint32_t>(table.candidates.size());
+  return table;
+}
+
+std::uint8_t nearest_index(const QuantizeTable& table,
+                           std::uint8_t r,
+                           std::uint8_t g,
+                           std::uint8_t b) noexcept
+{
+  const auto cell = cell_of(r, g, b);
+  const auto* candidate = table.candidates.data() + table.cell_offsets[cell];
+  const auto* end = table.candidates.data() + table.cell_offsets[cell + 1];
+  auto best = *candidate;
+  int best_distance =
+      squared_distance(table.rgb.data() + best * 3, r, g, b);
+  for (++candidate; candidate != end && best_distance != 0; ++candidate) {
+    const int distance =
+        squared_distance(table.rgb.data() + *candidate * 3, r, g, b);
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = *candidate;
+    }
+  }
+  return best;
+}
+
+std::expected<void, Error> rgba_to_indices_into(const RgbaImageView& image,
+                                                const QuantizeTable& table,
+                                                std::span<std::byte> out,
+                                                QuantizeOptions options)
+{
+  StageTimer timer(Stage::convert);
+  if (!image.valid()) {
+    return std::unexpected(
+        make_error(errc::conversion_failure, "invalid image view"));
+  }
+  if (table.cell_offsets.size() != kCellCount + 1) {
+    return std::unexpected(make_error(errc::conversion_failure,
+                                      "quantize table is not prepared"));
+  }
+  const auto pixels = static_cast<std::size_t>(image.width) * image.height;
+  if (out.size() < pixels) {
+    return std::unexpected(make_error(errc::conversion_failure,
+                                      "output buffer too small for tile"));
+  }
+
+  // Quantised a row at a time, then scattered down the columns. Texture
+  // rows are mostly runs of one colour, so the last pixel's answer is kept
+  // and repeated without a search.
+  std::array<std::uint8_t, kChannels> last{};
+  std::uint8_t last_index = kTransparentIndex;
+  bool have_last = false;
+  for (std::uint32_t y = 0; y < image.height; ++y) {
+    const auto* row =
+        image.pixels.data() + static_cast<std::size_t>(y) * image.stride;
+    auto* column = out.data() + y;
+    for (std::uint32_t x = 0; x < image.width; ++x) {
+      const auto* pixel = row + static_cast<std::size_t>(x) * kChannels;
+      std::uint8_t index = kTransparentIndex;
+      if (pixel[3] >= options.alpha_threshold) {
+        if (have_last && pixel[0] == last[0] && pixel[1] == last[1] &&
+            pixel[2] == last[2]) {
+          index = last_index;
+        }
+        else {
+          index = nearest_index(table, pixel[0], pixel[1], pixel[2]);
+          last = {pixel[0], pixel[1], pixel[2], 0};
+          last_index = index;
+          have_last = true;
+        }
+      }
+      column[static_cast<std::size_t>(x) * image.height] =
+          static_cast<std::byte>(index);
+    }
+  }
+
+  timer.add_pixels(pixels);
+  timer.add_bytes_in(pixels * kChannels);
+  timer.add_bytes_out(pixels);
+  return {};
+}
+
+std::expected<ArtTileData, Error> rgba_to_tile(const RgbaImageView& image,
+                                               const QuantizeTable& table,
+                                               QuantizeOptions options)
+{
+  if (image.width > kMaxTileDimension || image.height > kMaxTileDimension) {
+    return std::unexpected(make_error(
+        errc::conversion_failure, "image too large for an ART tile"));
+  }
+
+  ArtTileData tile{};
+  tile.metrics.width = static_cast<std::uint16_t>(image.width);
+  tile.metrics.height = static_cast<std::uint16_t>(image.height);
+  tile.indices.resize(static_cast<std::size_t>(image.width) * image.height);
+  note_allocation();
+  auto converted = rgba_to_indices_into(image, table, tile.indices, options);
+  if (!converted) {
+    return std::unexpected(converted.error());
+  }
+  return tile;
+}
+
+}  // namespace art2img::core
@@ -0,0 +1,116 @@
+#include <art2img/core/stats.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace art2img::core {
+
+namespace {
+
+// The outermost record of each stage being timed on this thread, and the
+// allocations noted so far; timers take the difference across their scope.
+thread_local std::array<StageRecord*, stage_count> timed_stages{};
+thread_local std::uint64_t allocation_count = 0;
+thread_local std::uint64_t current_tag = no_stage_tag;
+
+std::uint64_t now_ns() noexcept
+{
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+}  // namespace
+
+void StatsCollector::record(const StageRecord& record) noexcept
+{
+  auto& counters = counters_[static_cast<std::size_t>(record.stage)];
+  counters.calls.fetch_add(1, std::memory_order_relaxed);
+  counters.nanoseconds.fetch_add(record.duration_ns, std::memory_order_relaxed);
+  counters.pixels.fetch_add(record.pixels, std::memory_order_relaxed);
+  counters.bytes_in.fetch_add(record.bytes_in, std::memory_order_relaxed);
+  counters.bytes_out.fetch_add(record.bytes_out, std::memory_order_relaxed);
+  counters.allocations.fetch_add(record.allocations,
+                                 std::memory_order_relaxed);
+}
+
+std::array<StageTotals, stage_count> StatsCollector::totals() const noexcept
+{
+  std::array<StageTotals, stage_count> totals{};
+  for (std::size_t i = 0; i < stage_count; ++i) {
+    const auto& counters = counters_[i];
+    totals[i].calls = counters.calls.load(std::memory_order_relaxed);
+    totals[i].nanoseconds =
+        counters.nanoseconds.load(std::memory_order_relaxed);
+    totals[i].pixels = counters.pixels.load(std::memory_order_relaxed);
+    totals[i].bytes_in = counters.bytes_in.load(std::memory_order_relaxed);
+    totals[i].bytes_out = counters.bytes_out.load(std::memory_order_relaxed);
+    totals[i].allocations =
+        counters.allocations.load(std::memory_order_relaxed);
+  }
+  return totals;
+}
+
+void StatsCollector::reset() noexcept
+{
+  for (auto& counters : counters_) {
+    counters.calls.store(0, std::memory_order_relaxed);
+    counters.nanoseconds.store(0, std::memory_order_relaxed);
+    counters.pixels.store(0, std::memory_order_relaxed);
+    counters.bytes_in.store(0, std::memory_order_relaxed);
+    counters.bytes_out.store(0, std::memory_order_relaxed);
+    counters.allocations.store(0, std::memory_order_relaxed);
+  }
+}
+
+StageTimer::StageTimer(Stage stage) noexcept : sink_(stats_sink())
+{
+  if (sink_ == nullptr) {
+    return;
+  }
+  auto& outer = timed_stages[static_cast<std::size_t>(stage)];
+  if (outer != nullptr) {
+    sink_ = nullptr;
+    target_ = outer;
+    return;
+  }
+  outer = &record_;
+  target_ = &record_;
+  record_.stage = stage;
+  record_.tag = current_tag;
+  allocations_before_ = allocation_count;
+  record_.start_ns = now_ns();
+}
+
+StageTimer::~StageTimer()
+{
+  if (sink_ == nullptr) {
+    return;
+  }
+  record_.duration_ns = now_ns() - record_.start_ns;
+  record_.allocations = allocation_count - allocations_before_;
+  timed_stages[static_cast<std::size_t>(record_.stage)] = nullptr;
+  sink_->record(record_);
+}
+
+ScopedStageTag::ScopedStageTag(std::uint64_t tag) noexcept
+    : previous_(current_tag)
+{
+  current_tag = tag;
+}
+
+ScopedStageTag::~ScopedStageTag()
+{
+  current_tag = previous_;
+}
+
+void note_allocation(std::uint64_t count) noexcept
+{
+  allocation_count += count;
+}
+
+}  // namespace art2img::core
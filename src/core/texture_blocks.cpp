@@ -0,0 +1,184 @@
+#include "texture_blocks.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+namespace art2img::core::detail {
+
+namespace {
+
+constexpr int kBlockPixels = 16;
+
+using Rgb = std::array<int, 3>;
+
+std::uint16_t pack_565(const Rgb& rgb) noexcept
+{
+  const auto r = static_cast<unsigned>((rgb[0] * 31 + 127) / 255);
+  const auto g = static_cast<unsigned>((rgb[1] * 63 + 127) / 255);
+  const auto b = static_cast<unsigned>((rgb[2] * 31 + 127) / 255);
+  return static_cast<std::uint16_t>(r << 11 | g << 5 | b);
+}
+
+// The colour a decoder reconstructs for a 565 endpoint.
+Rgb unpack_565(std::uint16_t packed) noexcept
+{
+  const int r = packed >> 11;
+  const int g = (packed >> 5) & 0x3F;
+  const int b = packed & 0x1F;
+  return {r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2};
+}
+
+int distance(const Rgb& color, const std::uint8_t* pixel) noexcept
+{
+  const int r = color[0] - pixel[0];
+  const int g = color[1] - pixel[1];
+  const int b = color[2] - pixel[2];
+  return r * r + g * g + b * b;
+}
+
+void put_le16(std::uint8_t* out, std::uint16_t value) noexcept
+{
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+// Endpoints are the colour bounding box inset by 1/16 of its extent, which
+// keeps both ends inside the cluster; fast, and close to a least-squares
+// fit for the smooth gradients tiles mostly have. With `punch_through`,
+// pixels under alpha 128 are left out and encoded as transparent; otherwise
+// fully transparent pixels are only left out of the endpoint fit.
+void compress_color_block(const std::uint8_t* block,
+                          bool punch_through,
+                          std::uint8_t* out) noexcept
+{
+  std::array<bool, kBlockPixels> transparent{};
+  bool any_transparent = false;
+  Rgb low{255, 255, 255};
+  Rgb high{0, 0, 0};
+  int fitted = 0;
+  for (int i = 0; i < kBlockPixels; ++i) {
+    const auto* pixel = block + i * 4;
+    transparent[i] = punch_through && pixel[3] < 128;
+    any_transparent = any_transparent || transparent[i];
+    if (transparent[i] || pixel[3] == 0) {
+      continue;
+    }
+    ++fitted;
+    for (int c = 0; c < 3; ++c) {
+      low[c] = std::min<int>(low[c], pixel[c]);
+      high[c] = std::max<int>(high[c], pixel[c]);
+    }
+  }
+  if (fitted == 0) {
+    low = high = Rgb{0, 0, 0};
+  }
+  for (int c = 0; c < 3; ++c) {
+    const int inset = (high[c] - low[c]) >> 4;
+    low[c] += inset;
+    high[c] -= inset;
+  }
+
+  const auto a = pack_565(high);
+  const auto b = pack_565(low);
+  // color0 > color1 selects four colours; otherwise three plus transparent.
+  const bool three_colour = any_transparent;
+  const std::uint16_t color0 = three_colour ? std::min(a, b) : std::max(a, b);
+  const std::uint16_t color1 = three_colour ? std::max(a, b) : std::min(a, b);
+
+  std::array<Rgb, 4> palette{unpack_565(color0), unpack_565(color1)};
+  int choices = 4;
+  if (three_colour || color0 == color1) {
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+    }
+    choices = 3;
+  }
+  else {
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+  }
+
+  std::uint32_t indices = 0;
+  for (int i = 0; i < kBlockPixels; ++i) {
+    std::uint32_t best = 3;
+    if (!transparent[i]) {
+      const auto* pixel = block + i * 4;
+      int best_distance = distance(palette[0], pixel);
+      best = 0;
+      for (int candidate = 1; candidate < choices; ++candidate) {
+        const int d = distance(palette[candidate], pixel);
+        if (d < best_distance) {
+          best_distance = d;
+          best = static_cast<std::uint32_t>(candidate);
+        }
+      }
+    }
+    indices |= best << (2 * i);
+  }
+
+  put_le16(out, color0);
+  put_le16(out + 2, color1);
+  for (int i = 0; i < 4; ++i) {
+    out[4 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+  }
+}
+
+// Eight-level interpolated alpha between the block's extremes, so blocks of
+// only 0 and 255 stay exact.
+void compress_alpha_block(const std::uint8_t* block,
+                          std::uint8_t* out) noexcept
+{
+  int low = 255;
+  int high = 0;
+  for (int i = 0; i < kBlockPixels; ++i) {
+    low = std::min<int>(low, block[i * 4 + 3]);
+    high = std::max<int>(high, block[i * 4 + 3]);
+  }
+
+  std::array<int, 8> levels{high, low};
+  for (int i = 2; i < 8; ++i) {
+    levels[i] = ((8 - i) * high + (i - 1) * low) / 7;
+  }
+
+  std::uint64_t indices = 0;
+  if (high != low) {
+    for (int i = 0; i < kBlockPixels; ++i) {
+      const int alpha = block[i * 4 + 3];
+      std::uint64_t best = 0;
+      int best_distance = 256;
+      for (int candidate = 0; candidate < 8; ++candidate) {
+        const int d = std::abs(levels[candidate] - alpha);
+        if (d < best_distance) {
+          best_distance = d;
+          best = static_cast<std::uint64_t>(candidate);
+        }
+      }
+      indices |= best << (3 * i);
+    }
+  }
+
+  out[0] = static_cast<std::uint8_t>(high);
+  out[1] = static_cast<std::uint8_t>(low);
+  for (int i = 0; i < 6; ++i) {
+    out[2 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+  }
+}
+
+}  // namespace
+
+void compress_bc1_block(const std::uint8_t* block, std::uint8_t* out) noexcept
+{
+  compress_color_block(block, true, out);
+}
+
+void compress_bc3_block(const std::uint8_t* block, std::uint8_t* out) noexcept
+{
+  compress_alpha_block(block, out);
+  compress_color_block(block, false, out + 8);
+}
+
+}  // namespace art2img::core::detail
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace art2img::core::detail {
+
+/// Compresses a 4x4 block of RGBA pixels (64 bytes, rows top to bottom) to
+/// 8 bytes of BC1. Blocks with a pixel under alpha 128 use the three-colour
+/// mode, where those pixels decode as transparent black.
+void compress_bc1_block(const std::uint8_t* block, std::uint8_t* out) noexcept;
+
+/// Compresses a 4x4 block of RGBA pixels to 16 bytes of BC3: an interpolated
+/// alpha block followed by a four-colour BC1 colour block.
+void compress_bc3_block(const std::uint8_t* block, std::uint8_t* out) noexcept;
+
+}  // namespace art2img::core::detail
@@ -0,0 +1,257 @@
+#include <art2img/extras/atlas.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/extras/parallel.hpp>
+
+namespace art2img::extras {
+
+namespace {
+
+struct Shelf {
+  std::uint32_t page = 0;
+  std::uint32_t y = 0;
+  std::uint32_t height = 0;
+  std::uint32_t cursor = 0;  // next free x
+};
+
+struct PageState {
+  std::uint32_t width = 0;   // rightmost used column, padding included
+  std::uint32_t bottom = 0;  // first row below the last shelf
+  bool shared = true;        // false for a page holding one oversized tile
+};
+
+class ShelfPacker {
+ public:
+  ShelfPacker(std::uint32_t max_size, std::uint32_t padding)
+      : max_size_(max_size), padding_(padding)
+  {
+  }
+
+  void place(core::AtlasEntry& entry)
+  {
+    const auto w = entry.width + padding_;
+    const auto h = entry.height + padding_;
+    if (w + padding_ > max_size_ || h + padding_ > max_size_) {
+      entry.page = static_cast<std::uint32_t>(pages_.size());
+      entry.x = padding_;
+      entry.y = padding_;
+      pages_.push_back(PageState{w + padding_, h + padding_, false});
+      return;
+    }
+
+    // Tiles arrive tallest first, so every open shelf is tall enough to
+    // hold the current one unless a shorter shelf was opened on a later page.
+    for (auto& shelf : shelves_) {
+      if (shelf.height >= entry.height && shelf.cursor + w <= max_size_) {
+        put(entry, shelf);
+        return;
+      }
+    }
+
+    std::uint32_t page = 0;
+    while (page < pages_.size() &&
+           (!pages_[page].shared || pages_[page].bottom + h > max_size_)) {
+      ++page;
+    }
+    if (page == pages_.size()) {
+      pages_.push_back(PageState{padding_, padding_, true});
+    }
+    auto& state = pages_[page];
+    shelves_.push_back(Shelf{page, state.bottom, entry.height, padding_});
+    state.bottom += h;
+    put(entry, shelves_.back());
+  }
+
+  std::vector<core::AtlasPage> pages() const
+  {
+    std::vector<core::AtlasPage> result;
+    result.reserve(pages_.size());
+    for (const auto& state : pages_) {
+      result.push_back(core::AtlasPage{{}, state.width, state.bottom});
+    }
+    return result;
+  }
+
+ private:
+  void put(core::AtlasEntry& entry, Shelf& shelf)
+  {
+    entry.page = shelf.page;
+    entry.x = shelf.cursor;
+    entry.y = shelf.y;
+    shelf.cursor += entry.width + padding_;
+    auto& state = pages_[shelf.page];
+    state.width = std::max(state.width, shelf.cursor);
+  }
+
+  std::uint32_t max_size_;
+  std::uint32_t padding_;
+  std::vector<Shelf> shelves_{};
+  std::vector<PageState> pages_{};
+};
+
+void blit(std::span<const std::uint8_t> tile,
+          const core::AtlasEntry& entry,
+          std::uint32_t page_width,
+          std::span<std::uint8_t> page)
+{
+  const std::size_t row = static_cast<std::size_t>(entry.width) * 4;
+  for (std::uint32_t y = 0; y < entry.height; ++y) {
+    const auto offset =
+        (static_cast<std::size_t>(entry.y + y) * page_width + entry.x) * 4;
+    std::memcpy(page.data() + offset, tile.data() + y * row, row);
+  }
+}
+
+}  // namespace
+
+std::expected<core::AtlasManifest, core::Error> pack_atlas(
+    const core::ArtArchive& archive,
+    std::span<const std::size_t> tiles,
+    AtlasOptions options)
+{
+  if (options.max_size == 0) {
+    return std::unexpected(core::make_error(
+        core::errc::conversion_failure, "atlas size must be positive"));
+  }
+
+  core::AtlasManifest manifest{};
+  manifest.tile_start = archive.tile_start;
+  for (std::size_t index : tiles) {
+    if (index >= archive.layout.size()) {
+      return std::unexpected(
+          core::make_error(core::errc::invalid_art, "tile index out of range"));
+    }
+    const auto& metrics = archive.layout[index];
+    if (metrics.width == 0 || metrics.height == 0) {
+      continue;
+    }
+    manifest.entries.push_back(core::AtlasEntry{
+        .tile = index,
+        .width = metrics.width,
+        .height = metrics.height,
+        .origin_x = metrics.offset_x,
+        .origin_y = metrics.offset_y});
+  }
+
+  std::vector<std::size_t> order(manifest.entries.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     const auto& lhs = manifest.entries[a];
+                     const auto& rhs = manifest.entries[b];
+                     if (lhs.height != rhs.height) {
+                       return lhs.height > rhs.height;
+                     }
+                     return lhs.width > rhs.width;
+                   });
+
+  ShelfPacker packer(options.max_size, options.padding);
+  for (std::size_t position : order) {
+    packer.place(manifest.entries[position]);
+  }
+  manifest.pages = packer.pages();
+  return manifest;
+}
+
+std::expected<AtlasResult, core::Error> build_atlas(
+    const AtlasRequest& request)
+{
+  if (request.archive == nullptr || request.palette == nullptr) {
+    return std::unexpected(core::make_error(core::errc::invalid_art,
+                                            "atlas request missing data"));
+  }
+
+  std::vector<std::size_t> tiles = request.tiles;
+  if (tiles.empty()) {
+    tiles.resize(core::tile_count(*request.archive));
+    std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+  }
+  auto manifest = pack_atlas(*request.archive, tiles, request.atlas);
+  if (!manifest) {
+    return std::unexpected(manifest.error());
+  }
+
+  const auto palette = core::prepare_palette(
+      core::view_palette(*request.palette), request.conversion);
+  if (!palette) {
+    return std::unexpected(palette.error());
+  }
+
+  // Pages start fully transparent, so padding and unused space need no
+  // further clearing.
+  std::vector<std::vector<std::uint8_t>> pixels(manifest->pages.size());
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    const auto& page = manifest->pages[i];
+    pixels[i].assign(static_cast<std::size_t>(page.width) * page.height * 4,
+                     0);
+  }
+
+  // Rects are disjoint, so workers blit into shared pages without locking.
+  std::vector<std::size_t> placed(manifest->entries.size());
+  for (std::size_t i = 0; i < placed.size(); ++i) {
+    placed[i] = manifest->entries[i].tile;
+  }
+  const auto order = largest_first(*request.archive, placed);
+  const auto threads =
+      resolve_thread_count(request.parallel.threads, order.size());
+  std::vector<core::ConversionWorkspace> workspaces(threads);
+  std::vector<std::optional<core::Error>> errors(order.size());
+  for_each_index(
+      order, request.parallel, [&](std::size_t position, std::size_t slot) {
+        const auto& entry = manifest->entries[position];
+        auto tile = core::get_tile(*request.archive, entry.tile);
+        if (!tile) {
+          errors[position] = core::make_error(core::errc::invalid_art,
+                                              "tile index out of range");
+          return false;
+        }
+        auto& workspace = workspaces[slot];
+        const auto buffer = workspace.pixel_buffer(
+            static_cast<std::size_t>(tile->width) * tile->height * 4);
+        auto converted =
+            core::palette_to_rgba_into(*tile, *palette, buffer, workspace);
+        if (!converted) {
+          errors[position] = std::move(converted.error());
+          return false;
+        }
+        blit(buffer, entry, manifest->pages[entry.page].width,
+             pixels[entry.page]);
+        return true;
+      });
+  for (auto& error : errors) {
+    if (error) {
+      return std::unexpected(std::move(*error));
+    }
+  }
+
+  AtlasResult result{};
+  result.pages.reserve(pixels.size());
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    const auto& page = manifest->pages[i];
+    const core::RgbaImageView view{pixels[i], page.width, page.height,
+                                   page.width * 4u};
+    auto encoded = core::encode_image(view, request.format, request.encoder);
+    if (!encoded) {
+      return std::unexpected(encoded.error());
+    }
+    result.pages.push_back(std::move(*encoded));
+  }
+  result.manifest = std::move(*manifest);
+  return result;
+}
+
+}  // namespace art2img::extras
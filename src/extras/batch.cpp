@@ -1,51 +1,423 @@
 #include <art2img/extras/batch.hpp>
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <expected>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <art2img/core/art.hpp>
+#include <art2img/core/collection.hpp>
 #include <art2img/core/convert.hpp>
 #include <art2img/core/encode.hpp>
+#include <art2img/core/mipmap.hpp>
 #include <art2img/core/palette.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/dedupe.hpp>
+#include <art2img/extras/parallel.hpp>
 
 namespace art2img::extras {
 
-std::expected<BatchResult, core::Error> convert_tiles(
-    const BatchRequest& request)
+namespace {
+
+// The encoded mip levels and thumbnail of one tile.
+struct DerivedImages {
+  std::vector<core::EncodedImage> levels;
+  core::EncodedImage thumbnail;
+};
+
+// Encodes the freshly converted pixels and downscales them while they are
+// still in cache. A DDS carries its mip chain inside the file, so its levels
+// are not returned separately.
+std::expected<core::EncodedImage, core::Error> encode_with_derived(
+    const core::RgbaImageView& view,
+    const BatchRequest& request,
+    DerivedImages& derived)
+{
+  const bool premultiplied = request.conversion.premultiply_alpha ||
+                             request.postprocess.premultiply_alpha;
+  if (request.mipmaps.thumbnail_size > 0) {
+    auto thumbnail = core::make_thumbnail(view, request.mipmaps.thumbnail_size,
+                                          premultiplied);
+    if (!thumbnail) {
+      return std::unexpected(thumbnail.error());
+    }
+    auto encoded = core::encode_image(core::make_view(*thumbnail),
+                                      request.format, request.encoder);
+    if (!encoded) {
+      return std::unexpected(encoded.error());
+    }
+    derived.thumbnail = std::move(*encoded);
+  }
+  if (request.mipmaps.levels == 0) {
+    return core::encode_image(view, request.format, request.encoder);
+  }
+
+  auto chain =
+      core::build_mip_chain(view, request.mipmaps.levels, premultiplied);
+  if (!chain) {
+    return std::unexpected(chain.error());
+  }
+  if (request.format == core::ImageFormat::dds) {
+    std::vector<core::RgbaImageView> levels;
+    levels.reserve(chain->size());
+    for (const auto& level : *chain) {
+      levels.push_back(core::make_view(level));
+    }
+    return core::encode_image_levels(view, levels, request.format,
+                                     request.encoder);
+  }
+  derived.levels.reserve(chain->size());
+  for (const auto& level : *chain) {
+    auto encoded = core::encode_image(core::make_view(level), request.format,
+                                      request.encoder);
+    if (!encoded) {
+      return std::unexpected(encoded.error());
+    }
+    derived.levels.push_back(std::move(*encoded));
+  }
+  return core::encode_image(view, request.format, request.encoder);
+}
+
+std::expected<core::EncodedImage, core::Error> convert_one(
+    const core::TileView& tile,
+    const core::PreparedPalette& palette,
+    const BatchRequest& request,
+    core::ConversionWorkspace& workspace,
+    DerivedImages* derived = nullptr)
 {
-  if (request.archive == nullptr || request.palette == nullptr) {
+  // Pixels live in the worker's workspace, so steady-state conversion does
+  // not allocate; only the encoded output is a fresh buffer.
+  const auto pixels = workspace.pixel_buffer(
+      static_cast<std::size_t>(tile.width) * tile.height * 4);
+  auto converted = core::palette_to_rgba_into(tile, palette, pixels, workspace);
+  if (!converted) {
+    return std::unexpected(converted.error());
+  }
+
+  core::postprocess_rgba(
+      pixels, tile.width, tile.height,
+      core::residual_postprocess(request.conversion, request.postprocess),
+      workspace);
+  const core::RgbaImageView view{pixels, tile.width, tile.height,
+                                 tile.width * 4u};
+  if (derived != nullptr) {
+    return encode_with_derived(view, request, *derived);
+  }
+  return core::encode_image(view, request.format, request.encoder);
+}
+
+// What convert_tiles and convert_tiles_streaming share: the resolved views,
+// the prepared palette and which request positions are actually converted.
+struct BatchPlan {
+  std::vector<core::TileView> views;
+  core::PreparedPalette palette;
+  std::vector<std::size_t> unique;   // the positions that are converted
+  std::vector<std::size_t> sources;  // per position: index into unique
+  std::vector<std::size_t> order;    // indices into unique, scheduling order
+  std::size_t threads = 1;
+};
+
+std::expected<BatchPlan, core::Error> plan_batch(const BatchRequest& request)
+{
+  if ((request.archive == nullptr && request.collection == nullptr) ||
+      request.palette == nullptr) {
     return std::unexpected(core::make_error(core::errc::invalid_art,
                                             "batch request missing data"));
   }
 
-  auto palette_view = core::view_palette(*request.palette);
-  BatchResult result{};
-  result.images.reserve(request.tiles.size());
-
+  // Resolve every tile first so an out-of-range index is reported the same
+  // way whatever the thread count.
+  BatchPlan plan{};
+  plan.views.reserve(request.tiles.size());
   for (std::size_t index : request.tiles) {
-    auto tile_view = core::get_tile(*request.archive, index);
+    std::optional<core::TileView> tile_view;
+    if (request.collection != nullptr) {
+      if (index <= UINT32_MAX) {
+        tile_view = core::get_tile(*request.collection,
+                                   static_cast<std::uint32_t>(index));
+      }
+    }
+    else {
+      tile_view = core::get_tile(*request.archive, index);
+    }
     if (!tile_view) {
       return std::unexpected(
           core::make_error(core::errc::invalid_art, "tile index out of range"));
     }
+    plan.views.push_back(*tile_view);
+  }
 
-    auto rgba =
-        core::palette_to_rgba(*tile_view, palette_view, request.conversion);
-    if (!rgba) {
-      return std::unexpected(rgba.error());
+  // Built once per request and shared read-only by every worker.
+  auto palette = core::prepare_palette(core::view_palette(*request.palette),
+                                       request.conversion);
+  if (!palette) {
+    return std::unexpected(palette.error());
+  }
+  plan.palette = *palette;
+
+  const auto count = plan.views.size();
+  plan.sources.resize(count);
+  if (request.deduplicate) {
+    const auto canonical = find_duplicate_tiles(plan.views);
+    for (std::size_t position = 0; position < count; ++position) {
+      if (canonical[position] == position) {
+        plan.sources[position] = plan.unique.size();
+        plan.unique.push_back(position);
+      }
+      else {
+        plan.sources[position] = plan.sources[canonical[position]];
+      }
     }
+  }
+  else {
+    plan.unique.resize(count);
+    std::iota(plan.unique.begin(), plan.unique.end(), std::size_t{0});
+    plan.sources = plan.unique;
+  }
 
-    core::postprocess_rgba(*rgba, request.postprocess);
-    auto encoded = core::encode_image(core::make_view(*rgba), request.format,
-                                      request.encoder);
-    if (!encoded) {
-      return std::unexpected(encoded.error());
+  plan.threads =
+      resolve_thread_count(request.parallel.threads, plan.unique.size());
+  if (plan.threads > 1) {
+    std::vector<core::TileView> unique_views(plan.unique.size());
+    for (std::size_t i = 0; i < plan.unique.size(); ++i) {
+      unique_views[i] = plan.views[plan.unique[i]];
     }
+    plan.order = largest_first(unique_views);
+  }
+  else {
+    plan.order.resize(plan.unique.size());
+    std::iota(plan.order.begin(), plan.order.end(), std::size_t{0});
+  }
+  return plan;
+}
 
-    result.images.push_back(std::move(encoded.value()));
+void count_input(core::StageTimer& timer, const BatchPlan& plan)
+{
+  for (const auto position : plan.unique) {
+    const auto pixels = static_cast<std::uint64_t>(plan.views[position].width) *
+                        plan.views[position].height;
+    timer.add_pixels(pixels);
+    timer.add_bytes_in(pixels);
+  }
+}
+
+}  // namespace
+
+std::expected<BatchResult, core::Error> convert_tiles(
+    const BatchRequest& request)
+{
+  core::StageTimer timer(core::Stage::batch);
+  auto plan = plan_batch(request);
+  if (!plan) {
+    return std::unexpected(plan.error());
+  }
+  count_input(timer, *plan);
+
+  // Every request position maps onto one of the converted images through
+  // result.sources.
+  BatchResult result{};
+  result.sources = std::move(plan->sources);
+  const auto& unique = plan->unique;
+
+  // One workspace per worker slot, reused for every tile that slot runs.
+  std::vector<core::ConversionWorkspace> workspaces(plan->threads);
+  std::vector<std::optional<core::EncodedImage>> images(unique.size());
+  std::vector<std::optional<core::Error>> errors(unique.size());
+  const bool mipmapped =
+      request.mipmaps.levels > 0 || request.mipmaps.thumbnail_size > 0;
+  std::vector<DerivedImages> derived(mipmapped ? unique.size() : 0);
+  for_each_index(plan->order, request.parallel,
+                 [&](std::size_t item, std::size_t slot) {
+                   const core::ScopedStageTag tag(request.tiles[unique[item]]);
+                   auto encoded = convert_one(
+                       plan->views[unique[item]], plan->palette, request,
+                       workspaces[slot], mipmapped ? &derived[item] : nullptr);
+                   if (!encoded) {
+                     errors[item] = std::move(encoded.error());
+                     return false;
+                   }
+                   images[item] = std::move(encoded.value());
+                   return true;
+                 });
+
+  result.images.reserve(unique.size());
+  for (std::size_t item = 0; item < unique.size(); ++item) {
+    if (errors[item]) {
+      return std::unexpected(std::move(*errors[item]));
+    }
+  }
+  for (auto& image : images) {
+    if (!image) {
+      return std::unexpected(core::make_error(
+          core::errc::conversion_failure, "batch conversion was interrupted"));
+    }
+    timer.add_bytes_out(image->bytes.size());
+    result.images.push_back(std::move(*image));
+  }
+  for (auto& images_of_tile : derived) {
+    for (const auto& level : images_of_tile.levels) {
+      timer.add_bytes_out(level.bytes.size());
+    }
+    timer.add_bytes_out(images_of_tile.thumbnail.bytes.size());
+    result.levels.push_back(std::move(images_of_tile.levels));
+    result.thumbnails.push_back(std::move(images_of_tile.thumbnail));
   }
 
   return result;
 }
 
+std::expected<void, core::Error> convert_tiles_streaming(
+    const BatchRequest& request,
+    const TileSink& sink,
+    StreamOptions options)
+{
+  core::StageTimer timer(core::Stage::batch);
+  if (request.mipmaps.levels > 0 || request.mipmaps.thumbnail_size > 0) {
+    return std::unexpected(core::make_error(
+        core::errc::unsupported, "streaming batches cannot build mipmaps"));
+  }
+  auto plan = plan_batch(request);
+  if (!plan) {
+    return std::unexpected(plan.error());
+  }
+  count_input(timer, *plan);
+  const auto& unique = plan->unique;
+
+  // The request positions served by each converted image, grouped by image:
+  // those of unique[item] are positions[first[item]..first[item + 1]).
+  std::vector<std::size_t> first(unique.size() + 1, 0);
+  for (const auto source : plan->sources) {
+    ++first[source + 1];
+  }
+  std::partial_sum(first.begin(), first.end(), first.begin());
+  std::vector<std::size_t> positions(plan->sources.size());
+  {
+    auto next = first;
+    for (std::size_t position = 0; position < positions.size(); ++position) {
+      positions[next[plan->sources[position]]++] = position;
+    }
+  }
+  const auto deliver = [&](std::size_t item, const core::EncodedImage& image) {
+    timer.add_bytes_out(image.bytes.size());
+    return sink(std::span{positions}.subspan(first[item],
+                                             first[item + 1] - first[item]),
+                image);
+  };
+
+  std::vector<core::ConversionWorkspace> workspaces(plan->threads);
+  if (plan->threads == 1) {
+    // Serially there is nothing to overlap: each image goes straight to the
+    // sink and is freed before the next tile starts.
+    for (const auto item : plan->order) {
+      const core::ScopedStageTag tag(request.tiles[unique[item]]);
+      auto encoded = convert_one(plan->views[unique[item]], plan->palette,
+                                 request, workspaces[0]);
+      if (!encoded) {
+        return std::unexpected(std::move(encoded.error()));
+      }
+      if (!deliver(item, *encoded)) {
+        break;
+      }
+    }
+    return {};
+  }
+
+  // Workers hand finished images to this thread, which runs the sink, so a
+  // slow consumer holds back conversion instead of letting output pile up.
+  // `in_flight` counts images from the start of their conversion until the
+  // sink returns, and workers wait for room before starting a tile.
+  struct Finished {
+    std::size_t item;
+    core::EncodedImage image;
+  };
+  const auto limit = options.max_in_flight == 0 ? plan->threads * 2
+                                                : options.max_in_flight;
+  std::mutex mutex;
+  std::condition_variable space_ready;
+  std::condition_variable image_ready;
+  std::deque<Finished> finished;
+  std::size_t in_flight = 0;
+  bool stopping = false;
+  bool producers_done = false;
+  std::vector<std::optional<core::Error>> errors(unique.size());
+
+  std::jthread producer([&] {
+    for_each_index(
+        plan->order, request.parallel,
+        [&](std::size_t item, std::size_t slot) {
+          {
+            std::unique_lock lock(mutex);
+            space_ready.wait(lock,
+                             [&] { return stopping || in_flight < limit; });
+            if (stopping) {
+              return false;
+            }
+            ++in_flight;
+          }
+          const core::ScopedStageTag tag(request.tiles[unique[item]]);
+          auto encoded = convert_one(plan->views[unique[item]], plan->palette,
+                                     request, workspaces[slot]);
+          {
+            const std::lock_guard lock(mutex);
+            if (!encoded) {
+              errors[item] = std::move(encoded.error());
+              --in_flight;
+              stopping = true;
+            }
+            else {
+              finished.push_back(Finished{item, std::move(*encoded)});
+            }
+          }
+          space_ready.notify_all();
+          image_ready.notify_one();
+          return encoded.has_value();
+        });
+    {
+      const std::lock_guard lock(mutex);
+      producers_done = true;
+    }
+    image_ready.notify_one();
+  });
+
+  std::unique_lock lock(mutex);
+  while (true) {
+    image_ready.wait(lock, [&] { return producers_done || !finished.empty(); });
+    if (finished.empty() || stopping) {
+      if (producers_done) {
+        break;
+      }
+      // Stopped: drop what is queued and wait for the workers to return.
+      finished.clear();
+      continue;
+    }
+    auto next = std::move(finished.front());
+    finished.pop_front();
+    lock.unlock();
+    const bool keep_going = deliver(next.item, next.image);
+    next.image = {};
+    lock.lock();
+    --in_flight;
+    stopping = stopping || !keep_going;
+    space_ready.notify_all();
+  }
+  lock.unlock();
+  producer.join();
+
+  // Like convert_tiles, a failure is reported for the earliest failing
+  // position, whichever worker hit it first.
+  for (auto& error : errors) {
+    if (error) {
+      return std::unexpected(std::move(*error));
+    }
+  }
+  return {};
+}
+
 }  // namespace art2img::extras
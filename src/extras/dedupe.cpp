@@ -0,0 +1,70 @@
+#include <art2img/extras/dedupe.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/hash.hpp>
+
+namespace art2img::extras {
+
+namespace {
+
+bool same_payload(const core::TileView& lhs, const core::TileView& rhs)
+{
+  const auto count = static_cast<std::size_t>(lhs.width) * lhs.height;
+  return lhs.width == rhs.width && lhs.height == rhs.height &&
+         std::equal(lhs.indices.begin(), lhs.indices.begin() + count,
+                    rhs.indices.begin()) &&
+         std::ranges::equal(lhs.lookup, rhs.lookup);
+}
+
+}  // namespace
+
+std::vector<std::size_t> find_duplicate_tiles(
+    const core::ArtArchive& archive,
+    std::span<const std::size_t> tiles)
+{
+  std::vector<core::TileView> views(tiles.size());
+  for (std::size_t position = 0; position < tiles.size(); ++position) {
+    if (auto view = core::get_tile(archive, tiles[position])) {
+      views[position] = *view;
+    }
+  }
+  return find_duplicate_tiles(views);
+}
+
+std::vector<std::size_t> find_duplicate_tiles(
+    std::span<const core::TileView> views)
+{
+  std::vector<std::size_t> canonical(views.size());
+  std::iota(canonical.begin(), canonical.end(), std::size_t{0});
+
+  // Fingerprint -> positions of the distinct payloads seen with it.
+  std::unordered_map<std::uint64_t, std::vector<std::size_t>> seen;
+  seen.reserve(views.size());
+  for (std::size_t position = 0; position < views.size(); ++position) {
+    const auto& view = views[position];
+    if (view.width == 0 || view.height == 0 || !view.valid()) {
+      continue;
+    }
+
+    auto& candidates = seen[core::tile_fingerprint(view, 0)];
+    const auto match =
+        std::find_if(candidates.begin(), candidates.end(), [&](auto other) {
+          return same_payload(views[other], view);
+        });
+    if (match != candidates.end()) {
+      canonical[position] = *match;
+    }
+    else {
+      candidates.push_back(position);
+    }
+  }
+  return canonical;
+}
+
+}  // namespace art2img::extras
@@ -0,0 +1,74 @@
+#include <art2img/extras/palette_cache.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <art2img/core/hash.hpp>
+
+namespace art2img::extras {
+
+std::expected<std::shared_ptr<const core::PaletteView>, core::Error>
+PaletteCache::get(std::span<const std::byte> blob)
+{
+  const auto key = core::xxh64(blob);
+  const auto alias = [](std::shared_ptr<const Stored> stored) {
+    const auto* view = &stored->view;
+    return std::shared_ptr<const core::PaletteView>(std::move(stored), view);
+  };
+
+  const std::lock_guard lock(mutex_);
+  // Matching keys are confirmed byte for byte, so a hash collision costs a
+  // parse rather than the wrong palette.
+  const auto hit = std::find_if(
+      entries_.begin(), entries_.end(), [&](const Entry& entry) {
+        return entry.key == key &&
+               std::ranges::equal(entry.palette->bytes, blob);
+      });
+  if (hit != entries_.end()) {
+    std::rotate(hit, hit + 1, entries_.end());
+    return alias(entries_.back().palette);
+  }
+
+  auto stored = std::make_shared<Stored>();
+  stored->bytes.assign(blob.begin(), blob.end());
+  auto view = core::load_palette_view(stored->bytes);
+  if (!view) {
+    return std::unexpected(view.error());
+  }
+  stored->view = *view;
+
+  if (capacity_ == 0) {
+    return alias(std::move(stored));
+  }
+  if (entries_.size() >= capacity_) {
+    entries_.erase(entries_.begin());
+  }
+  entries_.push_back(Entry{key, stored});
+  return alias(std::move(stored));
+}
+
+std::size_t PaletteCache::size() const
+{
+  const std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+void PaletteCache::clear()
+{
+  const std::lock_guard lock(mutex_);
+  entries_.clear();
+}
+
+PaletteCache& palette_cache()
+{
+  static PaletteCache cache;
+  return cache;
+}
+
+}  // namespace art2img::extras
@@ -0,0 +1,116 @@
+#include <art2img/extras/parallel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace art2img::extras {
+
+void run_on_threads(std::size_t slots,
+                    const std::function<void(std::size_t slot)>& worker)
+{
+  if (slots == 0) {
+    return;
+  }
+
+  std::vector<std::jthread> pool;
+  pool.reserve(slots - 1);
+  for (std::size_t slot = 1; slot < slots; ++slot) {
+    pool.emplace_back([&worker, slot]() { worker(slot); });
+  }
+  worker(0);
+}
+
+std::size_t resolve_thread_count(std::size_t requested,
+                                 std::size_t items) noexcept
+{
+  std::size_t threads = requested;
+  if (threads == 0) {
+    threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  }
+  return std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(1, items));
+}
+
+namespace {
+
+std::vector<std::size_t> by_descending_weight(
+    const std::vector<std::uint64_t>& weights)
+{
+  std::vector<std::size_t> order(weights.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&weights](std::size_t lhs, std::size_t rhs) {
+                     return weights[lhs] > weights[rhs];
+                   });
+  return order;
+}
+
+}  // namespace
+
+std::vector<std::size_t> largest_first(const core::ArtArchive& archive,
+                                       std::span<const std::size_t> tiles)
+{
+  std::vector<std::uint64_t> weights(tiles.size(), 0);
+  for (std::size_t i = 0; i < tiles.size(); ++i) {
+    if (tiles[i] < archive.layout.size()) {
+      const auto& metrics = archive.layout[tiles[i]];
+      weights[i] = static_cast<std::uint64_t>(metrics.width) * metrics.height;
+    }
+  }
+  return by_descending_weight(weights);
+}
+
+std::vector<std::size_t> largest_first(std::span<const core::TileView> views)
+{
+  std::vector<std::uint64_t> weights(views.size());
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    weights[i] = static_cast<std::uint64_t>(views[i].width) * views[i].height;
+  }
+  return by_descending_weight(weights);
+}
+
+void for_each_index(
+    std::span<const std::size_t> order,
+    const ParallelOptions& options,
+    const std::function<bool(std::size_t item, std::size_t slot)>& body)
+{
+  const auto slots = resolve_thread_count(options.threads, order.size());
+  if (slots == 1) {
+    for (std::size_t item : order) {
+      if (!body(item, 0)) {
+        break;
+      }
+    }
+    return;
+  }
+
+  // A shared cursor gives dynamic self-scheduling: a worker that finishes a
+  // small tile immediately claims the next one, so no worker sits idle while
+  // another grinds through an oversized chunk.
+  std::atomic<std::size_t> cursor{0};
+  std::atomic<bool> stop{false};
+  auto worker = [&](std::size_t slot) {
+    while (!stop.load(std::memory_order_relaxed)) {
+      const auto position = cursor.fetch_add(1, std::memory_order_relaxed);
+      if (position >= order.size()) {
+        break;
+      }
+      if (!body(order[position], slot)) {
+        stop.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  if (options.executor) {
+    options.executor(slots, worker);
+  }
+  else {
+    run_on_threads(slots, worker);
+  }
+}
+
+}  // namespace art2img::extras
@@ -0,0 +1,122 @@
+#include <art2img/extras/trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace art2img::extras {
+
+namespace {
+
+std::atomic<std::uint64_t> next_recorder_id{1};
+
+// The buffer this thread last recorded into and the recorder it belongs to.
+// Ids are never reused, so a stale entry can only miss, never alias.
+struct CachedBuffer {
+  std::uint64_t recorder = 0;
+  void* buffer = nullptr;
+};
+thread_local CachedBuffer cached_buffer{};
+
+// Microseconds, the unit trace viewers expect, keeping nanosecond precision.
+std::string microseconds(std::uint64_t nanoseconds)
+{
+  return std::format("{}.{:03}", nanoseconds / 1000, nanoseconds % 1000);
+}
+
+}  // namespace
+
+TraceRecorder::TraceRecorder(core::StatsSink* forward)
+    : forward_(forward), id_(next_recorder_id.fetch_add(1))
+{
+}
+
+TraceRecorder::~TraceRecorder() = default;
+
+TraceRecorder::Buffer* TraceRecorder::buffer_for_this_thread()
+{
+  if (cached_buffer.recorder == id_) {
+    return static_cast<Buffer*>(cached_buffer.buffer);
+  }
+  const std::lock_guard lock(mutex_);
+  auto buffer = std::make_unique<Buffer>();
+  buffer->thread = buffers_.size() + 1;
+  buffers_.push_back(std::move(buffer));
+  cached_buffer = {id_, buffers_.back().get()};
+  return buffers_.back().get();
+}
+
+void TraceRecorder::record(const core::StageRecord& record) noexcept
+{
+  if (forward_ != nullptr) {
+    forward_->record(record);
+  }
+  // A span that cannot be stored is dropped rather than failing the call
+  // being measured.
+  try {
+    buffer_for_this_thread()->spans.push_back(record);
+  }
+  catch (...) {
+  }
+}
+
+std::size_t TraceRecorder::span_count() const
+{
+  const std::lock_guard lock(mutex_);
+  std::size_t count = 0;
+  for (const auto& buffer : buffers_) {
+    count += buffer->spans.size();
+  }
+  return count;
+}
+
+std::string TraceRecorder::chrome_trace_json() const
+{
+  const std::lock_guard lock(mutex_);
+  std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+  for (const auto& buffer : buffers_) {
+    for (const auto& span : buffer->spans) {
+      origin = std::min(origin, span.start_ns);
+    }
+  }
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  const auto separator = [&first] {
+    const char* text = first ? "\n" : ",\n";
+    first = false;
+    return text;
+  };
+  for (const auto& buffer : buffers_) {
+    json += std::format(
+        "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"art2img thread {}\"}}}}",
+        separator(), buffer->thread, buffer->thread);
+    for (const auto& span : buffer->spans) {
+      json += std::format(
+          "{}{{\"name\":\"{}\",\"cat\":\"art2img\",\"ph\":\"X\",\"ts\":{},"
+          "\"dur\":{},\"pid\":1,\"tid\":{},\"args\":{{",
+          separator(), core::stage_name(span.stage),
+          microseconds(span.start_ns - origin),
+          microseconds(span.duration_ns), buffer->thread);
+      if (span.tag != core::no_stage_tag) {
+        json += std::format("\"tile\":{},", span.tag);
+      }
+      json += std::format(
+          "\"pixels\":{},\"bytes_in\":{},\"bytes_out\":{},"
+          "\"allocations\":{}}}}}",
+          span.pixels, span.bytes_in, span.bytes_out, span.allocations);
+    }
+  }
+  json += "\n]}\n";
+  return json;
+}
+
+}  // namespace art2img::extras
@@ -1,11 +1,16 @@
 #include <doctest/doctest.h>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../test_helpers.hpp"
@@ -18,9 +23,28 @@ fs::path get_test_asset_path(const std::string& filename)
   return test_helpers::get_test_assets_dir() / filename;
 }
 
+// Helper function to collect converted images keyed by file name
+std::map<std::string, std::string> read_output_images(
+    const fs::path& dir,
+    const std::string& extension)
+{
+  std::map<std::string, std::string> images;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    if (entry.path().extension() != extension) {
+      continue;
+    }
+    std::ifstream file(entry.path(), std::ios::binary);
+    std::ostringstream bytes;
+    bytes << file.rdbuf();
+    images[entry.path().filename().string()] = bytes.str();
+  }
+  return images;
+}
+
 class CLITestFixture {
  public:
-  std::string run_cli(const std::vector<std::string>& args)
+  std::string run_cli(const std::vector<std::string>& args,
+                      const fs::path& stdin_path = {})
   {
     std::string cli_path = get_cli_path();
     std::string cmd = cli_path;
@@ -28,6 +52,9 @@ class CLITestFixture {
     for (const auto& arg : args) {
       cmd += " \"" + arg + "\"";
     }
+    if (!stdin_path.empty()) {
+      cmd += " < \"" + stdin_path.string() + "\"";
+    }
 
     std::array<char, 128> buffer;
     std::string result;
@@ -70,6 +97,18 @@ class CLITestFixture {
     return test_dir;
   }
 
+  /// Starts the CLI with stdout and stderr going to `log_path` and returns
+  /// its standard input; pclose closes it and waits for the CLI to exit.
+  FILE* open_cli(const std::vector<std::string>& args, const fs::path& log_path)
+  {
+    std::string cmd = get_cli_path().string();
+    for (const auto& arg : args) {
+      cmd += " \"" + arg + "\"";
+    }
+    cmd += " > \"" + log_path.string() + "\" 2>&1";
+    return popen(cmd.c_str(), "w");
+  }
+
  private:
   fs::path get_cli_path() { return test_helpers::get_cli_executable_path(); }
 };
@@ -316,4 +355,523 @@ TEST_CASE_FIXTURE(CLITestFixture, "CLI help")
     CHECK(output.find("--input") != std::string::npos);
     CHECK(output.find("--palette") != std::string::npos);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI parallel conversion")
+{
+  SUBCASE("Worker pool produces the same files as a single worker")
+  {
+    auto test_dir = create_test_dir();
+    const auto serial_dir = test_dir / "serial";
+    const auto parallel_dir = test_dir / "parallel";
+
+    run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+             (test_dir / "PALETTE.DAT").string(), "--output",
+             serial_dir.string(), "--jobs", "1"});
+    run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+             (test_dir / "PALETTE.DAT").string(), "--output",
+             parallel_dir.string(), "--jobs", "4"});
+
+    const auto serial = read_output_images(serial_dir, ".png");
+    const auto parallel = read_output_images(parallel_dir, ".png");
+    CHECK(!serial.empty());
+    CHECK(serial.size() == parallel.size());
+    CHECK(serial == parallel);
+    test_helpers::cleanup_test_output_dir(test_dir);
+  }
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI indexed output")
+{
+  auto test_dir = create_test_dir();
+  const auto rgba_dir = test_dir / "rgba";
+  const auto indexed_dir = test_dir / "indexed";
+
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output", rgba_dir.string()});
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output",
+           indexed_dir.string(), "--indexed"});
+
+  const auto rgba = read_output_images(rgba_dir, ".png");
+  const auto indexed = read_output_images(indexed_dir, ".png");
+  REQUIRE(!indexed.empty());
+  CHECK(indexed.size() == rgba.size());
+  std::size_t rgba_bytes = 0;
+  std::size_t indexed_bytes = 0;
+  for (const auto& [name, bytes] : indexed) {
+    REQUIRE(bytes.size() > 26);
+    CHECK(bytes[25] == 3);  // IHDR colour type: palette
+    indexed_bytes += bytes.size();
+    rgba_bytes += rgba.at(name).size();
+  }
+  CHECK(indexed_bytes < rgba_bytes);
+
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output",
+           (test_dir / "tga").string(), "--indexed", "--format", "tga"});
+  const auto tga = read_output_images(test_dir / "tga", ".tga");
+  CHECK(tga.size() == indexed.size());
+  for (const auto& [name, bytes] : tga) {
+    REQUIRE(bytes.size() > 18);
+    CHECK(bytes[2] == 9);  // colour-mapped, RLE
+  }
+
+  const auto rejected =
+      run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+               (test_dir / "PALETTE.DAT").string(), "--output",
+               (test_dir / "matte").string(), "--indexed", "--matte"});
+  CHECK(rejected.find("cannot be combined with --matte") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI atlas export")
+{
+  auto test_dir = create_test_dir();
+  const auto atlas_dir = test_dir / "atlas";
+
+  const auto output =
+      run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+               (test_dir / "PALETTE.DAT").string(), "--output",
+               atlas_dir.string(), "--atlas", "--atlas-size", "1024"});
+  INFO(output);
+
+  const auto pages = read_output_images(atlas_dir, ".png");
+  REQUIRE(!pages.empty());
+  CHECK(pages.size() < 10);
+  CHECK(pages.count("TILES000_atlas_0.png") == 1);
+
+  std::ifstream manifest_file(atlas_dir / "TILES000_atlas.json");
+  REQUIRE(manifest_file.good());
+  std::ostringstream manifest;
+  manifest << manifest_file.rdbuf();
+  CHECK(manifest.str().find("\"image\": \"TILES000_atlas_0.png\"") !=
+        std::string::npos);
+  CHECK(manifest.str().find("\"origin_x\"") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI trim crops tiles and records offsets")
+{
+  auto test_dir = create_test_dir();
+  const std::vector<std::string> base = {
+      "--input", (test_dir / "TILES000.ART").string(), "--palette",
+      (test_dir / "PALETTE.DAT").string(), "--output"};
+
+  auto full_args = base;
+  full_args.push_back((test_dir / "full").string());
+  run_cli(full_args);
+  auto trim_args = base;
+  trim_args.push_back((test_dir / "trim").string());
+  trim_args.push_back("--trim");
+  const auto output = run_cli(trim_args);
+  INFO(output);
+
+  const auto full = read_output_images(test_dir / "full", ".png");
+  const auto trimmed = read_output_images(test_dir / "trim", ".png");
+  REQUIRE(!full.empty());
+  REQUIRE(trimmed.size() == full.size());
+  std::size_t full_bytes = 0;
+  std::size_t trimmed_bytes = 0;
+  for (const auto& [name, bytes] : full) {
+    full_bytes += bytes.size();
+    trimmed_bytes += trimmed.at(name).size();
+  }
+  CHECK(trimmed_bytes < full_bytes);
+
+  std::ifstream manifest_file(test_dir / "trim" / "TILES000_trim.json");
+  REQUIRE(manifest_file.good());
+  std::ostringstream manifest;
+  manifest << manifest_file.rdbuf();
+  CHECK(manifest.str().find("\"tile\": 0, \"picnum\": 0, \"image\": "
+                            "\"TILES000_0000.png\"") != std::string::npos);
+  CHECK(manifest.str().find("\"trimmed_width\"") != std::string::npos);
+
+  trim_args.push_back("--atlas");
+  CHECK(run_cli(trim_args).find("--trim cannot be combined with --atlas") !=
+        std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI zip output")
+{
+  auto test_dir = create_test_dir();
+  const auto files_dir = test_dir / "files";
+  const auto zip_dir = test_dir / "zip";
+
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output",
+           files_dir.string()});
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output", zip_dir.string(),
+           "--zip", "--jobs", "1"});
+
+  CHECK(read_output_images(zip_dir, ".png").empty());
+  const auto archives = read_output_images(zip_dir, ".zip");
+  REQUIRE(archives.count("TILES000.zip") == 1);
+  const auto& zip = archives.at("TILES000.zip");
+  REQUIRE(zip.size() > 22);
+  const auto eocd = zip.size() - 22;
+  CHECK(zip.compare(eocd, 4, "PK\x05\x06") == 0);
+
+  // Entries are stored, so every image appears verbatim after its name.
+  const auto files = read_output_images(files_dir, ".png");
+  REQUIRE(!files.empty());
+  const auto entries = static_cast<std::uint8_t>(zip[eocd + 10]) |
+                       static_cast<std::uint8_t>(zip[eocd + 11]) << 8;
+  CHECK(static_cast<std::size_t>(entries) == files.size());
+  for (const auto& [name, bytes] : files) {
+    CHECK(zip.find(name + bytes) != std::string::npos);
+  }
+
+  const auto rejected =
+      run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+               (test_dir / "PALETTE.DAT").string(), "--output",
+               (test_dir / "both").string(), "--zip", "--atlas"});
+  CHECK(rejected.find("cannot be combined with --atlas") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI multiple inputs")
+{
+  auto test_dir = create_test_dir();
+  fs::copy_file(get_test_asset_path("TILES001.ART"), test_dir / "TILES001.ART",
+                fs::copy_options::overwrite_existing);
+
+  const auto count_stem = [](const fs::path& dir, const std::string& stem) {
+    std::size_t count = 0;
+    for (const auto& [name, bytes] : read_output_images(dir, ".png")) {
+      count += name.rfind(stem + "_", 0) == 0 ? 1 : 0;
+    }
+    return count;
+  };
+
+  SUBCASE("Directory input")
+  {
+    const auto out_dir = test_dir / "dir";
+    const auto output =
+        run_cli({"--input", test_dir.string(), "--palette",
+                 (test_dir / "PALETTE.DAT").string(), "--output",
+                 out_dir.string()});
+    CHECK(output.find("from TILES000.ART") != std::string::npos);
+    CHECK(output.find("from TILES001.ART") != std::string::npos);
+    CHECK(output.find("from TILES000.ART") < output.find("from TILES001.ART"));
+    CHECK(count_stem(out_dir, "TILES000") > 0);
+    CHECK(count_stem(out_dir, "TILES001") > 0);
+  }
+
+  SUBCASE("Wildcard and repeated inputs")
+  {
+    const auto out_dir = test_dir / "glob";
+    const auto output = run_cli(
+        {"--input", (test_dir / "tiles00?.art").string(),
+         (test_dir / "TILES000.ART").string(), "--palette",
+         (test_dir / "PALETTE.DAT").string(), "--output", out_dir.string()});
+    CHECK(output.find("from TILES001.ART") != std::string::npos);
+    // TILES000 matched the pattern already, so it is converted once.
+    CHECK(output.find("from TILES000.ART") ==
+          output.rfind("from TILES000.ART"));
+    CHECK(count_stem(out_dir, "TILES001") > 0);
+  }
+
+  SUBCASE("Unmatched pattern")
+  {
+    const auto output = run_cli(
+        {"--input", (test_dir / "*.xyz").string(), "--palette",
+         (test_dir / "PALETTE.DAT").string()});
+    CHECK(output.find("no ART files match") != std::string::npos);
+  }
+
+  SUBCASE("Inputs sharing a stem")
+  {
+    fs::create_directories(test_dir / "other");
+    fs::copy_file(get_test_asset_path("TILES001.ART"),
+                  test_dir / "other" / "tiles000.art",
+                  fs::copy_options::overwrite_existing);
+    const auto out_dir = test_dir / "clash";
+    const auto output = run_cli(
+        {"--input", (test_dir / "TILES000.ART").string(),
+         (test_dir / "other" / "tiles000.art").string(), "--palette",
+         (test_dir / "PALETTE.DAT").string(), "--output", out_dir.string()});
+    CHECK(output.find("would write the same output files") !=
+          std::string::npos);
+    CHECK(!fs::exists(out_dir));
+  }
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI GRP input")
+{
+  auto test_dir = create_test_dir();
+
+  // KenSilverman header, then 12-byte names with 32-bit sizes, then data.
+  std::string grp = "KenSilverman";
+  std::string data;
+  const auto append_le32 = [&grp](std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      grp += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  };
+  const std::vector<std::string> names = {"PALETTE.DAT", "TILES000.ART",
+                                          "README.TXT"};
+  append_le32(static_cast<std::uint32_t>(names.size()));
+  for (const auto& name : names) {
+    std::string bytes = "not an art file";
+    if (name != "README.TXT") {
+      std::ifstream file(test_dir / name, std::ios::binary);
+      std::ostringstream contents;
+      contents << file.rdbuf();
+      bytes = contents.str();
+    }
+    grp += name + std::string(12 - name.size(), '\0');
+    append_le32(static_cast<std::uint32_t>(bytes.size()));
+    data += bytes;
+  }
+  {
+    std::ofstream out(test_dir / "GAME.GRP", std::ios::binary);
+    out << grp << data;
+  }
+
+  const auto files_dir = test_dir / "files";
+  const auto grp_dir = test_dir / "grp";
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output",
+           files_dir.string()});
+  const auto output = run_cli({"--grp", (test_dir / "GAME.GRP").string(),
+                               "--output", grp_dir.string()});
+  CHECK(output.find("README.TXT") == std::string::npos);
+
+  // Entries are converted straight from the GRP and named after them.
+  const auto files = read_output_images(files_dir, ".png");
+  const auto from_grp = read_output_images(grp_dir, ".png");
+  REQUIRE(!files.empty());
+  REQUIRE(from_grp.size() == files.size());
+  auto expected = files.begin();
+  for (const auto& [name, bytes] : from_grp) {
+    CHECK(bytes == expected->second);
+    ++expected;
+  }
+
+  const auto missing = run_cli({"--grp", (test_dir / "GAME.GRP").string(),
+                                "--input", "TILES001.ART"});
+  CHECK(missing.find("no GRP entry named: TILES001.ART") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI incremental conversion")
+{
+  auto test_dir = create_test_dir();
+  const auto out_dir = test_dir / "out";
+  const std::vector<std::string> args = {
+      "--input", (test_dir / "TILES000.ART").string(), "--palette",
+      (test_dir / "PALETTE.DAT").string(), "--output", out_dir.string(),
+      "--incremental"};
+
+  const auto first = run_cli(args);
+  CHECK(first.find("unchanged") == std::string::npos);
+  REQUIRE(fs::exists(out_dir / ".art2img-cache"));
+  const auto images = read_output_images(out_dir, ".png");
+  REQUIRE(!images.empty());
+
+  // Nothing changed: every written tile is skipped.
+  const auto second = run_cli(args);
+  CHECK(second.find("(" + std::to_string(images.size()) + " unchanged)") !=
+        std::string::npos);
+
+  // A deleted output is rebuilt identically; the rest stay skipped.
+  const auto removed = images.begin()->first;
+  fs::remove(out_dir / removed);
+  const auto third = run_cli(args);
+  CHECK(third.find("(" + std::to_string(images.size() - 1) + " unchanged)") !=
+        std::string::npos);
+  CHECK(read_output_images(out_dir, ".png") == images);
+
+  // Different settings invalidate the cache.
+  auto shaded = args;
+  shaded.push_back("--shade");
+  shaded.push_back("4");
+  const auto fourth = run_cli(shaded);
+  CHECK(fourth.find("unchanged") == std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI dedupe links identical tiles")
+{
+  auto test_dir = create_test_dir();
+  const std::vector<std::string> base = {
+      "--input", (test_dir / "TILES000.ART").string(), "--palette",
+      (test_dir / "PALETTE.DAT").string(), "--output"};
+
+  auto plain_args = base;
+  plain_args.push_back((test_dir / "plain").string());
+  run_cli(plain_args);
+  const auto plain = read_output_images(test_dir / "plain", ".png");
+  REQUIRE(!plain.empty());
+
+  auto dedupe_args = base;
+  dedupe_args.push_back((test_dir / "dedupe").string());
+  dedupe_args.push_back("--dedupe");
+  run_cli(dedupe_args);
+  CHECK(read_output_images(test_dir / "dedupe", ".png") == plain);
+
+  // Tile 93 repeats tile 90, so both names share one file.
+  const auto original = test_dir / "dedupe" / "TILES000_0090.png";
+  const auto copy = test_dir / "dedupe" / "TILES000_0093.png";
+  REQUIRE(fs::exists(copy));
+  CHECK(fs::equivalent(original, copy));
+
+  // A plain rerun replaces the link rather than writing through it.
+  run_cli(plain_args);
+  auto rerun = base;
+  rerun.push_back((test_dir / "dedupe").string());
+  run_cli(rerun);
+  CHECK(!fs::equivalent(original, copy));
+  CHECK(read_output_images(test_dir / "dedupe", ".png") == plain);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI stats report per-stage counters")
+{
+  auto test_dir = create_test_dir();
+  const auto json_path = test_dir / "stats.json";
+  const auto output = run_cli(
+      {"--input", (test_dir / "TILES000.ART").string(), "--palette",
+       (test_dir / "PALETTE.DAT").string(), "--output",
+       (test_dir / "out").string(), "--stats", "--stats-json",
+       json_path.string()});
+  CHECK(output.find("tiles/s") != std::string::npos);
+  CHECK(output.find("encode") != std::string::npos);
+
+  std::ifstream file(json_path);
+  REQUIRE(file);
+  std::stringstream json;
+  json << file.rdbuf();
+  CHECK(json.str().find("\"tiles\": 256") != std::string::npos);
+  CHECK(json.str().find("\"tiles_per_second\"") != std::string::npos);
+  CHECK(json.str().find("\"encode_mb_per_second\"") != std::string::npos);
+  CHECK(json.str().find("\"load_art\": {\"calls\": 1") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI trace records per-tile spans")
+{
+  auto test_dir = create_test_dir();
+  const auto trace_path = test_dir / "trace.json";
+  run_cli({"--input", (test_dir / "TILES000.ART").string(), "--palette",
+           (test_dir / "PALETTE.DAT").string(), "--output",
+           (test_dir / "out").string(), "--jobs", "2", "--trace",
+           trace_path.string()});
+
+  std::ifstream file(trace_path);
+  REQUIRE(file);
+  std::stringstream trace;
+  trace << file.rdbuf();
+  const auto text = trace.str();
+  CHECK(text.find("\"traceEvents\"") != std::string::npos);
+  CHECK(text.find("\"name\":\"load_art\"") != std::string::npos);
+  CHECK(text.find("\"name\":\"convert\"") != std::string::npos);
+  CHECK(text.find("\"name\":\"encode\"") != std::string::npos);
+  CHECK(text.find("\"name\":\"write\"") != std::string::npos);
+  CHECK(text.find("\"tile\":90,") != std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI serve answers NDJSON jobs")
+{
+  auto test_dir = create_test_dir();
+  const auto art = (test_dir / "TILES000.ART").string();
+  const auto palette = (test_dir / "PALETTE.DAT").string();
+  const auto jobs_path = test_dir / "jobs.ndjson";
+  {
+    std::ofstream jobs(jobs_path);
+    jobs << "{\"id\":1,\"art\":\"" << art << "\",\"palette\":\"" << palette
+         << "\",\"tiles\":[0,1],\"output\":\"" << (test_dir / "out").string()
+         << "\"}\n";
+    jobs << "{\"id\":2,\"art\":\"" << art << "\",\"palette\":\"" << palette
+         << "\",\"tile\":0}\n";
+    jobs << "{\"id\":3,\"art\":\"" << art << "\",\"palette\":\"" << palette
+         << "\",\"tile\":4096}\n";
+    jobs << "not json\n";
+    jobs << "{\"id\":nan,\"tile\":0}\n";
+  }
+
+  const auto output = run_cli({"serve", "--jobs", "2"}, jobs_path);
+  INFO("serve output: " << output);
+  CHECK(output.find("{\"id\":1,\"ok\":true") != std::string::npos);
+  CHECK(output.find("TILES000_0001.png\"") != std::string::npos);
+  CHECK(fs::exists(test_dir / "out" / "TILES000_0000.png"));
+  CHECK(fs::exists(test_dir / "out" / "TILES000_0001.png"));
+  // Without an output directory the PNG comes back inline.
+  CHECK(output.find("{\"id\":2,\"ok\":true") != std::string::npos);
+  CHECK(output.find("\"data\":\"iVBORw0KGgo") != std::string::npos);
+  CHECK(output.find("{\"id\":3,\"ok\":false") != std::string::npos);
+  CHECK(output.find("{\"id\":null,\"ok\":false") != std::string::npos);
+  // nan is not JSON, so it is never echoed back as an id.
+  CHECK(output.find("\"id\":nan") == std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
+
+TEST_CASE_FIXTURE(CLITestFixture, "CLI watch reconverts changed tiles")
+{
+  auto test_dir = create_test_dir();
+  const auto art_path = test_dir / "TILES000.ART";
+  const auto log_path = test_dir / "watch.log";
+  FILE* session = open_cli(
+      {"--input", art_path.string(), "--palette",
+       (test_dir / "PALETTE.DAT").string(), "--output",
+       (test_dir / "out").string(), "--watch"},
+      log_path);
+  REQUIRE(session != nullptr);
+
+  const auto wait_for = [&](const std::string& text) {
+    for (int attempt = 0; attempt < 200; ++attempt) {
+      std::ifstream log(log_path);
+      std::ostringstream contents;
+      contents << log.rdbuf();
+      if (contents.str().find(text) != std::string::npos) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+  };
+  REQUIRE(wait_for("Watching 2 files for changes"));
+  const auto images = read_output_images(test_dir / "out", ".png");
+  REQUIRE(!images.empty());
+
+  // Rewrite the archive with one pixel of tile 0 changed: only that tile is
+  // converted again.
+  std::string art;
+  {
+    std::ifstream file(art_path, std::ios::binary);
+    std::ostringstream bytes;
+    bytes << file.rdbuf();
+    art = bytes.str();
+  }
+  std::int32_t header[4] = {};
+  std::memcpy(header, art.data(), sizeof(header));
+  const auto tiles = static_cast<std::size_t>(header[3] - header[2] + 1);
+  const auto pixels = 16 + 8 * tiles;
+  art[pixels] = static_cast<char>(art[pixels] ^ 0x11);
+  {
+    std::ofstream file(art_path, std::ios::binary | std::ios::trunc);
+    file << art;
+  }
+
+  CHECK(wait_for("(" + std::to_string(images.size() - 1) + " unchanged)"));
+  CHECK(wait_for("Updated in"));
+  pclose(session);
+
+  const auto updated = read_output_images(test_dir / "out", ".png");
+  REQUIRE(updated.size() == images.size());
+  CHECK(updated.at("TILES000_0000.png") != images.at("TILES000_0000.png"));
+  CHECK(updated.at("TILES000_0001.png") == images.at("TILES000_0001.png"));
+
+  // Reports cover one batch run, which a watch session never finishes.
+  CHECK(run_cli({"--input", art_path.string(), "--palette",
+                 (test_dir / "PALETTE.DAT").string(), "--output",
+                 (test_dir / "out").string(), "--watch", "--stats"})
+            .find("--watch cannot be combined with --stats") !=
+        std::string::npos);
+  test_helpers::cleanup_test_output_dir(test_dir);
+}
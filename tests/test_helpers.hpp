@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <doctest/doctest.h>
 #include <unistd.h>
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/palette.hpp>
 #include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <utility>
 
 namespace test_helpers {
 
@@ -69,6 +74,32 @@ inline std::filesystem::path get_test_assets_dir()
 #endif
 }
 
+/// @brief The sample archive and palette shipped in the test assets
+struct SampleAssets {
+  art2img::core::ArtArchive archive;
+  art2img::core::Palette palette;
+};
+
+/// @brief Load TILES000.ART and PALETTE.DAT from the test assets, failing
+/// the calling test if either cannot be read or parsed
+/// @return The parsed archive and palette
+inline SampleAssets load_sample_assets()
+{
+  const auto assets_dir = get_test_assets_dir();
+  auto art_data =
+      art2img::adapters::read_binary_file(assets_dir / "TILES000.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+
+  auto archive = art2img::core::load_art(std::move(*art_data));
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+  return SampleAssets{std::move(*archive), std::move(*palette)};
+}
+
 /// @brief Get integration test output directory
 /// @param test_name Name of the specific test
 /// @return Path to integration test directory
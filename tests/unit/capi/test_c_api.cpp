@@ -0,0 +1,166 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/c_api.h>
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/image.hpp>
+#include <art2img/core/palette.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+struct CAssets {
+  std::vector<std::byte> art;
+  std::vector<std::byte> palette;
+};
+
+CAssets read_assets()
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art = art2img::adapters::read_binary_file(test_assets_dir /
+                                                 "TILES000.ART");
+  REQUIRE(art.has_value());
+  auto palette = art2img::adapters::read_binary_file(test_assets_dir /
+                                                     "PALETTE.DAT");
+  REQUIRE(palette.has_value());
+  return {std::move(*art), std::move(*palette)};
+}
+
+// Opens the assets through the C API with default options.
+struct CHandles {
+  explicit CHandles(const CAssets& assets)
+  {
+    REQUIRE(art2img_archive_open(assets.art.data(), assets.art.size(),
+                                 &archive) == ART2IMG_OK);
+    art2img_palette* palette = nullptr;
+    REQUIRE(art2img_palette_open(assets.palette.data(), assets.palette.size(),
+                                 &palette) == ART2IMG_OK);
+    REQUIRE(art2img_converter_create(palette, nullptr, &converter) ==
+            ART2IMG_OK);
+    art2img_palette_close(palette);
+  }
+  CHandles(const CHandles&) = delete;
+  CHandles& operator=(const CHandles&) = delete;
+  ~CHandles()
+  {
+    art2img_converter_destroy(converter);
+    art2img_archive_close(archive);
+  }
+
+  art2img_archive* archive = nullptr;
+  art2img_converter* converter = nullptr;
+};
+
+}  // namespace
+
+TEST_CASE("C API converts tiles into caller buffers like the C++ API")
+{
+  const auto assets = read_assets();
+  const CHandles c(assets);
+  REQUIRE(art2img_archive_tile_count(c.archive) == 256);
+
+  auto archive = art2img::core::load_art(assets.art);
+  auto palette = art2img::core::load_palette(assets.palette);
+  REQUIRE(archive);
+  REQUIRE(palette);
+  const auto expected = art2img::core::palette_to_rgba(
+      *art2img::core::get_tile(*archive, 0),
+      art2img::core::view_palette(*palette), {.apply_lookup = true});
+  REQUIRE(expected);
+
+  art2img_tile_info info{};
+  REQUIRE(art2img_archive_tile_info(c.archive, 0, &info) == ART2IMG_OK);
+  CHECK(info.width == expected->width);
+  CHECK(info.height == expected->height);
+
+  std::size_t written = 0;
+  std::vector<std::uint8_t> pixels(16);
+  CHECK(art2img_convert_tile(c.converter, c.archive, 0, pixels.data(),
+                             pixels.size(),
+                             &written) == ART2IMG_ERROR_BUFFER_TOO_SMALL);
+  CHECK(written == expected->pixels.size());
+
+  pixels.resize(written);
+  REQUIRE(art2img_convert_tile(c.converter, c.archive, 0, pixels.data(),
+                               pixels.size(), &written) == ART2IMG_OK);
+  CHECK(pixels == expected->pixels);
+
+  std::size_t bound = 0;
+  REQUIRE(art2img_encoded_size(c.converter, c.archive, 0, ART2IMG_FORMAT_PNG,
+                               &bound) == ART2IMG_OK);
+  std::vector<std::byte> png(bound);
+  REQUIRE(art2img_encode_tile(c.converter, c.archive, 0, ART2IMG_FORMAT_PNG,
+                              png.data(), png.size(), &written) == ART2IMG_OK);
+  const auto encoded = art2img::core::encode_image(
+      art2img::core::make_view(*expected), art2img::core::ImageFormat::png);
+  REQUIRE(encoded);
+  png.resize(written);
+  CHECK(png == encoded->bytes);
+
+  // A short buffer reports the exact size to retry with.
+  CHECK(art2img_encode_tile(c.converter, c.archive, 0, ART2IMG_FORMAT_PNG,
+                            png.data(), png.size() - 1,
+                            &written) == ART2IMG_ERROR_BUFFER_TOO_SMALL);
+  CHECK(written == encoded->bytes.size());
+
+  CHECK(art2img_convert_tile(c.converter, c.archive, 256, pixels.data(),
+                             pixels.size(),
+                             &written) == ART2IMG_ERROR_OUT_OF_RANGE);
+  CHECK(std::strlen(art2img_last_error_message()) > 0);
+}
+
+TEST_CASE("C API batch packs tiles back to back for any thread count")
+{
+  const auto assets = read_assets();
+  const CHandles c(assets);
+
+  std::vector<std::size_t> tiles;
+  for (std::size_t tile = 0; tile < 64; ++tile) {
+    tiles.push_back(tile);
+  }
+  std::size_t size = 0;
+  REQUIRE(art2img_batch_size(c.archive, tiles.data(), tiles.size(), &size) ==
+          ART2IMG_OK);
+
+  std::vector<std::uint8_t> serial(size);
+  std::vector<std::size_t> serial_offsets(tiles.size());
+  REQUIRE(art2img_convert_tiles(c.converter, c.archive, tiles.data(),
+                                tiles.size(), serial.data(), serial.size(),
+                                serial_offsets.data(), 1) == ART2IMG_OK);
+  std::vector<std::uint8_t> parallel(size);
+  std::vector<std::size_t> parallel_offsets(tiles.size());
+  REQUIRE(art2img_convert_tiles(c.converter, c.archive, tiles.data(),
+                                tiles.size(), parallel.data(),
+                                parallel.size(), parallel_offsets.data(),
+                                4) == ART2IMG_OK);
+  CHECK(parallel_offsets == serial_offsets);
+  CHECK(parallel == serial);
+
+  // Each tile's range matches converting it on its own.
+  std::vector<std::uint8_t> single(size);
+  std::size_t written = 0;
+  for (std::size_t i = 0; i < tiles.size(); ++i) {
+    REQUIRE(art2img_convert_tile(c.converter, c.archive, tiles[i],
+                                 single.data(), single.size(),
+                                 &written) == ART2IMG_OK);
+    const auto end = i + 1 < tiles.size() ? serial_offsets[i + 1] : size;
+    REQUIRE(written == end - serial_offsets[i]);
+    CHECK(std::memcmp(single.data(), serial.data() + serial_offsets[i],
+                      written) == 0);
+  }
+
+  CHECK(art2img_convert_tiles(c.converter, c.archive, tiles.data(),
+                              tiles.size(), serial.data(), size - 1,
+                              serial_offsets.data(),
+                              1) == ART2IMG_ERROR_BUFFER_TOO_SMALL);
+}
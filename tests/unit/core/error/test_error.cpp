@@ -17,6 +17,7 @@ TEST_SUITE("error handling")
     CHECK(static_cast<int>(errc::conversion_failure) == 4);
     CHECK(static_cast<int>(errc::encoding_failure) == 5);
     CHECK(static_cast<int>(errc::unsupported) == 6);
+    CHECK(static_cast<int>(errc::buffer_too_small) == 9);
   }
 
   TEST_CASE("Error struct construction")
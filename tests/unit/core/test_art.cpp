@@ -2,7 +2,12 @@
 
 #include <art2img/adapters/io.hpp>
 #include <art2img/core/art.hpp>
+#include <algorithm>
 #include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
 
 TEST_SUITE("art module")
 {
@@ -162,4 +167,176 @@ TEST_SUITE("art module")
       }
     }
   }
-}
\ No newline at end of file
+
+  TEST_CASE("Borrowed and adopted archives view the source buffer")
+  {
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto file_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+    REQUIRE(file_data.has_value());
+
+    auto copied = art2img::core::load_art(*file_data);
+    REQUIRE(copied.has_value());
+    CHECK(copied->raw.data() != file_data->data());
+
+    SUBCASE("borrowed")
+    {
+      auto borrowed = art2img::core::load_art_borrowed(*file_data);
+      REQUIRE(borrowed.has_value());
+      CHECK(borrowed->raw.data() == file_data->data());
+      CHECK(borrowed->layout.size() == copied->layout.size());
+
+      auto tile = art2img::core::get_tile(*borrowed, 0);
+      auto reference = art2img::core::get_tile(*copied, 0);
+      REQUIRE(tile.has_value());
+      REQUIRE(reference.has_value());
+      CHECK(tile->indices.data() >= file_data->data());
+      CHECK(tile->indices.data() < file_data->data() + file_data->size());
+      CHECK(std::equal(tile->indices.begin(), tile->indices.end(),
+                       reference->indices.begin(), reference->indices.end()));
+    }
+
+    SUBCASE("adopted vector")
+    {
+      const auto* source = file_data->data();
+      auto adopted = art2img::core::load_art(std::move(*file_data));
+      REQUIRE(adopted.has_value());
+      CHECK(adopted->raw.data() == source);
+
+      auto tile = art2img::core::get_tile(*adopted, 0);
+      REQUIRE(tile.has_value());
+      CHECK(tile->valid());
+    }
+
+    SUBCASE("shared owner")
+    {
+      auto owner = std::make_shared<std::vector<std::byte>>(*file_data);
+      const std::span<const std::byte> bytes{owner->data(), owner->size()};
+      auto shared = art2img::core::load_art(owner, bytes);
+      REQUIRE(shared.has_value());
+
+      const std::weak_ptr<std::vector<std::byte>> watch = owner;
+      owner.reset();
+      CHECK(!watch.expired());
+      CHECK(shared->raw.data() == bytes.data());
+      CHECK(art2img::core::get_tile(*shared, 0).has_value());
+
+      shared = art2img::core::load_art_borrowed({});
+      CHECK(watch.expired());
+    }
+  }
+
+  TEST_CASE("Borrowed loading rejects truncated data")
+  {
+    std::vector<std::byte> small_data(10, std::byte{0});
+    CHECK(!art2img::core::load_art_borrowed(small_data).has_value());
+    CHECK(!art2img::core::load_art(std::move(small_data)).has_value());
+  }
+
+  TEST_CASE("Tile metrics carry picanm centre offsets")
+  {
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto file_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+    REQUIRE(file_data.has_value());
+    auto archive = art2img::core::load_art(*file_data);
+    REQUIRE(archive.has_value());
+
+    // Known entries from the bundled archive, including negative offsets.
+    CHECK(archive->layout[0].offset_x == 0);
+    CHECK(archive->layout[20].offset_x == 1);
+    CHECK(archive->layout[20].offset_y == 0);
+    CHECK(archive->layout[22].offset_x == 5);
+    CHECK(archive->layout[22].offset_y == -4);
+    CHECK(archive->layout[23].offset_x == -1);
+  }
+
+  TEST_CASE("write_art round-trips the bundled archive's tiles")
+  {
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto file_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+    REQUIRE(file_data.has_value());
+    auto archive = art2img::core::load_art(*file_data);
+    REQUIRE(archive.has_value());
+
+    std::vector<art2img::core::ArtTileData> tiles;
+    for (std::size_t i = 0; i < art2img::core::tile_count(*archive); ++i) {
+      art2img::core::ArtTileData tile{archive->layout[i], {}};
+      if (const auto view = art2img::core::get_tile(*archive, i)) {
+        tile.indices.assign(view->indices.begin(), view->indices.end());
+      }
+      else {
+        tile.metrics.width = 0;
+        tile.metrics.height = 0;
+      }
+      tiles.push_back(std::move(tile));
+    }
+
+    auto written = art2img::core::write_art(tiles, archive->tile_start);
+    REQUIRE(written.has_value());
+    auto reloaded = art2img::core::load_art(std::move(*written));
+    REQUIRE(reloaded.has_value());
+    CHECK(reloaded->tile_start == archive->tile_start);
+    REQUIRE(art2img::core::tile_count(*reloaded) == tiles.size());
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+      const auto& metrics = reloaded->layout[i];
+      CHECK(metrics.width == tiles[i].metrics.width);
+      CHECK(metrics.height == tiles[i].metrics.height);
+      CHECK(metrics.offset_x == tiles[i].metrics.offset_x);
+      CHECK(metrics.offset_y == tiles[i].metrics.offset_y);
+      const auto view = art2img::core::get_tile(*reloaded, i);
+      REQUIRE(view.has_value() == !tiles[i].indices.empty());
+      if (view) {
+        CHECK(std::ranges::equal(view->indices, tiles[i].indices));
+      }
+    }
+
+    tiles[0].indices.pop_back();
+    CHECK(!art2img::core::write_art(tiles).has_value());
+    CHECK(!art2img::core::write_art({}).has_value());
+  }
+
+  TEST_CASE("parse_art_layout needs only the header and tile arrays")
+  {
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto file_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+    REQUIRE(file_data.has_value());
+    auto archive = art2img::core::load_art(*file_data);
+    REQUIRE(archive.has_value());
+
+    const auto tables_size = art2img::core::art_tables_size(*file_data);
+    REQUIRE(tables_size.has_value());
+    CHECK(*tables_size == 16 + archive->layout.size() * 8);
+
+    const std::span<const std::byte> tables{file_data->data(), *tables_size};
+    auto layout = art2img::core::parse_art_layout(tables, file_data->size());
+    REQUIRE(layout.has_value());
+    CHECK(layout->tile_start == archive->tile_start);
+    REQUIRE(layout->tiles.size() == archive->layout.size());
+    CHECK(layout->tiles[22].offset_y == -4);
+    CHECK(layout->pixel_data_offset == *tables_size);
+
+    // A file too short for the pixels it declares is rejected up front.
+    CHECK(!art2img::core::parse_art_layout(tables, *tables_size + 1));
+    CHECK(!art2img::core::parse_art_layout(tables.first(20),
+                                           file_data->size()));
+  }
+}
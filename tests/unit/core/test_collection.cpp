@@ -0,0 +1,115 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/collection.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::filesystem::path> bundled_art_paths()
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  std::vector<std::filesystem::path> paths;
+  for (int i = 0; i < 20; ++i) {
+    std::string name = "TILES000.ART";
+    name[6] = static_cast<char>('0' + i / 10);
+    name[7] = static_cast<char>('0' + i % 10);
+    paths.push_back(test_assets_dir / name);
+  }
+  return paths;
+}
+
+art2img::core::ArtArchive small_archive(std::uint32_t tile_start,
+                                        std::size_t count)
+{
+  std::vector<art2img::core::ArtTileData> tiles(count);
+  for (auto& tile : tiles) {
+    tile.metrics.width = 2;
+    tile.metrics.height = 2;
+    tile.indices.assign(4, std::byte{1});
+  }
+  auto blob = art2img::core::write_art(tiles, tile_start);
+  REQUIRE(blob.has_value());
+  auto archive = art2img::core::load_art(std::move(*blob));
+  REQUIRE(archive.has_value());
+  return std::move(*archive);
+}
+
+}  // namespace
+
+TEST_CASE("ArtCollection finds every bundled tile by its number")
+{
+  auto paths = bundled_art_paths();
+  std::ranges::reverse(paths);  // the index does not rely on file order
+  auto collection = art2img::adapters::open_art_collection(paths);
+  REQUIRE(collection.has_value());
+  REQUIRE(collection->archives().size() == paths.size());
+
+  std::size_t total = 0;
+  for (std::size_t a = 0; a < collection->archives().size(); ++a) {
+    const auto& archive = collection->archives()[a];
+    total += art2img::core::tile_count(archive);
+    for (std::size_t i = 0; i < art2img::core::tile_count(archive); ++i) {
+      const auto number = archive.tile_start + static_cast<std::uint32_t>(i);
+      const auto location = collection->locate(number);
+      REQUIRE(location.has_value());
+      CHECK(location->archive == a);
+      CHECK(location->tile == i);
+      CHECK(collection->metrics(number) == &archive.layout[i]);
+
+      const auto expected = art2img::core::get_tile(archive, i);
+      const auto tile = art2img::core::get_tile(*collection, number);
+      REQUIRE(tile.has_value() == expected.has_value());
+      if (tile) {
+        CHECK(tile->indices.data() == expected->indices.data());
+      }
+    }
+  }
+  CHECK(art2img::core::tile_count(*collection) == total);
+
+  const auto numbers = collection->tile_numbers();
+  CHECK(numbers.size() == total);
+  CHECK(std::ranges::is_sorted(numbers));
+  CHECK(!collection->locate(numbers.back() + 1).has_value());
+  CHECK(collection->metrics(numbers.back() + 1) == nullptr);
+
+  const std::vector<std::filesystem::path> missing{"no_such_tiles.art"};
+  auto failed = art2img::adapters::open_art_collection(missing);
+  REQUIRE(!failed);
+  CHECK(failed.error().code == art2img::core::errc::io_failure);
+}
+
+TEST_CASE("make_art_collection keeps gaps and rejects overlaps")
+{
+  std::vector<art2img::core::ArtArchive> archives;
+  archives.push_back(small_archive(10, 2));
+  archives.push_back(small_archive(0, 3));
+  auto collection = art2img::core::make_art_collection(std::move(archives));
+  REQUIRE(collection.has_value());
+  CHECK(collection->tile_count() == 5);
+  CHECK(collection->tile_numbers() ==
+        std::vector<std::uint32_t>{0, 1, 2, 10, 11});
+  CHECK(!collection->locate(5).has_value());
+  CHECK(!collection->locate(12).has_value());
+  const auto location = collection->locate(11);
+  REQUIRE(location.has_value());
+  CHECK(location->archive == 0);
+  CHECK(location->tile == 1);
+
+  std::vector<art2img::core::ArtArchive> overlapping;
+  overlapping.push_back(small_archive(0, 3));
+  overlapping.push_back(small_archive(2, 3));
+  auto rejected = art2img::core::make_art_collection(std::move(overlapping));
+  REQUIRE(!rejected);
+  CHECK(rejected.error().code == art2img::core::errc::invalid_art);
+}
@@ -5,8 +5,12 @@
 #include <art2img/core/color_helpers.hpp>
 #include <art2img/core/convert.hpp>
 #include <art2img/core/palette.hpp>
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <utility>
+#include <vector>
 
 TEST_SUITE("convert module")
 {
@@ -647,4 +651,671 @@ TEST_CASE("Postprocess options validation")
   CHECK(!opts.apply_transparency_fix);
   CHECK(opts.premultiply_alpha);
   CHECK(opts.sanitize_matte);
-}
\ No newline at end of file
+}
+TEST_CASE("Prepared palette matches per-call conversion")
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+
+  auto archive = art2img::core::load_art(*art_data);
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+  const auto palette_view = art2img::core::view_palette(*palette);
+
+  const art2img::core::ConversionOptions variants[] = {
+      {},
+      {.fix_transparency = false},
+      {.apply_lookup = true, .shade_index = 12},
+      {.premultiply_alpha = true, .matte_hygiene = true},
+  };
+
+  for (const auto& options : variants) {
+    auto prepared = art2img::core::prepare_palette(palette_view, options);
+    REQUIRE(prepared.has_value());
+
+    for (std::size_t i = 0; i < art2img::core::tile_count(*archive); ++i) {
+      auto tile = art2img::core::get_tile(*archive, i);
+      if (!tile) {
+        continue;
+      }
+      auto direct = art2img::core::palette_to_rgba(*tile, palette_view, options);
+      auto fast = art2img::core::palette_to_rgba(*tile, *prepared);
+      REQUIRE(direct.has_value());
+      REQUIRE(fast.has_value());
+      CHECK(fast->pixels == direct->pixels);
+    }
+  }
+
+  // Index 255 is transparent only when the transparency fix is requested.
+  auto transparent = art2img::core::prepare_palette(palette_view);
+  REQUIRE(transparent.has_value());
+  CHECK(transparent->colors[255] == 0);
+  auto opaque = art2img::core::prepare_palette(
+      palette_view, {.fix_transparency = false});
+  REQUIRE(opaque.has_value());
+  std::uint8_t bytes[4] = {};
+  std::memcpy(bytes, &opaque->colors[255], sizeof(bytes));
+  CHECK(bytes[3] == 255);
+}
+
+TEST_CASE("Prepared palette applies per-tile lookups")
+{
+  art2img::core::Palette palette{};
+  for (std::size_t i = 0; i < art2img::core::palette_color_count; ++i) {
+    palette.rgb[i * 3 + 0] = static_cast<std::uint8_t>(i % 64);
+    palette.rgb[i * 3 + 1] = static_cast<std::uint8_t>((i / 4) % 64);
+    palette.rgb[i * 3 + 2] = 0;
+  }
+  const auto palette_view = art2img::core::view_palette(palette);
+
+  std::vector<std::byte> indices = {std::byte{1}, std::byte{2}, std::byte{3},
+                                    std::byte{4}};
+  std::vector<std::byte> lookup(256);
+  for (std::size_t i = 0; i < lookup.size(); ++i) {
+    lookup[i] = static_cast<std::byte>(255 - i);
+  }
+
+  art2img::core::TileView tile{};
+  tile.indices = indices;
+  tile.lookup = lookup;
+  tile.width = 2;
+  tile.height = 2;
+
+  const art2img::core::ConversionOptions options{.apply_lookup = true,
+                                                 .fix_transparency = false};
+  auto prepared = art2img::core::prepare_palette(palette_view, options);
+  REQUIRE(prepared.has_value());
+
+  auto direct = art2img::core::palette_to_rgba(tile, palette_view, options);
+  auto fast = art2img::core::palette_to_rgba(tile, *prepared);
+  REQUIRE(direct.has_value());
+  REQUIRE(fast.has_value());
+  CHECK(fast->pixels == direct->pixels);
+
+  // Column-major index 1 (x=0, y=0) is looked up to 254.
+  CHECK(fast->pixels[0] ==
+        static_cast<std::uint8_t>(((254 % 64) << 2) | ((254 % 64) >> 4)));
+}
+
+TEST_CASE("prepare_palette rejects incomplete palettes")
+{
+  art2img::core::PaletteView empty{};
+  auto prepared = art2img::core::prepare_palette(empty);
+  REQUIRE(!prepared.has_value());
+  CHECK(prepared.error().code == art2img::core::errc::invalid_palette);
+}
+
+TEST_CASE("Conversion transposes column-major tiles of any shape")
+{
+  art2img::core::Palette palette{};
+  for (std::size_t i = 0; i < art2img::core::palette_component_count; ++i) {
+    palette.rgb[i] = static_cast<std::uint8_t>((i * 7) % 64);
+  }
+  const auto palette_view = art2img::core::view_palette(palette);
+  auto prepared = art2img::core::prepare_palette(
+      palette_view, {.fix_transparency = false});
+  REQUIRE(prepared.has_value());
+
+  // Shapes straddle the transpose block size on both axes.
+  const std::pair<std::uint32_t, std::uint32_t> shapes[] = {
+      {1, 1}, {1, 40}, {40, 1}, {16, 16}, {17, 33}, {37, 53}, {64, 15}};
+  for (const auto& [width, height] : shapes) {
+    std::vector<std::byte> indices(static_cast<std::size_t>(width) * height);
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = static_cast<std::byte>((i * 31 + 7) & 0xFF);
+    }
+
+    art2img::core::TileView tile{};
+    tile.indices = indices;
+    tile.width = width;
+    tile.height = height;
+
+    auto image = art2img::core::palette_to_rgba(tile, *prepared);
+    REQUIRE(image.has_value());
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        const auto index = std::to_integer<std::uint8_t>(
+            indices[static_cast<std::size_t>(x) * height + y]);
+        std::uint32_t pixel = 0;
+        std::memcpy(&pixel,
+                    image->pixels.data() +
+                        (static_cast<std::size_t>(y) * width + x) * 4,
+                    sizeof(pixel));
+        CHECK(pixel == prepared->colors[index]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Every supported expansion kernel matches the scalar kernel")
+{
+  using art2img::core::ExpandKernel;
+
+  art2img::core::Palette palette{};
+  for (std::size_t i = 0; i < art2img::core::palette_component_count; ++i) {
+    palette.rgb[i] = static_cast<std::uint8_t>((i * 13 + 5) % 64);
+  }
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(palette), {.fix_transparency = false});
+  REQUIRE(prepared.has_value());
+
+  // 61x67 leaves remainders for every vector width and strip height.
+  constexpr std::uint32_t width = 61;
+  constexpr std::uint32_t height = 67;
+  std::vector<std::byte> indices(static_cast<std::size_t>(width) * height);
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<std::byte>((i * 151 + i / 7) & 0xFF);
+  }
+  art2img::core::TileView tile{};
+  tile.indices = indices;
+  tile.width = width;
+  tile.height = height;
+
+  REQUIRE(art2img::core::select_expand_kernel(ExpandKernel::scalar));
+  CHECK(art2img::core::active_expand_kernel() == ExpandKernel::scalar);
+  auto reference = art2img::core::palette_to_rgba(tile, *prepared);
+  REQUIRE(reference.has_value());
+
+  for (auto kernel : {ExpandKernel::avx2, ExpandKernel::neon}) {
+    if (!art2img::core::select_expand_kernel(kernel)) {
+      continue;
+    }
+    INFO("kernel: " << art2img::core::expand_kernel_name(kernel));
+    auto image = art2img::core::palette_to_rgba(tile, *prepared);
+    REQUIRE(image.has_value());
+    CHECK(image->pixels == reference->pixels);
+  }
+
+  art2img::core::reset_expand_kernel();
+  CHECK(!art2img::core::expand_kernel_name(art2img::core::active_expand_kernel())
+             .empty());
+}
+
+TEST_CASE("residual_postprocess output matches the full postprocess chain")
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+  auto archive = art2img::core::load_art(*art_data);
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+  const auto palette_view = art2img::core::view_palette(*palette);
+
+  for (int conversion_bits = 0; conversion_bits < 8; ++conversion_bits) {
+    art2img::core::ConversionOptions conversion{};
+    conversion.fix_transparency = (conversion_bits & 1) != 0;
+    conversion.matte_hygiene = (conversion_bits & 2) != 0;
+    conversion.premultiply_alpha = (conversion_bits & 4) != 0;
+
+    for (int post_bits = 0; post_bits < 8; ++post_bits) {
+      art2img::core::PostprocessOptions post{};
+      post.apply_transparency_fix = (post_bits & 1) != 0;
+      post.sanitize_matte = (post_bits & 2) != 0;
+      post.premultiply_alpha = (post_bits & 4) != 0;
+      const auto residual = art2img::core::residual_postprocess(conversion, post);
+
+      for (std::size_t tile_index : {0u, 3u, 42u, 58u}) {
+        auto tile = art2img::core::get_tile(*archive, tile_index);
+        REQUIRE(tile.has_value());
+        auto full = art2img::core::palette_to_rgba(*tile, palette_view, conversion);
+        REQUIRE(full.has_value());
+        auto trimmed = *full;
+        art2img::core::postprocess_rgba(*full, post);
+        art2img::core::postprocess_rgba(trimmed, residual);
+        CHECK(trimmed.pixels == full->pixels);
+      }
+    }
+  }
+
+  // Default batch settings need no second sweep at all.
+  const auto defaults = art2img::core::residual_postprocess({}, {});
+  CHECK(!defaults.apply_transparency_fix);
+  CHECK(!defaults.sanitize_matte);
+  CHECK(!defaults.premultiply_alpha);
+}
+
+namespace {
+
+// Straightforward three-plane matte filter used as the reference for the
+// rolling implementation.
+void reference_matte(std::vector<std::uint8_t>& pixels,
+                     std::uint32_t width,
+                     std::uint32_t height)
+{
+  if (width < 3 || height < 3) {
+    return;
+  }
+  const std::size_t count = static_cast<std::size_t>(width) * height;
+  std::vector<std::uint8_t> alpha(count, 0);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i * 4 + 3 < pixels.size()) {
+      alpha[i] = pixels[i * 4 + 3];
+    }
+  }
+  std::vector<std::uint8_t> eroded = alpha;
+  for (std::uint32_t y = 1; y + 1 < height; ++y) {
+    for (std::uint32_t x = 1; x + 1 < width; ++x) {
+      const std::size_t i = static_cast<std::size_t>(y) * width + x;
+      if (alpha[i] != 0) {
+        eroded[i] = std::min({alpha[i - width], alpha[i + width],
+                              alpha[i - 1], alpha[i + 1]});
+      }
+    }
+  }
+  std::vector<std::uint8_t> blurred = eroded;
+  for (std::uint32_t y = 1; y + 1 < height; ++y) {
+    for (std::uint32_t x = 1; x + 1 < width; ++x) {
+      std::uint32_t sum = 0;
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          sum += eroded[static_cast<std::size_t>(y + dy) * width + (x + dx)];
+        }
+      }
+      blurred[static_cast<std::size_t>(y) * width + x] =
+          static_cast<std::uint8_t>(sum / 9);
+    }
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i * 4 + 3 < pixels.size()) {
+      pixels[i * 4 + 3] = blurred[i];
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Matte hygiene matches the three-plane reference filter")
+{
+  art2img::core::ConversionWorkspace workspace{};
+  const std::pair<std::uint32_t, std::uint32_t> shapes[] = {
+      {3, 3}, {4, 7}, {31, 5}, {64, 64}, {257, 13}, {2, 9}};
+
+  std::uint32_t seed = 12345;
+  auto next = [&seed]() {
+    seed = seed * 1103515245u + 12345u;
+    return static_cast<std::uint8_t>(seed >> 16);
+  };
+
+  for (const auto& [width, height] : shapes) {
+    art2img::core::RgbaImage image{};
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<std::size_t>(width) * height * 4);
+    for (std::size_t i = 0; i < image.pixels.size(); ++i) {
+      const auto value = next();
+      // Plenty of fully transparent and fully opaque alpha.
+      image.pixels[i] = (i % 4 == 3 && value < 64)    ? 0
+                        : (i % 4 == 3 && value > 192) ? 255
+                                                      : value;
+    }
+
+    auto expected = image.pixels;
+    reference_matte(expected, width, height);
+
+    auto actual = image;
+    art2img::core::postprocess_rgba(
+        actual, {.apply_transparency_fix = false, .sanitize_matte = true},
+        workspace);
+    CHECK(actual.pixels == expected);
+  }
+
+  // Buffers shorter than width * height treat missing alpha as zero.
+  art2img::core::RgbaImage short_image{};
+  short_image.width = 5;
+  short_image.height = 5;
+  short_image.pixels.assign(5 * 4 * 4 + 2, 200);
+  auto expected = short_image.pixels;
+  reference_matte(expected, 5, 5);
+  art2img::core::postprocess_rgba(
+      short_image, {.apply_transparency_fix = false, .sanitize_matte = true},
+      workspace);
+  CHECK(short_image.pixels == expected);
+}
+
+TEST_CASE("Every fused matte kernel matches the separate passes")
+{
+  art2img::core::ConversionWorkspace workspace{};
+  std::uint32_t seed = 777;
+  auto next = [&seed]() {
+    seed = seed * 1103515245u + 12345u;
+    return static_cast<std::uint8_t>(seed >> 16);
+  };
+
+  for (const auto& [width, height] :
+       {std::pair<std::uint32_t, std::uint32_t>{3, 3}, {17, 9}, {64, 33}}) {
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * height *
+                                     4);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      const auto value = next();
+      pixels[i] = (i % 4 == 3 && value < 80) ? 0 : value;
+    }
+
+    for (const bool clean : {false, true}) {
+      for (const bool premultiply : {false, true}) {
+        INFO(width << "x" << height << " clean=" << clean
+                    << " premultiply=" << premultiply);
+        auto expected = pixels;
+        art2img::core::postprocess_rgba(
+            expected, width, height,
+            {.apply_transparency_fix = clean, .premultiply_alpha = false},
+            workspace);
+        art2img::core::postprocess_rgba(
+            expected, width, height,
+            {.apply_transparency_fix = false, .sanitize_matte = true},
+            workspace);
+        art2img::core::postprocess_rgba(
+            expected, width, height,
+            {.apply_transparency_fix = false,
+             .premultiply_alpha = premultiply},
+            workspace);
+
+        auto fused = pixels;
+        art2img::core::postprocess_rgba(
+            fused, width, height,
+            {.apply_transparency_fix = clean,
+             .premultiply_alpha = premultiply,
+             .sanitize_matte = true},
+            workspace);
+        CHECK(fused == expected);
+      }
+    }
+  }
+}
+
+TEST_CASE("palette_to_rgba_into writes caller-provided buffers")
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+  auto archive = art2img::core::load_art(*art_data);
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+  const auto palette_view = art2img::core::view_palette(*palette);
+
+  const art2img::core::ConversionOptions options{.matte_hygiene = true};
+  auto prepared = art2img::core::prepare_palette(palette_view, options);
+  REQUIRE(prepared.has_value());
+
+  art2img::core::ConversionWorkspace workspace{};
+  const std::uint8_t* first_buffer = nullptr;
+  for (std::size_t index : {58u, 0u, 3u}) {
+    auto tile = art2img::core::get_tile(*archive, index);
+    REQUIRE(tile.has_value());
+    const auto bytes = static_cast<std::size_t>(tile->width) * tile->height * 4;
+
+    auto expected = art2img::core::palette_to_rgba(*tile, palette_view, options);
+    REQUIRE(expected.has_value());
+
+    // Tile 58 is the largest, so later tiles reuse its buffer.
+    auto pixels = workspace.pixel_buffer(bytes);
+    if (first_buffer == nullptr) {
+      first_buffer = pixels.data();
+    }
+    CHECK(pixels.data() == first_buffer);
+    REQUIRE(art2img::core::palette_to_rgba_into(*tile, *prepared, pixels,
+                                                workspace));
+    CHECK(std::equal(pixels.begin(), pixels.end(), expected->pixels.begin(),
+                     expected->pixels.end()));
+
+    // Oversized buffers keep their tail untouched.
+    std::vector<std::uint8_t> oversized(bytes + 8, 0xAB);
+    REQUIRE(art2img::core::palette_to_rgba_into(*tile, palette_view, options,
+                                                oversized));
+    CHECK(std::equal(oversized.begin(), oversized.begin() + bytes,
+                     expected->pixels.begin()));
+    CHECK(oversized[bytes] == 0xAB);
+    CHECK(oversized.back() == 0xAB);
+
+    std::vector<std::uint8_t> small(bytes - 1);
+    auto rejected = art2img::core::palette_to_rgba_into(*tile, palette_view,
+                                                        options, small);
+    REQUIRE(!rejected);
+    CHECK(rejected.error().code == art2img::core::errc::conversion_failure);
+  }
+}
+
+TEST_CASE("palette_to_indices_into pairs with the prepared colour table")
+{
+  art2img::core::Palette palette{};
+  for (std::size_t i = 0; i < art2img::core::palette_component_count; ++i) {
+    palette.rgb[i] = static_cast<std::uint8_t>((i * 5) % 64);
+  }
+  const auto palette_view = art2img::core::view_palette(palette);
+
+  std::vector<std::byte> indices(static_cast<std::size_t>(19) * 23);
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<std::byte>((i * 13 + 1) & 0xFF);
+  }
+  std::vector<std::byte> lookup(256);
+  for (std::size_t i = 0; i < lookup.size(); ++i) {
+    lookup[i] = static_cast<std::byte>((i + 3) & 0xFF);
+  }
+
+  art2img::core::TileView tile{};
+  tile.indices = indices;
+  tile.lookup = lookup;
+  tile.width = 19;
+  tile.height = 23;
+
+  for (const bool apply_lookup : {false, true}) {
+    const art2img::core::ConversionOptions options{.apply_lookup =
+                                                       apply_lookup};
+    auto prepared = art2img::core::prepare_palette(palette_view, options);
+    REQUIRE(prepared.has_value());
+    auto expected = art2img::core::palette_to_rgba(tile, *prepared);
+    REQUIRE(expected.has_value());
+
+    std::vector<std::uint8_t> out(indices.size());
+    REQUIRE(art2img::core::palette_to_indices_into(tile, *prepared, out));
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      std::uint32_t pixel = 0;
+      std::memcpy(&pixel, expected->pixels.data() + i * 4, sizeof(pixel));
+      CHECK(prepared->colors[out[i]] == pixel);
+    }
+  }
+
+  auto matte = art2img::core::prepare_palette(palette_view,
+                                              {.matte_hygiene = true});
+  REQUIRE(matte.has_value());
+  std::vector<std::uint8_t> out(indices.size());
+  auto rejected = art2img::core::palette_to_indices_into(tile, *matte, out);
+  REQUIRE(!rejected);
+  CHECK(rejected.error().code == art2img::core::errc::unsupported);
+}
+
+TEST_CASE("palette_to_rgba_variants matches one conversion per variant")
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "TILES000.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+  auto archive = art2img::core::load_art(*art_data);
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+  const auto palette_view = art2img::core::view_palette(*palette);
+
+  // Shades, a lookup swap and a matte variant rendered side by side.
+  const std::vector<art2img::core::ConversionOptions> options{
+      {},
+      {.shade_index = 8},
+      {.shade_index = 24},
+      {.apply_lookup = true, .shade_index = 4},
+      {.matte_hygiene = true},
+      {.premultiply_alpha = true, .matte_hygiene = true}};
+  std::vector<art2img::core::PreparedPalette> prepared;
+  for (const auto& option : options) {
+    auto variant = art2img::core::prepare_palette(palette_view, option);
+    REQUIRE(variant.has_value());
+    prepared.push_back(*variant);
+  }
+
+  art2img::core::ConversionWorkspace workspace{};
+  for (std::size_t index : {58u, 0u, 3u}) {
+    auto tile = art2img::core::get_tile(*archive, index);
+    REQUIRE(tile.has_value());
+    const auto bytes = static_cast<std::size_t>(tile->width) * tile->height * 4;
+
+    std::vector<std::vector<std::uint8_t>> outputs(
+        prepared.size(), std::vector<std::uint8_t>(bytes));
+    std::vector<art2img::core::RenderVariant> variants;
+    for (std::size_t v = 0; v < prepared.size(); ++v) {
+      variants.push_back({&prepared[v], outputs[v]});
+    }
+    REQUIRE(art2img::core::palette_to_rgba_variants(*tile, variants,
+                                                    workspace));
+
+    for (std::size_t v = 0; v < prepared.size(); ++v) {
+      INFO(v);
+      auto expected = art2img::core::palette_to_rgba(*tile, prepared[v]);
+      REQUIRE(expected.has_value());
+      CHECK(outputs[v] == expected->pixels);
+    }
+  }
+
+  auto tile = art2img::core::get_tile(*archive, 0);
+  REQUIRE(tile.has_value());
+  std::vector<std::uint8_t> small(4);
+  const art2img::core::RenderVariant too_small{&prepared[0], small};
+  auto rejected = art2img::core::palette_to_rgba_variants(
+      *tile, std::span{&too_small, 1}, workspace);
+  REQUIRE(!rejected);
+  CHECK(rejected.error().code == art2img::core::errc::conversion_failure);
+}
+
+TEST_CASE("opaque_bounds matches the alpha of the converted tile")
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto art_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "TILES002.ART");
+  REQUIRE(art_data.has_value());
+  auto palette_data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(palette_data.has_value());
+  auto archive = art2img::core::load_art(*art_data);
+  REQUIRE(archive.has_value());
+  auto palette = art2img::core::load_palette(*palette_data);
+  REQUIRE(palette.has_value());
+
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(*palette), {.apply_lookup = true});
+  REQUIRE(prepared.has_value());
+
+  std::size_t trimmed = 0;
+  for (std::size_t i = 0; i < art2img::core::tile_count(*archive); ++i) {
+    auto tile = art2img::core::get_tile(*archive, i);
+    if (!tile) {
+      continue;
+    }
+    auto image = art2img::core::palette_to_rgba(*tile, *prepared);
+    REQUIRE(image.has_value());
+
+    art2img::core::ImageRect expected{tile->width, tile->height, 0, 0};
+    std::uint32_t right = 0;
+    std::uint32_t bottom = 0;
+    for (std::uint32_t y = 0; y < image->height; ++y) {
+      for (std::uint32_t x = 0; x < image->width; ++x) {
+        if (image->pixels[(static_cast<std::size_t>(y) * image->width + x) *
+                              4 +
+                          3] != 0) {
+          expected.x = std::min(expected.x, x);
+          expected.y = std::min(expected.y, y);
+          right = std::max(right, x + 1);
+          bottom = std::max(bottom, y + 1);
+        }
+      }
+    }
+
+    const auto bounds = art2img::core::opaque_bounds(*tile, *prepared);
+    if (right == 0) {
+      CHECK(bounds.empty());
+      continue;
+    }
+    CHECK(bounds.x == expected.x);
+    CHECK(bounds.y == expected.y);
+    CHECK(bounds.width == right - expected.x);
+    CHECK(bounds.height == bottom - expected.y);
+    if (bounds.width < tile->width || bounds.height < tile->height) {
+      ++trimmed;
+    }
+  }
+  CHECK(trimmed > 0);
+}
+
+TEST_CASE("opaque_bounds follows the tile lookup and handles empty tiles")
+{
+  art2img::core::Palette palette{};
+  auto prepared = art2img::core::prepare_palette(
+      art2img::core::view_palette(palette), {.apply_lookup = true});
+  REQUIRE(prepared.has_value());
+
+  // 4x3, column-major: index 7 at (1, 0) and index 9 at (2, 2).
+  std::vector<std::byte> indices(12, std::byte{255});
+  indices[1 * 3 + 0] = std::byte{7};
+  indices[2 * 3 + 2] = std::byte{9};
+  art2img::core::TileView tile{};
+  tile.indices = indices;
+  tile.width = 4;
+  tile.height = 3;
+
+  auto bounds = art2img::core::opaque_bounds(tile, *prepared);
+  CHECK(bounds.x == 1);
+  CHECK(bounds.y == 0);
+  CHECK(bounds.width == 2);
+  CHECK(bounds.height == 3);
+
+  // A lookup sending 9 to the transparent index leaves only (1, 0).
+  std::vector<std::byte> lookup(256);
+  for (std::size_t i = 0; i < lookup.size(); ++i) {
+    lookup[i] = static_cast<std::byte>(i);
+  }
+  lookup[9] = std::byte{255};
+  tile.lookup = lookup;
+  bounds = art2img::core::opaque_bounds(tile, *prepared);
+  CHECK(bounds.x == 1);
+  CHECK(bounds.y == 0);
+  CHECK(bounds.width == 1);
+  CHECK(bounds.height == 1);
+
+  lookup[7] = std::byte{255};
+  CHECK(art2img::core::opaque_bounds(tile, *prepared).empty());
+}
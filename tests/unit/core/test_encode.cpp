@@ -5,7 +5,16 @@
 #include <art2img/core/convert.hpp>
 #include <art2img/core/encode.hpp>
 #include <art2img/core/palette.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
 
 TEST_SUITE("encode module")
 {
@@ -283,6 +292,10 @@ TEST_SUITE("encode module")
           "tga");
     CHECK(art2img::core::file_extension(art2img::core::ImageFormat::bmp) ==
           "bmp");
+    CHECK(art2img::core::file_extension(art2img::core::ImageFormat::dds) ==
+          "dds");
+    CHECK(art2img::core::file_extension(art2img::core::ImageFormat::qoi) ==
+          "qoi");
   }
 
   TEST_CASE("Encoded image structure validation")
@@ -337,4 +350,784 @@ TEST_SUITE("encode module")
       CHECK(encoded->bytes.size() > 8);  // At least some minimal header
     }
   }
-}
\ No newline at end of file
+
+  TEST_CASE("Sink and caller-buffer encodes match encode_image")
+  {
+    std::vector<std::uint8_t> pixels(7 * 5 * 4);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      pixels[i] = static_cast<std::uint8_t>(i * 37);
+    }
+    const art2img::core::RgbaImageView view{pixels, 7, 5, 7 * 4};
+
+    for (const auto format :
+         {art2img::core::ImageFormat::png, art2img::core::ImageFormat::tga,
+          art2img::core::ImageFormat::bmp}) {
+      for (const auto depth :
+           {art2img::core::BitDepth::auto_detect,
+            art2img::core::BitDepth::bpp24}) {
+        const art2img::core::EncoderOptions options{.bit_depth = depth};
+        auto encoded = art2img::core::encode_image(view, format, options);
+        REQUIRE(encoded.has_value());
+        CHECK(encoded->bytes.size() <=
+              art2img::core::estimate_encoded_size(view, format, options));
+
+        std::vector<std::byte> streamed;
+        std::size_t chunks = 0;
+        auto written = art2img::core::encode_image_to(
+            view, format,
+            [&](std::span<const std::byte> chunk) {
+              ++chunks;
+              streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+              return true;
+            },
+            options);
+        REQUIRE(written.has_value());
+        CHECK(chunks > 0);
+        CHECK(*written == streamed.size());
+        CHECK(streamed == encoded->bytes);
+
+        std::vector<std::byte> buffer(
+            art2img::core::estimate_encoded_size(view, format, options));
+        auto used =
+            art2img::core::encode_image_into(view, format, buffer, options);
+        REQUIRE(used.has_value());
+        REQUIRE(*used == encoded->bytes.size());
+        CHECK(std::equal(encoded->bytes.begin(), encoded->bytes.end(),
+                         buffer.begin()));
+
+        std::vector<std::byte> small(encoded->bytes.size() - 1);
+        std::size_t required = 0;
+        auto overflow = art2img::core::encode_image_into(view, format, small,
+                                                         options, &required);
+        REQUIRE(!overflow.has_value());
+        CHECK(overflow.error().code == art2img::core::errc::buffer_too_small);
+        CHECK(required == encoded->bytes.size());
+      }
+    }
+  }
+
+  TEST_CASE("Strided views encode like their contiguous pixels")
+  {
+    // A 5x3 sub-rectangle of a 9-wide atlas, at column 2.
+    constexpr std::uint32_t width = 5;
+    constexpr std::uint32_t height = 3;
+    constexpr std::uint32_t atlas_stride = 9 * 4;
+    std::vector<std::uint8_t> atlas(atlas_stride * height);
+    for (std::size_t i = 0; i < atlas.size(); ++i) {
+      atlas[i] = static_cast<std::uint8_t>(i * 29 + 3);
+    }
+    std::vector<std::uint8_t> packed(width * height * 4);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      std::memcpy(packed.data() + y * width * 4,
+                  atlas.data() + y * atlas_stride + 2 * 4, width * 4);
+    }
+    const art2img::core::RgbaImageView strided{
+        std::span<const std::uint8_t>(atlas).subspan(2 * 4), width, height,
+        atlas_stride};
+    const art2img::core::RgbaImageView contiguous{packed, width, height,
+                                                   width * 4};
+
+    for (const auto format :
+         {art2img::core::ImageFormat::png, art2img::core::ImageFormat::tga,
+          art2img::core::ImageFormat::bmp, art2img::core::ImageFormat::qoi}) {
+      for (const auto depth : {art2img::core::BitDepth::bpp24,
+                               art2img::core::BitDepth::bpp32}) {
+        for (const auto preset : {art2img::core::CompressionPreset::balanced,
+                                  art2img::core::CompressionPreset::fast}) {
+          const art2img::core::EncoderOptions options{.compression = preset,
+                                                      .bit_depth = depth};
+          auto a = art2img::core::encode_image(strided, format, options);
+          auto b = art2img::core::encode_image(contiguous, format, options);
+          REQUIRE(a.has_value());
+          REQUIRE(b.has_value());
+          CHECK(a->bytes == b->bytes);
+        }
+      }
+    }
+
+    // Uncompressed TGA and 32-bit BMP store BGRA bottom-up.
+    auto tga = art2img::core::encode_image(
+        strided, art2img::core::ImageFormat::tga,
+        {.bit_depth = art2img::core::BitDepth::bpp32, .tga_rle = false});
+    REQUIRE(tga.has_value());
+    REQUIRE(tga->bytes.size() == 18 + packed.size());
+    CHECK(std::to_integer<int>(tga->bytes[2]) == 2);
+    CHECK(std::to_integer<int>(tga->bytes[16]) == 32);
+    auto bmp = art2img::core::encode_image(
+        strided, art2img::core::ImageFormat::bmp,
+        {.bit_depth = art2img::core::BitDepth::bpp32});
+    REQUIRE(bmp.has_value());
+    REQUIRE(bmp->bytes.size() == 122 + packed.size());
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        const auto* px = packed.data() + ((height - 1 - y) * width + x) * 4;
+        const std::size_t at = (y * width + x) * 4;
+        for (const auto& [bytes, offset] :
+             {std::pair{&tga->bytes, std::size_t{18}},
+              std::pair{&bmp->bytes, std::size_t{122}}}) {
+          CHECK(std::to_integer<int>((*bytes)[offset + at]) == px[2]);
+          CHECK(std::to_integer<int>((*bytes)[offset + at + 1]) == px[1]);
+          CHECK(std::to_integer<int>((*bytes)[offset + at + 2]) == px[0]);
+          CHECK(std::to_integer<int>((*bytes)[offset + at + 3]) == px[3]);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("crop_view encodes a sub-rectangle without copying")
+  {
+    constexpr std::uint32_t width = 7;
+    constexpr std::uint32_t height = 5;
+    std::vector<std::uint8_t> indices(width * height);
+    std::vector<std::uint8_t> pixels(width * height * 4);
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = static_cast<std::uint8_t>(i % 4);
+      for (std::size_t c = 0; c < 4; ++c) {
+        pixels[i * 4 + c] = static_cast<std::uint8_t>(i * 7 + c * 50);
+      }
+    }
+    const std::array<std::uint32_t, 4> colors{0xFF0000FFu, 0xFF00FF00u,
+                                              0xFFFF0000u, 0x00000000u};
+
+    // The bottom-right 3x2 corner, whose last row ends the buffer.
+    const art2img::core::ImageRect rect{4, 3, 3, 2};
+    std::vector<std::uint8_t> packed_indices;
+    std::vector<std::uint8_t> packed_pixels;
+    for (std::uint32_t y = rect.y; y < rect.y + rect.height; ++y) {
+      for (std::uint32_t x = rect.x; x < rect.x + rect.width; ++x) {
+        packed_indices.push_back(indices[y * width + x]);
+        for (std::size_t c = 0; c < 4; ++c) {
+          packed_pixels.push_back(pixels[(y * width + x) * 4 + c]);
+        }
+      }
+    }
+
+    const auto indexed = art2img::core::crop_view(
+        art2img::core::IndexedImageView{indices, colors, width, height, width},
+        rect);
+    const auto rgba = art2img::core::crop_view(
+        art2img::core::RgbaImageView{pixels, width, height, width * 4}, rect);
+    REQUIRE(indexed.valid());
+    REQUIRE(rgba.valid());
+    CHECK(indexed.indices.data() == indices.data() + 3 * width + 4);
+    CHECK(rgba.pixels.data() == pixels.data() + (3 * width + 4) * 4);
+
+    for (const auto format :
+         {art2img::core::ImageFormat::png, art2img::core::ImageFormat::tga,
+          art2img::core::ImageFormat::bmp}) {
+      auto a = art2img::core::encode_indexed_image(indexed, format);
+      auto b = art2img::core::encode_indexed_image(
+          {packed_indices, colors, rect.width, rect.height, rect.width},
+          format);
+      REQUIRE(a.has_value());
+      REQUIRE(b.has_value());
+      CHECK(a->bytes == b->bytes);
+
+      auto c = art2img::core::encode_image(rgba, format);
+      auto d = art2img::core::encode_image(
+          {packed_pixels, rect.width, rect.height, rect.width * 4}, format);
+      REQUIRE(c.has_value());
+      REQUIRE(d.has_value());
+      CHECK(c->bytes == d->bytes);
+    }
+  }
+
+  TEST_CASE("auto_detect drops alpha only when every pixel is opaque")
+  {
+    // 19 pixels per row exercises both the vector scan and its tail.
+    constexpr std::uint32_t width = 19;
+    constexpr std::uint32_t height = 4;
+    std::vector<std::uint8_t> pixels(width * height * 4, 0x55);
+    for (std::size_t i = 3; i < pixels.size(); i += 4) {
+      pixels[i] = 255;
+    }
+    const art2img::core::RgbaImageView view{pixels, width, height, width * 4};
+
+    auto channels = [&](art2img::core::ImageFormat format) {
+      auto encoded = art2img::core::encode_image(view, format);
+      REQUIRE(encoded.has_value());
+      switch (format) {
+        case art2img::core::ImageFormat::png:
+          return std::to_integer<int>(encoded->bytes[25]) == 6 ? 4 : 3;
+        case art2img::core::ImageFormat::tga:
+          return std::to_integer<int>(encoded->bytes[16]) / 8;
+        case art2img::core::ImageFormat::bmp:
+          return std::to_integer<int>(encoded->bytes[28]) / 8;
+        default:
+          return std::to_integer<int>(encoded->bytes[12]);
+      }
+    };
+    const std::array formats{
+        art2img::core::ImageFormat::png, art2img::core::ImageFormat::tga,
+        art2img::core::ImageFormat::bmp, art2img::core::ImageFormat::qoi};
+    for (const auto format : formats) {
+      CHECK(channels(format) == 3);
+    }
+    for (const std::size_t pixel : {std::size_t{0}, std::size_t{17},
+                                    std::size_t{width * height - 1}}) {
+      pixels[pixel * 4 + 3] = 254;
+      for (const auto format : formats) {
+        CHECK(channels(format) == 4);
+      }
+      pixels[pixel * 4 + 3] = 255;
+    }
+  }
+
+  TEST_CASE("Encode aborts when the sink rejects output")
+  {
+    std::vector<std::uint8_t> pixels(4 * 4 * 4, 0x80);
+    const art2img::core::RgbaImageView view{pixels, 4, 4, 4 * 4};
+
+    auto rejected = art2img::core::encode_image_to(
+        view, art2img::core::ImageFormat::tga,
+        [](std::span<const std::byte>) { return false; });
+    REQUIRE(!rejected.has_value());
+    CHECK(rejected.error().code == art2img::core::errc::encoding_failure);
+
+    auto empty = art2img::core::encode_image_to(
+        view, art2img::core::ImageFormat::png, art2img::core::EncodeSink{});
+    CHECK(!empty.has_value());
+  }
+
+  TEST_CASE("Indexed PNG carries the palette and transparency chunks")
+  {
+    std::array<std::uint32_t, 256> colors{};
+    for (std::size_t i = 0; i < colors.size(); ++i) {
+      const std::uint8_t rgba[4] = {static_cast<std::uint8_t>(i),
+                                    static_cast<std::uint8_t>(255 - i), 7,
+                                    static_cast<std::uint8_t>(i == 255 ? 0
+                                                                       : 255)};
+      std::memcpy(&colors[i], rgba, sizeof(rgba));
+    }
+    std::vector<std::uint8_t> indices(6 * 3 + 2);  // stride 6, width 5
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = static_cast<std::uint8_t>(i * 40);
+    }
+    const art2img::core::IndexedImageView view{indices, colors, 5, 3, 6};
+
+    auto encoded = art2img::core::encode_indexed_image(
+        view, art2img::core::ImageFormat::png);
+    REQUIRE(encoded.has_value());
+    const auto& bytes = encoded->bytes;
+    auto u8 = [&](std::size_t at) { return std::to_integer<int>(bytes[at]); };
+    auto be32 = [&](std::size_t at) {
+      return static_cast<std::uint32_t>(u8(at) << 24 | u8(at + 1) << 16 |
+                                        u8(at + 2) << 8 | u8(at + 3));
+    };
+    REQUIRE(bytes.size() > 8);
+    CHECK(u8(1) == 'P');
+
+    // Walk the chunk list after the signature.
+    std::vector<std::string> types;
+    std::size_t at = 8;
+    while (at + 12 <= bytes.size()) {
+      const auto length = be32(at);
+      const std::string type(reinterpret_cast<const char*>(&bytes[at + 4]), 4);
+      types.push_back(type);
+      if (type == "IHDR") {
+        CHECK(be32(at + 8) == 5);
+        CHECK(be32(at + 12) == 3);
+        CHECK(u8(at + 16) == 8);
+        CHECK(u8(at + 17) == 3);
+      }
+      if (type == "PLTE") {
+        CHECK(length == 256 * 3);
+        CHECK(u8(at + 8 + 10 * 3) == 10);
+        CHECK(u8(at + 8 + 10 * 3 + 1) == 245);
+      }
+      if (type == "tRNS") {
+        CHECK(length == 256);
+        CHECK(u8(at + 8) == 255);
+        CHECK(u8(at + 8 + 255) == 0);
+      }
+      at += 12 + length;
+    }
+    CHECK(at == bytes.size());
+    CHECK(types == std::vector<std::string>{"IHDR", "PLTE", "tRNS", "IDAT",
+                                            "IEND"});
+
+    // Fully opaque palettes drop tRNS.
+    for (auto& color : colors) {
+      std::uint8_t rgba[4];
+      std::memcpy(rgba, &color, sizeof(rgba));
+      rgba[3] = 255;
+      std::memcpy(&color, rgba, sizeof(rgba));
+    }
+    auto opaque = art2img::core::encode_indexed_image(
+        view, art2img::core::ImageFormat::png);
+    REQUIRE(opaque.has_value());
+    CHECK(opaque->bytes.size() < encoded->bytes.size());
+
+    const art2img::core::IndexedImageView invalid{indices, {}, 5, 3, 6};
+    CHECK(!art2img::core::encode_indexed_image(
+                 invalid, art2img::core::ImageFormat::png).has_value());
+  }
+
+  TEST_CASE("Every compression preset writes a well-formed PNG")
+  {
+    std::vector<std::uint8_t> pixels(33 * 17 * 4);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      pixels[i] = static_cast<std::uint8_t>((i / 4) % 11 * 23 + i % 4);
+    }
+    const art2img::core::RgbaImageView view{pixels, 33, 17, 33 * 4};
+
+    for (const auto preset : {art2img::core::CompressionPreset::balanced,
+                              art2img::core::CompressionPreset::fast,
+                              art2img::core::CompressionPreset::smallest}) {
+      for (const auto depth : {art2img::core::BitDepth::auto_detect,
+                               art2img::core::BitDepth::bpp24}) {
+        const art2img::core::EncoderOptions options{.compression = preset,
+                                                    .bit_depth = depth};
+        auto encoded = art2img::core::encode_image(
+            view, art2img::core::ImageFormat::png, options);
+        REQUIRE(encoded.has_value());
+        const auto& bytes = encoded->bytes;
+        REQUIRE(bytes.size() > 33);
+        CHECK(std::to_integer<int>(bytes[1]) == 'P');
+        CHECK(std::to_integer<int>(bytes[19]) == 33);  // IHDR width
+        CHECK(std::to_integer<int>(bytes[23]) == 17);  // IHDR height
+        CHECK(std::to_integer<int>(bytes[25]) ==
+              (depth == art2img::core::BitDepth::bpp24 ? 2 : 6));
+        const std::string tail(
+            reinterpret_cast<const char*>(&bytes[bytes.size() - 8]), 4);
+        CHECK(tail == "IEND");
+      }
+    }
+  }
+
+  TEST_CASE("PNG of incompressible pixels stays within the estimate")
+  {
+    // Noise defeats deflate, so the encoder has to store it instead.
+    std::vector<std::uint8_t> pixels(96 * 80 * 4);
+    std::uint32_t state = 0x9E3779B9u;
+    for (auto& byte : pixels) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      byte = static_cast<std::uint8_t>(state >> 24);
+    }
+    const art2img::core::RgbaImageView view{pixels, 96, 80, 96 * 4};
+    std::array<std::uint32_t, 256> colors{};
+    const art2img::core::IndexedImageView indexed{
+        std::span<const std::uint8_t>(pixels).first(96 * 80), colors, 96, 80,
+        96};
+
+    for (const auto preset : {art2img::core::CompressionPreset::balanced,
+                              art2img::core::CompressionPreset::fast,
+                              art2img::core::CompressionPreset::smallest}) {
+      const art2img::core::EncoderOptions options{.compression = preset};
+      std::vector<std::byte> buffer(art2img::core::estimate_encoded_size(
+          view, art2img::core::ImageFormat::png, options));
+      CHECK(art2img::core::encode_image_into(
+                view, art2img::core::ImageFormat::png, buffer, options)
+                .has_value());
+
+      auto encoded = art2img::core::encode_indexed_image(
+          indexed, art2img::core::ImageFormat::png, options);
+      REQUIRE(encoded.has_value());
+      CHECK(encoded->bytes.size() <=
+            art2img::core::estimate_encoded_size(
+                indexed, art2img::core::ImageFormat::png, options));
+    }
+  }
+
+  TEST_CASE("Indexed TGA and BMP round-trip indices and colour maps")
+  {
+    std::array<std::uint32_t, 256> colors{};
+    for (std::size_t i = 0; i < colors.size(); ++i) {
+      const std::uint8_t rgba[4] = {static_cast<std::uint8_t>(i), 3,
+                                    static_cast<std::uint8_t>(255 - i),
+                                    static_cast<std::uint8_t>(i == 255 ? 0
+                                                                       : 255)};
+      std::memcpy(&colors[i], rgba, sizeof(rgba));
+    }
+    // Runs, literals and a run longer than one 128-pixel packet.
+    constexpr std::uint32_t width = 150;
+    constexpr std::uint32_t height = 3;
+    std::vector<std::uint8_t> indices(width * height);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        indices[y * width + x] = static_cast<std::uint8_t>(
+            y == 1 ? 255 : (x < 20 ? x : x / 7 + y));
+      }
+    }
+    const art2img::core::IndexedImageView view{indices, colors, width, height,
+                                               width};
+    auto byte_at = [](const std::vector<std::byte>& bytes, std::size_t at) {
+      return std::to_integer<std::uint8_t>(bytes[at]);
+    };
+
+    for (const bool rle : {false, true}) {
+      auto tga = art2img::core::encode_indexed_image(
+          view, art2img::core::ImageFormat::tga, {.tga_rle = rle});
+      REQUIRE(tga.has_value());
+      const auto& bytes = tga->bytes;
+      CHECK(byte_at(bytes, 1) == 1);
+      CHECK(byte_at(bytes, 2) == (rle ? 9 : 1));
+      CHECK(byte_at(bytes, 7) == 32);
+      CHECK(byte_at(bytes, 16) == 8);
+      // Colour map entry 10 is stored BGRA.
+      CHECK(byte_at(bytes, 18 + 10 * 4 + 0) == 245);
+      CHECK(byte_at(bytes, 18 + 10 * 4 + 2) == 10);
+      CHECK(byte_at(bytes, 18 + 255 * 4 + 3) == 0);
+
+      std::vector<std::uint8_t> decoded;
+      std::size_t at = 18 + 256 * 4;
+      while (decoded.size() < indices.size()) {
+        REQUIRE(at < bytes.size());
+        if (!rle) {
+          decoded.push_back(byte_at(bytes, at++));
+          continue;
+        }
+        const auto packet = byte_at(bytes, at++);
+        const std::size_t count = (packet & 0x7F) + 1;
+        for (std::size_t i = 0; i < count; ++i) {
+          decoded.push_back(byte_at(bytes, at));
+          at += (packet & 0x80) != 0 ? 0 : 1;
+        }
+        at += (packet & 0x80) != 0 ? 1 : 0;
+      }
+      CHECK(at == bytes.size());
+      for (std::uint32_t y = 0; y < height; ++y) {
+        CHECK(std::equal(indices.begin() + (height - 1 - y) * width,
+                         indices.begin() + (height - y) * width,
+                         decoded.begin() + y * width));
+      }
+      if (rle) {
+        CHECK(bytes.size() < 18 + 256 * 4 + indices.size());
+      }
+    }
+
+    // Pairs of equal indices save nothing as runs, so they stay literals
+    // and cost one header per 128 pixels.
+    std::vector<std::uint8_t> pairs(width);
+    for (std::uint32_t x = 0; x < width; ++x) {
+      pairs[x] = x % 3 == 2 ? 1 : 0;
+    }
+    const art2img::core::IndexedImageView paired{pairs, colors, width, 1,
+                                                 width};
+    auto packed = art2img::core::encode_indexed_image(
+        paired, art2img::core::ImageFormat::tga, {.tga_rle = true});
+    REQUIRE(packed.has_value());
+    CHECK(packed->bytes.size() == 18 + 256 * 4 + width + 2);
+    CHECK(packed->bytes.size() <=
+          art2img::core::estimate_encoded_size(
+              paired, art2img::core::ImageFormat::tga, {.tga_rle = true}));
+
+    auto bmp = art2img::core::encode_indexed_image(
+        view, art2img::core::ImageFormat::bmp);
+    REQUIRE(bmp.has_value());
+    const auto& bytes = bmp->bytes;
+    const std::size_t row = (width + 3) & ~3u;
+    const std::size_t offset = 14 + 40 + 256 * 4;
+    REQUIRE(bytes.size() == offset + row * height);
+    CHECK(byte_at(bytes, 0) == 'B');
+    CHECK(byte_at(bytes, 28) == 8);
+    CHECK(byte_at(bytes, 54 + 10 * 4 + 0) == 245);
+    CHECK(byte_at(bytes, 54 + 10 * 4 + 2) == 10);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        CHECK(byte_at(bytes, offset + (height - 1 - y) * row + x) ==
+              indices[y * width + x]);
+      }
+    }
+  }
+
+  TEST_CASE("DDS stores RGBA8 rows or decodable BC1 and BC3 blocks")
+  {
+    // 6x5 so the right and bottom blocks are partial.
+    constexpr std::uint32_t width = 6;
+    constexpr std::uint32_t height = 5;
+    std::vector<std::uint8_t> pixels(width * height * 4);
+    for (std::uint32_t i = 0; i < width * height; ++i) {
+      const auto x = i % width;
+      const auto y = i / width;
+      pixels[i * 4 + 0] = static_cast<std::uint8_t>(200 - y * 30);
+      pixels[i * 4 + 1] = static_cast<std::uint8_t>(40 + x * 20);
+      pixels[i * 4 + 2] = 90;
+      pixels[i * 4 + 3] = (x + y) % 3 == 0 ? 0 : 255;
+    }
+    const art2img::core::RgbaImageView view{pixels, width, height, width * 4};
+
+    auto le32 = [](const std::vector<std::byte>& bytes, std::size_t at) {
+      std::uint32_t value = 0;
+      for (std::size_t i = 0; i < 4; ++i) {
+        value |= std::to_integer<std::uint32_t>(bytes[at + i]) << (8 * i);
+      }
+      return value;
+    };
+    auto byte_at = [](const std::vector<std::byte>& bytes, std::size_t at) {
+      return std::to_integer<int>(bytes[at]);
+    };
+    // Reference decoder for one 4x4 block into RGBA; `alpha` is the BC3
+    // alpha block, or null for BC1.
+    auto decode_block = [&](const std::vector<std::byte>& bytes,
+                            std::size_t colour, const std::size_t* alpha,
+                            std::array<std::array<int, 4>, 16>& out) {
+      const auto c0 = static_cast<int>(le32(bytes, colour) & 0xFFFF);
+      const auto c1 = static_cast<int>(le32(bytes, colour) >> 16);
+      auto expand = [](int c) {
+        const int r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        return std::array<int, 4>{r << 3 | r >> 2, g << 2 | g >> 4,
+                                  b << 3 | b >> 2, 255};
+      };
+      std::array<std::array<int, 4>, 4> colours{expand(c0), expand(c1)};
+      const bool four = alpha != nullptr || c0 > c1;
+      for (int c = 0; c < 3; ++c) {
+        colours[2][c] = four ? (2 * colours[0][c] + colours[1][c]) / 3
+                             : (colours[0][c] + colours[1][c]) / 2;
+        colours[3][c] = four ? (colours[0][c] + 2 * colours[1][c]) / 3 : 0;
+      }
+      colours[2][3] = 255;
+      colours[3][3] = four ? 255 : 0;
+      const auto indices = le32(bytes, colour + 4);
+      for (int i = 0; i < 16; ++i) {
+        out[i] = colours[(indices >> (2 * i)) & 3];
+      }
+      if (alpha == nullptr) {
+        return;
+      }
+      const int a0 = byte_at(bytes, *alpha);
+      const int a1 = byte_at(bytes, *alpha + 1);
+      std::array<int, 8> levels{a0, a1};
+      for (int i = 2; i < 8; ++i) {
+        levels[i] = a0 > a1 ? ((8 - i) * a0 + (i - 1) * a1) / 7
+                    : i < 6 ? ((6 - i) * a0 + (i - 1) * a1) / 5
+                            : (i == 6 ? 0 : 255);
+      }
+      std::uint64_t bits = 0;
+      for (int i = 0; i < 6; ++i) {
+        bits |= static_cast<std::uint64_t>(byte_at(bytes, *alpha + 2 + i))
+                << (8 * i);
+      }
+      for (int i = 0; i < 16; ++i) {
+        out[i][3] = levels[(bits >> (3 * i)) & 7];
+      }
+    };
+
+    auto raw = art2img::core::encode_image(view,
+                                           art2img::core::ImageFormat::dds);
+    REQUIRE(raw.has_value());
+    REQUIRE(raw->bytes.size() == 128 + pixels.size());
+    CHECK(le32(raw->bytes, 0) == 0x20534444u);  // "DDS "
+    CHECK(le32(raw->bytes, 4) == 124);
+    CHECK(le32(raw->bytes, 12) == height);
+    CHECK(le32(raw->bytes, 16) == width);
+    CHECK(le32(raw->bytes, 88) == 32);
+    CHECK(le32(raw->bytes, 92) == 0x000000FFu);
+    CHECK(std::equal(pixels.begin(), pixels.end(), raw->bytes.begin() + 128,
+                     [](std::uint8_t a, std::byte b) {
+                       return a == std::to_integer<std::uint8_t>(b);
+                     }));
+    CHECK(raw->bytes.size() ==
+          art2img::core::estimate_encoded_size(
+              view, art2img::core::ImageFormat::dds));
+
+    // Binary alpha picks BC1; graded alpha below picks BC3.
+    for (const bool graded : {false, true}) {
+      if (graded) {
+        for (std::uint32_t i = 0; i < width * height; ++i) {
+          pixels[i * 4 + 3] = static_cast<std::uint8_t>(i * 8);
+        }
+      }
+      const art2img::core::EncoderOptions options{
+          .texture = art2img::core::TextureCompression::automatic};
+      auto encoded = art2img::core::encode_image(
+          view, art2img::core::ImageFormat::dds, options);
+      REQUIRE(encoded.has_value());
+      const std::size_t block_bytes = graded ? 16 : 8;
+      INFO("graded alpha: " << graded);
+      REQUIRE(encoded->bytes.size() == 128 + 2 * 2 * block_bytes);
+      CHECK(encoded->bytes.size() <=
+            art2img::core::estimate_encoded_size(
+                view, art2img::core::ImageFormat::dds, options));
+      CHECK(byte_at(encoded->bytes, 84) == 'D');
+      CHECK(byte_at(encoded->bytes, 87) == (graded ? '5' : '1'));
+
+      for (std::uint32_t block = 0; block < 4; ++block) {
+        const std::size_t at = 128 + block * block_bytes;
+        const std::size_t alpha = at;
+        std::array<std::array<int, 4>, 16> decoded{};
+        decode_block(encoded->bytes, graded ? at + 8 : at,
+                     graded ? &alpha : nullptr, decoded);
+        for (std::uint32_t i = 0; i < 16; ++i) {
+          const auto x = (block % 2) * 4 + i % 4;
+          const auto y = (block / 2) * 4 + i / 4;
+          if (x >= width || y >= height) {
+            continue;
+          }
+          const auto* source = pixels.data() + (y * width + x) * 4;
+          if (graded) {
+            CHECK(std::abs(decoded[i][3] - source[3]) <= 16);
+          }
+          else {
+            CHECK(decoded[i][3] == source[3]);
+          }
+          if (source[3] == 0) {
+            continue;
+          }
+          for (int c = 0; c < 3; ++c) {
+            CHECK(std::abs(decoded[i][c] - source[c]) <= 40);
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("DDS embeds mip levels that halve the level above")
+  {
+    std::vector<std::uint8_t> base(8 * 4 * 4, 0xFF);
+    std::vector<std::uint8_t> half(4 * 2 * 4, 0x80);
+    std::vector<std::uint8_t> quarter(2 * 1 * 4, 0x40);
+    const art2img::core::RgbaImageView view{base, 8, 4, 8 * 4};
+    const std::array levels{
+        art2img::core::RgbaImageView{half, 4, 2, 4 * 4},
+        art2img::core::RgbaImageView{quarter, 2, 1, 2 * 4}};
+
+    auto chained = art2img::core::encode_image_levels(
+        view, levels, art2img::core::ImageFormat::dds);
+    REQUIRE(chained.has_value());
+    const auto& bytes = chained->bytes;
+    REQUIRE(bytes.size() == 128 + base.size() + half.size() + quarter.size());
+    CHECK(std::to_integer<int>(bytes[28]) == 3);  // dwMipMapCount
+    CHECK(std::to_integer<int>(bytes[128 + base.size()]) == 0x80);
+    CHECK(std::to_integer<int>(bytes.back()) == 0x40);
+
+    auto compressed = art2img::core::encode_image_levels(
+        view, levels, art2img::core::ImageFormat::dds,
+        {.texture = art2img::core::TextureCompression::bc3});
+    REQUIRE(compressed.has_value());
+    CHECK(compressed->bytes.size() == 128 + (2 + 1 + 1) * 16);
+
+    const std::array skipped{levels[1]};
+    auto mismatched = art2img::core::encode_image_levels(
+        view, skipped, art2img::core::ImageFormat::dds);
+    REQUIRE(!mismatched.has_value());
+    CHECK(mismatched.error().code == art2img::core::errc::encoding_failure);
+
+    auto png = art2img::core::encode_image_levels(
+        view, levels, art2img::core::ImageFormat::png);
+    REQUIRE(!png.has_value());
+    CHECK(png.error().code == art2img::core::errc::unsupported);
+
+    const std::vector<std::uint8_t> indices(4, 0);
+    const std::array<std::uint32_t, 1> colours{0xFF000000u};
+    const art2img::core::IndexedImageView indexed{indices, colours, 2, 2, 2};
+    CHECK(!art2img::core::encode_indexed_image(
+               indexed, art2img::core::ImageFormat::dds)
+               .has_value());
+  }
+
+  TEST_CASE("QOI round-trips strided RGBA through a reference decoder")
+  {
+    // Runs longer than 62, repeats for the index, small and large deltas,
+    // and alpha changes, read through a padded stride.
+    constexpr std::uint32_t width = 40;
+    constexpr std::uint32_t height = 6;
+    constexpr std::uint32_t stride = width * 4 + 12;
+    std::vector<std::uint8_t> pixels(stride * height, 0xEE);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        auto* px = pixels.data() + y * stride + x * 4;
+        if (y < 2) {
+          px[0] = 10, px[1] = 20, px[2] = 30, px[3] = 255;
+        }
+        else if (y == 2) {
+          px[0] = static_cast<std::uint8_t>(x * 3);
+          px[1] = static_cast<std::uint8_t>(x * 4);
+          px[2] = static_cast<std::uint8_t>(x * 2);
+          px[3] = 255;
+        }
+        else {
+          px[0] = static_cast<std::uint8_t>((x * 37 + y * 11) % 256);
+          px[1] = static_cast<std::uint8_t>(x % 4 == 0 ? 200 : 7);
+          px[2] = static_cast<std::uint8_t>(y * 50);
+          px[3] = static_cast<std::uint8_t>(x % 5 == 0 ? 0 : 255);
+        }
+      }
+    }
+    const art2img::core::RgbaImageView view{pixels, width, height, stride};
+
+    auto decode = [](const std::vector<std::byte>& bytes) {
+      std::vector<std::uint8_t> out;
+      std::array<std::array<std::uint8_t, 4>, 64> seen{};
+      std::array<std::uint8_t, 4> px{0, 0, 0, 255};
+      const auto width = std::to_integer<std::uint32_t>(bytes[7]);
+      const auto height = std::to_integer<std::uint32_t>(bytes[11]);
+      std::size_t at = 14;
+      int run = 0;
+      for (std::uint32_t i = 0; i < width * height; ++i) {
+        if (run > 0) {
+          --run;
+        }
+        else {
+          const auto op = std::to_integer<std::uint8_t>(bytes[at++]);
+          auto next = [&] { return std::to_integer<std::uint8_t>(bytes[at++]); };
+          if (op == 0xFE) {
+            px[0] = next(), px[1] = next(), px[2] = next();
+          }
+          else if (op == 0xFF) {
+            px[0] = next(), px[1] = next(), px[2] = next(), px[3] = next();
+          }
+          else if ((op & 0xC0) == 0x00) {
+            px = seen[op];
+          }
+          else if ((op & 0xC0) == 0x40) {
+            px[0] = static_cast<std::uint8_t>(px[0] + ((op >> 4) & 3) - 2);
+            px[1] = static_cast<std::uint8_t>(px[1] + ((op >> 2) & 3) - 2);
+            px[2] = static_cast<std::uint8_t>(px[2] + (op & 3) - 2);
+          }
+          else if ((op & 0xC0) == 0x80) {
+            const int dg = (op & 0x3F) - 32;
+            const auto b2 = next();
+            px[0] = static_cast<std::uint8_t>(px[0] + dg - 8 + (b2 >> 4));
+            px[1] = static_cast<std::uint8_t>(px[1] + dg);
+            px[2] = static_cast<std::uint8_t>(px[2] + dg - 8 + (b2 & 0xF));
+          }
+          else {
+            run = op & 0x3F;
+          }
+          seen[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px;
+        }
+        out.insert(out.end(), px.begin(), px.end());
+      }
+      CHECK(bytes.size() == at + 8);
+      CHECK(std::to_integer<int>(bytes.back()) == 1);
+      return out;
+    };
+
+    auto encoded =
+        art2img::core::encode_image(view, art2img::core::ImageFormat::qoi);
+    REQUIRE(encoded.has_value());
+    const auto& bytes = encoded->bytes;
+    REQUIRE(bytes.size() > 14);
+    CHECK(std::memcmp(bytes.data(), "qoif", 4) == 0);
+    CHECK(std::to_integer<int>(bytes[12]) == 4);
+    CHECK(bytes.size() <= art2img::core::estimate_encoded_size(
+                              view, art2img::core::ImageFormat::qoi));
+    const auto decoded = decode(bytes);
+    REQUIRE(decoded.size() == width * height * 4);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      CHECK(std::memcmp(decoded.data() + y * width * 4,
+                        pixels.data() + y * stride, width * 4) == 0);
+    }
+
+    auto opaque = art2img::core::encode_image(
+        view, art2img::core::ImageFormat::qoi,
+        {.bit_depth = art2img::core::BitDepth::bpp24});
+    REQUIRE(opaque.has_value());
+    CHECK(std::to_integer<int>(opaque->bytes[12]) == 3);
+    const auto rgb = decode(opaque->bytes);
+    REQUIRE(rgb.size() == width * height * 4);
+    for (std::size_t i = 3; i < rgb.size(); i += 4) {
+      REQUIRE(rgb[i] == 255);
+    }
+
+    const std::vector<std::uint8_t> indices(4, 0);
+    const std::array<std::uint32_t, 1> colours{0xFF000000u};
+    const art2img::core::IndexedImageView indexed{indices, colours, 2, 2, 2};
+    CHECK(!art2img::core::encode_indexed_image(
+               indexed, art2img::core::ImageFormat::qoi)
+               .has_value());
+  }
+}
@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/hash.hpp>
+
+namespace {
+
+std::span<const std::byte> as_bytes(std::string_view text)
+{
+  return std::as_bytes(std::span{text.data(), text.size()});
+}
+
+}  // namespace
+
+TEST_CASE("xxh64 matches the reference vectors")
+{
+  using art2img::core::xxh64;
+  CHECK(xxh64({}) == 0xEF46DB3751D8E999ull);
+  CHECK(xxh64(as_bytes("a")) == 0xD24EC4F1A98C6E5Bull);
+  CHECK(xxh64(as_bytes("abc")) == 0x44BC2CF5AD770999ull);
+  CHECK(xxh64(as_bytes("Nobody inspects the spammish repetition")) ==
+        0xFBCEA83C8A378BF1ull);
+}
+
+TEST_CASE("Xxh64 gives the same digest however the input is split")
+{
+  std::vector<std::byte> data(200);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<std::byte>(i * 37 + 11);
+  }
+  const auto expected = art2img::core::xxh64(data, 42);
+
+  for (std::size_t split = 0; split <= data.size(); split += 7) {
+    art2img::core::Xxh64 hasher(42);
+    hasher.update(std::span{data}.first(split));
+    hasher.update(std::span{data}.subspan(split));
+    CHECK(hasher.digest() == expected);
+  }
+}
+
+TEST_CASE("Fingerprints change with tile content and settings")
+{
+  std::vector<std::byte> indices(6, std::byte{3});
+  const art2img::core::TileView tile{indices, {}, 2, 3};
+  art2img::core::PreparedPalette palette{};
+  palette.colors.fill(0xFF102030u);
+
+  const auto base = art2img::core::settings_fingerprint(
+      palette, art2img::core::ImageFormat::png, {});
+  const auto fingerprint = art2img::core::tile_fingerprint(tile, base);
+  CHECK(fingerprint == art2img::core::tile_fingerprint(tile, base));
+
+  // Same bytes, transposed dimensions.
+  CHECK(fingerprint != art2img::core::tile_fingerprint(
+                           art2img::core::TileView{indices, {}, 3, 2}, base));
+
+  auto changed = indices;
+  changed[5] = std::byte{4};
+  CHECK(fingerprint != art2img::core::tile_fingerprint(
+                           art2img::core::TileView{changed, {}, 2, 3}, base));
+
+  const std::vector<std::byte> lookup(256, std::byte{0});
+  CHECK(fingerprint != art2img::core::tile_fingerprint(
+                           art2img::core::TileView{indices, lookup, 2, 3},
+                           base));
+
+  CHECK(base != art2img::core::settings_fingerprint(
+                    palette, art2img::core::ImageFormat::tga, {}));
+  CHECK(base != art2img::core::settings_fingerprint(
+                    palette, art2img::core::ImageFormat::png,
+                    {.compression = art2img::core::CompressionPreset::fast}));
+  CHECK(base != art2img::core::settings_fingerprint(
+                    palette, art2img::core::ImageFormat::png, {}, 1));
+  const auto rgba8 = art2img::core::settings_fingerprint(
+      palette, art2img::core::ImageFormat::dds, {});
+  CHECK(rgba8 != art2img::core::settings_fingerprint(
+                     palette, art2img::core::ImageFormat::dds,
+                     {.texture = art2img::core::TextureCompression::bc1}));
+
+  auto shaded = palette;
+  shaded.options.shade_index = 0;
+  CHECK(base != art2img::core::settings_fingerprint(
+                    shaded, art2img::core::ImageFormat::png, {}));
+  auto recoloured = palette;
+  recoloured.colors[7] = 0;
+  CHECK(base != art2img::core::settings_fingerprint(
+                    recoloured, art2img::core::ImageFormat::png, {}));
+}
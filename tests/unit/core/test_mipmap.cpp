@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/core/image.hpp>
+#include <art2img/core/mipmap.hpp>
+
+namespace {
+
+art2img::core::RgbaImage solid(std::uint32_t width,
+                               std::uint32_t height,
+                               std::uint32_t rgba)
+{
+  art2img::core::RgbaImage image{width, height, {}};
+  for (std::uint32_t i = 0; i < width * height; ++i) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      image.pixels.push_back(static_cast<std::uint8_t>(rgba >> shift));
+    }
+  }
+  return image;
+}
+
+}  // namespace
+
+TEST_CASE("build_mip_chain halves down to 1x1")
+{
+  const auto image = solid(12, 5, 0xFF336699u);
+  const auto chain =
+      art2img::core::build_mip_chain(art2img::core::make_view(image));
+  REQUIRE(chain);
+  // 12x5 -> 6x2 -> 3x1 -> 1x1
+  REQUIRE(chain->size() == 3);
+  CHECK((*chain)[0].width == 6);
+  CHECK((*chain)[0].height == 2);
+  CHECK((*chain)[1].width == 3);
+  CHECK((*chain)[1].height == 1);
+  CHECK((*chain)[2].width == 1);
+  CHECK((*chain)[2].height == 1);
+  for (const auto& level : *chain) {
+    CHECK(level.pixels == solid(level.width, level.height, 0xFF336699u).pixels);
+  }
+
+  const auto limited =
+      art2img::core::build_mip_chain(art2img::core::make_view(image), 1);
+  REQUIRE(limited);
+  CHECK(limited->size() == 1);
+}
+
+TEST_CASE("resize_rgba keeps transparent pixels out of the colour")
+{
+  // One opaque red pixel next to three transparent black ones.
+  art2img::core::RgbaImage image{2, 2, {255, 0, 0, 255, 0, 0, 0, 0,  //
+                                        0, 0, 0, 0, 0, 0, 0, 0}};
+  const auto view = art2img::core::make_view(image);
+
+  const auto straight = art2img::core::resize_rgba(view, 1, 1);
+  REQUIRE(straight);
+  CHECK(straight->pixels == std::vector<std::uint8_t>{255, 0, 0, 64});
+
+  const auto premultiplied = art2img::core::resize_rgba(view, 1, 1, true);
+  REQUIRE(premultiplied);
+  CHECK(premultiplied->pixels == std::vector<std::uint8_t>{64, 0, 0, 64});
+
+  const auto clear = solid(4, 4, 0u);
+  const auto transparent =
+      art2img::core::resize_rgba(art2img::core::make_view(clear), 2, 2);
+  REQUIRE(transparent);
+  CHECK(transparent->pixels == solid(2, 2, 0u).pixels);
+}
+
+TEST_CASE("make_thumbnail fits the longer side and never upscales")
+{
+  const auto wide = solid(200, 50, 0xFF00FF00u);
+  const auto thumbnail =
+      art2img::core::make_thumbnail(art2img::core::make_view(wide), 64);
+  REQUIRE(thumbnail);
+  CHECK(thumbnail->width == 64);
+  CHECK(thumbnail->height == 16);
+
+  const auto small = solid(10, 20, 0xFF00FF00u);
+  const auto copy =
+      art2img::core::make_thumbnail(art2img::core::make_view(small), 64);
+  REQUIRE(copy);
+  CHECK(copy->width == 10);
+  CHECK(copy->height == 20);
+  CHECK(copy->pixels == small.pixels);
+
+  CHECK_FALSE(
+      art2img::core::make_thumbnail(art2img::core::make_view(small), 0));
+}
@@ -2,7 +2,10 @@
 
 #include <art2img/adapters/io.hpp>
 #include <art2img/core/palette.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 
 TEST_SUITE("palette module")
 {
@@ -189,4 +192,41 @@ TEST_SUITE("palette module")
       }
     }
   }
-}
\ No newline at end of file
+
+  TEST_CASE("load_palette_view matches load_palette without copying")
+  {
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto file_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+    REQUIRE(file_data.has_value());
+
+    auto palette = art2img::core::load_palette(*file_data);
+    REQUIRE(palette.has_value());
+    auto view = art2img::core::load_palette_view(*file_data);
+    REQUIRE(view.has_value());
+
+    const auto* base = reinterpret_cast<const std::uint8_t*>(file_data->data());
+    CHECK(view->rgb.data() == base);
+    CHECK(std::ranges::equal(view->rgb, palette->rgb));
+    CHECK(view->shade_table_count == palette->shade_table_count);
+    CHECK(std::ranges::equal(view->shade_tables, palette->shade_tables));
+    CHECK(std::ranges::equal(view->translucent, palette->translucent));
+
+    // Without a translucency table the view leaves it empty.
+    const auto shades_end = art2img::core::palette_component_count + 2 +
+                            view->shade_tables.size();
+    auto short_view = art2img::core::load_palette_view(
+        std::span{*file_data}.first(shades_end));
+    REQUIRE(short_view.has_value());
+    CHECK(short_view->translucent.empty());
+    CHECK(short_view->has_shades() == view->has_shades());
+
+    CHECK(!art2img::core::load_palette_view(
+               std::span{*file_data}.first(shades_end - 1))
+               .has_value());
+  }
+}
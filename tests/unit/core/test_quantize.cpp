@@ -0,0 +1,163 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/core/quantize.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace {
+
+std::filesystem::path assets_dir()
+{
+  return std::filesystem::path{__FILE__}.parent_path().parent_path().parent_path() /
+         "assets";
+}
+
+// The reference the table must agree with: a full search over the first 255
+// colours, lowest index on ties.
+std::uint8_t brute_force_nearest(const art2img::core::QuantizeTable& table,
+                                 int r,
+                                 int g,
+                                 int b)
+{
+  std::uint8_t best = 0;
+  int best_distance = 1 << 30;
+  for (int c = 0; c < 255; ++c) {
+    const int dr = table.rgb[c * 3] - r;
+    const int dg = table.rgb[c * 3 + 1] - g;
+    const int db = table.rgb[c * 3 + 2] - b;
+    const int distance = dr * dr + dg * dg + db * db;
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = static_cast<std::uint8_t>(c);
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+TEST_SUITE("quantize module")
+{
+  TEST_CASE("The lookup grid finds the exact nearest palette colour")
+  {
+    auto palette_data =
+        art2img::adapters::read_binary_file(assets_dir() / "PALETTE.DAT");
+    REQUIRE(palette_data.has_value());
+    auto palette = art2img::core::load_palette(*palette_data);
+    REQUIRE(palette.has_value());
+    auto table = art2img::core::prepare_quantize_table(
+        art2img::core::view_palette(*palette));
+    REQUIRE(table.has_value());
+
+    // Every cell corner and centre, plus a scattered sample of the cube.
+    for (int r = 0; r < 256; r += 7) {
+      for (int g = 0; g < 256; g += 11) {
+        for (int b = 0; b < 256; b += 5) {
+          CHECK(art2img::core::nearest_index(
+                    *table, static_cast<std::uint8_t>(r),
+                    static_cast<std::uint8_t>(g),
+                    static_cast<std::uint8_t>(b)) ==
+                brute_force_nearest(*table, r, g, b));
+        }
+      }
+    }
+    for (int c = 0; c < 255; ++c) {
+      const auto index = art2img::core::nearest_index(
+          *table, table->rgb[c * 3], table->rgb[c * 3 + 1],
+          table->rgb[c * 3 + 2]);
+      CHECK(index != 255);
+      CHECK(table->rgb[index * 3] == table->rgb[c * 3]);
+      CHECK(table->rgb[index * 3 + 1] == table->rgb[c * 3 + 1]);
+      CHECK(table->rgb[index * 3 + 2] == table->rgb[c * 3 + 2]);
+    }
+
+    const art2img::core::PaletteView short_palette{};
+    CHECK(!art2img::core::prepare_quantize_table(short_palette).has_value());
+  }
+
+  TEST_CASE("Converted tiles quantise back to the same colours")
+  {
+    auto art_data =
+        art2img::adapters::read_binary_file(assets_dir() / "TILES000.ART");
+    auto palette_data =
+        art2img::adapters::read_binary_file(assets_dir() / "PALETTE.DAT");
+    REQUIRE(art_data.has_value());
+    REQUIRE(palette_data.has_value());
+    auto archive = art2img::core::load_art(*art_data);
+    auto palette = art2img::core::load_palette(*palette_data);
+    REQUIRE(archive.has_value());
+    REQUIRE(palette.has_value());
+    const auto view = art2img::core::view_palette(*palette);
+    auto table = art2img::core::prepare_quantize_table(view);
+    REQUIRE(table.has_value());
+
+    std::vector<art2img::core::ArtTileData> tiles;
+    std::size_t checked = 0;
+    for (std::size_t i = 0; i < art2img::core::tile_count(*archive) &&
+                            checked < 8;
+         ++i) {
+      const auto tile = art2img::core::get_tile(*archive, i);
+      if (!tile) {
+        continue;
+      }
+      auto rgba = art2img::core::palette_to_rgba(*tile, view);
+      REQUIRE(rgba.has_value());
+      auto quantised = art2img::core::rgba_to_tile(
+          art2img::core::make_view(*rgba), *table);
+      REQUIRE(quantised.has_value());
+      REQUIRE(quantised->indices.size() == tile->indices.size());
+
+      // Indices may differ where the palette repeats a colour, but the
+      // pixels they convert to may not.
+      const art2img::core::TileView back{quantised->indices, {}, tile->width,
+                                         tile->height};
+      auto again = art2img::core::palette_to_rgba(back, view);
+      REQUIRE(again.has_value());
+      CHECK(again->pixels == rgba->pixels);
+      tiles.push_back(std::move(*quantised));
+      ++checked;
+    }
+    REQUIRE(checked > 0);
+
+    auto written = art2img::core::write_art(tiles);
+    REQUIRE(written.has_value());
+    CHECK(art2img::core::load_art(*written).has_value());
+  }
+
+  TEST_CASE("Alpha below the threshold maps to the transparent index")
+  {
+    std::vector<std::uint8_t> palette_rgb(768, 0);
+    palette_rgb[3] = 63;  // index 1 is red
+    const art2img::core::PaletteView palette{palette_rgb};
+    auto table = art2img::core::prepare_quantize_table(palette);
+    REQUIRE(table.has_value());
+
+    // 3x2, with a padded stride; column-major output.
+    const std::vector<std::uint8_t> pixels{
+        255, 0, 0, 255, 250, 10, 0, 0, 0, 0, 0, 100, 9, 9,
+        0,   0, 0, 200, 255, 0,  0, 1, 0, 0, 0, 255, 9, 9};
+    const art2img::core::RgbaImageView image{pixels, 3, 2, 14};
+    std::vector<std::byte> out(6);
+    REQUIRE(art2img::core::rgba_to_indices_into(image, *table, out));
+    const std::vector<std::byte> expected{std::byte{1},   std::byte{0},
+                                          std::byte{255}, std::byte{1},
+                                          std::byte{0},   std::byte{0}};
+    CHECK(out == expected);
+
+    REQUIRE(art2img::core::rgba_to_indices_into(
+        image, *table, out, {.alpha_threshold = 128}));
+    CHECK(out[3] == std::byte{255});
+    CHECK(out[4] == std::byte{255});
+    CHECK(out[5] == std::byte{0});
+
+    std::vector<std::byte> small(5);
+    CHECK(!art2img::core::rgba_to_indices_into(image, *table, small));
+  }
+}
@@ -0,0 +1,109 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/core/convert.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/image.hpp>
+#include <art2img/core/stats.hpp>
+
+namespace {
+
+using art2img::core::Stage;
+
+// Installs a collector for the scope of a test case.
+class ScopedCollector {
+ public:
+  ScopedCollector() { art2img::core::set_stats_sink(&collector_); }
+  ScopedCollector(const ScopedCollector&) = delete;
+  ScopedCollector& operator=(const ScopedCollector&) = delete;
+  ~ScopedCollector() { art2img::core::set_stats_sink(nullptr); }
+
+  art2img::core::StageTotals totals(Stage stage) const
+  {
+    return collector_.totals()[static_cast<std::size_t>(stage)];
+  }
+
+ private:
+  art2img::core::StatsCollector collector_{};
+};
+
+}  // namespace
+
+TEST_CASE("StatsCollector sees each stage once with its counters")
+{
+  std::vector<std::byte> indices(12 * 5, std::byte{7});
+  const art2img::core::TileView tile{indices, {}, 12, 5};
+  art2img::core::PreparedPalette palette{};
+  palette.colors.fill(0xFF204060u);
+
+  const ScopedCollector stats;
+  // The PreparedPalette overload forwards to the workspace overload, which
+  // calls palette_to_rgba_into; all three must add up to one call.
+  auto image = art2img::core::palette_to_rgba(tile, palette);
+  REQUIRE(image);
+  art2img::core::postprocess_rgba(*image, {});
+  const auto encoded = art2img::core::encode_image(
+      art2img::core::make_view(*image), art2img::core::ImageFormat::png);
+  REQUIRE(encoded);
+
+  const auto convert = stats.totals(Stage::convert);
+  CHECK(convert.calls == 1);
+  CHECK(convert.pixels == 60);
+  CHECK(convert.bytes_in == 60);
+  CHECK(convert.bytes_out == 240);
+  CHECK(convert.allocations >= 1);
+
+  const auto postprocess = stats.totals(Stage::postprocess);
+  CHECK(postprocess.calls == 1);
+  CHECK(postprocess.pixels == 60);
+
+  const auto encode = stats.totals(Stage::encode);
+  CHECK(encode.calls == 1);
+  CHECK(encode.pixels == 60);
+  CHECK(encode.bytes_in == 240);
+  CHECK(encode.bytes_out == encoded->bytes.size());
+  CHECK(encode.allocations >= 1);
+
+  CHECK(stats.totals(Stage::load_art).calls == 0);
+  CHECK(stats.totals(Stage::write).calls == 0);
+}
+
+TEST_CASE("Nothing is recorded without a sink")
+{
+  std::vector<std::byte> indices(4, std::byte{1});
+  const art2img::core::TileView tile{indices, {}, 2, 2};
+  art2img::core::PreparedPalette palette{};
+
+  art2img::core::StatsCollector collector;
+  art2img::core::set_stats_sink(&collector);
+  art2img::core::set_stats_sink(nullptr);
+  REQUIRE(art2img::core::palette_to_rgba(tile, palette));
+
+  for (const auto& totals : collector.totals()) {
+    CHECK(totals.calls == 0);
+    CHECK(totals.nanoseconds == 0);
+  }
+}
+
+TEST_CASE("StatsCollector reset clears every stage")
+{
+  std::vector<std::byte> indices(4, std::byte{1});
+  const art2img::core::TileView tile{indices, {}, 2, 2};
+  art2img::core::PreparedPalette palette{};
+
+  art2img::core::StatsCollector collector;
+  art2img::core::set_stats_sink(&collector);
+  REQUIRE(art2img::core::palette_to_rgba(tile, palette));
+  art2img::core::set_stats_sink(nullptr);
+  CHECK(collector.totals()[static_cast<std::size_t>(Stage::convert)].calls ==
+        1);
+
+  collector.reset();
+  for (const auto& totals : collector.totals()) {
+    CHECK(totals.calls == 0);
+    CHECK(totals.pixels == 0);
+  }
+}
@@ -0,0 +1,191 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/meta_serialization.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/convert.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/extras/atlas.hpp>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../../test_helpers.hpp"
+
+namespace {
+
+bool overlaps(const art2img::core::AtlasEntry& a,
+              const art2img::core::AtlasEntry& b,
+              std::uint32_t padding)
+{
+  return a.page == b.page && a.x < b.x + b.width + padding &&
+         b.x < a.x + a.width + padding && a.y < b.y + b.height + padding &&
+         b.y < a.y + a.height + padding;
+}
+
+}  // namespace
+
+TEST_SUITE("atlas module")
+{
+  TEST_CASE("pack_atlas places every non-empty tile without overlap")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+    std::vector<std::size_t> tiles(art2img::core::tile_count(assets.archive));
+    std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+
+    const art2img::extras::AtlasOptions options{.max_size = 512,
+                                                .padding = 2};
+    auto manifest = art2img::extras::pack_atlas(assets.archive, tiles, options);
+    REQUIRE(manifest.has_value());
+    CHECK(manifest->pages.size() > 1);
+
+    std::size_t non_empty = 0;
+    for (const auto& metrics : assets.archive.layout) {
+      non_empty += metrics.width > 0 && metrics.height > 0 ? 1 : 0;
+    }
+    REQUIRE(manifest->entries.size() == non_empty);
+
+    for (std::size_t i = 0; i < manifest->entries.size(); ++i) {
+      const auto& entry = manifest->entries[i];
+      if (i > 0) {
+        CHECK(entry.tile > manifest->entries[i - 1].tile);  // request order
+      }
+      const auto& metrics = assets.archive.layout[entry.tile];
+      CHECK(entry.origin_x == metrics.offset_x);
+      CHECK(entry.origin_y == metrics.offset_y);
+      REQUIRE(entry.page < manifest->pages.size());
+      const auto& page = manifest->pages[entry.page];
+      if (entry.width + 2 * options.padding <= options.max_size &&
+          entry.height + 2 * options.padding <= options.max_size) {
+        CHECK(page.width <= options.max_size);
+        CHECK(page.height <= options.max_size);
+      }
+      CHECK(entry.x >= options.padding);
+      CHECK(entry.y >= options.padding);
+      CHECK(entry.x + entry.width + options.padding <= page.width);
+      CHECK(entry.y + entry.height + options.padding <= page.height);
+      for (std::size_t j = i + 1; j < manifest->entries.size(); ++j) {
+        CHECK(!overlaps(entry, manifest->entries[j], options.padding));
+      }
+    }
+  }
+
+  TEST_CASE("pack_atlas gives oversized tiles their own page")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+    const std::vector<std::size_t> tiles = {0, 58, 3};
+    auto manifest = art2img::extras::pack_atlas(assets.archive, tiles,
+                                                {.max_size = 64, .padding = 0});
+    REQUIRE(manifest.has_value());
+    REQUIRE(manifest->entries.size() == 3);
+    const auto& large = manifest->entries[1];  // tile 58 is 54x105
+    CHECK(large.tile == 58);
+    CHECK(manifest->pages[large.page].height == 105);
+    CHECK(manifest->entries[0].page != large.page);
+
+    const std::vector<std::size_t> invalid = {100000};
+    CHECK(!art2img::extras::pack_atlas(assets.archive, invalid).has_value());
+  }
+
+  TEST_CASE("build_atlas pages hold the converted tiles")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+    art2img::extras::AtlasRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.atlas.max_size = 1024;
+    request.parallel.threads = 3;
+
+    // Encode uncompressed BMP pages so the test can compare raw pixels.
+    request.format = art2img::core::ImageFormat::bmp;
+    request.encoder.bit_depth = art2img::core::BitDepth::bpp24;
+    auto atlas = art2img::extras::build_atlas(request);
+    REQUIRE(atlas.has_value());
+    REQUIRE(atlas->pages.size() == atlas->manifest.pages.size());
+
+    request.parallel.threads = 1;
+    auto serial = art2img::extras::build_atlas(request);
+    REQUIRE(serial.has_value());
+    for (std::size_t i = 0; i < atlas->pages.size(); ++i) {
+      CHECK(atlas->pages[i].bytes == serial->pages[i].bytes);
+      CHECK(atlas->pages[i].width == atlas->manifest.pages[i].width);
+    }
+
+    // Spot-check one tile against a direct conversion through the BMP rows.
+    const auto palette_view = art2img::core::view_palette(assets.palette);
+    const auto& entry = atlas->manifest.entries.front();
+    auto tile = art2img::core::get_tile(assets.archive, entry.tile);
+    REQUIRE(tile.has_value());
+    auto expected = art2img::core::palette_to_rgba(*tile, palette_view);
+    REQUIRE(expected.has_value());
+
+    const auto& page = atlas->manifest.pages[entry.page];
+    const auto& bytes = atlas->pages[entry.page].bytes;
+    std::uint32_t data_offset = 0;
+    std::memcpy(&data_offset, bytes.data() + 10, sizeof(data_offset));
+    const std::size_t row =
+        (static_cast<std::size_t>(page.width) * 3 + 3) & ~std::size_t{3};
+    for (std::uint32_t y = 0; y < entry.height; ++y) {
+      const auto page_row = page.height - 1 - (entry.y + y);
+      for (std::uint32_t x = 0; x < entry.width; ++x) {
+        const auto* bgr = bytes.data() + data_offset + page_row * row +
+                          (entry.x + x) * 3;
+        const auto* rgba = expected->pixels.data() + (y * entry.width + x) * 4;
+        CHECK(std::to_integer<std::uint8_t>(bgr[2]) == rgba[0]);
+        CHECK(std::to_integer<std::uint8_t>(bgr[0]) == rgba[2]);
+      }
+    }
+  }
+
+  TEST_CASE("format_atlas_json lists pages and tile rects")
+  {
+    art2img::core::AtlasManifest manifest{};
+    manifest.tile_start = 100;
+    manifest.pages.push_back({"tiles_atlas_0.png", 128, 64});
+    manifest.entries.push_back({.tile = 3,
+                                .page = 0,
+                                .x = 1,
+                                .y = 2,
+                                .width = 16,
+                                .height = 8,
+                                .origin_x = -4,
+                                .origin_y = 5});
+
+    auto json = art2img::adapters::format_atlas_json(manifest);
+    REQUIRE(json.has_value());
+    CHECK(json->find("\"image\": \"tiles_atlas_0.png\"") != std::string::npos);
+    CHECK(json->find("\"tile\": 3, \"picnum\": 103, \"page\": 0, \"x\": 1, "
+                     "\"y\": 2, \"width\": 16, \"height\": 8, \"origin_x\": "
+                     "-4, \"origin_y\": 5") != std::string::npos);
+
+    manifest.entries.front().page = 1;
+    CHECK(!art2img::adapters::format_atlas_json(manifest).has_value());
+  }
+
+  TEST_CASE("format_trim_json places each trimmed image in its tile")
+  {
+    art2img::core::TrimManifest manifest{};
+    manifest.tile_start = 100;
+    manifest.entries.push_back({.tile = 3,
+                                .image = "TILES000_0003.png",
+                                .width = 64,
+                                .height = 32,
+                                .x = 10,
+                                .y = 4,
+                                .trimmed_width = 20,
+                                .trimmed_height = 28,
+                                .origin_x = -4,
+                                .origin_y = 5});
+
+    auto json = art2img::adapters::format_trim_json(manifest);
+    REQUIRE(json.has_value());
+    CHECK(json->find("\"tile\": 3, \"picnum\": 103, \"image\": "
+                     "\"TILES000_0003.png\", \"width\": 64, \"height\": 32, "
+                     "\"x\": 10, \"y\": 4, \"trimmed_width\": 20, "
+                     "\"trimmed_height\": 28, \"origin_x\": -4, "
+                     "\"origin_y\": 5") != std::string::npos);
+
+    manifest.entries.front().x = 50;
+    CHECK(!art2img::adapters::format_trim_json(manifest).has_value());
+  }
+}
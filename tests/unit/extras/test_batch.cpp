@@ -0,0 +1,315 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/batch.hpp>
+#include <art2img/extras/parallel.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "../../test_helpers.hpp"
+
+TEST_SUITE("batch module")
+{
+  TEST_CASE("largest_first orders positions by pixel count")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+    std::vector<std::size_t> tiles(art2img::core::tile_count(assets.archive));
+    std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+    tiles.push_back(tiles.size() + 100);  // out of range sorts last
+
+    const auto order = art2img::extras::largest_first(assets.archive, tiles);
+    REQUIRE(order.size() == tiles.size());
+    CHECK(order.back() == tiles.size() - 1);
+
+    auto pixels = [&](std::size_t position) -> std::size_t {
+      if (tiles[position] >= assets.archive.layout.size()) {
+        return 0;
+      }
+      const auto& metrics = assets.archive.layout[tiles[position]];
+      return static_cast<std::size_t>(metrics.width) * metrics.height;
+    };
+    for (std::size_t i = 1; i < order.size(); ++i) {
+      CHECK(pixels(order[i - 1]) >= pixels(order[i]));
+    }
+  }
+
+  TEST_CASE("for_each_index visits every item once")
+  {
+    std::vector<std::size_t> order(64);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::vector<std::atomic<int>> visits(order.size());
+
+    art2img::extras::for_each_index(
+        order, art2img::extras::ParallelOptions{.threads = 4},
+        [&](std::size_t item, std::size_t slot) {
+          CHECK(slot < 4);
+          visits[item].fetch_add(1);
+          return true;
+        });
+
+    for (const auto& count : visits) {
+      CHECK(count.load() == 1);
+    }
+  }
+
+  TEST_CASE("parallel convert_tiles matches serial output and order")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {5, 0, 58, 3, 42, 3};
+
+    auto serial = art2img::extras::convert_tiles(request);
+    REQUIRE(serial.has_value());
+
+    request.parallel.threads = 4;
+    auto parallel = art2img::extras::convert_tiles(request);
+    REQUIRE(parallel.has_value());
+
+    REQUIRE(serial->images.size() == request.tiles.size());
+    REQUIRE(parallel->images.size() == request.tiles.size());
+    for (std::size_t i = 0; i < request.tiles.size(); ++i) {
+      const auto& metrics = assets.archive.layout[request.tiles[i]];
+      CHECK(parallel->images[i].width == metrics.width);
+      CHECK(parallel->images[i].height == metrics.height);
+      CHECK(parallel->images[i].bytes == serial->images[i].bytes);
+    }
+  }
+
+  TEST_CASE("convert_tiles runs on a caller-supplied executor")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    std::size_t executor_slots = 0;
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {0, 1, 2, 3};
+    request.parallel.threads = 3;
+    request.parallel.executor =
+        [&](std::size_t slots, const std::function<void(std::size_t)>& work) {
+          executor_slots = slots;
+          for (std::size_t slot = 0; slot < slots; ++slot) {
+            work(slot);
+          }
+        };
+
+    auto result = art2img::extras::convert_tiles(request);
+    REQUIRE(result.has_value());
+    CHECK(executor_slots == 3);
+    CHECK(result->images.size() == 4);
+  }
+
+  TEST_CASE("convert_tiles rejects out-of-range tiles in parallel mode")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {0, 100000};
+    request.parallel.threads = 2;
+
+    auto result = art2img::extras::convert_tiles(request);
+    REQUIRE(!result.has_value());
+    CHECK(result.error().code == art2img::core::errc::invalid_art);
+  }
+
+  TEST_CASE("convert_tiles runs across a collection by tile number")
+  {
+    auto assets = test_helpers::load_sample_assets();
+    const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                     .parent_path()
+                                     .parent_path()
+                                     .parent_path() /
+                                 "assets";
+    auto second_data =
+        art2img::adapters::read_binary_file(test_assets_dir / "TILES001.ART");
+    REQUIRE(second_data.has_value());
+    auto second = art2img::core::load_art(*second_data);
+    REQUIRE(second.has_value());
+
+    std::vector<art2img::core::ArtArchive> archives{assets.archive, *second};
+    auto collection = art2img::core::make_art_collection(std::move(archives));
+    REQUIRE(collection.has_value());
+
+    // Tiles from both files in one work list, one of them twice.
+    const std::uint32_t first = assets.archive.tile_start;
+    const std::uint32_t other = second->tile_start;
+    art2img::extras::BatchRequest request{};
+    request.collection = &*collection;
+    request.palette = &assets.palette;
+    request.tiles = {other + 2, first + 5, other, first + 5};
+    request.parallel.threads = 3;
+    request.deduplicate = true;
+    auto result = art2img::extras::convert_tiles(request);
+    REQUIRE(result.has_value());
+    CHECK(result->images.size() == 3);
+
+    for (std::size_t i = 0; i < request.tiles.size(); ++i) {
+      const auto location = collection->locate(
+          static_cast<std::uint32_t>(request.tiles[i]));
+      REQUIRE(location.has_value());
+      art2img::extras::BatchRequest single{};
+      single.archive = &collection->archives()[location->archive];
+      single.palette = &assets.palette;
+      single.tiles = {location->tile};
+      auto expected = art2img::extras::convert_tiles(single);
+      REQUIRE(expected.has_value());
+      CHECK(art2img::extras::image_for(*result, i).bytes ==
+            expected->images.front().bytes);
+    }
+
+    request.tiles = {first + 100000};
+    CHECK(!art2img::extras::convert_tiles(request).has_value());
+  }
+
+  TEST_CASE("convert_tiles tags each tile's stages with its tile index")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    struct TagSink final : art2img::core::StatsSink {
+      std::mutex mutex;
+      std::multiset<std::uint64_t> converted;
+      void record(const art2img::core::StageRecord& record) noexcept override
+      {
+        if (record.stage == art2img::core::Stage::convert) {
+          const std::lock_guard lock(mutex);
+          converted.insert(record.tag);
+        }
+      }
+    } sink;
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {5, 0, 58, 3};
+    request.parallel.threads = 2;
+
+    art2img::core::set_stats_sink(&sink);
+    auto result = art2img::extras::convert_tiles(request);
+    art2img::core::set_stats_sink(nullptr);
+    REQUIRE(result.has_value());
+    CHECK(sink.converted == std::multiset<std::uint64_t>{0, 3, 5, 58});
+  }
+
+  TEST_CASE("convert_tiles_streaming delivers every tile once")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    // Every non-empty tile between 60 and 123.
+    for (std::size_t tile = 60; tile < 124; ++tile) {
+      if (assets.archive.layout[tile].width > 0) {
+        request.tiles.push_back(tile);
+      }
+    }
+    auto whole = art2img::extras::convert_tiles(request);
+    REQUIRE(whole.has_value());
+
+    for (const std::size_t threads : {1, 4}) {
+      INFO("threads " << threads);
+      request.parallel.threads = threads;
+      const auto caller = std::this_thread::get_id();
+      std::vector<int> seen(request.tiles.size(), 0);
+      auto streamed = art2img::extras::convert_tiles_streaming(
+          request,
+          [&](std::span<const std::size_t> positions,
+              const art2img::core::EncodedImage& image) {
+            CHECK(std::this_thread::get_id() == caller);
+            REQUIRE(positions.size() == 1);
+            ++seen[positions[0]];
+            CHECK(image.bytes == whole->images[positions[0]].bytes);
+            return true;
+          },
+          art2img::extras::StreamOptions{.max_in_flight = 3});
+      REQUIRE(streamed.has_value());
+      CHECK(std::all_of(seen.begin(), seen.end(),
+                        [](int count) { return count == 1; }));
+    }
+  }
+
+  TEST_CASE("convert_tiles_streaming groups duplicates and can stop early")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {90, 91, 93, 92};
+    request.deduplicate = true;
+    request.parallel.threads = 2;
+
+    std::vector<std::vector<std::size_t>> groups;
+    auto streamed = art2img::extras::convert_tiles_streaming(
+        request, [&](std::span<const std::size_t> positions,
+                     const art2img::core::EncodedImage&) {
+          groups.emplace_back(positions.begin(), positions.end());
+          return true;
+        });
+    REQUIRE(streamed.has_value());
+    REQUIRE(groups.size() == 3);
+    // Tile 93 repeats tile 90, so positions 0 and 2 share one image.
+    CHECK(std::count(groups.begin(), groups.end(),
+                     std::vector<std::size_t>{0, 2}) == 1);
+
+    request.tiles = {0, 1, 2, 3, 4, 5, 6, 7};
+    request.deduplicate = false;
+    std::size_t delivered = 0;
+    streamed = art2img::extras::convert_tiles_streaming(
+        request, [&](std::span<const std::size_t>,
+                     const art2img::core::EncodedImage&) {
+          ++delivered;
+          return false;
+        });
+    REQUIRE(streamed.has_value());
+    CHECK(delivered == 1);
+  }
+
+  TEST_CASE("convert_tiles encodes mip levels and thumbnails per image")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {0, 3};
+    request.mipmaps.levels = art2img::core::full_mip_chain;
+    request.mipmaps.thumbnail_size = 8;
+    request.parallel.threads = 2;
+
+    auto result = art2img::extras::convert_tiles(request);
+    REQUIRE(result.has_value());
+    REQUIRE(result->levels.size() == result->images.size());
+    REQUIRE(result->thumbnails.size() == result->images.size());
+    for (std::size_t i = 0; i < request.tiles.size(); ++i) {
+      const auto& base = result->images[i];
+      const auto& levels = result->levels[i];
+      REQUIRE_FALSE(levels.empty());
+      CHECK(levels.front().width == std::max(1u, base.width / 2));
+      CHECK(levels.front().height == std::max(1u, base.height / 2));
+      CHECK(levels.back().width == 1);
+      CHECK(levels.back().height == 1);
+      CHECK(std::max(result->thumbnails[i].width,
+                     result->thumbnails[i].height) == 8);
+    }
+
+    CHECK_FALSE(art2img::extras::convert_tiles_streaming(
+        request, [](auto, const auto&) { return true; }));
+  }
+}
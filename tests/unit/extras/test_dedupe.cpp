@@ -0,0 +1,71 @@
+#include <doctest/doctest.h>
+
+#include <art2img/core/art.hpp>
+#include <art2img/core/palette.hpp>
+#include <art2img/extras/batch.hpp>
+#include <art2img/extras/dedupe.hpp>
+#include <numeric>
+#include <vector>
+
+#include "../../test_helpers.hpp"
+
+TEST_SUITE("dedupe module")
+{
+  TEST_CASE("find_duplicate_tiles maps copies to the first identical tile")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+    std::vector<std::size_t> tiles(art2img::core::tile_count(assets.archive));
+    std::iota(tiles.begin(), tiles.end(), std::size_t{0});
+    tiles.push_back(tiles.size() + 100);  // out of range maps to itself
+
+    const auto canonical =
+        art2img::extras::find_duplicate_tiles(assets.archive, tiles);
+    REQUIRE(canonical.size() == tiles.size());
+    // Tile 93 repeats tile 90 in the sample archive.
+    CHECK(canonical[93] == 90);
+    CHECK(canonical[90] == 90);
+    CHECK(canonical.back() == tiles.size() - 1);
+
+    for (std::size_t position = 0; position < tiles.size(); ++position) {
+      const auto source = canonical[position];
+      CHECK(source <= position);
+      CHECK(canonical[source] == source);
+      if (source != position) {
+        const auto lhs = art2img::core::get_tile(assets.archive, source);
+        const auto rhs = art2img::core::get_tile(assets.archive, position);
+        REQUIRE(lhs.has_value());
+        REQUIRE(rhs.has_value());
+        CHECK(lhs->width == rhs->width);
+        CHECK(lhs->height == rhs->height);
+      }
+    }
+  }
+
+  TEST_CASE("deduplicated convert_tiles shares one image per group")
+  {
+    const auto assets = test_helpers::load_sample_assets();
+
+    art2img::extras::BatchRequest request{};
+    request.archive = &assets.archive;
+    request.palette = &assets.palette;
+    request.tiles = {93, 5, 90, 5, 42};
+
+    auto plain = art2img::extras::convert_tiles(request);
+    REQUIRE(plain.has_value());
+    CHECK(plain->images.size() == request.tiles.size());
+
+    request.deduplicate = true;
+    request.parallel.threads = 2;
+    auto shared = art2img::extras::convert_tiles(request);
+    REQUIRE(shared.has_value());
+    CHECK(shared->images.size() == 3);
+    REQUIRE(shared->sources.size() == request.tiles.size());
+    CHECK(shared->sources[0] == shared->sources[2]);
+    CHECK(shared->sources[1] == shared->sources[3]);
+
+    for (std::size_t i = 0; i < request.tiles.size(); ++i) {
+      CHECK(art2img::extras::image_for(*shared, i).bytes ==
+            art2img::extras::image_for(*plain, i).bytes);
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/error.hpp>
+#include <art2img/extras/palette_cache.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace {
+
+std::vector<std::byte> read_palette_asset()
+{
+  const auto test_assets_dir = std::filesystem::path{__FILE__}
+                                   .parent_path()
+                                   .parent_path()
+                                   .parent_path() /
+                               "assets";
+  auto data =
+      art2img::adapters::read_binary_file(test_assets_dir / "PALETTE.DAT");
+  REQUIRE(data.has_value());
+  return std::move(*data);
+}
+
+}  // namespace
+
+TEST_SUITE("palette cache")
+{
+  TEST_CASE("equal palette bytes share one cached copy")
+  {
+    art2img::extras::PaletteCache cache(2);
+    const auto bytes = read_palette_asset();
+    const auto copy = bytes;
+
+    auto first = cache.get(bytes);
+    REQUIRE(first.has_value());
+    auto second = cache.get(copy);
+    REQUIRE(second.has_value());
+    CHECK(first->get() == second->get());
+    CHECK(cache.size() == 1);
+    // The view is over the cache's own copy, not the caller's bytes.
+    CHECK(static_cast<const void*>((*first)->rgb.data()) !=
+          static_cast<const void*>(bytes.data()));
+
+    auto changed = bytes;
+    changed[0] ^= std::byte{1};
+    auto other = cache.get(changed);
+    REQUIRE(other.has_value());
+    CHECK(other->get() != first->get());
+    CHECK(cache.size() == 2);
+  }
+
+  TEST_CASE("evicted palettes stay valid for their holders")
+  {
+    art2img::extras::PaletteCache cache(1);
+    auto bytes = read_palette_asset();
+
+    auto held = cache.get(bytes);
+    REQUIRE(held.has_value());
+    const auto first_red = (*held)->rgb[0];
+
+    bytes[0] ^= std::byte{1};
+    REQUIRE(cache.get(bytes).has_value());
+    CHECK(cache.size() == 1);
+    CHECK((*held)->rgb[0] == first_red);
+
+    std::vector<std::byte> too_small(8);
+    auto invalid = cache.get(too_small);
+    REQUIRE(!invalid.has_value());
+    CHECK(invalid.error().code == art2img::core::errc::invalid_palette);
+    CHECK(cache.size() == 1);
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK(&art2img::extras::palette_cache() ==
+          &art2img::extras::palette_cache());
+  }
+}
@@ -0,0 +1,62 @@
+#include <doctest/doctest.h>
+
+#include <art2img/core/convert.hpp>
+#include <art2img/core/stats.hpp>
+#include <art2img/extras/trace.hpp>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("trace")
+{
+  TEST_CASE("TraceRecorder keeps a tagged span per call on each thread")
+  {
+    std::vector<std::byte> indices(16, std::byte{2});
+    const art2img::core::TileView tile{indices, {}, 4, 4};
+    art2img::core::PreparedPalette palette{};
+
+    art2img::core::StatsCollector collector;
+    art2img::extras::TraceRecorder trace(&collector);
+    art2img::core::set_stats_sink(&trace);
+    const auto convert = [&](std::size_t tag) {
+      const art2img::core::ScopedStageTag scope(tag);
+      CHECK(art2img::core::palette_to_rgba(tile, palette));
+    };
+    convert(7);
+    std::thread worker([&] {
+      convert(8);
+      convert(9);
+    });
+    worker.join();
+    art2img::core::set_stats_sink(nullptr);
+
+    CHECK(trace.span_count() == 3);
+    const auto forwarded = collector.totals()[static_cast<std::size_t>(
+        art2img::core::Stage::convert)];
+    CHECK(forwarded.calls == 3);
+
+    const auto json = trace.chrome_trace_json();
+    CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.find("\"tile\":7,") != std::string::npos);
+    CHECK(json.find("\"tile\":9,") != std::string::npos);
+    CHECK(json.find("\"name\":\"convert\"") != std::string::npos);
+    CHECK(json.find("\"tid\":2") != std::string::npos);
+    CHECK(json.find("\"tid\":3") == std::string::npos);
+  }
+
+  TEST_CASE("Untagged calls carry no tile")
+  {
+    std::vector<std::byte> indices(4, std::byte{0});
+    const art2img::core::TileView tile{indices, {}, 2, 2};
+    art2img::core::PreparedPalette palette{};
+
+    art2img::extras::TraceRecorder trace;
+    art2img::core::set_stats_sink(&trace);
+    CHECK(art2img::core::palette_to_rgba(tile, palette));
+    art2img::core::set_stats_sink(nullptr);
+
+    CHECK(trace.span_count() == 1);
+    CHECK(trace.chrome_trace_json().find("\"tile\"") == std::string::npos);
+  }
+}
@@ -81,3 +81,53 @@ TEST_CASE("load_grp rejects invalid headers")
   CHECK(!result);
   CHECK(result.error().code == art2img::core::errc::invalid_art);
 }
+
+TEST_CASE("GrpFile lookups are case-insensitive and keep the first duplicate")
+{
+  const auto blob = make_grp_blob({{"Tiles000.Art", {std::byte{0x01}}},
+                                   {"PALETTE.DAT", {std::byte{0x02}}},
+                                   {"tiles000.art", {std::byte{0x03}}}});
+
+  const auto grp = art2img::adapters::load_grp(blob);
+  REQUIRE(grp);
+  CHECK(grp->entries().size() == 3);
+
+  const std::array<std::string_view, 4> spellings = {
+      "TILES000.ART", "tiles000.art", "TiLeS000.aRt",
+      std::string_view("TILES000.ART\0", 13)};
+  for (const auto name : spellings) {
+    const auto found = grp->entry(name);
+    REQUIRE(found);
+    CHECK(std::to_integer<unsigned char>(found->data[0]) == 0x01);
+  }
+
+  const auto palette = grp->entry("palette.dat ");
+  REQUIRE(palette);
+  CHECK(std::to_integer<unsigned char>(palette->data[0]) == 0x02);
+  CHECK(!grp->entry("PALETTE.DA"));
+  CHECK(!grp->entry(""));
+}
+
+TEST_CASE("load_grp_borrowed views the caller's blob")
+{
+  const auto blob = make_grp_blob({{"FIRSTART", {std::byte{0x01}}},
+                                   {"SECONDART", {std::byte{0xAA}}}});
+
+  const auto borrowed = art2img::adapters::load_grp_borrowed(blob);
+  REQUIRE(borrowed);
+  const auto second = borrowed->entry("secondart");
+  REQUIRE(second);
+  CHECK(second->data.data() == blob.data() + blob.size() - 1);
+
+  const auto copied = art2img::adapters::load_grp(blob);
+  REQUIRE(copied);
+  const auto copied_second = copied->entry("SECONDART");
+  REQUIRE(copied_second);
+  CHECK(copied_second->data.data() != second->data.data());
+
+  // Copies share the index and storage of the original.
+  const auto copy = *copied;
+  const auto from_copy = copy.entry("secondart");
+  REQUIRE(from_copy);
+  CHECK(from_copy->data.data() == copied_second->data.data());
+}
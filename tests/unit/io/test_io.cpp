@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/grp.hpp>
+#include <art2img/adapters/io.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/encode.hpp>
+#include <art2img/core/error.hpp>
+#include <art2img/core/palette.hpp>
+
+namespace {
+
+std::filesystem::path assets_dir()
+{
+  return std::filesystem::path{__FILE__}
+             .parent_path()
+             .parent_path()
+             .parent_path() /
+         "assets";
+}
+
+}  // namespace
+
+TEST_CASE("map_file exposes the same bytes as read_binary_file")
+{
+  const auto path = assets_dir() / "TILES000.ART";
+  const auto read = art2img::adapters::read_binary_file(path);
+  REQUIRE(read);
+
+  const auto mapped = art2img::adapters::map_file(path);
+  REQUIRE(mapped);
+  CHECK(mapped->handle != nullptr);
+  REQUIRE(mapped->data.size() == read->size());
+  CHECK(std::equal(mapped->data.begin(), mapped->data.end(), read->begin()));
+}
+
+TEST_CASE("mapped files feed the loaders without copying")
+{
+  auto art_file = art2img::adapters::map_file(assets_dir() / "TILES000.ART");
+  REQUIRE(art_file);
+  const std::weak_ptr<const void> watch = art_file->handle;
+
+  auto archive = art2img::core::load_art(art_file->handle, art_file->data);
+  REQUIRE(archive);
+  CHECK(archive->raw.data() == art_file->data.data());
+
+  // The archive keeps the mapping alive on its own.
+  art_file = art2img::adapters::MappedFile{};
+  CHECK(!watch.expired());
+  auto tile = art2img::core::get_tile(*archive, 0);
+  REQUIRE(tile);
+  CHECK(tile->valid());
+
+  const auto palette_file =
+      art2img::adapters::map_file(assets_dir() / "PALETTE.DAT");
+  REQUIRE(palette_file);
+  CHECK(art2img::core::load_palette(palette_file->data));
+}
+
+TEST_CASE("load_grp can view an owned blob in place")
+{
+  auto blob = std::make_shared<std::vector<std::byte>>();
+  for (char c : std::string_view("KenSilverman")) {
+    blob->push_back(static_cast<std::byte>(c));
+  }
+  blob->insert(blob->end(), {std::byte{1}, std::byte{0}, std::byte{0},
+                             std::byte{0}});
+  for (char c : std::string_view("PALETTE.DAT\0", 12)) {
+    blob->push_back(static_cast<std::byte>(c));
+  }
+  blob->insert(blob->end(), {std::byte{2}, std::byte{0}, std::byte{0},
+                             std::byte{0}, std::byte{0x7F}, std::byte{0x80}});
+
+  const std::span<const std::byte> bytes(*blob);
+  const auto grp = art2img::adapters::load_grp(blob, bytes);
+  REQUIRE(grp);
+  const auto entry = grp->entry("palette.dat");
+  REQUIRE(entry);
+  CHECK(entry->data.data() == bytes.data() + bytes.size() - 2);
+}
+
+TEST_CASE("map_file reports missing and maps empty files")
+{
+  const auto missing =
+      art2img::adapters::map_file(assets_dir() / "does_not_exist.bin");
+  REQUIRE(!missing);
+  CHECK(missing.error().code == art2img::core::errc::io_failure);
+
+  const auto empty_path =
+      std::filesystem::temp_directory_path() / "art2img_map_empty.bin";
+  REQUIRE(art2img::adapters::write_file(empty_path, {}));
+  const auto empty = art2img::adapters::map_file(empty_path);
+  REQUIRE(empty);
+  CHECK(empty->data.empty());
+  std::filesystem::remove(empty_path);
+}
+
+TEST_CASE("encode_to_file streams the same bytes encode_image produces")
+{
+  std::vector<std::uint8_t> pixels(9 * 3 * 4);
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<std::uint8_t>(i * 11);
+  }
+  const art2img::core::RgbaImageView view{pixels, 9, 3, 9 * 4};
+  const auto path =
+      std::filesystem::temp_directory_path() / "art2img_encode_sink.tga";
+
+  auto written = art2img::adapters::encode_to_file(
+      path, view, art2img::core::ImageFormat::tga);
+  REQUIRE(written);
+  auto encoded =
+      art2img::core::encode_image(view, art2img::core::ImageFormat::tga);
+  REQUIRE(encoded);
+  auto on_disk = art2img::adapters::read_binary_file(path);
+  REQUIRE(on_disk);
+  CHECK(*written == encoded->bytes.size());
+  CHECK(*on_disk == encoded->bytes);
+  std::filesystem::remove(path);
+
+  const auto bad = assets_dir() / "no_such_dir" / "out.tga";
+  auto failed = art2img::adapters::encode_to_file(
+      bad, view, art2img::core::ImageFormat::tga);
+  REQUIRE(!failed);
+  CHECK(failed.error().code == art2img::core::errc::io_failure);
+}
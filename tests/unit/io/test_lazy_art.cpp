@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/adapters/lazy_art.hpp>
+#include <art2img/core/art.hpp>
+#include <art2img/core/error.hpp>
+
+namespace {
+
+std::filesystem::path test_art_path()
+{
+  return std::filesystem::path{__FILE__}
+             .parent_path()
+             .parent_path()
+             .parent_path() /
+         "assets" / "TILES000.ART";
+}
+
+}  // namespace
+
+TEST_CASE("LazyArtArchive reads the same tiles as load_art")
+{
+  auto blob = art2img::adapters::read_binary_file(test_art_path());
+  REQUIRE(blob);
+  auto eager = art2img::core::load_art(*blob);
+  REQUIRE(eager);
+  auto lazy = art2img::adapters::open_art_lazy(test_art_path());
+  REQUIRE(lazy);
+
+  REQUIRE(lazy->tile_count() == art2img::core::tile_count(*eager));
+  CHECK(lazy->tile_start() == eager->tile_start);
+
+  std::vector<std::byte> storage;
+  for (std::size_t i = 0; i < lazy->tile_count(); ++i) {
+    INFO(i);
+    CHECK(lazy->layout()[i].width == eager->layout[i].width);
+    CHECK(lazy->layout()[i].offset_y == eager->layout[i].offset_y);
+
+    const auto expected = art2img::core::get_tile(*eager, i);
+    const auto tile = lazy->read_tile(i, storage);
+    REQUIRE(tile);
+    REQUIRE(tile->has_value() == expected.has_value());
+    if (!expected) {
+      continue;
+    }
+    CHECK((*tile)->width == expected->width);
+    CHECK((*tile)->height == expected->height);
+    CHECK(std::ranges::equal((*tile)->indices, expected->indices));
+    CHECK(std::ranges::equal((*tile)->lookup, expected->lookup));
+  }
+
+  const auto past_end = lazy->read_tile(lazy->tile_count(), storage);
+  REQUIRE(past_end);
+  CHECK(!past_end->has_value());
+}
+
+TEST_CASE("open_art_lazy rejects missing and truncated files")
+{
+  auto missing = art2img::adapters::open_art_lazy("no_such_file.art");
+  REQUIRE(!missing);
+  CHECK(missing.error().code == art2img::core::errc::io_failure);
+
+  auto blob = art2img::adapters::read_binary_file(test_art_path());
+  REQUIRE(blob);
+  const auto path =
+      std::filesystem::temp_directory_path() / "art2img_lazy_truncated.art";
+  blob->resize(blob->size() / 2);
+  REQUIRE(art2img::adapters::write_file(path, *blob));
+
+  auto truncated = art2img::adapters::open_art_lazy(path);
+  REQUIRE(!truncated);
+  CHECK(truncated.error().code == art2img::core::errc::invalid_art);
+  std::filesystem::remove(path);
+}
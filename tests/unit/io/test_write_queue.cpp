@@ -0,0 +1,90 @@
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/adapters/write_queue.hpp>
+#include <art2img/core/error.hpp>
+
+namespace {
+
+std::vector<std::byte> pattern_bytes(std::size_t size, std::size_t seed)
+{
+  std::vector<std::byte> bytes(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<std::byte>((i * 31 + seed * 7) & 0xFF);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST_CASE("WriteQueue writes every file and reports each tag once")
+{
+  const auto dir =
+      std::filesystem::temp_directory_path() / "art2img_write_queue";
+  std::filesystem::create_directories(dir);
+
+  for (const bool use_io_uring : {true, false}) {
+    INFO(use_io_uring);
+    constexpr std::size_t count = 40;
+    std::mutex mutex;
+    std::vector<int> completions(count + 1, 0);
+    std::optional<art2img::core::Error> failure;
+
+    {
+      art2img::adapters::WriteQueueOptions options{};
+      options.use_io_uring = use_io_uring;
+      options.batch = 8;
+      // Small enough that submit() has to wait for the writer.
+      options.max_pending_bytes = 64 * 1024;
+      art2img::adapters::WriteQueue queue(
+          [&](std::size_t tag,
+              std::expected<void, art2img::core::Error> result) {
+            const std::lock_guard lock(mutex);
+            ++completions[tag];
+            if (!result) {
+              failure = result.error();
+            }
+            else {
+              CHECK(tag < count);
+            }
+          },
+          options);
+      if (!use_io_uring) {
+        CHECK(queue.backend() == art2img::adapters::WriteBackend::threads);
+      }
+
+      for (std::size_t i = 0; i < count; ++i) {
+        // Includes an empty file and files larger than the queue budget.
+        const auto size = i == 0 ? 0 : (i * 4099) % (96 * 1024);
+        queue.submit(i, dir / ("file_" + std::to_string(i) + ".bin"),
+                     pattern_bytes(size, i));
+      }
+      queue.submit(count, dir / "no_such_dir" / "file.bin",
+                   pattern_bytes(16, 0));
+      queue.drain();
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      CHECK(completions[i] == 1);
+      const auto size = i == 0 ? 0 : (i * 4099) % (96 * 1024);
+      const auto path = dir / ("file_" + std::to_string(i) + ".bin");
+      const auto on_disk = art2img::adapters::read_binary_file(path);
+      REQUIRE(on_disk);
+      CHECK(*on_disk == pattern_bytes(size, i));
+    }
+    CHECK(completions[count] == 1);
+    REQUIRE(failure);
+    CHECK(failure->code == art2img::core::errc::io_failure);
+  }
+
+  std::filesystem::remove_all(dir);
+}
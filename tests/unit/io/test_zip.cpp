@@ -0,0 +1,127 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include <art2img/adapters/io.hpp>
+#include <art2img/adapters/zip.hpp>
+#include <art2img/core/error.hpp>
+
+namespace {
+
+std::filesystem::path temp_zip(std::string_view name)
+{
+  return std::filesystem::temp_directory_path() / name;
+}
+
+std::uint32_t le(const std::vector<std::byte>& bytes,
+                 std::size_t offset,
+                 int width)
+{
+  std::uint32_t value = 0;
+  for (int i = width - 1; i >= 0; --i) {
+    value = (value << 8) | static_cast<std::uint8_t>(bytes.at(offset + i));
+  }
+  return value;
+}
+
+std::span<const std::byte> as_bytes(std::string_view text)
+{
+  return std::as_bytes(std::span{text.data(), text.size()});
+}
+
+struct ListedEntry {
+  std::string name;
+  std::uint32_t crc;
+  std::vector<std::byte> data;
+};
+
+// Walks the central directory the way an unzip tool would.
+std::vector<ListedEntry> list_entries(const std::vector<std::byte>& zip)
+{
+  const auto end = zip.size() - 22;
+  REQUIRE(le(zip, end, 4) == 0x06054B50u);
+  const auto count = le(zip, end + 10, 2);
+  auto cursor = static_cast<std::size_t>(le(zip, end + 16, 4));
+
+  std::vector<ListedEntry> entries;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    REQUIRE(le(zip, cursor, 4) == 0x02014B50u);
+    CHECK(le(zip, cursor + 10, 2) == 0);  // stored
+    const auto crc = le(zip, cursor + 16, 4);
+    const auto size = le(zip, cursor + 20, 4);
+    const auto name_length = le(zip, cursor + 28, 2);
+    const auto local = static_cast<std::size_t>(le(zip, cursor + 42, 4));
+    std::string name(reinterpret_cast<const char*>(zip.data() + cursor + 46),
+                     name_length);
+
+    REQUIRE(le(zip, local, 4) == 0x04034B50u);
+    CHECK(le(zip, local + 14, 4) == crc);
+    CHECK(le(zip, local + 18, 4) == size);
+    const auto data = local + 30 + le(zip, local + 26, 2);
+    entries.push_back(
+        {name, crc,
+         std::vector<std::byte>(zip.begin() + static_cast<std::ptrdiff_t>(data),
+                                zip.begin() +
+                                    static_cast<std::ptrdiff_t>(data + size))});
+    cursor += 46 + name_length;
+  }
+  return entries;
+}
+
+}  // namespace
+
+TEST_CASE("ZipWriter produces a stored archive with a central directory")
+{
+  const auto path = temp_zip("art2img_entries.zip");
+  auto writer = art2img::adapters::create_zip(path);
+  REQUIRE(writer);
+
+  REQUIRE(writer->add("a.txt", as_bytes("123456789")));
+  REQUIRE(writer->add("dir/empty.bin", {}));
+  CHECK(writer->entry_count() == 2);
+
+  const auto size = writer->finish();
+  REQUIRE(size);
+  CHECK(*size == std::filesystem::file_size(path));
+
+  const auto bytes = art2img::adapters::read_binary_file(path);
+  REQUIRE(bytes);
+  const auto entries = list_entries(*bytes);
+  REQUIRE(entries.size() == 2);
+  CHECK(entries[0].name == "a.txt");
+  CHECK(entries[0].crc == 0xCBF43926u);  // the standard CRC-32 check value
+  CHECK(entries[0].data ==
+        std::vector<std::byte>(as_bytes("123456789").begin(),
+                               as_bytes("123456789").end()));
+  CHECK(entries[1].name == "dir/empty.bin");
+  CHECK(entries[1].crc == 0);
+  CHECK(entries[1].data.empty());
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("ZipWriter rejects use after finish and bad names")
+{
+  const auto path = temp_zip("art2img_finished.zip");
+  auto writer = art2img::adapters::create_zip(path);
+  REQUIRE(writer);
+
+  const auto unnamed = writer->add("", as_bytes("x"));
+  REQUIRE_FALSE(unnamed);
+  CHECK(unnamed.error().code == art2img::core::errc::unsupported);
+
+  REQUIRE(writer->finish());
+  CHECK_FALSE(writer->add("late.txt", as_bytes("x")));
+  CHECK_FALSE(writer->finish());
+  std::filesystem::remove(path);
+
+  const auto missing = art2img::adapters::create_zip(
+      std::filesystem::temp_directory_path() / "no_such_dir" / "out.zip");
+  REQUIRE_FALSE(missing);
+  CHECK(missing.error().code == art2img::core::errc::io_failure);
+}